@@ -19,6 +19,7 @@
 #include <common/StringTools.h>
 #include <common/HashUtil.h>
 #include "Aggregator.h"
+#include <google/protobuf/io/coded_stream.h>
 #include "common/LogtailCommonFlags.h"
 #include "sender/Sender.h"
 #include "config/Config.h"
@@ -33,11 +34,39 @@ DECLARE_FLAG_INT32(max_send_log_group_size);
 
 namespace logtail {
 
-
 bool MergeItem::IsReady() {
     return (mRawBytes > INT32_FLAG(batch_send_metric_size) || ((time(NULL) - mLastUpdateTime) >= mBatchSendInterval));
 }
 
+const std::string& MergeItem::SerializeLogGroup() {
+    // Logs is the first field of LogGroup, so the output is the same as serializing a LogGroup with them.
+    if (!mSerialized) {
+        mLogGroup.AppendToString(&mRawLogs);
+        mSerialized = true;
+    }
+    return mRawLogs;
+}
+
+void MergeItem::AppendLog(const sls_logs::Log& log) {
+    static const uint8_t kLogsFieldTag = (1 << 3) | 2; // field 1, length delimited
+    const uint32_t size = (uint32_t)log.GetCachedSize();
+    uint8_t header[1 + 5];
+    header[0] = kLogsFieldTag;
+    uint8_t* end = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(size, header + 1);
+    mRawLogs.append((const char*)header, end - header);
+    mLastRawLogOffset = mRawLogs.size();
+    mLastRawLogSize = size;
+    mRawLogs.resize(mRawLogs.size() + size);
+    log.SerializeWithCachedSizesToArray((uint8_t*)&mRawLogs[mLastRawLogOffset]);
+}
+
+bool MergeItem::GetLastLog(sls_logs::Log& log) const {
+    if (mLines == 0 || mLastRawLogOffset + mLastRawLogSize > mRawLogs.size()) {
+        return false;
+    }
+    return log.ParseFromArray(mRawLogs.data() + mLastRawLogOffset, (int)mLastRawLogSize);
+}
+
 bool PackageListMergeBuffer::IsReady(int32_t curTime) {
     // should use 2 * INT32_FLAG(batch_send_interval)), package list interval should > merge item interval
     return (mTotalRawBytes >= INT32_FLAG(batch_send_metric_size))
@@ -48,10 +77,14 @@ bool PackageListMergeBuffer::IsReady(int32_t curTime) {
 bool Aggregator::FlushReadyBuffer() {
     static Sender* sender = Sender::Instance();
     vector<MergeItem*> sendDataVec;
-    {
-        PTScopedLock lock(mMergeLock);
-        unordered_map<int64_t, MergeItem*>::iterator itr = mMergeMap.begin();
-        for (; itr != mMergeMap.end();) {
+    vector<vector<MergeItem*> > packageListVec;
+    int32_t curTime = time(NULL);
+    // Stripes are locked one by one, Add of other stripes goes on meanwhile.
+    for (size_t stripeIdx = 0; stripeIdx < kStripeCount; ++stripeIdx) {
+        MergeStripe& stripe = mMergeStripes[stripeIdx];
+        PTScopedLock lock(stripe.mMergeLock);
+        unordered_map<int64_t, MergeItem*>::iterator itr = stripe.mMergeMap.begin();
+        for (; itr != stripe.mMergeMap.end();) {
             if (sender->IsFlush()
                 || (itr->second->IsReady()
                     && sender->GetSenderFeedBackInterface()->IsValidToPush(itr->second->mLogstoreKey))) {
@@ -59,25 +92,21 @@ bool Aggregator::FlushReadyBuffer() {
                     sendDataVec.push_back(itr->second);
                 else {
                     int64_t key = itr->second->mKey;
-                    unordered_map<int64_t, PackageListMergeBuffer*>::iterator pIter = mPackageListMergeMap.find(key);
-                    if (pIter == mPackageListMergeMap.end()) {
+                    unordered_map<int64_t, PackageListMergeBuffer*>::iterator pIter
+                        = stripe.mPackageListMergeMap.find(key);
+                    if (pIter == stripe.mPackageListMergeMap.end()) {
                         PackageListMergeBuffer* tmpPtr = new PackageListMergeBuffer;
-                        pIter = mPackageListMergeMap.insert(std::make_pair(key, tmpPtr)).first;
+                        pIter = stripe.mPackageListMergeMap.insert(std::make_pair(key, tmpPtr)).first;
                     }
                     pIter->second->AddMergeItem(itr->second);
                 }
-                itr = mMergeMap.erase(itr);
+                itr = stripe.mMergeMap.erase(itr);
             } else
                 itr++;
         }
-    }
 
-    vector<vector<MergeItem*> > packageListVec;
-    int32_t curTime = time(NULL);
-    {
-        PTScopedLock lock(mMergeLock);
-        unordered_map<int64_t, PackageListMergeBuffer*>::iterator pIter = mPackageListMergeMap.begin();
-        for (; pIter != mPackageListMergeMap.end();) {
+        unordered_map<int64_t, PackageListMergeBuffer*>::iterator pIter = stripe.mPackageListMergeMap.begin();
+        for (; pIter != stripe.mPackageListMergeMap.end();) {
             if (sender->IsFlush()
                 || (pIter->second->IsReady(curTime) && pIter->second->mMergeItems.size() > 0
                     && sender->GetSenderFeedBackInterface()->IsValidToPush(
@@ -93,7 +122,7 @@ bool Aggregator::FlushReadyBuffer() {
                     sendDataVec.push_back(
                         pIter->second->mMergeItems[0]); // send LogGroup avoid more cost for LogPackageList
                 delete pIter->second;
-                pIter = mPackageListMergeMap.erase(pIter);
+                pIter = stripe.mPackageListMergeMap.erase(pIter);
             } else
                 pIter++;
         }
@@ -149,6 +178,15 @@ bool Aggregator::Add(const std::string& projectName,
     }
     vector<int32_t> neededLogs;
     int32_t neededLogSize = FilterNoneUtf8Metric(logGroup, config, neededLogs, context);
+    if (neededLogSize < logSize && config != NULL) {
+        LogFileProfiler::GetInstance()->AddProfilingFilterDrops(config->mConfigName,
+                                                                config->mRegion,
+                                                                projectName,
+                                                                logGroup.category(),
+                                                                filename,
+                                                                0,
+                                                                logSize - neededLogSize);
+    }
     if (neededLogSize == 0)
         return true;
     if (config != NULL && config->mSensitiveWordCastOptions.size() > (size_t)0) {
@@ -162,14 +200,24 @@ bool Aggregator::Add(const std::string& projectName,
     const string& category = logGroup.category();
     const string& topic = logGroup.topic();
     const string& source = logGroup.has_source() ? logGroup.source() : LogFileProfiler::mIpAddr;
-    string shardHashKey = CalPostRequestShardHashKey(source, topic, config);
-    // now shardHashKey is compute using machine level fields, so logGroupKey will not contain shardHashKey
-    int64_t logGroupKey
-        = HashString(projectName + "_" + category + "_" + topic + "_" + source + "_"
-                     + ((config != NULL && config->mLogType != STREAM_LOG && config->mLogType != PLUGIN_LOG)
-                            ? (config->mBasePath + config->mFilePattern)
-                            : "")
-                     + "_" + sourceId);
+    LogGroupRoutingKeyPtr cachedKey;
+    LogGroupRoutingKey localKey;
+    const LogGroupRoutingKey* routingKey = GetRoutingKey(projectName,
+                                                         sourceId,
+                                                         category,
+                                                         topic,
+                                                         source,
+                                                         config,
+                                                         context,
+                                                         mergeType == MERGE_BY_LOGSTORE,
+                                                         cachedKey,
+                                                         localKey);
+    string dynamicShardHashKey;
+    if (!routingKey->mShardHashKeyCached) {
+        dynamicShardHashKey = CalPostRequestShardHashKey(source, topic, config);
+    }
+    const string& shardHashKey = routingKey->mShardHashKeyCached ? routingKey->mShardHashKey : dynamicShardHashKey;
+    const int64_t logGroupKey = routingKey->mLogGroupKey;
 
     // Replay checkpoint had already been merged, resend directly.
     if (context.mExactlyOnceCheckpoint && context.mExactlyOnceCheckpoint->IsComplete()) {
@@ -184,22 +232,18 @@ bool Aggregator::Add(const std::string& projectName,
 
     LogstoreFeedBackKey feedBackKey
         = config == NULL ? GenerateLogstoreFeedBackKey(projectName, category) : config->mLogstoreKey;
-    int64_t key, logstoreKey;
-    if (mergeType == MERGE_BY_LOGSTORE) {
-        logstoreKey = HashString(projectName + "_" + category);
-        key = logstoreKey;
-    } else {
-        key = logGroupKey;
-    }
+    const int64_t logstoreKey = routingKey->mLogstoreKey;
+    const int64_t key = mergeType == MERGE_BY_LOGSTORE ? logstoreKey : logGroupKey;
 
-    LogGroup discardLogGroup;
     vector<MergeItem*> sendDataVec;
     int32_t logByteSize = (logGroupSize == 0 ? logGroup.ByteSize() : logGroupSize) / logSize;
-    decltype(logGroup.mutable_logs()->mutable_data()) mutableLogPtr = logGroup.mutable_logs()->mutable_data();
     int32_t neededIdx = 0;
-    int32_t discardLogSize = logSize - neededLogSize;
-    if (discardLogSize > 0) {
-        discardLogGroup.mutable_logs()->Reserve(discardLogSize);
+    // Sizes of needed logs are computed before taking the merge lock, logs are serialized into
+    //  merge items with them under lock. ByteSize of the log group has computed them already.
+    if (logGroupSize != 0) {
+        for (int32_t i = 0; i < neededLogSize; ++i) {
+            logGroup.logs(neededLogs[i]).ByteSize();
+        }
     }
     int32_t logCountMin = INT32_FLAG(merge_log_count_limit) > 1 ? (INT32_FLAG(merge_log_count_limit) - 1) : 0;
     int32_t logGroupByteMin = AppConfig::GetInstance()->GetMaxHoldedDataSize() > logByteSize
@@ -208,28 +252,29 @@ bool Aggregator::Add(const std::string& projectName,
 
     int32_t curTime = time(NULL);
     {
-        PTScopedLock lock(mMergeLock);
+        MergeStripe& stripe = mMergeStripes[GetStripeIndex(key)];
+        PTScopedLock lock(stripe.mMergeLock);
         unordered_map<int64_t, PackageListMergeBuffer*>::iterator pIter;
         if (mergeType == MERGE_BY_LOGSTORE) {
-            pIter = mPackageListMergeMap.find(logstoreKey);
-            if (pIter == mPackageListMergeMap.end()) {
+            pIter = stripe.mPackageListMergeMap.find(logstoreKey);
+            if (pIter == stripe.mPackageListMergeMap.end()) {
                 PackageListMergeBuffer* tmpPtr = new PackageListMergeBuffer();
-                pIter = mPackageListMergeMap.insert(std::make_pair(logstoreKey, tmpPtr)).first;
+                pIter = stripe.mPackageListMergeMap.insert(std::make_pair(logstoreKey, tmpPtr)).first;
             }
         }
-        unordered_map<int64_t, MergeItem*>::iterator itr = mMergeMap.find(logGroupKey);
+        unordered_map<int64_t, MergeItem*>::iterator itr = stripe.mMergeMap.find(logGroupKey);
         MergeItem* value = NULL;
-        if (itr != mMergeMap.end())
+        if (itr != stripe.mMergeMap.end())
             value = itr->second;
         else
-            itr = mMergeMap.insert(std::make_pair(logGroupKey, value)).first;
+            itr = stripe.mMergeMap.insert(std::make_pair(logGroupKey, value)).first;
 
         bool mergeFinishedFlag = false, initFlag = false;
         for (int32_t logIdx = 0; logIdx < logSize; logIdx++) {
             if (neededIdx < neededLogSize && logIdx == neededLogs[neededIdx]) {
                 if (value == NULL || value->mLines > logCountMin || value->mRawBytes > logGroupByteMin
                     || (curTime - value->mLastUpdateTime) >= INT32_FLAG(batch_send_interval)
-                    || ((value->mLogGroup).logs(0).time() / 60 != (*(mutableLogPtr + logIdx))->time() / 60)) {
+                    || (value->mLogTimeInMinute / 60 != (int32_t)logGroup.logs(logIdx).time() / 60)) {
                     // value is not NULL, log group merging finished
                     if (value != NULL) {
                         if (context.mMarkOffsetFlag) {
@@ -286,7 +331,6 @@ bool Aggregator::Add(const std::string& projectName,
                     initFlag = true;
 
                     value->mLastUpdateTime = curTime;
-                    (value->mLogGroup).mutable_logs()->Reserve(INT32_FLAG(merge_log_count_limit));
                     (value->mLogGroup).set_category(category);
                     (value->mLogGroup).set_topic(topic);
                     (value->mLogGroup).set_machineuuid(ConfigManager::GetInstance()->GetUUID());
@@ -302,13 +346,13 @@ bool Aggregator::Add(const std::string& projectName,
                     AddPackIDForLogGroup(sourceId, logGroupKey, value->mLogGroup);
                 }
 
-                (value->mLogGroup).mutable_logs()->AddAllocated(*(mutableLogPtr + logIdx));
+                value->AppendLog(logGroup.logs(logIdx));
                 if (context.mExactlyOnceCheckpoint) {
                     auto& logPosition = context.mExactlyOnceCheckpoint->positions[logIdx];
                     auto& cpt = value->mLogGroupContext.mExactlyOnceCheckpoint->data;
 
                     // First log, upodate read_offset.
-                    if (1 == value->mLogGroup.logs_size()) {
+                    if (0 == value->mLines) {
                         cpt.set_read_offset(logPosition.first);
                     }
                     // Update read_length.
@@ -316,12 +360,14 @@ bool Aggregator::Add(const std::string& projectName,
                 }
 
                 // get first log time as log time of this log group in merge item
-                value->mLogTimeInMinute = (value->mLogGroup).logs(0).time() - (value->mLogGroup).logs(0).time() % 60;
+                if (0 == value->mLines) {
+                    int32_t logTime = (int32_t)logGroup.logs(logIdx).time();
+                    value->mLogTimeInMinute = logTime - logTime % 60;
+                }
                 value->mRawBytes += logByteSize;
                 value->mLines++;
                 neededIdx++;
-            } else
-                discardLogGroup.mutable_logs()->AddAllocated(*(mutableLogPtr + logIdx));
+            }
         }
 
         // handle truncate info, the first truncate info may be inserted while merge item 'value' initialized
@@ -332,15 +378,13 @@ bool Aggregator::Add(const std::string& projectName,
             value->mLogGroupContext.mFileInfoPtr = context.mFileInfoPtr;
         }
 
-        for (int32_t logIdx = 0; logIdx < logSize; logIdx++)
-            logGroup.mutable_logs()->ReleaseLast();
         if (value != NULL && (value->IsReady() || sender->IsFlush())) {
             if (mergeType == MERGE_BY_LOGSTORE)
                 (pIter->second)->AddMergeItem(value);
             else
                 sendDataVec.push_back(value);
 
-            mMergeMap.erase(itr);
+            stripe.mMergeMap.erase(itr);
         }
         if (mergeType == MERGE_BY_LOGSTORE) {
             if (pIter->second->IsReady(curTime) || sender->IsFlush()) {
@@ -353,11 +397,14 @@ bool Aggregator::Add(const std::string& projectName,
                 sendDataVec.insert(
                     sendDataVec.end(), (pIter->second)->mMergeItems.begin(), (pIter->second)->mMergeItems.end());
                 delete pIter->second;
-                mPackageListMergeMap.erase(pIter);
+                stripe.mPackageListMergeMap.erase(pIter);
             }
         }
     }
 
+    // Logs are encoded into merge items, release them out of lock.
+    logGroup.clear_logs();
+
     if (sendDataVec.size() > 0) {
         // if send data package count greater than INT32_FLAG(same_topic_merge_send_count), there will be many little
         // package in send queue, so we merge data package to send. because the send loggroup's max size is 512k, so
@@ -401,6 +448,68 @@ void Aggregator::MergeTruncateInfo(const sls_logs::LogGroup& logGroup, MergeItem
     }
 }
 
+void Aggregator::MakeRoutingKey(const std::string& projectName,
+                                const std::string& sourceId,
+                                const std::string& category,
+                                const std::string& topic,
+                                const std::string& source,
+                                const Config* config,
+                                bool withLogstoreKey,
+                                LogGroupRoutingKey& routingKey) {
+    // now shardHashKey is compute using machine level fields, so logGroupKey will not contain shardHashKey
+    routingKey.mLogGroupKey
+        = HashString(projectName + "_" + category + "_" + topic + "_" + source + "_"
+                     + ((config != NULL && config->mLogType != STREAM_LOG && config->mLogType != PLUGIN_LOG)
+                            ? (config->mBasePath + config->mFilePattern)
+                            : "")
+                     + "_" + sourceId);
+    if (withLogstoreKey) {
+        routingKey.mLogstoreKey = HashString(projectName + "_" + category);
+    }
+    // User defined ids and machine uuid may be changed at runtime.
+    routingKey.mShardHashKeyCached = true;
+    if (config != NULL) {
+        for (const string& key : config->mShardHashKey) {
+            if (key == LOG_RESERVED_KEY_USER_DEFINED_ID || key == LOG_RESERVED_KEY_MACHINE_UUID) {
+                routingKey.mShardHashKeyCached = false;
+                break;
+            }
+        }
+    }
+    if (routingKey.mShardHashKeyCached) {
+        routingKey.mShardHashKey = CalPostRequestShardHashKey(source, topic, config);
+    }
+}
+
+const LogGroupRoutingKey* Aggregator::GetRoutingKey(const std::string& projectName,
+                                                    const std::string& sourceId,
+                                                    const std::string& category,
+                                                    const std::string& topic,
+                                                    const std::string& source,
+                                                    const Config* config,
+                                                    const LogGroupContext& context,
+                                                    bool withLogstoreKey,
+                                                    LogGroupRoutingKeyPtr& cachedKey,
+                                                    LogGroupRoutingKey& localKey) {
+    if (!context.mRoutingKeyCache || config == NULL) {
+        MakeRoutingKey(projectName, sourceId, category, topic, source, config, withLogstoreKey, localKey);
+        return &localKey;
+    }
+    // Keys of a reader are computed once, unless its topic, source or config is changed.
+    cachedKey = context.mRoutingKeyCache->Get();
+    if (!cachedKey || cachedKey->mConfigInstanceId != config->mInstanceId || cachedKey->mTopic != topic
+        || cachedKey->mSource != source) {
+        std::shared_ptr<LogGroupRoutingKey> newKey = std::make_shared<LogGroupRoutingKey>();
+        newKey->mConfigInstanceId = config->mInstanceId;
+        newKey->mTopic = topic;
+        newKey->mSource = source;
+        MakeRoutingKey(projectName, sourceId, category, topic, source, config, true, *newKey);
+        context.mRoutingKeyCache->Set(newKey);
+        cachedKey = newKey;
+    }
+    return cachedKey.get();
+}
+
 std::string
 Aggregator::CalPostRequestShardHashKey(const std::string& source, const std::string& topic, const Config* config) {
     if (config == NULL)
@@ -431,34 +540,47 @@ Aggregator::CalPostRequestShardHashKey(const std::string& source, const std::str
 
 
 void Aggregator::CleanTimeoutLogPackSeq() {
-    PTScopedLock lock(mLogPackSeqMapLock);
+    size_t totalSize = 0;
+    for (size_t stripeIdx = 0; stripeIdx < kStripeCount; ++stripeIdx) {
+        LogPackSeqStripe& stripe = mLogPackSeqStripes[stripeIdx];
+        PTScopedLock lock(stripe.mLogPackSeqMapLock);
+        totalSize += stripe.mLogPackSeqMap.size();
+    }
     int32_t curTime = time(NULL);
-    int32_t timeoutInterval = mLogPackSeqMap.size() > 100000 ? 86400 : (86400 * 30);
-    std::unordered_map<int64_t, LogPackSeqInfo*>::iterator iter = mLogPackSeqMap.begin();
-    for (; iter != mLogPackSeqMap.end();) {
-        if ((curTime - iter->second->mLastUpdateTime) > timeoutInterval) {
-            delete iter->second;
-            iter = mLogPackSeqMap.erase(iter);
-        } else
-            iter++;
+    int32_t timeoutInterval = totalSize > 100000 ? 86400 : (86400 * 30);
+    for (size_t stripeIdx = 0; stripeIdx < kStripeCount; ++stripeIdx) {
+        LogPackSeqStripe& stripe = mLogPackSeqStripes[stripeIdx];
+        PTScopedLock lock(stripe.mLogPackSeqMapLock);
+        std::unordered_map<int64_t, LogPackSeqInfo*>::iterator iter = stripe.mLogPackSeqMap.begin();
+        for (; iter != stripe.mLogPackSeqMap.end();) {
+            if ((curTime - iter->second->mLastUpdateTime) > timeoutInterval) {
+                delete iter->second;
+                iter = stripe.mLogPackSeqMap.erase(iter);
+            } else
+                iter++;
+        }
     }
 }
 
 void Aggregator::CleanLogPackSeqMap() {
-    PTScopedLock lock(mLogPackSeqMapLock);
-    for (std::unordered_map<int64_t, LogPackSeqInfo*>::iterator iter = mLogPackSeqMap.begin();
-         iter != mLogPackSeqMap.end();
-         ++iter)
-        delete iter->second;
-    mLogPackSeqMap.clear();
+    for (size_t stripeIdx = 0; stripeIdx < kStripeCount; ++stripeIdx) {
+        LogPackSeqStripe& stripe = mLogPackSeqStripes[stripeIdx];
+        PTScopedLock lock(stripe.mLogPackSeqMapLock);
+        for (std::unordered_map<int64_t, LogPackSeqInfo*>::iterator iter = stripe.mLogPackSeqMap.begin();
+             iter != stripe.mLogPackSeqMap.end();
+             ++iter)
+            delete iter->second;
+        stripe.mLogPackSeqMap.clear();
+    }
 }
 
 
 int64_t Aggregator::GetAndIncLogPackSeq(int64_t key) {
-    PTScopedLock lock(mLogPackSeqMapLock);
-    std::unordered_map<int64_t, LogPackSeqInfo*>::iterator iter = mLogPackSeqMap.find(key);
-    if (iter == mLogPackSeqMap.end()) {
-        mLogPackSeqMap[key] = new LogPackSeqInfo(1);
+    LogPackSeqStripe& stripe = mLogPackSeqStripes[GetStripeIndex(key)];
+    PTScopedLock lock(stripe.mLogPackSeqMapLock);
+    std::unordered_map<int64_t, LogPackSeqInfo*>::iterator iter = stripe.mLogPackSeqMap.find(key);
+    if (iter == stripe.mLogPackSeqMap.end()) {
+        stripe.mLogPackSeqMap[key] = new LogPackSeqInfo(1);
         return 0;
     } else {
         int64_t seq = iter->second->mSeq;
@@ -494,10 +616,13 @@ int32_t Aggregator::FilterNoneUtf8Metric(sls_logs::LogGroup& logGroup,
 }
 
 bool Aggregator::IsMergeMapEmpty() {
-    PTScopedLock lock(mMergeLock);
-    if (mMergeMap.size() == 0 && mPackageListMergeMap.size() == 0)
-        return true;
-    return false;
+    for (size_t stripeIdx = 0; stripeIdx < kStripeCount; ++stripeIdx) {
+        MergeStripe& stripe = mMergeStripes[stripeIdx];
+        PTScopedLock lock(stripe.mMergeLock);
+        if (stripe.mMergeMap.size() != 0 || stripe.mPackageListMergeMap.size() != 0)
+            return false;
+    }
+    return true;
 }
 
 } // namespace logtail
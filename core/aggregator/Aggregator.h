@@ -38,7 +38,15 @@ struct MergeItem {
     std::string mProjectName;
     std::string mConfigName;
     std::string mFilename;
+    // Fields of log group except logs, logs are kept in mRawLogs.
     sls_logs::LogGroup mLogGroup;
+    // Logs serialized in wire format (field Logs of LogGroup) when they are merged, followed by
+    //  fields of mLogGroup after SerializeLogGroup, it is the data to send.
+    std::string mRawLogs;
+    bool mSerialized;
+    // Offset and size of the last log's message in mRawLogs.
+    size_t mLastRawLogOffset;
+    size_t mLastRawLogSize;
     std::string mShardHashKey;
     bool mBufferOrNot;
     std::string mAliuid;
@@ -52,6 +60,13 @@ struct MergeItem {
     LogGroupContext mLogGroupContext;
 
     bool IsReady();
+    // AppendLog serializes @log to mRawLogs, sizes of @log must have been computed by ByteSize.
+    void AppendLog(const sls_logs::Log& log);
+    // SerializeLogGroup appends fields of mLogGroup to mRawLogs at the first call and returns the
+    //  whole log group, logs can not be appended after it.
+    const std::string& SerializeLogGroup();
+    // GetLastLog decodes the last merged log, returns false if there is no log.
+    bool GetLastLog(sls_logs::Log& log) const;
     MergeItem(const std::string& projectName,
               const std::string& configName,
               const std::string& filename,
@@ -75,6 +90,9 @@ struct MergeItem {
         mLastUpdateTime = -1;
         mRawBytes = 0;
         mLines = 0;
+        mSerialized = false;
+        mLastRawLogOffset = 0;
+        mLastRawLogSize = 0;
         mShardHashKey = shardHashKey;
         mLogstoreKey = logstoreKey;
         mLogTimeInMinute = -1;
@@ -166,20 +184,58 @@ private:
 
     void AddPackIDForLogGroup(const std::string& packIDPrefix, int64_t logGroupKey, sls_logs::LogGroup& logGroup);
 
+    // MakeRoutingKey computes keys of @routingKey, logstore key is computed if @withLogstoreKey.
+    void MakeRoutingKey(const std::string& projectName,
+                        const std::string& sourceId,
+                        const std::string& category,
+                        const std::string& topic,
+                        const std::string& source,
+                        const Config* config,
+                        bool withLogstoreKey,
+                        LogGroupRoutingKey& routingKey);
+
+    // GetRoutingKey returns keys of a log group added with @context, reused from its reader's cache
+    //  unless config, topic or source is changed. The result is held by @cachedKey or @localKey.
+    const LogGroupRoutingKey* GetRoutingKey(const std::string& projectName,
+                                            const std::string& sourceId,
+                                            const std::string& category,
+                                            const std::string& topic,
+                                            const std::string& source,
+                                            const Config* config,
+                                            const LogGroupContext& context,
+                                            bool withLogstoreKey,
+                                            LogGroupRoutingKeyPtr& cachedKey,
+                                            LogGroupRoutingKey& localKey);
+
 private:
     Aggregator() = default;
     ~Aggregator() = default;
 
 private:
-    std::unordered_map<int64_t, LogPackSeqInfo*> mLogPackSeqMap;
-    PTMutex mLogPackSeqMapLock;
+    // Merge state is partitioned into stripes so that processor threads adding log groups of
+    //  different logstores do not wait for each other.
+    // A merge item and the package list buffer it goes to are in the same stripe, which is
+    //  chosen by MergeItem::mKey (logstore key for MERGE_BY_LOGSTORE, log group key otherwise).
+    struct MergeStripe {
+        std::unordered_map<int64_t, MergeItem*> mMergeMap;
+        std::unordered_map<int64_t, PackageListMergeBuffer*> mPackageListMergeMap;
+        PTMutex mMergeLock;
+    };
+    // Pack sequences are striped by log group key.
+    struct LogPackSeqStripe {
+        std::unordered_map<int64_t, LogPackSeqInfo*> mLogPackSeqMap;
+        PTMutex mLogPackSeqMapLock;
+    };
+    static const size_t kStripeCount = 64;
+
+    static size_t GetStripeIndex(int64_t key) { return (uint64_t)key % kStripeCount; }
 
-    std::unordered_map<int64_t, MergeItem*> mMergeMap;
-    std::unordered_map<int64_t, PackageListMergeBuffer*> mPackageListMergeMap;
-    PTMutex mMergeLock;
+    MergeStripe mMergeStripes[kStripeCount];
+    LogPackSeqStripe mLogPackSeqStripes[kStripeCount];
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class SenderUnittest;
+    friend class AggregatorUnittest;
 #endif
 };
 
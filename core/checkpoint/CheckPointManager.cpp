@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "CheckPointManager.h"
+#include "CheckPointStore.h"
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <thread>
@@ -39,9 +41,33 @@ DEFINE_FLAG_INT32(check_point_version, "now check point version xx.xx.xx such as
 DEFINE_FLAG_INT32(check_point_dump_interval, "default 15 min", 15 * 60);
 DEFINE_FLAG_INT32(check_point_max_count, "max check point count", 100000);
 DEFINE_FLAG_INT32(checkpoint_find_max_file_count, "", 1000);
+DEFINE_FLAG_BOOL(enable_checkpoint_store,
+                 "dump changed checkpoints to binary checkpoint store instead of rewriting json checkpoint file",
+                 true);
 
 namespace logtail {
 
+CheckPointManager::CheckPointManager()
+    : mLastCheckTime(time(NULL)),
+      mLastDumpTime(time(NULL)),
+      mLoadVersion(NO_CHECKPOINT_VERSION),
+      mReaderCount(0),
+      mHasPending(false),
+      mStopDumpThread(false) {
+}
+
+CheckPointManager::~CheckPointManager() {
+    {
+        std::lock_guard<std::mutex> lock(mPendingMux);
+        mStopDumpThread = true;
+    }
+    mPendingCV.notify_one();
+    if (mDumpThreadPtr) {
+        mDumpThreadPtr->join();
+        mDumpThreadPtr.reset();
+    }
+}
+
 bool CheckPointManager::CheckVersion() {
     return (mLoadVersion == NO_CHECKPOINT_VERSION) || (mLoadVersion / 10000 == INT32_FLAG(check_point_version) / 10000);
 }
@@ -122,7 +148,57 @@ void CheckPointManager::AddDirCheckPoint(const string& dirname) {
         ptr = it->second.get();
     ptr->mSubDir.insert(dirname);
 }
+CheckPointStore* CheckPointManager::getStore() {
+    // Checkpoint file path can be changed by app config before the first load.
+    string storeFile = AppConfig::GetInstance()->GetCheckPointFilePath() + ".bin";
+    if (!mStore || mStore->GetFileName() != storeFile) {
+        mStore.reset(new CheckPointStore(storeFile));
+    }
+    return mStore.get();
+}
+
+bool CheckPointManager::loadFromStore() {
+    std::lock_guard<std::mutex> lock(mDumpMux);
+    CheckPointStore* store = getStore();
+    vector<CheckPointPtr> fileCheckPoints;
+    vector<DirCheckPointPtr> dirCheckPoints;
+    string errorMessage;
+    bool loaded = store->Load(fileCheckPoints, dirCheckPoints, errorMessage);
+    if (!errorMessage.empty()) {
+        LOG_ERROR(sLogger, ("load checkpoint store fail", errorMessage));
+        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM, "load checkpoint store fail:" + errorMessage);
+    }
+    if (!loaded) {
+        return false;
+    }
+
+    mLoadVersion = INT32_FLAG(check_point_version);
+    int32_t timeoutTime = time(NULL) - INT32_FLAG(file_check_point_time_out);
+    for (auto& dirCheckPoint : dirCheckPoints) {
+        if (dirCheckPoint->mUpdateTime >= timeoutTime) {
+            mDirNameMap[dirCheckPoint->mParentName] = dirCheckPoint;
+        } else {
+            LOG_INFO(sLogger,
+                     ("load timeout dir check point, ignore", dirCheckPoint->mParentName)(
+                         ToString(dirCheckPoint->mUpdateTime), time(NULL)));
+        }
+    }
+    mReaderCount = fileCheckPoints.size();
+    for (auto& fileCheckPoint : fileCheckPoints) {
+        mDevInodeCheckPointPtrMap[CheckPointKey(fileCheckPoint->mDevInode, fileCheckPoint->mConfigName)]
+            = fileCheckPoint;
+    }
+    LOG_INFO(sLogger,
+             ("load checkpoint store", store->GetFileName())("size", store->GetFileSize())(
+                 "file check point", mDevInodeCheckPointPtrMap.size())("dir check point", mDirNameMap.size()));
+    return true;
+}
+
 void CheckPointManager::LoadCheckPoint() {
+    // Json checkpoint file is still loaded if checkpoint store does not exist, to upgrade.
+    if (BOOL_FLAG(enable_checkpoint_store) && loadFromStore()) {
+        return;
+    }
     Json::Value root;
     ParseConfResult cptRes = ParseConfig(AppConfig::GetInstance()->GetCheckPointFilePath(), root);
     // if new checkpoint file not exist, check old checkpoint file.
@@ -292,6 +368,125 @@ void CheckPointManager::LoadFileCheckPoint(const Json::Value& root) {
 }
 bool CheckPointManager::DumpCheckPointToLocal() {
     mLastDumpTime = time(NULL);
+    mReaderCount = mDevInodeCheckPointPtrMap.size();
+    std::lock_guard<std::mutex> lock(mDumpMux);
+    {
+        // Checkpoints waiting for dump thread are older than current ones.
+        std::lock_guard<std::mutex> pendingLock(mPendingMux);
+        mHasPending = false;
+        mPendingFileCheckPoints.clear();
+        mPendingDirCheckPoints.clear();
+    }
+    return dumpCheckPoints(mDevInodeCheckPointPtrMap, mDirNameMap);
+}
+
+void CheckPointManager::DumpCheckPointInBackground() {
+    mLastDumpTime = time(NULL);
+    mReaderCount = mDevInodeCheckPointPtrMap.size();
+    {
+        std::lock_guard<std::mutex> lock(mPendingMux);
+        // Swap out checkpoints not written yet, they are replaced by current ones.
+        mPendingFileCheckPoints.swap(mDevInodeCheckPointPtrMap);
+        mPendingDirCheckPoints.swap(mDirNameMap);
+        mHasPending = true;
+        if (!mDumpThreadPtr) {
+            mDumpThreadPtr.reset(new std::thread([this]() { runDumpLoop(); }));
+        }
+    }
+    mPendingCV.notify_one();
+    RemoveAllCheckPoint();
+}
+
+void CheckPointManager::runDumpLoop() {
+    LOG_INFO(sLogger, ("checkpoint dump thread", "started"));
+    DevInodeCheckPointHashMap fileCheckPoints;
+    std::unordered_map<std::string, DirCheckPointPtr> dirCheckPoints;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> pendingLock(mPendingMux);
+            mPendingCV.wait(pendingLock, [this]() { return mStopDumpThread || mHasPending; });
+            if (mStopDumpThread) {
+                break;
+            }
+        }
+        // Take pending checkpoints with mDumpMux held, so DumpCheckPointToLocal can not
+        //  write newer checkpoints before them.
+        std::lock_guard<std::mutex> lock(mDumpMux);
+        {
+            std::lock_guard<std::mutex> pendingLock(mPendingMux);
+            if (!mHasPending) {
+                continue;
+            }
+            fileCheckPoints.swap(mPendingFileCheckPoints);
+            dirCheckPoints.swap(mPendingDirCheckPoints);
+            mHasPending = false;
+        }
+        if (!dumpCheckPoints(fileCheckPoints, dirCheckPoints)) {
+            LOG_WARNING(sLogger, ("dump checkpoint to local", "fail"));
+        } else {
+            LOG_DEBUG(sLogger, ("dump checkpoint to local", "success"));
+        }
+        fileCheckPoints.clear();
+        dirCheckPoints.clear();
+    }
+    LOG_INFO(sLogger, ("checkpoint dump thread", "stopped"));
+}
+
+bool CheckPointManager::dumpCheckPoints(const DevInodeCheckPointHashMap& fileCheckPoints,
+                                        const std::unordered_map<std::string, DirCheckPointPtr>& dirCheckPoints) {
+    vector<const CheckPoint*> checkPointVec;
+    checkPointVec.reserve(fileCheckPoints.size());
+    for (auto it = fileCheckPoints.begin(); it != fileCheckPoints.end(); ++it) {
+        checkPointVec.push_back(it->second.get());
+    }
+    if (checkPointVec.size() > (size_t)INT32_FLAG(check_point_max_count)) {
+        sort(checkPointVec.begin(), checkPointVec.end(), CheckPointManager::CheckPointCmpByUpdateTime);
+        checkPointVec.resize(INT32_FLAG(check_point_max_count));
+        LOG_WARNING(sLogger, ("Too many check point", fileCheckPoints.size()));
+        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM,
+                                               "Too many check point:" + ToString(fileCheckPoints.size()));
+    }
+
+    if (BOOL_FLAG(enable_checkpoint_store)) {
+        return dumpToStore(checkPointVec, dirCheckPoints);
+    }
+    return dumpToJson(checkPointVec, dirCheckPoints);
+}
+
+bool CheckPointManager::dumpToStore(const std::vector<const CheckPoint*>& fileCheckPoints,
+                                    const std::unordered_map<std::string, DirCheckPointPtr>& dirCheckPoints) {
+    CheckPointStore* store = getStore();
+    if (!Mkdirs(ParentPath(store->GetFileName()))) {
+        LOG_ERROR(sLogger, ("open check point file dir error", store->GetFileName()));
+        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM, "open check point file dir failed");
+        return false;
+    }
+    vector<const DirCheckPoint*> dirCheckPointVec;
+    dirCheckPointVec.reserve(dirCheckPoints.size());
+    for (auto it = dirCheckPoints.begin(); it != dirCheckPoints.end(); ++it) {
+        dirCheckPointVec.push_back(it->second.get());
+    }
+    string errorMessage;
+    if (!store->Dump(fileCheckPoints, dirCheckPointVec, errorMessage)) {
+        LOG_ERROR(sLogger, ("dump checkpoint store fail", errorMessage));
+        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM, "dump checkpoint store fail:" + errorMessage);
+        return false;
+    }
+    // Json checkpoint file is out of date now, remove it so that it is never loaded.
+    const string& checkPointFile = AppConfig::GetInstance()->GetCheckPointFilePath();
+    if (CheckExistance(checkPointFile)) {
+        LOG_INFO(sLogger, ("remove json checkpoint file replaced by checkpoint store", checkPointFile));
+        remove(checkPointFile.c_str());
+    }
+    LOG_DEBUG(sLogger,
+              ("dump checkpoint store, file check point", fileCheckPoints.size())(
+                  "dir check point", dirCheckPoints.size())("written records", store->GetLastAppendCount())(
+                  "file size", store->GetFileSize()));
+    return true;
+}
+
+bool CheckPointManager::dumpToJson(const std::vector<const CheckPoint*>& fileCheckPoints,
+                                   const std::unordered_map<std::string, DirCheckPointPtr>& dirCheckPoints) {
     string checkPointFile = AppConfig::GetInstance()->GetCheckPointFilePath();
     string checkPointTempFile = checkPointFile + ".bak";
 
@@ -302,64 +497,29 @@ bool CheckPointManager::DumpCheckPointToLocal() {
     }
 
     Json::Value root;
-    mReaderCount = mDevInodeCheckPointPtrMap.size();
-    if (mDevInodeCheckPointPtrMap.size() <= (size_t)INT32_FLAG(check_point_max_count)) {
-        CheckPointManager::DevInodeCheckPointHashMap::iterator it;
-        for (it = mDevInodeCheckPointPtrMap.begin(); it != mDevInodeCheckPointPtrMap.end(); ++it) {
-            CheckPoint* checkPointPtr = it->second.get();
-            Json::Value leaf;
-            leaf["file_name"] = Json::Value(checkPointPtr->mFileName);
-            leaf["real_file_name"] = Json::Value(checkPointPtr->mRealFileName);
-            leaf["offset"] = Json::Value(ToString(checkPointPtr->mOffset));
-            leaf["sig_size"] = Json::Value(Json::UInt(checkPointPtr->mSignatureSize));
-            leaf["sig_hash"] = Json::Value(Json::UInt64(checkPointPtr->mSignatureHash));
-            leaf["update_time"] = Json::Value(checkPointPtr->mLastUpdateTime);
-            leaf["inode"] = Json::Value(Json::UInt64(checkPointPtr->mDevInode.inode));
-            leaf["dev"] = Json::Value(Json::UInt64(checkPointPtr->mDevInode.dev));
-            leaf["file_open"] = Json::Value(checkPointPtr->mFileOpenFlag);
-            leaf["config_name"] = Json::Value(checkPointPtr->mConfigName);
-            // forward compatible
-            leaf["sig"] = Json::Value(string(""));
-            // use filename + dev + inode + configName to prevent same filename conflict
-            root[checkPointPtr->mFileName + "*" + ToString(checkPointPtr->mDevInode.dev) + "*"
-                 + ToString(checkPointPtr->mDevInode.inode) + "*" + checkPointPtr->mConfigName]
-                = leaf;
-        }
-    } else {
-        vector<CheckPoint*> sortedCheckPointVec;
-        CheckPointManager::DevInodeCheckPointHashMap::iterator it;
-        for (it = mDevInodeCheckPointPtrMap.begin(); it != mDevInodeCheckPointPtrMap.end(); ++it) {
-            sortedCheckPointVec.push_back(it->second.get());
-        }
-        sort(sortedCheckPointVec.begin(), sortedCheckPointVec.end(), CheckPointManager::CheckPointCmpByUpdateTime);
-        for (int32_t i = 0; i < INT32_FLAG(check_point_max_count); ++i) {
-            CheckPoint* checkPointPtr = sortedCheckPointVec[i];
-            Json::Value leaf;
-            leaf["file_name"] = Json::Value(checkPointPtr->mFileName);
-            leaf["real_file_name"] = Json::Value(checkPointPtr->mRealFileName);
-            leaf["offset"] = Json::Value(ToString(checkPointPtr->mOffset));
-            leaf["sig_size"] = Json::Value(Json::UInt(checkPointPtr->mSignatureSize));
-            leaf["sig_hash"] = Json::Value(Json::UInt64(checkPointPtr->mSignatureHash));
-            leaf["update_time"] = Json::Value(checkPointPtr->mLastUpdateTime);
-            leaf["inode"] = Json::Value(Json::UInt64(checkPointPtr->mDevInode.inode));
-            leaf["dev"] = Json::Value(Json::UInt64(checkPointPtr->mDevInode.dev));
-            leaf["file_open"] = Json::Value(checkPointPtr->mFileOpenFlag);
-            leaf["config_name"] = Json::Value(checkPointPtr->mConfigName);
-            // forward compatible
-            leaf["sig"] = Json::Value(string(""));
-            // use filename + dev + inode + configName to prevent same filename conflict
-            root[checkPointPtr->mFileName + "*" + ToString(checkPointPtr->mDevInode.dev) + "*"
-                 + ToString(checkPointPtr->mDevInode.inode) + "*" + checkPointPtr->mConfigName]
-                = leaf;
-        }
-        LOG_WARNING(sLogger, ("Too many check point", mDevInodeCheckPointPtrMap.size()));
-        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM,
-                                               "Too many check point:" + ToString(mDevInodeCheckPointPtrMap.size()));
+    for (size_t i = 0; i < fileCheckPoints.size(); ++i) {
+        const CheckPoint* checkPointPtr = fileCheckPoints[i];
+        Json::Value leaf;
+        leaf["file_name"] = Json::Value(checkPointPtr->mFileName);
+        leaf["real_file_name"] = Json::Value(checkPointPtr->mRealFileName);
+        leaf["offset"] = Json::Value(ToString(checkPointPtr->mOffset));
+        leaf["sig_size"] = Json::Value(Json::UInt(checkPointPtr->mSignatureSize));
+        leaf["sig_hash"] = Json::Value(Json::UInt64(checkPointPtr->mSignatureHash));
+        leaf["update_time"] = Json::Value(checkPointPtr->mLastUpdateTime);
+        leaf["inode"] = Json::Value(Json::UInt64(checkPointPtr->mDevInode.inode));
+        leaf["dev"] = Json::Value(Json::UInt64(checkPointPtr->mDevInode.dev));
+        leaf["file_open"] = Json::Value(checkPointPtr->mFileOpenFlag);
+        leaf["config_name"] = Json::Value(checkPointPtr->mConfigName);
+        // forward compatible
+        leaf["sig"] = Json::Value(string(""));
+        // use filename + dev + inode + configName to prevent same filename conflict
+        root[checkPointPtr->mFileName + "*" + ToString(checkPointPtr->mDevInode.dev) + "*"
+             + ToString(checkPointPtr->mDevInode.inode) + "*" + checkPointPtr->mConfigName]
+            = leaf;
     }
 
-
     Json::Value dirJson;
-    for (unordered_map<string, DirCheckPointPtr>::iterator it = mDirNameMap.begin(); it != mDirNameMap.end(); ++it) {
+    for (auto it = dirCheckPoints.begin(); it != dirCheckPoints.end(); ++it) {
         DirCheckPoint* ptr = it->second.get();
         Json::Value value;
         for (set<string>::iterator itr = ptr->mSubDir.begin(); itr != ptr->mSubDir.end(); ++itr) {
@@ -400,9 +560,17 @@ bool CheckPointManager::DumpCheckPointToLocal() {
                                                std::string("rename check point file fail, errno ") + ToString(errno));
         return false;
     }
+    // Remove checkpoint store which is out of date, so that it is never loaded.
+    CheckPointStore* store = getStore();
+    if (CheckExistance(store->GetFileName())) {
+        LOG_INFO(sLogger, ("remove checkpoint store replaced by json checkpoint file", store->GetFileName()));
+        remove(store->GetFileName().c_str());
+        mStore.reset();
+    }
     LOG_DEBUG(sLogger,
-              ("dump checkpoint, version", INT32_FLAG(check_point_version))(
-                  "file check point", mDevInodeCheckPointPtrMap.size())("dir check point", mDirNameMap.size()));
+              ("dump checkpoint, version", INT32_FLAG(check_point_version))("file check point",
+                                                                            fileCheckPoints.size())(
+                  "dir check point", dirCheckPoints.size()));
 
     return true;
 }
@@ -520,6 +688,9 @@ void CheckPointManager::RemoveLocalCheckPoint() {
     std::string checkPointFile = AppConfig::GetInstance()->GetCheckPointFilePath();
     if (remove(checkPointFile.c_str()) == -1) {
     }
+    std::lock_guard<std::mutex> lock(mDumpMux);
+    remove(getStore()->GetFileName().c_str());
+    mStore.reset();
 }
 
 void CheckPointManager::PrintStatus() {
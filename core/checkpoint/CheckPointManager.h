@@ -17,8 +17,12 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <unordered_map>
 #include <set>
+#include <vector>
 #include <ctime>
 #include <json/json.h>
 #include <boost/optional.hpp>
@@ -78,6 +82,8 @@ public:
 typedef std::shared_ptr<DirCheckPoint> DirCheckPointPtr;
 typedef std::shared_ptr<CheckPoint> CheckPointPtr;
 
+class CheckPointStore;
+
 class CheckPointManager {
 public:
     struct CheckPointKey {
@@ -107,8 +113,32 @@ private:
     int32_t mLastDumpTime;
     int32_t mLoadVersion;
     int32_t mReaderCount;
-    CheckPointManager()
-        : mLastCheckTime(time(NULL)), mLastDumpTime(time(NULL)), mLoadVersion(NO_CHECKPOINT_VERSION), mReaderCount(0) {}
+
+    // Held while checkpoints are written, by dispatcher thread or dump thread.
+    std::mutex mDumpMux;
+    std::unique_ptr<CheckPointStore> mStore;
+    // Checkpoints moved by DumpCheckPointInBackground and not written yet.
+    std::mutex mPendingMux;
+    std::condition_variable mPendingCV;
+    bool mHasPending;
+    DevInodeCheckPointHashMap mPendingFileCheckPoints;
+    std::unordered_map<std::string, DirCheckPointPtr> mPendingDirCheckPoints;
+    bool mStopDumpThread;
+    std::unique_ptr<std::thread> mDumpThreadPtr;
+
+    CheckPointManager();
+    ~CheckPointManager();
+
+    CheckPointStore* getStore();
+    bool loadFromStore();
+    // dumpCheckPoints writes checkpoints to checkpoint store or json file, mDumpMux must be held.
+    bool dumpCheckPoints(const DevInodeCheckPointHashMap& fileCheckPoints,
+                         const std::unordered_map<std::string, DirCheckPointPtr>& dirCheckPoints);
+    bool dumpToStore(const std::vector<const CheckPoint*>& fileCheckPoints,
+                     const std::unordered_map<std::string, DirCheckPointPtr>& dirCheckPoints);
+    bool dumpToJson(const std::vector<const CheckPoint*>& fileCheckPoints,
+                    const std::unordered_map<std::string, DirCheckPointPtr>& dirCheckPoints);
+    void runDumpLoop();
 
 public:
     bool CheckVersion();
@@ -120,6 +150,9 @@ public:
     void LoadDirCheckPoint(const Json::Value& root);
     void LoadFileCheckPoint(const Json::Value& root);
     bool DumpCheckPointToLocal();
+    // DumpCheckPointInBackground moves all checkpoints to the dump thread, which writes them
+    //  like DumpCheckPointToLocal. Checkpoints are removed from manager as RemoveAllCheckPoint.
+    void DumpCheckPointInBackground();
     int32_t GetReaderCount();
     bool GetCheckPoint(DevInode devInode, const std::string& configName, CheckPointPtr& checkPointPtr);
     bool GetDirCheckPoint(const std::string& filename, DirCheckPointPtr& checkPointPtr);
@@ -0,0 +1,410 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CheckPointStore.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "common/ErrorUtil.h"
+#include "common/FileSystemUtil.h"
+#include "common/HashUtil.h"
+#include "common/StringTools.h"
+
+namespace logtail {
+
+namespace {
+
+const char kStoreMagic[8] = {'L', 'T', 'C', 'K', 'P', 'T', '0', '1'};
+const uint32_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+// Small files are not rewritten to drop overwritten records.
+const int64_t kMinRewriteSize = 1024 * 1024;
+
+enum RecordOp : uint8_t { kRecordPut = 1, kRecordDelete = 2 };
+enum KeyType : uint8_t { kFileKey = 1, kDirKey = 2 };
+
+template <typename T>
+inline void AppendValue(std::string& buffer, T value) {
+    buffer.append((const char*)&value, sizeof(T));
+}
+
+inline void AppendString(std::string& buffer, const std::string& value) {
+    AppendValue<uint32_t>(buffer, value.size());
+    buffer.append(value);
+}
+
+inline uint32_t BodyChecksum(const char* data, size_t size) {
+    return (uint32_t)HashSignatureString(data, size);
+}
+
+// Cursor decodes values from a record body, all reads fail after the end is exceeded.
+class Cursor {
+public:
+    Cursor(const char* data, size_t size) : mPos(data), mEnd(data + size) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        if (mEnd - mPos < (ptrdiff_t)sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, mPos, sizeof(T));
+        mPos += sizeof(T);
+        return true;
+    }
+
+    bool ReadString(std::string& value) {
+        uint32_t size = 0;
+        if (!Read(size) || (size_t)(mEnd - mPos) < size) {
+            return false;
+        }
+        value.assign(mPos, size);
+        mPos += size;
+        return true;
+    }
+
+    bool Empty() const { return mPos == mEnd; }
+
+private:
+    const char* mPos;
+    const char* mEnd;
+};
+
+bool DecodeFileCheckPoint(const std::string& key, const char* value, size_t size, CheckPointPtr& cpt) {
+    Cursor keyCursor(key.data() + 1, key.size() - 1);
+    DevInode devInode;
+    if (!keyCursor.Read(devInode.dev) || !keyCursor.Read(devInode.inode)) {
+        return false;
+    }
+    cpt = std::make_shared<CheckPoint>();
+    cpt->mDevInode = devInode;
+    cpt->mConfigName.assign(key, 1 + 2 * sizeof(uint64_t), std::string::npos);
+
+    Cursor cursor(value, size);
+    return cursor.ReadString(cpt->mFileName) && cursor.ReadString(cpt->mRealFileName) && cursor.Read(cpt->mOffset)
+        && cursor.Read(cpt->mSignatureSize) && cursor.Read(cpt->mSignatureHash) && cursor.Read(cpt->mLastUpdateTime)
+        && cursor.Read(cpt->mFileOpenFlag) && cursor.Empty();
+}
+
+bool DecodeDirCheckPoint(const std::string& key, const char* value, size_t size, DirCheckPointPtr& cpt) {
+    cpt = std::make_shared<DirCheckPoint>();
+    cpt->mParentName.assign(key, 1, std::string::npos);
+
+    Cursor cursor(value, size);
+    uint32_t subDirCount = 0;
+    if (!cursor.Read(cpt->mUpdateTime) || !cursor.Read(subDirCount)) {
+        return false;
+    }
+    std::string subDir;
+    for (uint32_t i = 0; i < subDirCount; ++i) {
+        if (!cursor.ReadString(subDir)) {
+            return false;
+        }
+        cpt->mSubDir.insert(cpt->mSubDir.end(), subDir);
+    }
+    return cursor.Empty();
+}
+
+} // namespace
+
+void CheckPointStore::encodeFileKey(const CheckPoint& cpt, std::string& key) {
+    key.clear();
+    AppendValue<uint8_t>(key, kFileKey);
+    AppendValue<uint64_t>(key, cpt.mDevInode.dev);
+    AppendValue<uint64_t>(key, cpt.mDevInode.inode);
+    key.append(cpt.mConfigName);
+}
+
+void CheckPointStore::encodeFileValue(const CheckPoint& cpt, std::string& body) {
+    AppendString(body, cpt.mFileName);
+    AppendString(body, cpt.mRealFileName);
+    AppendValue<int64_t>(body, cpt.mOffset);
+    AppendValue<uint32_t>(body, cpt.mSignatureSize);
+    AppendValue<uint64_t>(body, cpt.mSignatureHash);
+    AppendValue<int32_t>(body, cpt.mLastUpdateTime);
+    AppendValue<int32_t>(body, cpt.mFileOpenFlag);
+}
+
+void CheckPointStore::encodeDirValue(const DirCheckPoint& cpt, std::string& body) {
+    AppendValue<int32_t>(body, cpt.mUpdateTime);
+    AppendValue<uint32_t>(body, cpt.mSubDir.size());
+    for (auto& subDir : cpt.mSubDir) {
+        AppendString(body, subDir);
+    }
+}
+
+void CheckPointStore::appendRecord(const std::string& body, std::string& buffer) {
+    AppendValue<uint32_t>(buffer, body.size());
+    AppendValue<uint32_t>(buffer, BodyChecksum(body.data(), body.size()));
+    buffer.append(body);
+}
+
+bool CheckPointStore::Load(std::vector<CheckPointPtr>& fileCheckPoints,
+                           std::vector<DirCheckPointPtr>& dirCheckPoints,
+                           std::string& errorMessage) {
+    mIndex.clear();
+    mLiveSize = 0;
+    mFileSize = 0;
+    mNeedRewrite = true;
+
+    FILE* file = FileReadOnlyOpen(mFileName.c_str(), "rb");
+    if (file == NULL) {
+        if (GetErrno() != ENOENT) {
+            errorMessage = "open file error:" + mFileName + ", error:" + ErrnoToString(GetErrno());
+        }
+        return false;
+    }
+    std::string content;
+    FSeek(file, 0, SEEK_END);
+    int64_t fileSize = FTell(file);
+    FSeek(file, 0, SEEK_SET);
+    if (fileSize > 0) {
+        content.resize(fileSize);
+        content.resize(fread(&content[0], 1, fileSize, file));
+    }
+    fclose(file);
+    if (content.size() < sizeof(kStoreMagic) || memcmp(content.data(), kStoreMagic, sizeof(kStoreMagic)) != 0) {
+        errorMessage = "invalid file header:" + mFileName + ", size:" + ToString(content.size());
+        return false;
+    }
+
+    // Offset and size of the put body of each live key.
+    std::unordered_map<std::string, std::pair<size_t, uint32_t>> liveBodies;
+    size_t pos = sizeof(kStoreMagic);
+    std::string recordKey;
+    while (pos + kRecordHeaderSize <= content.size()) {
+        uint32_t bodySize = 0, checksum = 0;
+        memcpy(&bodySize, content.data() + pos, sizeof(uint32_t));
+        memcpy(&checksum, content.data() + pos + sizeof(uint32_t), sizeof(uint32_t));
+        size_t bodyPos = pos + kRecordHeaderSize;
+        if (content.size() - bodyPos < bodySize || BodyChecksum(content.data() + bodyPos, bodySize) != checksum) {
+            break;
+        }
+        Cursor cursor(content.data() + bodyPos, bodySize);
+        uint8_t op = 0;
+        if (!cursor.Read(op) || !cursor.ReadString(recordKey) || recordKey.empty()) {
+            break;
+        }
+        if (op == kRecordPut) {
+            liveBodies[recordKey] = std::make_pair(bodyPos, bodySize);
+        } else {
+            liveBodies.erase(recordKey);
+        }
+        pos = bodyPos + bodySize;
+    }
+    mNeedRewrite = pos != content.size();
+    if (mNeedRewrite) {
+        errorMessage = "broken record in file:" + mFileName + ", offset:" + ToString(pos)
+            + ", size:" + ToString(content.size());
+    }
+    mFileSize = pos;
+
+    for (auto& item : liveBodies) {
+        const std::string& key = item.first;
+        size_t valuePos = item.second.first + sizeof(uint8_t) + sizeof(uint32_t) + key.size();
+        size_t valueSize = item.second.first + item.second.second - valuePos;
+        bool decoded = false;
+        if (key[0] == kFileKey) {
+            CheckPointPtr cpt;
+            if ((decoded = DecodeFileCheckPoint(key, content.data() + valuePos, valueSize, cpt))) {
+                fileCheckPoints.push_back(cpt);
+            }
+        } else if (key[0] == kDirKey) {
+            DirCheckPointPtr cpt;
+            if ((decoded = DecodeDirCheckPoint(key, content.data() + valuePos, valueSize, cpt))) {
+                dirCheckPoints.push_back(cpt);
+            }
+        }
+        if (!decoded) {
+            mNeedRewrite = true;
+            continue;
+        }
+        RecordInfo& info = mIndex[key];
+        info.mDigest = (uint64_t)HashSignatureString(content.data() + item.second.first, item.second.second);
+        info.mSize = kRecordHeaderSize + item.second.second;
+        mLiveSize += info.mSize;
+    }
+    return true;
+}
+
+void CheckPointStore::diffRecord(const std::string& key, std::vector<std::pair<std::string, RecordInfo>>& updates) {
+    uint64_t digest = (uint64_t)HashSignatureString(mBody.data(), mBody.size());
+    auto it = mIndex.find(key);
+    if (it != mIndex.end()) {
+        it->second.mDumpSeq = mDumpSeq;
+        if (it->second.mDigest == digest) {
+            return;
+        }
+    }
+    RecordInfo info;
+    info.mDigest = digest;
+    info.mSize = kRecordHeaderSize + mBody.size();
+    info.mDumpSeq = mDumpSeq;
+    updates.emplace_back(key, info);
+    appendRecord(mBody, mPending);
+}
+
+bool CheckPointStore::Dump(const std::vector<const CheckPoint*>& fileCheckPoints,
+                           const std::vector<const DirCheckPoint*>& dirCheckPoints,
+                           std::string& errorMessage) {
+    mLastAppendCount = 0;
+    if (mNeedRewrite) {
+        return rewrite(fileCheckPoints, dirCheckPoints, errorMessage);
+    }
+
+    ++mDumpSeq;
+    mPending.clear();
+    std::vector<std::pair<std::string, RecordInfo>> updates;
+    for (auto cpt : fileCheckPoints) {
+        encodeFileKey(*cpt, mKey);
+        mBody.clear();
+        AppendValue<uint8_t>(mBody, kRecordPut);
+        AppendString(mBody, mKey);
+        encodeFileValue(*cpt, mBody);
+        diffRecord(mKey, updates);
+    }
+    for (auto cpt : dirCheckPoints) {
+        mKey.clear();
+        AppendValue<uint8_t>(mKey, kDirKey);
+        mKey.append(cpt->mParentName);
+        mBody.clear();
+        AppendValue<uint8_t>(mBody, kRecordPut);
+        AppendString(mBody, mKey);
+        encodeDirValue(*cpt, mBody);
+        diffRecord(mKey, updates);
+    }
+
+    int64_t liveSize = mLiveSize;
+    std::vector<std::string> deletedKeys;
+    for (auto& item : mIndex) {
+        if (item.second.mDumpSeq != mDumpSeq) {
+            deletedKeys.push_back(item.first);
+            liveSize -= item.second.mSize;
+            mBody.clear();
+            AppendValue<uint8_t>(mBody, kRecordDelete);
+            AppendString(mBody, item.first);
+            appendRecord(mBody, mPending);
+        }
+    }
+    if (mPending.empty()) {
+        return true;
+    }
+    for (auto& update : updates) {
+        auto it = mIndex.find(update.first);
+        if (it != mIndex.end()) {
+            liveSize -= it->second.mSize;
+        }
+        liveSize += update.second.mSize;
+    }
+    int64_t fileSize = mFileSize + (int64_t)mPending.size();
+    if (fileSize > kMinRewriteSize && fileSize > 2 * liveSize) {
+        return rewrite(fileCheckPoints, dirCheckPoints, errorMessage);
+    }
+
+    if (!appendPending(errorMessage)) {
+        mNeedRewrite = true;
+        return false;
+    }
+    mLastAppendCount = updates.size() + deletedKeys.size();
+    for (auto& key : deletedKeys) {
+        mIndex.erase(key);
+    }
+    for (auto& update : updates) {
+        mIndex[update.first] = update.second;
+    }
+    mLiveSize = liveSize;
+    return true;
+}
+
+bool CheckPointStore::appendPending(std::string& errorMessage) {
+    FILE* file = FileAppendOpen(mFileName.c_str(), "ab");
+    if (file == NULL) {
+        errorMessage = "open file error:" + mFileName + ", error:" + ErrnoToString(GetErrno());
+        return false;
+    }
+    size_t nbytes = fwrite(mPending.data(), 1, mPending.size(), file);
+    bool result = nbytes == mPending.size() && fflush(file) == 0;
+    if (!result) {
+        errorMessage = "write file error:" + mFileName + ", error:" + ErrnoToString(GetErrno())
+            + ", nbytes:" + ToString(nbytes) + ", size:" + ToString(mPending.size());
+    }
+    fclose(file);
+    mFileSize += nbytes;
+    return result;
+}
+
+bool CheckPointStore::rewrite(const std::vector<const CheckPoint*>& fileCheckPoints,
+                              const std::vector<const DirCheckPoint*>& dirCheckPoints,
+                              std::string& errorMessage) {
+    ++mDumpSeq;
+    mPending.assign(kStoreMagic, sizeof(kStoreMagic));
+    std::unordered_map<std::string, RecordInfo> index;
+    index.reserve(fileCheckPoints.size() + dirCheckPoints.size());
+    for (size_t i = 0; i < fileCheckPoints.size() + dirCheckPoints.size(); ++i) {
+        mBody.clear();
+        AppendValue<uint8_t>(mBody, kRecordPut);
+        if (i < fileCheckPoints.size()) {
+            encodeFileKey(*fileCheckPoints[i], mKey);
+            AppendString(mBody, mKey);
+            encodeFileValue(*fileCheckPoints[i], mBody);
+        } else {
+            const DirCheckPoint* cpt = dirCheckPoints[i - fileCheckPoints.size()];
+            mKey.clear();
+            AppendValue<uint8_t>(mKey, kDirKey);
+            mKey.append(cpt->mParentName);
+            AppendString(mBody, mKey);
+            encodeDirValue(*cpt, mBody);
+        }
+        appendRecord(mBody, mPending);
+        RecordInfo& info = index[mKey];
+        info.mDigest = (uint64_t)HashSignatureString(mBody.data(), mBody.size());
+        info.mSize = kRecordHeaderSize + mBody.size();
+        info.mDumpSeq = mDumpSeq;
+    }
+
+    std::string tmpFileName = mFileName + ".bak";
+    FILE* file = FileWriteOnlyOpen(tmpFileName.c_str(), "wb");
+    if (file == NULL) {
+        errorMessage = "open file error:" + tmpFileName + ", error:" + ErrnoToString(GetErrno());
+        mNeedRewrite = true;
+        return false;
+    }
+    size_t nbytes = fwrite(mPending.data(), 1, mPending.size(), file);
+    if (nbytes != mPending.size() || fflush(file) != 0) {
+        errorMessage = "write file error:" + tmpFileName + ", error:" + ErrnoToString(GetErrno())
+            + ", nbytes:" + ToString(nbytes) + ", size:" + ToString(mPending.size());
+        fclose(file);
+        mNeedRewrite = true;
+        return false;
+    }
+    fclose(file);
+#if defined(_MSC_VER)
+    // The rename on Windows will fail if the destination is existing.
+    remove(mFileName.c_str());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    if (rename(tmpFileName.c_str(), mFileName.c_str()) == -1) {
+        errorMessage = "rename file error:" + tmpFileName + ", error:" + ErrnoToString(GetErrno());
+        mNeedRewrite = true;
+        return false;
+    }
+
+    mIndex.swap(index);
+    mFileSize = mPending.size();
+    mLiveSize = mFileSize - sizeof(kStoreMagic);
+    mNeedRewrite = false;
+    mLastAppendCount = mIndex.size();
+    return true;
+}
+
+} // namespace logtail
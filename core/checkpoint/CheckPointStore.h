@@ -0,0 +1,111 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CheckPointManager.h"
+
+namespace logtail {
+
+// CheckPointStore persists file and dir checkpoints of CheckPointManager as binary records
+//  appended to one file.
+//
+// Each dump only appends records of checkpoints which are changed since last dump, and
+//  delete records of checkpoints which are gone. The file is rewritten with live records
+//  only when overwritten and deleted records take more than half of it, or a broken
+//  record is found when loading.
+//
+// Record layout: body size (uint32), body checksum (uint32), body. Body is an operation
+//  (uint8), key size (uint32), key, and the encoded checkpoint for put operations.
+// It is not thread-safe.
+class CheckPointStore {
+public:
+    explicit CheckPointStore(const std::string& fileName) : mFileName(fileName) {}
+
+    const std::string& GetFileName() const { return mFileName; }
+    int64_t GetFileSize() const { return mFileSize; }
+    // GetLiveCount returns the count of checkpoints in file.
+    size_t GetLiveCount() const { return mIndex.size(); }
+    // GetLastAppendCount returns the count of records written by last dump, all live
+    //  records are counted if the file was rewritten.
+    size_t GetLastAppendCount() const { return mLastAppendCount; }
+
+    // Load replays records in file and appends alive checkpoints to @fileCheckPoints and
+    //  @dirCheckPoints. Records from the first broken one are discarded, and @errorMessage
+    //  is set then.
+    //
+    // @return false if the file does not exist or can not be read, @errorMessage is set
+    //  if the file exists.
+    bool Load(std::vector<CheckPointPtr>& fileCheckPoints,
+              std::vector<DirCheckPointPtr>& dirCheckPoints,
+              std::string& errorMessage);
+
+    // Dump makes the file hold exactly @fileCheckPoints and @dirCheckPoints.
+    //  Nothing is written if no checkpoint is changed since last dump.
+    //
+    // If it fails, the file is rewritten in next dump.
+    bool Dump(const std::vector<const CheckPoint*>& fileCheckPoints,
+              const std::vector<const DirCheckPoint*>& dirCheckPoints,
+              std::string& errorMessage);
+
+private:
+    struct RecordInfo {
+        // Hash of the put body, to find changed checkpoints.
+        uint64_t mDigest = 0;
+        // Size of the put record in file.
+        uint32_t mSize = 0;
+        // Sequence of the last dump which contains this checkpoint.
+        uint64_t mDumpSeq = 0;
+    };
+
+    static void encodeFileKey(const CheckPoint& cpt, std::string& key);
+    static void encodeFileValue(const CheckPoint& cpt, std::string& body);
+    static void encodeDirValue(const DirCheckPoint& cpt, std::string& body);
+    static void appendRecord(const std::string& body, std::string& buffer);
+
+    // diffRecord appends the put record whose body is in mBody to mPending if the
+    //  checkpoint is not in index or changed since last dump.
+    void diffRecord(const std::string& key, std::vector<std::pair<std::string, RecordInfo>>& updates);
+    bool appendPending(std::string& errorMessage);
+    bool rewrite(const std::vector<const CheckPoint*>& fileCheckPoints,
+                 const std::vector<const DirCheckPoint*>& dirCheckPoints,
+                 std::string& errorMessage);
+
+    std::string mFileName;
+    int64_t mFileSize = 0;
+    // Live checkpoints in file, indexed by encoded key.
+    std::unordered_map<std::string, RecordInfo> mIndex;
+    // Total size of live records in file.
+    int64_t mLiveSize = 0;
+    uint64_t mDumpSeq = 0;
+    // Set when file is missing, broken or a write failed, then next dump rewrites it.
+    bool mNeedRewrite = true;
+    size_t mLastAppendCount = 0;
+
+    // Buffers reused between dumps.
+    std::string mKey;
+    std::string mBody;
+    std::string mPending;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class CheckPointStoreUnittest;
+#endif
+};
+
+} // namespace logtail
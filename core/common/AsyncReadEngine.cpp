@@ -0,0 +1,318 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AsyncReadEngine.h"
+#include <cerrno>
+#include <cstring>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+// liburing is not required, the ring is set up with raw syscalls so that the
+//  binary still runs (with pread) on kernels older than 5.1.
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define LOGTAIL_IO_URING_SUPPORTED 1
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+#include "common/Flags.h"
+#include "logger/Logger.h"
+
+DEFINE_FLAG_STRING(file_read_backend, "backend to read log files, pread or io_uring", "pread");
+DEFINE_FLAG_INT32(io_uring_queue_depth, "entries of io_uring submission queue", 256);
+DEFINE_FLAG_INT32(io_uring_submit_batch, "queued reads are submitted when count reaches the batch", 32);
+
+namespace logtail {
+
+AsyncReadEngine::AsyncReadEngine() {
+    if (STRING_FLAG(file_read_backend) != "io_uring") {
+        return;
+    }
+    if (init(static_cast<uint32_t>(INT32_FLAG(io_uring_queue_depth)))) {
+        LOG_INFO(sLogger, ("file read backend", "io_uring")("queue depth", mEntries));
+    } else {
+        LOG_WARNING(sLogger, ("io_uring is not supported", "fallback to pread")("errno", errno));
+    }
+}
+
+AsyncReadEngine::~AsyncReadEngine() {
+#if defined(LOGTAIL_IO_URING_SUPPORTED)
+    if (mSqes != NULL) {
+        munmap(mSqes, mSqesSize);
+    }
+    if (mCqRing != NULL && mCqRing != mSqRing) {
+        munmap(mCqRing, mCqRingSize);
+    }
+    if (mSqRing != NULL) {
+        munmap(mSqRing, mSqRingSize);
+    }
+    if (mRingFd >= 0) {
+        close(mRingFd);
+    }
+#endif
+}
+
+bool AsyncReadEngine::init(uint32_t entries) {
+#if defined(LOGTAIL_IO_URING_SUPPORTED)
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return false;
+    }
+
+    mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = false;
+#if defined(IORING_FEAT_SINGLE_MMAP)
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        singleMmap = true;
+        if (mCqRingSize > mSqRingSize) {
+            mSqRingSize = mCqRingSize;
+        }
+        mCqRingSize = mSqRingSize;
+    }
+#endif
+    void* sqRing = mmap(NULL, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    void* cqRing = sqRing;
+    if (!singleMmap) {
+        cqRing = mmap(NULL, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            munmap(sqRing, mSqRingSize);
+            close(fd);
+            return false;
+        }
+    }
+    mSqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (cqRing != sqRing) {
+            munmap(cqRing, mCqRingSize);
+        }
+        munmap(sqRing, mSqRingSize);
+        close(fd);
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sqRing);
+    char* cq = static_cast<char*>(cqRing);
+    mSqRing = sqRing;
+    mCqRing = cqRing;
+    mSqes = sqes;
+    mSqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    mSqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    mCqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    mCqes = cq + params.cq_off.cqes;
+    mEntries = params.sq_entries;
+    mRingFd = fd;
+    return true;
+#else
+    (void)entries;
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+AsyncReadRequestPtr
+AsyncReadEngine::Submit(int fd, const ReadBufferPtr& buffer, size_t size, int64_t offset, bool flush) {
+#if defined(LOGTAIL_IO_URING_SUPPORTED)
+    if (!IsEnabled()) {
+        return AsyncReadRequestPtr();
+    }
+    AsyncReadRequestPtr request = std::make_shared<AsyncReadRequest>();
+    request->fd = fd;
+    request->offset = offset;
+    request->size = size;
+    request->buffer = buffer;
+    request->iov.iov_base = buffer.get();
+    request->iov.iov_len = size;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    // Keep inflight reads within the submission queue, so neither queue can overflow
+    //  (completion queue has twice the entries).
+    while (mInflightRequests.size() >= mEntries) {
+        flushLocked();
+        if (mPolling) {
+            mCond.wait(lock);
+            continue;
+        }
+        reapLocked();
+        if (mInflightRequests.size() < mEntries) {
+            break;
+        }
+        // Wait for a batch of slots rather than one, or each following submit enters kernel again.
+        uint32_t minComplete = static_cast<uint32_t>(INT32_FLAG(io_uring_submit_batch));
+        if (minComplete < 1 || minComplete > mInflightRequests.size()) {
+            minComplete = 1;
+        }
+        mPolling = true;
+        lock.unlock();
+        enter(0, minComplete);
+        lock.lock();
+        mPolling = false;
+        reapLocked();
+        mCond.notify_all();
+    }
+
+    const uint64_t id = ++mNextId;
+    request->id = id;
+    const unsigned tail = *mSqTail;
+    const unsigned index = tail & *mSqMask;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(mSqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->off = static_cast<uint64_t>(offset);
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iov);
+    sqe->len = 1;
+    sqe->user_data = id;
+    mSqArray[index] = index;
+    __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+    ++mPendingCount;
+    mInflightRequests[id] = request;
+
+    if (flush || mPendingCount >= static_cast<uint32_t>(INT32_FLAG(io_uring_submit_batch))) {
+        flushLocked();
+    }
+    return request;
+#else
+    (void)fd;
+    (void)buffer;
+    (void)size;
+    (void)offset;
+    (void)flush;
+    return AsyncReadRequestPtr();
+#endif
+}
+
+void AsyncReadEngine::Flush() {
+    if (!IsEnabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    flushLocked();
+}
+
+int64_t AsyncReadEngine::Wait(const AsyncReadRequestPtr& request) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    flushLocked();
+    // Only the thread waiting in kernel reaps completions, others wait for its notification,
+    //  otherwise the completion it waits for may be consumed by others and it never wakes up.
+    while (!request->done) {
+        if (mPolling) {
+            mCond.wait(lock);
+            continue;
+        }
+        reapLocked();
+        if (request->done) {
+            break;
+        }
+        // Reads are mostly completed in submission order, wait for the ones submitted before
+        //  @request together, it saves syscalls when a caller waits for a batch of reads.
+        uint32_t minComplete = 0;
+        for (const auto& inflight : mInflightRequests) {
+            if (inflight.first <= request->id) {
+                ++minComplete;
+            }
+        }
+        mPolling = true;
+        lock.unlock();
+        enter(0, minComplete);
+        lock.lock();
+        mPolling = false;
+        reapLocked();
+        mCond.notify_all();
+    }
+    return request->result;
+}
+
+void AsyncReadEngine::flushLocked() {
+    while (mPendingCount > 0) {
+        int ret = enter(mPendingCount, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            const int error = errno;
+            LOG_ERROR(sLogger, ("submit io_uring reads failed", strerror(error))("pending", mPendingCount));
+            failPendingLocked(-error);
+            return;
+        }
+        mPendingCount -= static_cast<uint32_t>(ret) > mPendingCount ? mPendingCount : static_cast<uint32_t>(ret);
+    }
+}
+
+void AsyncReadEngine::failPendingLocked(int64_t result) {
+#if defined(LOGTAIL_IO_URING_SUPPORTED)
+    // Unsubmitted entries are the last mPendingCount ones of the submission queue, take them back
+    //  and complete their requests, so that nobody waits for completions which never arrive.
+    const unsigned tail = *mSqTail;
+    for (unsigned pos = tail - mPendingCount; pos != tail; ++pos) {
+        const struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(mSqes) + mSqArray[pos & *mSqMask];
+        auto iter = mInflightRequests.find(sqe->user_data);
+        if (iter != mInflightRequests.end()) {
+            iter->second->result = result;
+            iter->second->done = true;
+            mInflightRequests.erase(iter);
+        }
+    }
+    __atomic_store_n(mSqTail, tail - mPendingCount, __ATOMIC_RELEASE);
+    mPendingCount = 0;
+    mCond.notify_all();
+#else
+    (void)result;
+#endif
+}
+
+void AsyncReadEngine::reapLocked() {
+#if defined(LOGTAIL_IO_URING_SUPPORTED)
+    unsigned head = *mCqHead;
+    const unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const struct io_uring_cqe* cqe = static_cast<struct io_uring_cqe*>(mCqes) + (head & *mCqMask);
+        auto iter = mInflightRequests.find(cqe->user_data);
+        if (iter != mInflightRequests.end()) {
+            iter->second->result = cqe->res;
+            iter->second->done = true;
+            mInflightRequests.erase(iter);
+        }
+        ++head;
+        mCompleteCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+#endif
+}
+
+int AsyncReadEngine::enter(uint32_t toSubmit, uint32_t minComplete) {
+#if defined(LOGTAIL_IO_URING_SUPPORTED)
+    mEnterCount.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<int>(syscall(
+        __NR_io_uring_enter, mRingFd, toSubmit, minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0));
+#else
+    (void)toSubmit;
+    (void)minComplete;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+} // namespace logtail
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#if defined(__linux__)
+#include <sys/uio.h>
+#endif
+#include "ReadBufferPool.h"
+
+namespace logtail {
+
+// AsyncReadRequest is a read submitted to AsyncReadEngine, the buffer is owned by the request
+//  so that it stays valid until the kernel completes the read, even if the caller gives up.
+struct AsyncReadRequest {
+    uint64_t id = 0;
+    int fd = -1;
+    int64_t offset = 0;
+    size_t size = 0;
+    ReadBufferPtr buffer;
+    // Bytes read or -errno, valid after done is set.
+    int64_t result = 0;
+    bool done = false;
+#if defined(__linux__)
+    struct iovec iov;
+#endif
+};
+typedef std::shared_ptr<AsyncReadRequest> AsyncReadRequestPtr;
+
+// AsyncReadEngine submits file reads to a shared io_uring instance.
+//
+// Reads of all readers go to the same submission queue and are submitted with one
+//  io_uring_enter when a caller flushes or waits, which saves a syscall per read and
+//  lets readers issue the next chunk before the current one is processed.
+// The engine is disabled (IsEnabled returns false) when flag file_read_backend is not
+//  io_uring or the kernel/container does not support io_uring, callers should use
+//  LogFileOperator::Pread in this case.
+class AsyncReadEngine {
+public:
+    static AsyncReadEngine* GetInstance() {
+        static auto singleton = new AsyncReadEngine;
+        return singleton;
+    }
+
+    bool IsEnabled() const { return mRingFd >= 0; }
+
+    // Submit queues a read of @size bytes at @offset of @fd into @buffer.
+    // Queued reads are passed to kernel when @flush is true, pending reads reach
+    //  the batch size or someone waits.
+    // Returns NULL if the engine is disabled.
+    AsyncReadRequestPtr Submit(int fd, const ReadBufferPtr& buffer, size_t size, int64_t offset, bool flush = true);
+
+    // Flush passes all queued reads to kernel.
+    void Flush();
+
+    // Wait blocks until @request completes, returns bytes read or -errno.
+    int64_t Wait(const AsyncReadRequestPtr& request);
+
+    // Count of io_uring_enter calls and completed reads, for benchmark and metrics.
+    uint64_t GetEnterCount() const { return mEnterCount.load(std::memory_order_relaxed); }
+    uint64_t GetCompleteCount() const { return mCompleteCount.load(std::memory_order_relaxed); }
+
+private:
+    AsyncReadEngine();
+    ~AsyncReadEngine();
+
+    bool init(uint32_t entries);
+    void flushLocked();
+    // Complete all unsubmitted reads with @result (-errno), called when they can not be submitted.
+    void failPendingLocked(int64_t result);
+    void reapLocked();
+    int enter(uint32_t toSubmit, uint32_t minComplete);
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    // There is at most one thread waiting in kernel, others wait for its notification.
+    bool mPolling = false;
+
+    int mRingFd = -1;
+    uint32_t mEntries = 0;
+    uint32_t mPendingCount = 0;
+    uint64_t mNextId = 0;
+    std::unordered_map<uint64_t, AsyncReadRequestPtr> mInflightRequests;
+
+    // Ring memory mapped from kernel.
+    void* mSqRing = NULL;
+    size_t mSqRingSize = 0;
+    void* mCqRing = NULL;
+    size_t mCqRingSize = 0;
+    void* mSqes = NULL;
+    size_t mSqesSize = 0;
+    unsigned* mSqHead = NULL;
+    unsigned* mSqTail = NULL;
+    unsigned* mSqMask = NULL;
+    unsigned* mSqArray = NULL;
+    unsigned* mCqHead = NULL;
+    unsigned* mCqTail = NULL;
+    unsigned* mCqMask = NULL;
+    void* mCqes = NULL;
+
+    std::atomic<uint64_t> mEnterCount{0};
+    std::atomic<uint64_t> mCompleteCount{0};
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class AsyncReadEngineUnittest;
+#endif
+};
+
+} // namespace logtail
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace logtail {
+
+// BoundedMPMCQueue is a lock-free ring for multiple producers and consumers.
+//
+// Each cell carries a sequence number telling whether it is ready for the producer or
+//  the consumer of current lap (Dmitry Vyukov's bounded MPMC queue), so producers and
+//  consumers only contend on their own position counter.
+// The capacity is rounded up to a power of two.
+template <class T>
+class BoundedMPMCQueue {
+public:
+    explicit BoundedMPMCQueue(size_t capacity = 1) { Reset(capacity); }
+
+    BoundedMPMCQueue(const BoundedMPMCQueue&) = delete;
+    BoundedMPMCQueue& operator=(const BoundedMPMCQueue&) = delete;
+
+    // Reset drops all items, it must not run concurrently with other methods.
+    void Reset(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mMask = size - 1;
+        mCells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            mCells[i].mSequence.store(i, std::memory_order_relaxed);
+        }
+        mEnqueuePos.store(0, std::memory_order_relaxed);
+        mDequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    size_t Capacity() const { return mMask + 1; }
+
+    bool TryPush(const T& item) {
+        Cell* cell = NULL;
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &mCells[pos & mMask];
+            size_t seq = cell->mSequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Full, or the consumer of previous lap has not released the cell yet.
+                return false;
+            } else {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->mData = item;
+        cell->mSequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item) {
+        Cell* cell = NULL;
+        size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &mCells[pos & mMask];
+            size_t seq = cell->mSequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Empty, or the producer has not finished writing the cell yet.
+                return false;
+            } else {
+                pos = mDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = cell->mData;
+        cell->mSequence.store(pos + mMask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> mSequence;
+        T mData;
+    };
+
+    // Keep positions on different cache lines, they are written by different threads.
+    // Padding is used instead of alignas, heap allocation is not over-aligned before C++17.
+    std::atomic<size_t> mEnqueuePos;
+    char mEnqueuePad[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> mDequeuePos;
+    char mDequeuePad[64 - sizeof(std::atomic<size_t>)];
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask = 0;
+};
+
+} // namespace logtail
@@ -15,10 +15,92 @@
 #include "CompressTools.h"
 #include <zlib/zlib.h>
 #include <lz4/lz4.h>
+#include <zstd.h>
+#include <zdict.h>
 #include <cstring>
 
 namespace logtail {
 
+namespace {
+
+// Contexts are reused by the thread, creating them costs more than compressing a small log group.
+struct ZstdContext {
+    ZstdContext() : mCCtx(ZSTD_createCCtx()), mDCtx(ZSTD_createDCtx()) {}
+    ~ZstdContext() {
+        ZSTD_freeCCtx(mCCtx);
+        ZSTD_freeDCtx(mDCtx);
+    }
+
+    ZSTD_CCtx* mCCtx;
+    ZSTD_DCtx* mDCtx;
+};
+
+ZstdContext& GetZstdContext() {
+    static thread_local ZstdContext sContext;
+    return sContext;
+}
+
+} // namespace
+
+const char* CompressTypeToString(CompressType type) {
+    switch (type) {
+        case COMPRESS_ZSTD:
+            return "zstd";
+        default:
+            return "lz4";
+    }
+}
+
+bool StringToCompressType(const std::string& name, CompressType& type) {
+    if (name == "lz4") {
+        type = COMPRESS_LZ4;
+    } else if (name == "zstd") {
+        type = COMPRESS_ZSTD;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ZstdDictionary::~ZstdDictionary() {
+    ZSTD_freeCDict(mCDict);
+    ZSTD_freeDDict(mDDict);
+}
+
+std::shared_ptr<ZstdDictionary>
+ZstdDictionary::Train(const std::vector<std::string>& samples, size_t capacity, int32_t level) {
+    std::string samplesBuffer;
+    std::vector<size_t> sampleSizes;
+    sampleSizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        samplesBuffer.append(sample);
+        sampleSizes.push_back(sample.size());
+    }
+    std::string content(capacity, '\0');
+    size_t size = ZDICT_trainFromBuffer(&content[0],
+                                        content.size(),
+                                        samplesBuffer.data(),
+                                        sampleSizes.data(),
+                                        static_cast<unsigned>(sampleSizes.size()));
+    if (ZDICT_isError(size)) {
+        return std::shared_ptr<ZstdDictionary>();
+    }
+    content.resize(size);
+    return Load(content, level);
+}
+
+std::shared_ptr<ZstdDictionary> ZstdDictionary::Load(const std::string& content, int32_t level) {
+    std::shared_ptr<ZstdDictionary> dict(new ZstdDictionary);
+    dict->mContent = content;
+    dict->mId = ZSTD_getDictID_fromDict(content.data(), content.size());
+    dict->mCDict = ZSTD_createCDict(content.data(), content.size(), level);
+    dict->mDDict = ZSTD_createDDict(content.data(), content.size());
+    if (dict->mId == 0 || dict->mCDict == NULL || dict->mDDict == NULL) {
+        return std::shared_ptr<ZstdDictionary>();
+    }
+    return dict;
+}
+
 bool RawCompress(std::string& data) {
     int64_t length = compressBound(data.length());
     char* compressed = new char[length];
@@ -199,4 +281,61 @@ bool CompressLz4(const std::string& src, std::string& dst) {
     return CompressLz4(src.c_str(), src.length(), dst);
 }
 
+bool UncompressZstd(const char* srcPtr,
+                    const uint32_t srcSize,
+                    const uint32_t rawSize,
+                    std::string& dst,
+                    const ZstdDictionary* dict) {
+    static const uint32_t MAX_UMCOMPRESS_SIZE = 128 * 1024 * 1024;
+    if (rawSize > MAX_UMCOMPRESS_SIZE) {
+        return false;
+    }
+    dst.resize(rawSize);
+    ZSTD_DCtx* dctx = GetZstdContext().mDCtx;
+    size_t length = dict != NULL ? ZSTD_decompress_usingDDict(dctx, &dst[0], rawSize, srcPtr, srcSize, dict->GetDDict())
+                                 : ZSTD_decompressDCtx(dctx, &dst[0], rawSize, srcPtr, srcSize);
+    return !ZSTD_isError(length) && length == rawSize;
+}
+
+bool CompressZstd(
+    const char* srcPtr, const uint32_t srcSize, std::string& dst, int32_t level, const ZstdDictionary* dict) {
+    dst.resize(ZSTD_compressBound(srcSize));
+    ZSTD_CCtx* cctx = GetZstdContext().mCCtx;
+    size_t length = dict != NULL
+        ? ZSTD_compress_usingCDict(cctx, &dst[0], dst.size(), srcPtr, srcSize, dict->GetCDict())
+        : ZSTD_compressCCtx(cctx, &dst[0], dst.size(), srcPtr, srcSize, level);
+    if (ZSTD_isError(length)) {
+        return false;
+    }
+    dst.resize(length);
+    return true;
+}
+
+bool CompressData(CompressType type, const char* srcPtr, const uint32_t srcSize, std::string& dst, int32_t level) {
+    switch (type) {
+        case COMPRESS_ZSTD:
+            return CompressZstd(srcPtr, srcSize, dst, level);
+        default:
+            return CompressLz4(srcPtr, srcSize, dst);
+    }
+}
+
+bool CompressData(CompressType type, const std::string& src, std::string& dst, int32_t level) {
+    return CompressData(type, src.data(), src.size(), dst, level);
+}
+
+bool UncompressData(
+    CompressType type, const char* srcPtr, const uint32_t srcSize, const uint32_t rawSize, std::string& dst) {
+    switch (type) {
+        case COMPRESS_ZSTD:
+            return UncompressZstd(srcPtr, srcSize, rawSize, dst);
+        default:
+            return UncompressLz4(srcPtr, srcSize, rawSize, dst);
+    }
+}
+
+bool UncompressData(CompressType type, const std::string& src, const uint32_t rawSize, std::string& dst) {
+    return UncompressData(type, src.data(), src.size(), rawSize, dst);
+}
+
 } // namespace logtail
@@ -17,9 +17,48 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <memory>
+#include <vector>
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
 
 namespace logtail {
 
+// Codec of log groups sent to SLS, the value is recorded in buffer files, do not change it.
+enum CompressType { COMPRESS_LZ4 = 0, COMPRESS_ZSTD = 1 };
+
+// Name of codec used in config and x-log-compresstype header.
+const char* CompressTypeToString(CompressType type);
+bool StringToCompressType(const std::string& name, CompressType& type);
+
+// ZstdDictionary is a zstd dictionary with digested compression and decompression
+//  states, it can be used by multiple threads at the same time.
+class ZstdDictionary {
+public:
+    ~ZstdDictionary();
+
+    // Train builds a dictionary of at most @capacity bytes from @samples, which are
+    //  compressed with @level later. Returns NULL if there are not enough samples.
+    static std::shared_ptr<ZstdDictionary>
+    Train(const std::vector<std::string>& samples, size_t capacity, int32_t level);
+    // Load builds a dictionary from @content returned by GetContent before.
+    static std::shared_ptr<ZstdDictionary> Load(const std::string& content, int32_t level);
+
+    uint32_t GetId() const { return mId; }
+    const std::string& GetContent() const { return mContent; }
+    const ZSTD_CDict_s* GetCDict() const { return mCDict; }
+    const ZSTD_DDict_s* GetDDict() const { return mDDict; }
+
+private:
+    ZstdDictionary() = default;
+
+    std::string mContent;
+    uint32_t mId = 0;
+    ZSTD_CDict_s* mCDict = NULL;
+    ZSTD_DDict_s* mDDict = NULL;
+};
+
 bool UncompressDeflate(const std::string& src, const int64_t rawSize, std::string& dst);
 bool UncompressDeflate(const char* srcPtr, const uint32_t srcSize, const int64_t rawSize, std::string& dst);
 
@@ -33,6 +72,26 @@ bool UncompressLz4(const char* srcPtr, const uint32_t srcSize, const uint32_t ra
 bool CompressLz4(const std::string& src, std::string& dst);
 bool CompressLz4(const char* srcPtr, const uint32_t srcSize, std::string& dest);
 
+bool UncompressZstd(const char* srcPtr,
+                    const uint32_t srcSize,
+                    const uint32_t rawSize,
+                    std::string& dst,
+                    const ZstdDictionary* dict = NULL);
+
+// @level is ignored if @dict is set, the level is decided when the dictionary is built.
+bool CompressZstd(const char* srcPtr,
+                  const uint32_t srcSize,
+                  std::string& dst,
+                  int32_t level,
+                  const ZstdDictionary* dict = NULL);
+
+// Compress and uncompress with codec @type, @level is ignored by lz4.
+bool CompressData(CompressType type, const char* srcPtr, const uint32_t srcSize, std::string& dst, int32_t level);
+bool CompressData(CompressType type, const std::string& src, std::string& dst, int32_t level);
+bool UncompressData(
+    CompressType type, const char* srcPtr, const uint32_t srcSize, const uint32_t rawSize, std::string& dst);
+bool UncompressData(CompressType type, const std::string& src, const uint32_t rawSize, std::string& dst);
+
 // old mode , with 8 bytes leading raw size
 bool RawCompress(std::string& data);
 bool Compress(std::string& data);
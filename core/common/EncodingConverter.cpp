@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "EncodingConverter.h"
+#include <cstring>
 #include "LogtailAlarm.h"
 #include "logger/Logger.h"
 #if defined(__linux__)
@@ -20,6 +21,13 @@
 #elif defined(_MSC_VER)
 #include <Windows.h>
 #endif
+#if defined(__x86_64__) || defined(_M_X64)
+#define LOGTAIL_GBK_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
 
 namespace logtail {
 
@@ -27,6 +35,11 @@ namespace logtail {
 static iconv_t mGbk2Utf8Cd = (iconv_t)-1;
 #endif
 
+static const uint32_t kGbkLeadBegin = 0x81;
+static const uint32_t kGbkLeadEnd = 0xFE;
+static const uint32_t kGbkTrailBegin = 0x40;
+static const uint32_t kGbkTrailCount = 192; // 0x40 - 0xFF
+
 EncodingConverter::EncodingConverter() {
 #if defined(__linux__)
     mGbk2Utf8Cd = iconv_open("UTF-8", "GBK");
@@ -34,6 +47,78 @@ EncodingConverter::EncodingConverter() {
         LOG_ERROR(sLogger, ("create Gbk2Utf8 iconv descriptor fail, errno", strerror(errno)));
     else
         iconv(mGbk2Utf8Cd, NULL, NULL, NULL, NULL);
+#endif
+    initGbkTable();
+}
+
+static uint32_t PackUtf8(const char* utf8, size_t size) {
+    if (size == 0 || size > 3) {
+        return 0;
+    }
+    uint32_t entry = static_cast<uint32_t>(size) << 24;
+    for (size_t i = 0; i < size; ++i) {
+        entry |= static_cast<uint32_t>(static_cast<unsigned char>(utf8[i])) << (8 * i);
+    }
+    return entry;
+}
+
+#if defined(__linux__)
+// GbkCharToUtf8Entry converts a GBK character by iconv, the table has exactly the same mapping as iconv.
+static uint32_t GbkCharToUtf8Entry(iconv_t cd, const char* gbk, size_t size) {
+    char in[2] = {gbk[0], size > 1 ? gbk[1] : '\0'};
+    char out[8];
+    char* inPtr = in;
+    char* outPtr = out;
+    size_t inLeft = size;
+    size_t outLeft = sizeof(out);
+    size_t ret = iconv(cd, &inPtr, &inLeft, &outPtr, &outLeft);
+    iconv(cd, NULL, NULL, NULL, NULL);
+    if (ret == (size_t)(-1) || inLeft != 0) {
+        return 0;
+    }
+    return PackUtf8(out, sizeof(out) - outLeft);
+}
+#elif defined(_MSC_VER)
+static uint32_t GbkCharToUtf8Entry(const char* gbk, size_t size) {
+    wchar_t wc[2];
+    if (MultiByteToWideChar(936, MB_ERR_INVALID_CHARS, gbk, static_cast<int>(size), wc, 2) != 1) {
+        return 0;
+    }
+    char out[8];
+    int len = WideCharToMultiByte(CP_UTF8, 0, wc, 1, out, sizeof(out), NULL, NULL);
+    return len > 0 ? PackUtf8(out, len) : 0;
+}
+#endif
+
+void EncodingConverter::initGbkTable() {
+    mGbkTable.assign((kGbkLeadEnd - kGbkLeadBegin + 1) * kGbkTrailCount, 0);
+    memset(mGbkSingleTable, 0, sizeof(mGbkSingleTable));
+#if defined(__linux__)
+    // A private descriptor, mGbk2Utf8Cd is in use by ConvertGbk2Utf8.
+    iconv_t cd = iconv_open("UTF-8", "GBK");
+    if (cd == (iconv_t)(-1)) {
+        LOG_ERROR(sLogger, ("create GBK table fail, iconv errno", strerror(errno)));
+        return;
+    }
+#define LOGTAIL_GBK_ENTRY(gbk, size) GbkCharToUtf8Entry(cd, gbk, size)
+#else
+#define LOGTAIL_GBK_ENTRY(gbk, size) GbkCharToUtf8Entry(gbk, size)
+#endif
+    for (uint32_t c = 0x80; c <= 0xFF; ++c) {
+        if (c < kGbkLeadBegin || c > kGbkLeadEnd) {
+            char gbk[1] = {static_cast<char>(c)};
+            mGbkSingleTable[c - 0x80] = LOGTAIL_GBK_ENTRY(gbk, 1);
+        }
+    }
+    for (uint32_t lead = kGbkLeadBegin; lead <= kGbkLeadEnd; ++lead) {
+        for (uint32_t trail = kGbkTrailBegin; trail < kGbkTrailBegin + kGbkTrailCount; ++trail) {
+            char gbk[2] = {static_cast<char>(lead), static_cast<char>(trail)};
+            mGbkTable[(lead - kGbkLeadBegin) * kGbkTrailCount + trail - kGbkTrailBegin] = LOGTAIL_GBK_ENTRY(gbk, 2);
+        }
+    }
+#undef LOGTAIL_GBK_ENTRY
+#if defined(__linux__)
+    iconv_close(cd);
 #endif
 }
 
@@ -131,6 +216,121 @@ bool EncodingConverter::ConvertGbk2Utf8(
 #endif
 }
 
+#if defined(LOGTAIL_GBK_SSE2)
+static inline uint32_t CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward(&idx, mask);
+    return static_cast<uint32_t>(idx);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+size_t EncodingConverter::ConvertGbk2Utf8Lines(
+    const char* src, size_t* srcLength, char* des, size_t desCapacity, std::vector<size_t>& lineFeedPos) {
+    const size_t srcSize = *srcLength;
+    size_t srcPos = 0;
+    size_t desPos = 0;
+    // Current line starts from lineBegin in src, and from lineDesBegin in des.
+    size_t lineBegin = 0;
+    size_t lineDesBegin = 0;
+    size_t invalidLineCount = 0;
+    bool full = false;
+    while (srcPos < srcSize) {
+#if defined(LOGTAIL_GBK_SSE2)
+        if (srcPos + 16 <= srcSize && desPos + 16 <= desCapacity) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + srcPos));
+            uint32_t nonAscii = static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+            uint32_t asciiSize = nonAscii == 0 ? 16 : CountTrailingZeros(nonAscii);
+            if (asciiSize > 0) {
+                // All 16 bytes are stored, bytes after the ASCII run are overwritten later.
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(des + desPos), chunk);
+                __m128i lineFeedMask = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+                uint32_t lineFeeds = static_cast<uint32_t>(_mm_movemask_epi8(lineFeedMask));
+                lineFeeds &= asciiSize == 16 ? 0xFFFFU : (1U << asciiSize) - 1;
+                while (lineFeeds != 0) {
+                    uint32_t offset = CountTrailingZeros(lineFeeds);
+                    lineFeedPos.push_back(srcPos + offset);
+                    lineBegin = srcPos + offset + 1;
+                    lineDesBegin = desPos + offset + 1;
+                    lineFeeds &= lineFeeds - 1;
+                }
+                srcPos += asciiSize;
+                desPos += asciiSize;
+                continue;
+            }
+        }
+#endif
+        unsigned char c = static_cast<unsigned char>(src[srcPos]);
+        if (c < 0x80) {
+            if (desPos >= desCapacity) {
+                full = true;
+                break;
+            }
+            des[desPos++] = static_cast<char>(c);
+            if (c == '\n') {
+                lineFeedPos.push_back(srcPos);
+                lineBegin = srcPos + 1;
+                lineDesBegin = desPos;
+            }
+            ++srcPos;
+            continue;
+        }
+        uint32_t entry = 0;
+        size_t charSize = 1;
+        if (c < kGbkLeadBegin || c > kGbkLeadEnd) {
+            entry = mGbkSingleTable[c - 0x80];
+        } else if (srcPos + 1 < srcSize) {
+            unsigned char trail = static_cast<unsigned char>(src[srcPos + 1]);
+            if (trail >= kGbkTrailBegin) {
+                entry = mGbkTable[(c - kGbkLeadBegin) * kGbkTrailCount + trail - kGbkTrailBegin];
+                charSize = 2;
+            }
+        }
+        if (entry == 0) {
+            // Copy the whole line without converting.
+            const char* lineFeed = static_cast<const char*>(memchr(src + srcPos, '\n', srcSize - srcPos));
+            size_t lineEnd = lineFeed == NULL ? srcSize : lineFeed - src + 1;
+            if (lineDesBegin + lineEnd - lineBegin > desCapacity) {
+                full = true;
+                break;
+            }
+            memcpy(des + lineDesBegin, src + lineBegin, lineEnd - lineBegin);
+            desPos = lineDesBegin + lineEnd - lineBegin;
+            srcPos = lineEnd;
+            if (lineFeed != NULL) {
+                lineFeedPos.push_back(lineEnd - 1);
+            }
+            lineBegin = lineEnd;
+            lineDesBegin = desPos;
+            ++invalidLineCount;
+            continue;
+        }
+        if (desPos + 3 > desCapacity) {
+            full = true;
+            break;
+        }
+        des[desPos] = static_cast<char>(entry & 0xFF);
+        des[desPos + 1] = static_cast<char>((entry >> 8) & 0xFF);
+        des[desPos + 2] = static_cast<char>((entry >> 16) & 0xFF);
+        desPos += entry >> 24;
+        srcPos += charSize;
+    }
+    if (full) {
+        // Rollback the line which can not be held.
+        srcPos = lineBegin;
+        desPos = lineDesBegin;
+    }
+    *srcLength = srcPos;
+    if (invalidLineCount > 0) {
+        LOG_ERROR(sLogger, ("convert GBK to UTF8 fail, lines copied without converting", invalidLineCount));
+        LogtailAlarm::GetInstance()->SendAlarm(ENCODING_CONVERT_ALARM, "convert GBK to UTF8 fail");
+    }
+    return desPos;
+}
+
 std::string EncodingConverter::FromUTF8ToACP(const std::string& s) {
     if (s.empty())
         return s;
@@ -0,0 +1,452 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "JsonObjectScanner.h"
+#include <cstring>
+#if defined(__x86_64__) || defined(_M_X64)
+#define LOGTAIL_JSON_SCANNER_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+#if defined(__GNUC__)
+// Bytes after '\0' are read on purpose, see FindSpecial.
+#define LOGTAIL_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define LOGTAIL_NO_SANITIZE_ADDRESS
+#endif
+
+namespace logtail {
+
+static inline bool IsJsonWhitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline const char* SkipWhitespaces(const char* pos) {
+    while (IsJsonWhitespace(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+#if defined(LOGTAIL_JSON_SCANNER_SSE2)
+
+static inline uint32_t CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward(&idx, mask);
+    return static_cast<uint32_t>(idx);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
+// Marks '"', '\\' and control characters (including '\0'), which end the plain part of a string.
+static inline uint32_t StringSpecialMask(__m128i chunk) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+    return static_cast<uint32_t>(_mm_movemask_epi8(special));
+}
+
+// Marks '"', brackets and '\0', which have to be handled when skipping a nested value.
+static inline uint32_t ContainerSpecialMask(__m128i chunk) {
+    // '{' and '}' are '[' and ']' with bit 0x20 set.
+    const __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i special
+        = _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}')));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, _mm_setzero_si128()));
+    return static_cast<uint32_t>(_mm_movemask_epi8(special));
+}
+
+template <uint32_t (*SpecialMask)(__m128i)>
+LOGTAIL_NO_SANITIZE_ADDRESS static inline const char* FindSpecial(const char* pos) {
+    // Aligned loads never cross a page, so bytes before @pos and after '\0' can be read safely.
+    const char* aligned = reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(pos) & ~uintptr_t(15));
+    uint32_t mask = SpecialMask(_mm_load_si128(reinterpret_cast<const __m128i*>(aligned))) >> (pos - aligned);
+    if (mask != 0) {
+        return pos + CountTrailingZeros(mask);
+    }
+    while (true) {
+        aligned += 16;
+        mask = SpecialMask(_mm_load_si128(reinterpret_cast<const __m128i*>(aligned)));
+        if (mask != 0) {
+            return aligned + CountTrailingZeros(mask);
+        }
+    }
+}
+
+static inline const char* FindStringSpecial(const char* pos) {
+    return FindSpecial<StringSpecialMask>(pos);
+}
+
+static inline const char* FindContainerSpecial(const char* pos) {
+    return FindSpecial<ContainerSpecialMask>(pos);
+}
+
+#else
+
+static inline const char* FindStringSpecial(const char* pos) {
+    while (*pos != '"' && *pos != '\\' && static_cast<unsigned char>(*pos) >= 0x20) {
+        ++pos;
+    }
+    return pos;
+}
+
+static inline const char* FindContainerSpecial(const char* pos) {
+    while (*pos != '"' && *pos != '{' && *pos != '}' && *pos != '[' && *pos != ']' && *pos != '\0') {
+        ++pos;
+    }
+    return pos;
+}
+
+#endif
+
+static inline int32_t HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static bool ParseHex4(const char* pos, uint32_t& codepoint) {
+    codepoint = 0;
+    for (int i = 0; i < 4; ++i) {
+        int32_t value = HexValue(pos[i]);
+        if (value < 0) {
+            return false;
+        }
+        codepoint = (codepoint << 4) | static_cast<uint32_t>(value);
+    }
+    return true;
+}
+
+static void AppendUTF8(std::string& out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+bool JsonObjectScanner::SetError(const char* pos, const char* error) {
+    mError = error;
+    mErrorOffset = pos - mBegin;
+    return false;
+}
+
+// @pos points to the opening quote, and is moved after the closing quote.
+bool JsonObjectScanner::ScanString(const char*& pos, StringPiece& str, int32_t& offset) {
+    const char* begin = ++pos;
+    pos = FindStringSpecial(pos);
+    if (*pos == '"') {
+        str = StringPiece(begin, pos - begin);
+        offset = -1;
+        ++pos;
+        return true;
+    }
+    // Slow path, the string is copied to mUnescaped and unescaped.
+    size_t start = mUnescaped.size();
+    mUnescaped.append(begin, pos - begin);
+    while (true) {
+        if (*pos == '"') {
+            break;
+        }
+        if (*pos != '\\') {
+            return SetError(pos, *pos == '\0' ? "missing quotation mark" : "invalid control character in string");
+        }
+        const char* escape = pos++;
+        switch (*pos++) {
+            case '"':
+                mUnescaped.push_back('"');
+                break;
+            case '\\':
+                mUnescaped.push_back('\\');
+                break;
+            case '/':
+                mUnescaped.push_back('/');
+                break;
+            case 'b':
+                mUnescaped.push_back('\b');
+                break;
+            case 'f':
+                mUnescaped.push_back('\f');
+                break;
+            case 'n':
+                mUnescaped.push_back('\n');
+                break;
+            case 'r':
+                mUnescaped.push_back('\r');
+                break;
+            case 't':
+                mUnescaped.push_back('\t');
+                break;
+            case 'u': {
+                uint32_t codepoint = 0;
+                if (!ParseHex4(pos, codepoint)) {
+                    return SetError(escape, "invalid unicode escape");
+                }
+                pos += 4;
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                    uint32_t low = 0;
+                    if (pos[0] != '\\' || pos[1] != 'u' || !ParseHex4(pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return SetError(escape, "invalid unicode surrogate");
+                    }
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    pos += 6;
+                }
+                AppendUTF8(mUnescaped, codepoint);
+                break;
+            }
+            default:
+                return SetError(escape, "invalid escape character");
+        }
+        const char* plain = pos;
+        pos = FindStringSpecial(pos);
+        mUnescaped.append(plain, pos - plain);
+    }
+    ++pos;
+    offset = static_cast<int32_t>(start);
+    str = StringPiece(NULL, mUnescaped.size() - start);
+    return true;
+}
+
+bool JsonObjectScanner::ScanNumber(const char*& pos) {
+    const char* begin = pos;
+    if (*pos == '-') {
+        ++pos;
+    }
+    if (*pos == '0') {
+        ++pos;
+    } else if (*pos >= '1' && *pos <= '9') {
+        while (*pos >= '0' && *pos <= '9') {
+            ++pos;
+        }
+    } else {
+        return SetError(begin, "invalid value");
+    }
+    if (*pos == '.') {
+        ++pos;
+        if (*pos < '0' || *pos > '9') {
+            return SetError(pos, "missing fraction of number");
+        }
+        while (*pos >= '0' && *pos <= '9') {
+            ++pos;
+        }
+    }
+    if (*pos == 'e' || *pos == 'E') {
+        ++pos;
+        if (*pos == '+' || *pos == '-') {
+            ++pos;
+        }
+        if (*pos < '0' || *pos > '9') {
+            return SetError(pos, "missing exponent of number");
+        }
+        while (*pos >= '0' && *pos <= '9') {
+            ++pos;
+        }
+    }
+    return true;
+}
+
+bool JsonObjectScanner::ScanLiteral(const char*& pos, const char* literal, size_t size) {
+    if (strncmp(pos, literal, size) != 0) {
+        return SetError(pos, "invalid value");
+    }
+    pos += size;
+    return true;
+}
+
+// @pos points to '{' or '[', and is moved after the matching bracket.
+bool JsonObjectScanner::SkipContainer(const char*& pos) {
+    // Closing brackets expected, short enough for most values to stay in the small string buffer.
+    std::string closings;
+    const char* begin = pos;
+    while (true) {
+        switch (*pos) {
+            case '{':
+            case '[':
+                closings.push_back(*pos == '{' ? '}' : ']');
+                break;
+            case '}':
+            case ']':
+                if (closings.back() != *pos) {
+                    return SetError(pos, "mismatched bracket");
+                }
+                closings.pop_back();
+                if (closings.empty()) {
+                    ++pos;
+                    return true;
+                }
+                break;
+            case '"': {
+                StringPiece str;
+                int32_t offset = -1;
+                size_t unescapedSize = mUnescaped.size();
+                if (!ScanString(pos, str, offset)) {
+                    return false;
+                }
+                // Nested strings are validated only, and the raw text is kept.
+                mUnescaped.resize(unescapedSize);
+                pos = FindContainerSpecial(pos);
+                continue;
+            }
+            default:
+                return SetError(begin, "missing closing bracket");
+        }
+        pos = FindContainerSpecial(pos + 1);
+    }
+}
+
+bool JsonObjectScanner::Scan(const char* buffer) {
+    mBegin = buffer;
+    mMembers.clear();
+    mUnescaped.clear();
+    mError = NULL;
+    mErrorOffset = 0;
+
+    const char* pos = SkipWhitespaces(buffer);
+    if (*pos != '{') {
+        return SetError(pos, *pos == '\0' ? "empty document" : "not an object");
+    }
+    pos = SkipWhitespaces(pos + 1);
+    if (*pos == '}') {
+        pos = SkipWhitespaces(pos + 1);
+        return *pos == '\0' || SetError(pos, "root not singular");
+    }
+    while (true) {
+        if (*pos != '"') {
+            return SetError(pos, "missing name of object member");
+        }
+        mMembers.emplace_back();
+        JsonMember& member = mMembers.back();
+        if (!ScanString(pos, member.key, member.keyOffset)) {
+            return false;
+        }
+        pos = SkipWhitespaces(pos);
+        if (*pos != ':') {
+            return SetError(pos, "missing colon after name");
+        }
+        pos = SkipWhitespaces(pos + 1);
+        const char* valueBegin = pos;
+        member.valueOffset = -1;
+        switch (*pos) {
+            case '"':
+                member.type = JSON_VALUE_STRING;
+                if (!ScanString(pos, member.value, member.valueOffset)) {
+                    return false;
+                }
+                break;
+            case '{':
+            case '[':
+                member.type = *pos == '{' ? JSON_VALUE_OBJECT : JSON_VALUE_ARRAY;
+                if (!SkipContainer(pos)) {
+                    return false;
+                }
+                member.value = StringPiece(valueBegin, pos - valueBegin);
+                break;
+            case 't':
+                member.type = JSON_VALUE_TRUE;
+                if (!ScanLiteral(pos, "true", 4)) {
+                    return false;
+                }
+                member.value = StringPiece(valueBegin, 4);
+                break;
+            case 'f':
+                member.type = JSON_VALUE_FALSE;
+                if (!ScanLiteral(pos, "false", 5)) {
+                    return false;
+                }
+                member.value = StringPiece(valueBegin, 5);
+                break;
+            case 'n':
+                member.type = JSON_VALUE_NULL;
+                if (!ScanLiteral(pos, "null", 4)) {
+                    return false;
+                }
+                member.value = StringPiece(valueBegin, 0);
+                break;
+            default:
+                member.type = JSON_VALUE_NUMBER;
+                if (!ScanNumber(pos)) {
+                    return false;
+                }
+                member.value = StringPiece(valueBegin, pos - valueBegin);
+                break;
+        }
+        pos = SkipWhitespaces(pos);
+        if (*pos == ',') {
+            pos = SkipWhitespaces(pos + 1);
+        } else if (*pos == '}') {
+            break;
+        } else {
+            return SetError(pos, "missing comma or curly bracket");
+        }
+    }
+    pos = SkipWhitespaces(pos + 1);
+    if (*pos != '\0') {
+        return SetError(pos, "root not singular");
+    }
+    // mUnescaped is not reallocated any more, rebind unescaped slices to it.
+    for (auto& member : mMembers) {
+        if (member.keyOffset >= 0) {
+            member.key = StringPiece(mUnescaped.data() + member.keyOffset, member.key.size());
+        }
+        if (member.valueOffset >= 0) {
+            member.value = StringPiece(mUnescaped.data() + member.valueOffset, member.value.size());
+        }
+    }
+    return true;
+}
+
+const JsonMember* JsonObjectScanner::FindMember(const StringPiece& key) const {
+    for (auto& member : mMembers) {
+        if (member.key == key) {
+            return &member;
+        }
+    }
+    return NULL;
+}
+
+bool JsonObjectScanner::IsInteger(const JsonMember& member) {
+    if (member.type != JSON_VALUE_NUMBER) {
+        return false;
+    }
+    for (char c : member.value) {
+        if (c == '.' || c == 'e' || c == 'E') {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace logtail
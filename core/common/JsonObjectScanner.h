@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StringPiece.h"
+
+namespace logtail {
+
+enum JsonValueType {
+    JSON_VALUE_STRING,
+    JSON_VALUE_NUMBER,
+    JSON_VALUE_TRUE,
+    JSON_VALUE_FALSE,
+    JSON_VALUE_NULL,
+    JSON_VALUE_OBJECT,
+    JSON_VALUE_ARRAY,
+};
+
+// JsonMember is a top-level member of the scanned object. Key and string value are unescaped,
+// number, true and false are the literal text, null is empty, and object and array are the raw
+// text of the input, including their whitespaces.
+struct JsonMember {
+    StringPiece key;
+    StringPiece value;
+    JsonValueType type;
+    // Offsets in the unescape buffer of the scanner, -1 if the slice points to the input.
+    int32_t keyOffset;
+    int32_t valueOffset;
+};
+
+// JsonObjectScanner walks top-level members of a JSON object without building a DOM, and
+// members are slices of the input unless they have escapes. The object is validated as strict
+// as rapidjson (default flags) except nested objects and arrays, whose brackets and strings are
+// checked only.
+//
+// On x86, strings and nested values are searched 16 bytes per step with SSE2. As the input is
+// terminated by '\0' rather than sized, loads are 16 bytes aligned so that they never cross
+// the page of the terminator.
+//
+// A scanner is not thread safe, and it reuses its buffers for the next Scan.
+class JsonObjectScanner {
+public:
+    // Scan parses the '\0' terminated @buffer, which must be an object with optional
+    // whitespaces around. Members are invalid after the next Scan.
+    bool Scan(const char* buffer);
+
+    const std::vector<JsonMember>& Members() const { return mMembers; }
+
+    // FindMember returns the first member named @key, NULL if not found.
+    const JsonMember* FindMember(const StringPiece& key) const;
+
+    // Error and ErrorOffset describe why the last Scan failed.
+    const char* Error() const { return mError; }
+    size_t ErrorOffset() const { return mErrorOffset; }
+
+    // IsInteger returns true if @member is a number without fraction and exponent.
+    static bool IsInteger(const JsonMember& member);
+
+private:
+    bool ScanString(const char*& pos, StringPiece& str, int32_t& offset);
+    bool ScanNumber(const char*& pos);
+    bool ScanLiteral(const char*& pos, const char* literal, size_t size);
+    bool SkipContainer(const char*& pos);
+    bool SetError(const char* pos, const char* error);
+
+    const char* mBegin = NULL;
+    std::vector<JsonMember> mMembers;
+    std::string mUnescaped;
+    const char* mError = NULL;
+    size_t mErrorOffset = 0;
+};
+
+} // namespace logtail
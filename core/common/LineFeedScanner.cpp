@@ -0,0 +1,119 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LineFeedScanner.h"
+#include <cstring>
+#if defined(__x86_64__) || defined(_M_X64)
+#define LOGTAIL_LINE_FEED_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define LOGTAIL_LINE_FEED_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+namespace logtail {
+
+void FindLineFeedsScalar(const char* buffer, size_t size, std::vector<int32_t>& positions) {
+    for (size_t i = 0; i < size; ++i) {
+        if (buffer[i] == '\n') {
+            positions.push_back(static_cast<int32_t>(i));
+        }
+    }
+}
+
+#if defined(LOGTAIL_LINE_FEED_SSE2)
+
+static inline uint32_t CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward(&idx, mask);
+    return static_cast<uint32_t>(idx);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
+static inline void AppendMaskPositions(uint32_t mask, size_t base, std::vector<int32_t>& positions) {
+    while (mask != 0) {
+        positions.push_back(static_cast<int32_t>(base + CountTrailingZeros(mask)));
+        mask &= mask - 1;
+    }
+}
+
+// Scans [buffer + begin, buffer + size), offsets are relative to @buffer.
+static void FindLineFeedsSSE2(const char* buffer, size_t begin, size_t size, std::vector<int32_t>& positions) {
+    const __m128i lineFeed = _mm_set1_epi8('\n');
+    size_t i = begin;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lineFeed)));
+        AppendMaskPositions(mask, i, positions);
+    }
+    for (; i < size; ++i) {
+        if (buffer[i] == '\n') {
+            positions.push_back(static_cast<int32_t>(i));
+        }
+    }
+}
+
+#if defined(LOGTAIL_LINE_FEED_AVX2)
+__attribute__((target("avx2"))) static void
+FindLineFeedsAVX2(const char* buffer, size_t size, std::vector<int32_t>& positions) {
+    const __m256i lineFeed = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lineFeed)));
+        AppendMaskPositions(mask, i, positions);
+    }
+    FindLineFeedsSSE2(buffer, i, size, positions);
+}
+
+static bool IsAVX2Supported() {
+    static const bool sSupported = __builtin_cpu_supports("avx2");
+    return sSupported;
+}
+#endif
+
+void FindLineFeeds(const char* buffer, size_t size, std::vector<int32_t>& positions) {
+#if defined(LOGTAIL_LINE_FEED_AVX2)
+    if (IsAVX2Supported()) {
+        FindLineFeedsAVX2(buffer, size, positions);
+        return;
+    }
+#endif
+    FindLineFeedsSSE2(buffer, 0, size, positions);
+}
+
+#else
+
+void FindLineFeeds(const char* buffer, size_t size, std::vector<int32_t>& positions) {
+    const char* begin = buffer;
+    const char* end = buffer + size;
+    while (begin < end) {
+        const char* pos = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        if (pos == NULL) {
+            break;
+        }
+        positions.push_back(static_cast<int32_t>(pos - buffer));
+        begin = pos + 1;
+    }
+}
+
+#endif
+
+} // namespace logtail
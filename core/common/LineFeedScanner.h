@@ -0,0 +1,33 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace logtail {
+
+// FindLineFeeds appends the offset of every '\n' in [buffer, buffer + size) to @positions.
+//
+// On x86, 32 (AVX2) or 16 (SSE2) bytes are compared per step, AVX2 is selected at runtime
+// when the CPU supports it. Other platforms fall back to memchr.
+void FindLineFeeds(const char* buffer, size_t size, std::vector<int32_t>& positions);
+
+// FindLineFeedsScalar is the byte-by-byte reference implementation, exposed for tests.
+void FindLineFeedsScalar(const char* buffer, size_t size, std::vector<int32_t>& positions);
+
+} // namespace logtail
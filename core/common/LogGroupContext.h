@@ -15,6 +15,8 @@
  */
 
 #pragma once
+#include <memory>
+#include <string>
 #include "config/IntegrityConfig.h"
 #include "profiler/LogtailAlarm.h"
 #include "FileInfo.h"
@@ -22,6 +24,33 @@
 
 namespace logtail {
 
+// LogGroupRoutingKey holds keys computed by Aggregator::Add to merge and route log groups, they are
+//  stable for log groups from the same reader and config.
+struct LogGroupRoutingKey {
+    // Inputs which may change during the life of a reader, keys are reused only if they are the same.
+    uint64_t mConfigInstanceId = 0;
+    std::string mTopic;
+    std::string mSource;
+
+    int64_t mLogGroupKey = 0;
+    int64_t mLogstoreKey = 0;
+    // Shard hash key is computed for every log group if it has fields changing at runtime.
+    bool mShardHashKeyCached = false;
+    std::string mShardHashKey;
+};
+typedef std::shared_ptr<const LogGroupRoutingKey> LogGroupRoutingKeyPtr;
+
+// RoutingKeyCache keeps the routing key of a reader, shared by processing threads.
+class RoutingKeyCache {
+public:
+    LogGroupRoutingKeyPtr Get() const { return std::atomic_load(&mKey); }
+    void Set(const LogGroupRoutingKeyPtr& key) { std::atomic_store(&mKey, key); }
+
+private:
+    LogGroupRoutingKeyPtr mKey;
+};
+typedef std::shared_ptr<RoutingKeyCache> RoutingKeyCachePtr;
+
 // store context info according to log group, may be used in closure callback
 struct LogGroupContext {
     LogGroupContext(const std::string& region = "",
@@ -63,6 +92,9 @@ struct LogGroupContext {
     bool mMarkOffsetFlag;
 
     RangeCheckpointPtr mExactlyOnceCheckpoint;
+
+    // Set by readers, NULL to compute routing keys for every log group.
+    RoutingKeyCachePtr mRoutingKeyCache;
 };
 
 } // namespace logtail
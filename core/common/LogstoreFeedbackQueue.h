@@ -15,13 +15,20 @@
  */
 
 #pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <unordered_map>
 #include <string>
 #include <stdlib.h>
 #include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #include "WaitObject.h"
 #include "MemoryBarrier.h"
 #include "Lock.h"
+#include "BoundedMPMCQueue.h"
 #include "QueueManager.h"
 
 #define MAX_CONFIG_PRIORITY_LEVEL (3)
@@ -40,35 +47,33 @@ public:
 
 class TriggerEvent {
 public:
-    TriggerEvent() : mTriggerState(false) {}
+    TriggerEvent() : mTriggerState(false), mWaiterCount(0) {}
 
     bool Wait(int32_t waitMs) {
         WaitObject::Lock lock(mWaitObj);
-        ReadWriteBarrier();
-        if (mTriggerState) {
-            mTriggerState = false;
+        if (mTriggerState.exchange(false)) {
             return true;
         }
+        ++mWaiterCount;
         mWaitObj.wait(lock, (int64_t)waitMs * (int64_t)1000);
-        if (mTriggerState) {
-            mTriggerState = false;
-            return true;
-        }
-        return false;
+        --mWaiterCount;
+        return mTriggerState.exchange(false);
     }
 
     void Trigger() {
-        WaitObject::Lock lock(mWaitObj);
-        {
-            ReadWriteBarrier();
-            mTriggerState = true;
+        // Nobody is waiting and the next Wait returns immediately, skip the lock.
+        if (mTriggerState.load() && mWaiterCount.load() == 0) {
+            return;
         }
+        WaitObject::Lock lock(mWaitObj);
+        mTriggerState = true;
         mWaitObj.signal();
     }
 
 protected:
     WaitObject mWaitObj;
-    volatile bool mTriggerState;
+    std::atomic_bool mTriggerState;
+    std::atomic_int mWaiterCount;
 };
 
 template <class TT, class PARAM>
@@ -198,10 +203,125 @@ public:
     size_t HIGH_SIZE;
 };
 
+// ConcurrentSingleLogstoreFeedbackQueue is the queue of a logstore in LogstoreFeedbackQueue.
+//
+// Unlike SingleLogstoreFeedbackQueue, items are kept in a lock-free ring and the watermark
+//  state is kept in atomics, so producers and consumers of different threads can work on
+//  the same queue without holding a lock.
+template <class TT, class PARAM>
+class ConcurrentSingleLogstoreFeedbackQueue {
+public:
+    ConcurrentSingleLogstoreFeedbackQueue() : mType(QueueType::Normal) {
+        ResetParam(PARAM::GetInstance()->GetLowSize(),
+                   PARAM::GetInstance()->GetHighSize(),
+                   PARAM::GetInstance()->GetMaxSize());
+    }
+
+    ConcurrentSingleLogstoreFeedbackQueue(const ConcurrentSingleLogstoreFeedbackQueue& que) = delete;
+    ConcurrentSingleLogstoreFeedbackQueue& operator=(const ConcurrentSingleLogstoreFeedbackQueue&) = delete;
+
+    void SetType(QueueType type) { mType = type; }
+
+    // ResetParam and Reset must not run concurrently with push or pop.
+    void ResetParam(const size_t lowSize, const size_t highSize, const size_t maxSize) {
+        LOW_SIZE = lowSize;
+        HIGH_SIZE = highSize;
+        SIZE = maxSize;
+        Reset();
+    }
+
+    void Reset() {
+        mRing.Reset(SIZE);
+        mState = 0;
+    }
+
+    bool IsValid() const { return (mState & INVALID_BIT) == 0; }
+
+    bool IsEmpty() const { return GetSize() == 0; }
+
+    bool IsFull() const { return GetSize() >= SIZE; }
+
+    bool PushItem(const TT& item) {
+        // Reserve a place at first, so the queue never holds more than SIZE items. The queue becomes
+        //  invalid in the same step, or consumers may pop it below LOW_SIZE before it is marked.
+        size_t state = mState.load(std::memory_order_relaxed);
+        size_t newState;
+        do {
+            const size_t size = state >> 1;
+            if (size >= SIZE) {
+                return false;
+            }
+            newState = state + 2;
+            if (size + 1 >= HIGH_SIZE) {
+                newState |= INVALID_BIT;
+            }
+        } while (!mState.compare_exchange_weak(state, newState));
+
+        // The ring may look full until a consumer releases its cell, it is short.
+        while (!mRing.TryPush(item)) {
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // Pop an item from queue.
+    //
+    // @return:
+    // - 0: the queue is empty.
+    // - 1: item is poped and the queue's status is unchanged.
+    // - 2: item is poped and the queue becomes valid.
+    int PopItem(TT& item) {
+        if (!mRing.TryPop(item)) {
+            return 0;
+        }
+        size_t state = mState.load(std::memory_order_relaxed);
+        size_t newState;
+        do {
+            newState = state - 2;
+            if ((newState >> 1) <= LOW_SIZE) {
+                newState &= ~INVALID_BIT;
+            }
+        } while (!mState.compare_exchange_weak(state, newState));
+        return (state & INVALID_BIT) != 0 && (newState & INVALID_BIT) == 0 ? 2 : 1;
+    }
+
+    size_t GetSize() const { return mState >> 1; }
+
+    QueueType GetQueueType() const { return mType; }
+
+    // Slot of the queue in ready bitmap of LogstoreFeedbackQueue.
+    size_t GetSlot() const { return mSlot; }
+    void SetSlot(size_t slot) { mSlot = slot; }
+
+protected:
+    size_t LOW_SIZE;
+    size_t HIGH_SIZE;
+    size_t SIZE;
+
+    // Lowest bit of mState is set when the queue is invalid (reaches HIGH_SIZE and not yet drops
+    //  to LOW_SIZE), others are the size, so that both change in one atomic step.
+    static const size_t INVALID_BIT = 1;
+
+    BoundedMPMCQueue<TT> mRing;
+    std::atomic<size_t> mState;
+    std::atomic<QueueType> mType;
+    size_t mSlot = 0;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class QueueManagerUnittest;
+#endif
+};
+
+// LogstoreFeedbackQueue is the queue between input and processor threads, with a queue for each logstore.
+//
+// The map of logstore queues is protected by a read-write lock, only creating or deleting a queue
+//  (and HoldOn by Lock) takes it exclusively, push and pop share it and work on lock-free rings.
+// Non-empty queues are marked in a ready bitmap indexed by the slot of queue, so consumers find
+//  data without walking all queues.
 template <class T, class PARAM = LogstoreFeedbackQueueParam>
 class LogstoreFeedbackQueue : public LogstoreFeedBackInterface {
 protected:
-    typedef SingleLogstoreFeedbackQueue<T, PARAM> SingleLogStoreQueue;
+    typedef ConcurrentSingleLogstoreFeedbackQueue<T, PARAM> SingleLogStoreQueue;
     typedef std::unordered_map<LogstoreFeedBackKey, SingleLogStoreQueue> LogstoreFeedBackQueueMap;
     typedef typename std::unordered_map<LogstoreFeedBackKey, SingleLogStoreQueue>::iterator
         LogstoreFeedBackQueueMapIterator;
@@ -220,6 +340,14 @@ protected:
     typedef std::vector<SingleLogStorePriorityQueue> LogstoreFeedBackQueueVector;
     typedef typename std::vector<SingleLogStorePriorityQueue>::iterator LogstoreFeedBackQueueVectorIterator;
 
+    // Slot of the bitmap, key is kept with queue pointer so that consumers don't look up the map.
+    struct QueueSlot {
+        SingleLogStoreQueue* mQueue;
+        LogstoreFeedBackKey mKey;
+
+        QueueSlot() : mQueue(NULL), mKey() {}
+    };
+
 public:
     LogstoreFeedbackQueue() : mFeedBackObj(NULL) {}
 
@@ -230,129 +358,58 @@ public:
         pParam->SetMaxSize(maxSize);
     }
 
-    void SetFeedBackObject(LogstoreFeedBackInterface* pFeedbackObj) {
-        PTScopedLock dataLock(mLock);
-        mFeedBackObj = pFeedbackObj;
-    }
+    void SetFeedBackObject(LogstoreFeedBackInterface* pFeedbackObj) { mFeedBackObj = pFeedbackObj; }
 
     bool Wait(int32_t waitMs) { return mTrigger.Wait(waitMs); }
 
     void Signal() { mTrigger.Trigger(); }
 
     bool IsValid(const LogstoreFeedBackKey& key) {
-        PTScopedLock dataLock(mLock);
-        SingleLogStoreQueue& singleQueue = mLogstoreQueueMap[key];
-        return singleQueue.IsValid();
-    }
-
-    bool PushItem(const LogstoreFeedBackKey& key, const T& item) {
         {
-            PTScopedLock dataLock(mLock);
-            SingleLogStoreQueue& singleQueue = mLogstoreQueueMap[key];
-
-            if (!singleQueue.PushItem(item)) {
-                return false;
+            ReadLock dataLock(mLock);
+            auto iter = mLogstoreQueueMap.find(key);
+            if (iter != mLogstoreQueueMap.end()) {
+                return iter->second.IsValid();
             }
         }
-        mTrigger.Trigger();
-        return true;
+        WriteLock dataLock(mLock);
+        return GetQueueNoLock(key).IsValid();
     }
 
-    bool PopItem(LogstoreFeedBackKey& startKey, T& item) {
-        PTScopedLock dataLock(mLock);
-        for (size_t i = 0; i < MAX_CONFIG_PRIORITY_LEVEL; ++i) {
-            for (LogstoreFeedBackQueueVectorIterator iter = mPriorityQueueArray[i].begin();
-                 iter != mPriorityQueueArray[i].end();
-                 ++iter) {
-                int rst = iter->mQueue->PopItem(item);
-                if (rst == 0) {
-                    continue;
-                }
-                if (rst == 2 && mFeedBackObj != NULL) {
-                    mFeedBackObj->FeedBack(iter->mKey);
-                }
-                return true;
+    bool PushItem(const LogstoreFeedBackKey& key, const T& item) {
+        bool pushed = false;
+        bool found = false;
+        {
+            ReadLock dataLock(mLock);
+            auto iter = mLogstoreQueueMap.find(key);
+            if (iter != mLogstoreQueueMap.end()) {
+                found = true;
+                pushed = PushItemNoLock(iter->second, item);
             }
         }
-
-        LogstoreFeedBackQueueMapIterator startKeyIter = mLogstoreQueueMap.find(startKey);
-        for (LogstoreFeedBackQueueMapIterator iter = startKeyIter; iter != mLogstoreQueueMap.end(); ++iter) {
-            int rst = iter->second.PopItem(item);
-            if (rst == 0) {
-                continue;
-            }
-            startKey = iter->first;
-            if (rst == 2 && mFeedBackObj != NULL) {
-                mFeedBackObj->FeedBack(startKey);
-            }
-            return true;
+        if (!found) {
+            WriteLock dataLock(mLock);
+            pushed = PushItemNoLock(GetQueueNoLock(key), item);
         }
-        for (LogstoreFeedBackQueueMapIterator iter = mLogstoreQueueMap.begin(); iter != startKeyIter; ++iter) {
-            int rst = iter->second.PopItem(item);
-            if (rst == 0) {
-                continue;
-            }
-            startKey = iter->first;
-            if (rst == 2 && mFeedBackObj != NULL) {
-                mFeedBackObj->FeedBack(startKey);
-            }
-            return true;
+        if (pushed) {
+            mTrigger.Trigger();
         }
-        return false;
+        return pushed;
+    }
+
+    bool PopItem(LogstoreFeedBackKey& startKey, T& item) {
+        return PopNextItemInternal(
+            startKey, item, false, [](const LogstoreFeedBackKey&, SingleLogStoreQueue&) { return true; });
     }
 
     bool CheckAndPopItem(LogstoreFeedBackKey& startKey, T& item, LogstoreFeedBackInterface* pCheckObj) {
         if (pCheckObj == NULL) {
             return false;
         }
-        PTScopedLock dataLock(mLock);
-        for (size_t i = 0; i < MAX_CONFIG_PRIORITY_LEVEL; ++i) {
-            for (LogstoreFeedBackQueueVectorIterator iter = mPriorityQueueArray[i].begin();
-                 iter != mPriorityQueueArray[i].end();
-                 ++iter) {
-                if (!pCheckObj->IsValidToPush(iter->mKey)) {
-                    continue;
-                }
-                int rst = iter->mQueue->PopItem(item);
-                if (rst == 0) {
-                    continue;
-                }
-                if (rst == 2 && mFeedBackObj != NULL) {
-                    mFeedBackObj->FeedBack(iter->mKey);
-                }
-                return true;
-            }
-        }
-        LogstoreFeedBackQueueMapIterator startKeyIter = mLogstoreQueueMap.find(startKey);
-        for (LogstoreFeedBackQueueMapIterator iter = startKeyIter; iter != mLogstoreQueueMap.end(); ++iter) {
-            if (!pCheckObj->IsValidToPush(iter->first)) {
-                continue;
-            }
-            int rst = iter->second.PopItem(item);
-            if (rst == 0) {
-                continue;
-            }
-            startKey = iter->first;
-            if (rst == 2 && mFeedBackObj != NULL) {
-                mFeedBackObj->FeedBack(startKey);
-            }
-            return true;
-        }
-        for (LogstoreFeedBackQueueMapIterator iter = mLogstoreQueueMap.begin(); iter != startKeyIter; ++iter) {
-            if (!pCheckObj->IsValidToPush(iter->first)) {
-                continue;
-            }
-            int rst = iter->second.PopItem(item);
-            if (rst == 0) {
-                continue;
-            }
-            startKey = iter->first;
-            if (rst == 2 && mFeedBackObj != NULL) {
-                mFeedBackObj->FeedBack(startKey);
-            }
-            return true;
-        }
-        return false;
+        return PopNextItemInternal(
+            startKey, item, false, [pCheckObj](const LogstoreFeedBackKey& key, SingleLogStoreQueue&) {
+                return pCheckObj->IsValidToPush(key);
+            });
     }
 
     bool CheckAndPopNextItem(LogstoreFeedBackKey& startKey,
@@ -363,82 +420,17 @@ public:
         if (pCheckObj == NULL) {
             return false;
         }
-
-        int rst = 0;
-        do {
-            PTScopedLock dataLock(mLock);
-            if (mLogstoreQueueMap.empty()) {
-                return false;
-            }
-
-            // Iterate queues by priority at first.
-            for (size_t i = 0; i < MAX_CONFIG_PRIORITY_LEVEL; ++i) {
-                for (LogstoreFeedBackQueueVectorIterator iter = mPriorityQueueArray[i].begin();
-                     iter != mPriorityQueueArray[i].end();
-                     ++iter) {
-                    if (!CanPopItem(threadNo, threadNum, pCheckObj, iter->mKey, *(iter->mQueue))) {
-                        continue;
-                    }
-
-                    rst = iter->mQueue->PopItem(item);
-                    if (rst == 0) {
-                        continue;
-                    }
-                    if (rst == 2 && mFeedBackObj != NULL) {
-                        mFeedBackObj->FeedBack(iter->mKey);
-                    }
-                    return true;
-                }
-            }
-
-            // Iterate queues, startKey is used for fairness.
-            LogstoreFeedBackQueueMapIterator startKeyIter = mLogstoreQueueMap.find(startKey);
-            if (startKeyIter == mLogstoreQueueMap.end()) {
-                startKeyIter = mLogstoreQueueMap.begin();
-            } else {
-                ++startKeyIter;
-            }
-
-            // Range: the key of last poped item -> end.
-            for (auto iter = startKeyIter; iter != mLogstoreQueueMap.end(); ++iter) {
-                if (!CanPopItem(threadNo, threadNum, pCheckObj, iter->first, iter->second)) {
-                    continue;
-                }
-
-                rst = iter->second.PopItem(item);
-                if (rst == 0) {
-                    continue;
-                }
-                startKey = iter->first;
-                break;
-            }
-            if (rst != 0) {
-                break;
-            }
-
-            // Range: begin -> the key of last poped item.
-            for (auto iter = mLogstoreQueueMap.begin(); iter != startKeyIter; ++iter) {
-                if (!CanPopItem(threadNo, threadNum, pCheckObj, iter->first, iter->second)) {
-                    continue;
-                }
-
-                rst = iter->second.PopItem(item);
-                if (rst == 0) {
-                    continue;
-                }
-                startKey = iter->first;
-                break;
-            }
-        } while (false);
-
-        if (rst == 2 && mFeedBackObj != NULL) {
-            mFeedBackObj->FeedBack(startKey);
-        }
-        return rst != 0;
+        return PopNextItemInternal(
+            startKey,
+            item,
+            true,
+            [this, threadNo, threadNum, pCheckObj](const LogstoreFeedBackKey& key, SingleLogStoreQueue& queue) {
+                return CanPopItem(threadNo, threadNum, pCheckObj, key, queue);
+            });
     }
 
     bool IsEmpty() {
-        PTScopedLock dataLock(mLock);
+        ReadLock dataLock(mLock);
         for (LogstoreFeedBackQueueMapIterator iter = mLogstoreQueueMap.begin(); iter != mLogstoreQueueMap.end();
              ++iter) {
             if (!iter->second.IsEmpty()) {
@@ -449,7 +441,7 @@ public:
     }
 
     bool IsEmpty(const LogstoreFeedBackKey& key) {
-        PTScopedLock dataLock(mLock);
+        ReadLock dataLock(mLock);
         auto iter = mLogstoreQueueMap.find(key);
         return iter == mLogstoreQueueMap.end() || iter->second.IsEmpty();
     }
@@ -460,15 +452,11 @@ public:
 
     virtual void FeedBack(const LogstoreFeedBackKey& key) { mTrigger.Trigger(); }
 
-    virtual bool IsValidToPush(const LogstoreFeedBackKey& key) {
-        PTScopedLock dataLock(mLock);
-        auto& singleQueue = mLogstoreQueueMap[key];
-        return singleQueue.IsValid();
-    }
+    virtual bool IsValidToPush(const LogstoreFeedBackKey& key) { return IsValid(key); }
 
     void
     GetStatus(int32_t& normalInvalidCount, int32_t& normalTotalCount, int32_t& eoInvalidCount, int32_t& eoTotalCount) {
-        PTScopedLock dataLock(mLock);
+        ReadLock dataLock(mLock);
         for (LogstoreFeedBackQueueMapIterator iter = mLogstoreQueueMap.begin(); iter != mLogstoreQueueMap.end();
              ++iter) {
             bool isExactlyOnceQueue = iter->second.GetQueueType() == QueueType::ExactlyOnce;
@@ -483,23 +471,26 @@ public:
     }
 
     void Delete(const LogstoreFeedBackKey& key) {
-        PTScopedLock dataLock(mLock);
+        WriteLock dataLock(mLock);
         auto iter = mLogstoreQueueMap.find(key);
         if (iter != mLogstoreQueueMap.end()) {
+            DeletePriorityNoLock(key);
+            ReleaseSlotNoLock(iter->second.GetSlot());
             mLogstoreQueueMap.erase(iter);
         }
     }
 
     void DeletePriority(const LogstoreFeedBackKey& key) {
-        PTScopedLock dataLock(mLock);
+        WriteLock dataLock(mLock);
         DeletePriorityNoLock(key);
     }
 
     void SetPriority(const LogstoreFeedBackKey& key, int32_t priority) {
-        PTScopedLock dataLock(mLock);
+        WriteLock dataLock(mLock);
         SetPriorityNoLock(key, priority);
     }
 
+    // SetPriorityNoLock and DeletePriorityNoLock must be called with Lock held.
     void SetPriorityNoLock(const LogstoreFeedBackKey& key, int32_t priority) {
         if (priority < 1 || priority > MAX_CONFIG_PRIORITY_LEVEL) {
             return;
@@ -507,7 +498,7 @@ public:
         priority -= 1;
         // should delete this key first
         DeletePriorityNoLock(key);
-        mPriorityQueueArray[priority].push_back(SingleLogStorePriorityQueue(priority, key, &mLogstoreQueueMap[key]));
+        mPriorityQueueArray[priority].push_back(SingleLogStorePriorityQueue(priority, key, &GetQueueNoLock(key)));
     }
 
     void DeletePriorityNoLock(const LogstoreFeedBackKey& key) {
@@ -524,17 +515,23 @@ public:
     }
 
     void ConvertToExactlyOnceQueue(const LogstoreFeedBackKey& key) {
-        PTScopedLock dataLock(mLock);
-        mLogstoreQueueMap[key].SetType(QueueType::ExactlyOnce);
+        WriteLock dataLock(mLock);
+        GetQueueNoLock(key).SetType(QueueType::ExactlyOnce);
     }
 
 protected:
-    PTMutex mLock;
+    ReadWriteLock mLock;
     TriggerEvent mTrigger;
-    LogstoreFeedBackInterface* mFeedBackObj;
+    std::atomic<LogstoreFeedBackInterface*> mFeedBackObj;
     LogstoreFeedBackQueueMap mLogstoreQueueMap;
     LogstoreFeedBackQueueVector mPriorityQueueArray[MAX_CONFIG_PRIORITY_LEVEL];
 
+    // Slots of queues and the ready bitmap, resized with mLock held exclusively.
+    std::vector<QueueSlot> mSlots;
+    std::vector<size_t> mFreeSlots;
+    std::unique_ptr<std::atomic<uint32_t>[]> mReadyBits;
+    size_t mReadyWordCount = 0;
+
 private:
     bool CanPopItem(int32_t threadNo,
                     int32_t threadNum,
@@ -548,90 +545,206 @@ private:
         return checkObj->IsValidToPush(key);
     }
 
-#ifdef APSARA_UNIT_TEST_MAIN
-    friend class ExactlyOnceReaderUnittest;
-    friend class SenderUnittest;
-    friend class QueueManagerUnittest;
+    static uint32_t CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+        unsigned long idx = 0;
+        _BitScanForward(&idx, mask);
+        return static_cast<uint32_t>(idx);
+#else
+        return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+    }
 
-public:
-    // do not clear real data
-    void RemoveAll() {
-        PTScopedLock dataLock(mLock);
-        mLogstoreQueueMap.clear();
-        for (size_t i = 0; i < MAX_CONFIG_PRIORITY_LEVEL; ++i) {
-            mPriorityQueueArray[i].clear();
+    // GetQueueNoLock returns the queue of @key, creates it if not existing, mLock must be held exclusively.
+    SingleLogStoreQueue& GetQueueNoLock(const LogstoreFeedBackKey& key) {
+        auto iter = mLogstoreQueueMap.find(key);
+        if (iter != mLogstoreQueueMap.end()) {
+            return iter->second;
+        }
+        SingleLogStoreQueue& queue = mLogstoreQueueMap[key];
+        size_t slot = 0;
+        if (!mFreeSlots.empty()) {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        } else {
+            slot = mSlots.size();
+            mSlots.push_back(QueueSlot());
+            if (mSlots.size() > mReadyWordCount * 32) {
+                size_t wordCount = mReadyWordCount == 0 ? 1 : mReadyWordCount * 2;
+                std::unique_ptr<std::atomic<uint32_t>[]> bits(new std::atomic<uint32_t>[wordCount]);
+                for (size_t i = 0; i < wordCount; ++i) {
+                    bits[i] = i < mReadyWordCount ? mReadyBits[i].load() : 0;
+                }
+                mReadyBits.swap(bits);
+                mReadyWordCount = wordCount;
+            }
         }
+        mSlots[slot].mQueue = &queue;
+        mSlots[slot].mKey = key;
+        queue.SetSlot(slot);
+        return queue;
     }
 
-    void ClearEmptyQueue() {
-        PTScopedLock dataLock(mLock);
-        LogstoreFeedBackQueueMapIterator iter = mLogstoreQueueMap.begin();
-        while (iter != mLogstoreQueueMap.end()) {
-            if (iter->second.IsEmpty()) {
-                // delete priority queue first
-                DeletePriorityNoLock(iter->first);
-                iter = mLogstoreQueueMap.erase(iter);
-            } else {
-                ++iter;
+    void ReleaseSlotNoLock(size_t slot) {
+        ClearReady(slot);
+        mSlots[slot] = QueueSlot();
+        mFreeSlots.push_back(slot);
+    }
+
+    void SetReady(size_t slot) {
+        std::atomic<uint32_t>& word = mReadyBits[slot / 32];
+        const uint32_t mask = 1U << (slot % 32);
+        // Test before set, most pushes go to a queue which is ready already.
+        if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+            word.fetch_or(mask);
+        }
+    }
+
+    void ClearReady(size_t slot) { mReadyBits[slot / 32].fetch_and(~(1U << (slot % 32))); }
+
+    bool PushItemNoLock(SingleLogStoreQueue& queue, const T& item) {
+        if (!queue.PushItem(item)) {
+            return false;
+        }
+        SetReady(queue.GetSlot());
+        return true;
+    }
+
+    int PopItemNoLock(SingleLogStoreQueue& queue, T& item) {
+        int rst = queue.PopItem(item);
+        if (queue.IsEmpty()) {
+            ClearReady(queue.GetSlot());
+            // A producer may have pushed after the check, the bit must not be lost for it.
+            if (!queue.IsEmpty()) {
+                SetReady(queue.GetSlot());
             }
         }
+        return rst;
     }
 
-    bool PopNextItem(LogstoreFeedBackKey& startKey, T& item) {
+    // PopNextItemInternal pops an item from queues with priority at first, then from ready queues
+    //  in slot order, starting from the queue of @startKey (or the one after it if @afterStartKey
+    //  is set) for fairness. @canPop tells whether a queue can be popped now.
+    template <class CHECK>
+    bool PopNextItemInternal(LogstoreFeedBackKey& startKey, T& item, bool afterStartKey, const CHECK& canPop) {
         int rst = 0;
-        do {
-            PTScopedLock dataLock(mLock);
+        LogstoreFeedBackKey popKey = LogstoreFeedBackKey();
+        LogstoreFeedBackInterface* feedBackObj = mFeedBackObj;
+        {
+            ReadLock dataLock(mLock);
             if (mLogstoreQueueMap.empty()) {
                 return false;
             }
-            for (size_t i = 0; i < MAX_CONFIG_PRIORITY_LEVEL; ++i) {
+
+            // Iterate queues by priority at first.
+            for (size_t i = 0; i < MAX_CONFIG_PRIORITY_LEVEL && rst == 0; ++i) {
                 for (LogstoreFeedBackQueueVectorIterator iter = mPriorityQueueArray[i].begin();
                      iter != mPriorityQueueArray[i].end();
                      ++iter) {
-                    rst = iter->mQueue->PopItem(item);
-                    if (rst == 0) {
+                    if (iter->mQueue->IsEmpty() || !canPop(iter->mKey, *(iter->mQueue))) {
                         continue;
                     }
-                    // don't set start key, for fairness
-                    // startKey = iter->mKey;
-                    if (rst == 2 && mFeedBackObj != NULL) {
-                        mFeedBackObj->FeedBack(iter->mKey);
+                    rst = PopItemNoLock(*(iter->mQueue), item);
+                    if (rst != 0) {
+                        // don't set start key, for fairness
+                        popKey = iter->mKey;
+                        break;
                     }
-                    return rst != 0;
                 }
             }
-            LogstoreFeedBackQueueMapIterator startKeyIter = mLogstoreQueueMap.find(startKey);
-            if (startKeyIter == mLogstoreQueueMap.end()) {
-                startKeyIter = mLogstoreQueueMap.begin();
-            } else {
-                ++startKeyIter;
+            if (rst != 0) {
+                dataLock.unlock();
+                if (rst == 2 && feedBackObj != NULL) {
+                    feedBackObj->FeedBack(popKey);
+                }
+                return true;
             }
 
-            for (LogstoreFeedBackQueueMapIterator iter = startKeyIter; iter != mLogstoreQueueMap.end(); ++iter) {
-                rst = iter->second.PopItem(item);
-                if (rst == 0) {
-                    continue;
+            // Iterate ready queues, startKey is used for fairness.
+            size_t beginSlot = 0;
+            auto startKeyIter = mLogstoreQueueMap.find(startKey);
+            if (startKeyIter != mLogstoreQueueMap.end()) {
+                beginSlot = startKeyIter->second.GetSlot() + (afterStartKey ? 1 : 0);
+                if (beginSlot >= mSlots.size()) {
+                    beginSlot = 0;
                 }
-                startKey = iter->first;
-                break;
-            }
-            if (rst != 0) {
-                break;
             }
-            for (LogstoreFeedBackQueueMapIterator iter = mLogstoreQueueMap.begin(); iter != startKeyIter; ++iter) {
-                rst = iter->second.PopItem(item);
-                if (rst == 0) {
-                    continue;
+            const size_t beginWord = beginSlot / 32;
+            const uint32_t beginBit = beginSlot % 32;
+            const size_t wordCount = (mSlots.size() + 31) / 32;
+            // The word of beginSlot is visited twice, bits after beginSlot at first and bits before it at last.
+            for (size_t i = 0; i <= wordCount && rst == 0; ++i) {
+                const size_t wordIndex = (beginWord + i) % wordCount;
+                uint32_t bits = mReadyBits[wordIndex].load();
+                if (i == 0) {
+                    bits &= ~0U << beginBit;
+                } else if (i == wordCount) {
+                    bits &= (1U << beginBit) - 1;
+                }
+                while (bits != 0) {
+                    const size_t slot = wordIndex * 32 + CountTrailingZeros(bits);
+                    bits &= bits - 1;
+                    QueueSlot& queueSlot = mSlots[slot];
+                    if (queueSlot.mQueue == NULL || !canPop(queueSlot.mKey, *queueSlot.mQueue)) {
+                        continue;
+                    }
+                    rst = PopItemNoLock(*queueSlot.mQueue, item);
+                    if (rst != 0) {
+                        popKey = queueSlot.mKey;
+                        break;
+                    }
                 }
-                startKey = iter->first;
-                break;
             }
-        } while (false);
+        }
+        if (rst == 0) {
+            return false;
+        }
+        startKey = popKey;
+        if (rst == 2 && feedBackObj != NULL) {
+            feedBackObj->FeedBack(popKey);
+        }
+        return true;
+    }
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class ExactlyOnceReaderUnittest;
+    friend class SenderUnittest;
+    friend class QueueManagerUnittest;
+    friend class LogstoreFeedbackQueueUnittest;
+
+public:
+    // do not clear real data
+    void RemoveAll() {
+        WriteLock dataLock(mLock);
+        mLogstoreQueueMap.clear();
+        for (size_t i = 0; i < MAX_CONFIG_PRIORITY_LEVEL; ++i) {
+            mPriorityQueueArray[i].clear();
+        }
+        mSlots.clear();
+        mFreeSlots.clear();
+        for (size_t i = 0; i < mReadyWordCount; ++i) {
+            mReadyBits[i] = 0;
+        }
+    }
 
-        if (rst == 2 && mFeedBackObj != NULL) {
-            mFeedBackObj->FeedBack(startKey);
+    void ClearEmptyQueue() {
+        WriteLock dataLock(mLock);
+        LogstoreFeedBackQueueMapIterator iter = mLogstoreQueueMap.begin();
+        while (iter != mLogstoreQueueMap.end()) {
+            if (iter->second.IsEmpty()) {
+                // delete priority queue first
+                DeletePriorityNoLock(iter->first);
+                ReleaseSlotNoLock(iter->second.GetSlot());
+                iter = mLogstoreQueueMap.erase(iter);
+            } else {
+                ++iter;
+            }
         }
-        return rst != 0;
+    }
+
+    bool PopNextItem(LogstoreFeedBackKey& startKey, T& item) {
+        return PopNextItemInternal(
+            startKey, item, true, [](const LogstoreFeedBackKey&, SingleLogStoreQueue&) { return true; });
     }
 #endif
 };
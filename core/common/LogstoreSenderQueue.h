@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include "logger/Logger.h"
 #include "LogGroupContext.h"
+#include "CompressTools.h"
 #include "Lock.h"
 #include "LogstoreFeedbackQueue.h"
 
@@ -49,6 +50,8 @@ struct LogstoreSenderStatistics {
 struct LoggroupTimeValue {
     int32_t mLastUpdateTime;
     SEND_DATA_TYPE mDataType;
+    // codec of mLogData, or of each package if mDataType is LOG_PACKAGE_LIST
+    CompressType mCompressType = COMPRESS_LZ4;
     std::string mLogData;
     int32_t mRawSize;
     int32_t mLogLines;
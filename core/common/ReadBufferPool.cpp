@@ -0,0 +1,122 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ReadBufferPool.h"
+#include <cstdlib>
+#include <new>
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+#include "common/Flags.h"
+
+DEFINE_FLAG_INT32(read_buffer_pool_max_free_count,
+                  "max count of free blocks cached in read buffer pool, 0 to disable the pool",
+                  32);
+
+namespace logtail {
+
+static const size_t kReadBufferAlignment = 64;
+
+ReadBufferPool::ReadBufferPool() : mBlockSize(512 * 1024 + 1) {
+}
+
+ReadBufferPool::~ReadBufferPool() {
+    for (auto block : mFreeBlocks) {
+        freeBlock(block);
+    }
+}
+
+ReadBufferPtr ReadBufferPool::Acquire(size_t size) {
+    char* block = NULL;
+    size_t blockSize = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        blockSize = mBlockSize;
+        if (size <= blockSize && !mFreeBlocks.empty()) {
+            block = mFreeBlocks.back();
+            mFreeBlocks.pop_back();
+        }
+    }
+    if (block != NULL) {
+        mHitCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mMissCount.fetch_add(1, std::memory_order_relaxed);
+        if (size > blockSize) {
+            blockSize = size;
+        }
+        block = allocateBlock(blockSize);
+    }
+    return ReadBufferPtr(block, [this, blockSize](char* p) { release(p, blockSize); });
+}
+
+void ReadBufferPool::SetBlockSize(size_t blockSize) {
+    std::vector<char*> toFree;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mBlockSize == blockSize) {
+            return;
+        }
+        mBlockSize = blockSize;
+        toFree.swap(mFreeBlocks);
+    }
+    for (auto block : toFree) {
+        freeBlock(block);
+    }
+}
+
+size_t ReadBufferPool::GetBlockSize() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mBlockSize;
+}
+
+size_t ReadBufferPool::GetFreeBlockCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFreeBlocks.size();
+}
+
+void ReadBufferPool::release(char* block, size_t blockSize) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (blockSize == mBlockSize && mFreeBlocks.size() < (size_t)INT32_FLAG(read_buffer_pool_max_free_count)) {
+            mFreeBlocks.push_back(block);
+            return;
+        }
+    }
+    freeBlock(block);
+}
+
+char* ReadBufferPool::allocateBlock(size_t size) {
+#if defined(_MSC_VER)
+    void* block = _aligned_malloc(size, kReadBufferAlignment);
+#else
+    void* block = NULL;
+    if (posix_memalign(&block, kReadBufferAlignment, size) != 0) {
+        block = NULL;
+    }
+#endif
+    if (block == NULL) {
+        throw std::bad_alloc();
+    }
+    return static_cast<char*>(block);
+}
+
+void ReadBufferPool::freeBlock(char* block) {
+#if defined(_MSC_VER)
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+} // namespace logtail
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace logtail {
+
+// Reference counted handle of a read buffer, memory is given back to ReadBufferPool
+//  (or freed if it is not pooled) when the last reference is released.
+typedef std::shared_ptr<char> ReadBufferPtr;
+
+// ReadBufferPool caches fixed size, cache line aligned blocks for file reading.
+//
+// Readers acquire a block for each read (up to 512KB by default), and the block is
+//  released by processor threads after parsing. Reusing blocks avoids the alloc/free
+//  churn of large buffers, which makes tcmalloc keep growing its page heap.
+class ReadBufferPool {
+public:
+    static ReadBufferPool* GetInstance() {
+        static auto singleton = new ReadBufferPool;
+        return singleton;
+    }
+
+    // Acquire returns a buffer with at least @size bytes.
+    // Requests larger than block size (eg. replay of exactly once checkpoint) are not pooled.
+    ReadBufferPtr Acquire(size_t size);
+
+    // Wrap takes the ownership of @buffer which is allocated by new[].
+    static ReadBufferPtr Wrap(char* buffer) { return ReadBufferPtr(buffer, std::default_delete<char[]>()); }
+
+    // SetBlockSize changes the size of pooled blocks, cached blocks are freed.
+    void SetBlockSize(size_t blockSize);
+    size_t GetBlockSize();
+
+    size_t GetFreeBlockCount();
+    uint64_t GetHitCount() const { return mHitCount.load(std::memory_order_relaxed); }
+    uint64_t GetMissCount() const { return mMissCount.load(std::memory_order_relaxed); }
+
+private:
+    ReadBufferPool();
+    ~ReadBufferPool();
+
+    void release(char* block, size_t blockSize);
+
+    static char* allocateBlock(size_t size);
+    static void freeBlock(char* block);
+
+    std::mutex mMutex;
+    size_t mBlockSize;
+    std::vector<char*> mFreeBlocks;
+
+    std::atomic<uint64_t> mHitCount{0};
+    std::atomic<uint64_t> mMissCount{0};
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class ReadBufferPoolUnittest;
+#endif
+};
+
+} // namespace logtail
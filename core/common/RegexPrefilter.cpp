@@ -0,0 +1,199 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RegexPrefilter.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace logtail {
+
+// Upper bound of elements generated by a single {n}, longer shapes bring no extra benefit.
+static const size_t kMaxRepeatCount = 256;
+
+void RegexPrefilter::Reset(const std::string& regex) {
+    Clear();
+    if (HasTopLevelAlternation(regex) || regex.find("\\Q") != std::string::npos) {
+        return;
+    }
+
+    const size_t size = regex.size();
+    size_t pos = 0;
+    if (pos < size && regex[pos] == '^') {
+        ++pos;
+    }
+    while (pos < size) {
+        Element element;
+        element.ch = 0;
+        size_t next = pos + 1;
+        const char c = regex[pos];
+        if (c == '\\') {
+            if (pos + 1 >= size) {
+                break;
+            }
+            const char e = regex[pos + 1];
+            next = pos + 2;
+            element.type = ELEMENT_LITERAL;
+            if (e == 'd') {
+                element.type = ELEMENT_DIGIT;
+            } else if (e == 's') {
+                element.type = ELEMENT_SPACE;
+            } else if (e == 'w') {
+                element.type = ELEMENT_WORD;
+            } else if (e == 't') {
+                element.ch = '\t';
+            } else if (e == 'n') {
+                element.ch = '\n';
+            } else if (e == 'r') {
+                element.ch = '\r';
+            } else if (!isalnum(static_cast<unsigned char>(e))) {
+                element.ch = e;
+            } else {
+                // \b, \D, \x.., back references and so on.
+                break;
+            }
+        } else if (c == '[') {
+            if (regex.compare(pos, 5, "[0-9]") != 0) {
+                break;
+            }
+            element.type = ELEMENT_DIGIT;
+            next = pos + 5;
+        } else if (c == '.') {
+            element.type = ELEMENT_ANY;
+        } else if (strchr("()[]{}*+?|^$", c) != NULL) {
+            break;
+        } else {
+            element.type = ELEMENT_LITERAL;
+            element.ch = c;
+        }
+
+        size_t count = 1;
+        bool stop = false;
+        if (next < size) {
+            const char q = regex[next];
+            if (q == '*' || q == '?') {
+                // Optional element, nothing after it has a fixed position.
+                break;
+            }
+            if (q == '+') {
+                stop = true;
+            } else if (q == '{') {
+                size_t close = regex.find('}', next);
+                if (close == std::string::npos) {
+                    break;
+                }
+                const std::string body = regex.substr(next + 1, close - next - 1);
+                if (body.empty() || !isdigit(static_cast<unsigned char>(body[0]))) {
+                    break;
+                }
+                char* end = NULL;
+                count = strtoul(body.c_str(), &end, 10);
+                if (*end == ',') {
+                    stop = true;
+                } else if (*end != '\0') {
+                    break;
+                }
+                next = close + 1;
+                if (!stop && next < size) {
+                    if (regex[next] == '?' || regex[next] == '+') {
+                        // Lazy or possessive modifier doesn't change an exact count.
+                        ++next;
+                    } else if (regex[next] == '*' || regex[next] == '{') {
+                        break;
+                    }
+                }
+                if (count > kMaxRepeatCount) {
+                    count = kMaxRepeatCount;
+                    stop = true;
+                }
+            }
+        }
+        mElements.insert(mElements.end(), count, element);
+        if (stop) {
+            break;
+        }
+        pos = next;
+    }
+
+    for (size_t i = 0; i < mElements.size() && mElements[i].type == ELEMENT_LITERAL; ++i) {
+        mLiteralPrefix.push_back(mElements[i].ch);
+    }
+}
+
+bool RegexPrefilter::MayMatch(const char* input, size_t size) const {
+    if (size < mElements.size()) {
+        return false;
+    }
+    const size_t literalSize = mLiteralPrefix.size();
+    if (literalSize > 0 && memcmp(input, mLiteralPrefix.data(), literalSize) != 0) {
+        return false;
+    }
+    for (size_t i = literalSize; i < mElements.size(); ++i) {
+        if (!MatchElement(mElements[i], static_cast<unsigned char>(input[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Non-ASCII bytes are always accepted by classes because their meaning depends on the locale.
+bool RegexPrefilter::MatchElement(const Element& element, unsigned char c) {
+    switch (element.type) {
+        case ELEMENT_LITERAL:
+            return c == static_cast<unsigned char>(element.ch);
+        case ELEMENT_DIGIT:
+            return (c >= '0' && c <= '9') || c >= 0x80;
+        case ELEMENT_SPACE:
+            return c == ' ' || (c >= '\t' && c <= '\r') || c >= 0x80;
+        case ELEMENT_WORD:
+            return isalnum(c) || c == '_' || c >= 0x80;
+        case ELEMENT_ANY:
+            return true;
+    }
+    return true;
+}
+
+bool RegexPrefilter::HasTopLevelAlternation(const std::string& regex) {
+    int depth = 0;
+    for (size_t i = 0; i < regex.size(); ++i) {
+        const char c = regex[i];
+        if (c == '\\') {
+            ++i;
+        } else if (c == '[') {
+            // Skip the character class, ']' right after '[' or '[^' is a literal.
+            ++i;
+            if (i < regex.size() && regex[i] == '^') {
+                ++i;
+            }
+            if (i < regex.size() && regex[i] == ']') {
+                ++i;
+            }
+            while (i < regex.size() && regex[i] != ']') {
+                if (regex[i] == '\\') {
+                    ++i;
+                }
+                ++i;
+            }
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            --depth;
+        } else if (c == '|' && depth <= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace logtail
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace logtail {
+
+// RegexPrefilter extracts the fixed-shape head of a regex used with regex_match, such as
+// the literal prefix of `\[\d+\] .*` or the timestamp shape of `\d{4}-\d{2}-\d{2} \d{2}:.*`.
+// MayMatch only returns false when the input can not match the regex, so the expensive
+// regex only needs to run on inputs passing it.
+//
+// The analysis is conservative: it stops at the first group, alternation, variable
+// quantifier or unsupported escape, and it is disabled when the regex has top-level
+// alternation.
+class RegexPrefilter {
+public:
+    RegexPrefilter() {}
+    explicit RegexPrefilter(const std::string& regex) { Reset(regex); }
+
+    void Reset(const std::string& regex);
+    void Clear() {
+        mLiteralPrefix.clear();
+        mElements.clear();
+    }
+
+    bool IsEnabled() const { return !mElements.empty(); }
+
+    // @return false if [input, input + size) can never be matched by the regex.
+    bool MayMatch(const char* input, size_t size) const;
+
+    // The leading literal part of the shape, checked with memcmp before other elements.
+    const std::string& GetLiteralPrefix() const { return mLiteralPrefix; }
+    size_t GetShapeLength() const { return mElements.size(); }
+
+private:
+    enum ElementType : uint8_t {
+        ELEMENT_LITERAL,
+        ELEMENT_DIGIT,
+        ELEMENT_SPACE,
+        ELEMENT_WORD,
+        ELEMENT_ANY,
+    };
+    struct Element {
+        ElementType type;
+        char ch;
+    };
+
+    static bool HasTopLevelAlternation(const std::string& regex);
+    static bool MatchElement(const Element& element, unsigned char c);
+
+    std::string mLiteralPrefix;
+    std::vector<Element> mElements;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class RegexPrefilterUnittest;
+#endif
+};
+
+} // namespace logtail
@@ -0,0 +1,302 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "TimeFormatParser.h"
+#include <cctype>
+#include <cstring>
+#if defined(_MSC_VER)
+#define strncasecmp _strnicmp
+#endif
+
+namespace logtail {
+
+static const char* kFullMonthNames[] = {"January",
+                                        "February",
+                                        "March",
+                                        "April",
+                                        "May",
+                                        "June",
+                                        "July",
+                                        "August",
+                                        "September",
+                                        "October",
+                                        "November",
+                                        "December"};
+static const char* kShortMonthNames[]
+    = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+// Minutes are cached for years in [1970, 2370), so that the key fits in 32 bits.
+static const int32_t kMinCachedYear = 70;
+static const int32_t kMaxCachedYear = 470;
+
+static inline bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool IsSpace(char c) {
+    return isspace((unsigned char)c) != 0;
+}
+
+// MinuteKey returns a key identifying the minute of @tm, or 0 if it is not cacheable.
+static uint64_t MinuteKey(const struct tm& tm) {
+    if (tm.tm_year < kMinCachedYear || tm.tm_year >= kMaxCachedYear || tm.tm_mon < 0 || tm.tm_mon > 11
+        || tm.tm_mday < 1 || tm.tm_mday > 31 || tm.tm_hour < 0 || tm.tm_hour > 23 || tm.tm_min < 0 || tm.tm_min > 59) {
+        return 0;
+    }
+    uint64_t key = tm.tm_year - kMinCachedYear;
+    key = key * 12 + tm.tm_mon;
+    key = key * 31 + tm.tm_mday - 1;
+    key = key * 24 + tm.tm_hour;
+    key = key * 60 + tm.tm_min;
+    return key + 1;
+}
+
+std::shared_ptr<TimeFormatParser> TimeFormatParser::Compile(const std::string& format) {
+    std::shared_ptr<TimeFormatParser> parser(new TimeFormatParser);
+    if (!parser->CompileFormat(format.c_str())) {
+        return std::shared_ptr<TimeFormatParser>();
+    }
+    // Year is deduced by Strptime if it is not in format.
+    for (const auto& step : parser->mSteps) {
+        if (step.mField == FIELD_YEAR || step.mField == FIELD_YEAR_OF_CENTURY) {
+            return parser;
+        }
+    }
+    return std::shared_ptr<TimeFormatParser>();
+}
+
+void TimeFormatParser::AddNumber(Field field, int32_t width, int32_t min, int32_t max) {
+    mSteps.push_back(Step{STEP_NUMBER, field, 0, width, min, max});
+}
+
+bool TimeFormatParser::CompileFormat(const char* format) {
+    for (const char* f = format; *f != '\0'; ++f) {
+        if (IsSpace(*f)) {
+            if (mSteps.empty() || mSteps.back().mType != STEP_SPACE) {
+                mSteps.push_back(Step{STEP_SPACE, FIELD_NONE, 0, 0, 0, 0});
+            }
+            continue;
+        }
+        if (*f != '%') {
+            mSteps.push_back(Step{STEP_LITERAL, FIELD_NONE, *f, 0, 0, 0});
+            continue;
+        }
+        switch (*++f) {
+            case 'Y':
+                AddNumber(FIELD_YEAR, 4, 0, 9999);
+                break;
+            case 'y':
+                AddNumber(FIELD_YEAR_OF_CENTURY, 2, 0, 99);
+                break;
+            case 'm':
+                AddNumber(FIELD_MONTH, 2, 1, 12);
+                break;
+            case 'd':
+            case 'e':
+                AddNumber(FIELD_DAY, 2, 1, 31);
+                break;
+            case 'H':
+                AddNumber(FIELD_HOUR, 2, 0, 23);
+                break;
+            case 'M':
+                AddNumber(FIELD_MINUTE, 2, 0, 59);
+                break;
+            case 'S':
+                AddNumber(FIELD_SECOND, 2, 0, 61);
+                break;
+            case 'b':
+            case 'h':
+            case 'B':
+                mSteps.push_back(Step{STEP_MONTH_NAME, FIELD_MONTH, 0, 0, 0, 0});
+                break;
+            case 'z':
+                mSteps.push_back(Step{STEP_TIMEZONE, FIELD_NONE, 0, 0, 0, 0});
+                break;
+            case 'F':
+                if (!CompileFormat("%Y-%m-%d")) {
+                    return false;
+                }
+                break;
+            case 'T':
+                if (!CompileFormat("%H:%M:%S")) {
+                    return false;
+                }
+                break;
+            case 'R':
+                if (!CompileFormat("%H:%M")) {
+                    return false;
+                }
+                break;
+            case 'n':
+            case 't':
+                if (mSteps.empty() || mSteps.back().mType != STEP_SPACE) {
+                    mSteps.push_back(Step{STEP_SPACE, FIELD_NONE, 0, 0, 0, 0});
+                }
+                break;
+            case '%':
+                mSteps.push_back(Step{STEP_LITERAL, FIELD_NONE, '%', 0, 0, 0});
+                break;
+            default:
+                // Other directives, modifiers or a trailing '%'.
+                return false;
+        }
+    }
+    return true;
+}
+
+const char* TimeFormatParser::Parse(const char* buf, time_t& logTime, bool& fixedWidth) const {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    fixedWidth = true;
+    const char* p = buf;
+    for (const Step& step : mSteps) {
+        switch (step.mType) {
+            case STEP_LITERAL:
+                if (*p != step.mLiteral) {
+                    return NULL;
+                }
+                ++p;
+                break;
+            case STEP_SPACE:
+                while (IsSpace(*p)) {
+                    ++p;
+                }
+                break;
+            case STEP_NUMBER: {
+                // Same as get_number of glibc strptime, which stops early if the next digit
+                //  would make the value exceed the max.
+                while (IsSpace(*p)) {
+                    ++p;
+                }
+                if (!IsDigit(*p)) {
+                    return NULL;
+                }
+                int32_t value = 0, digits = 0, remain = step.mWidth;
+                do {
+                    value = value * 10 + (*p++ - '0');
+                    ++digits;
+                } while (--remain > 0 && value * 10 <= step.mMax && IsDigit(*p));
+                if (value < step.mMin || value > step.mMax) {
+                    return NULL;
+                }
+                if (digits < step.mWidth) {
+                    fixedWidth = false;
+                }
+                switch (step.mField) {
+                    case FIELD_YEAR:
+                        tm.tm_year = value - 1900;
+                        break;
+                    case FIELD_YEAR_OF_CENTURY:
+                        tm.tm_year = value >= 69 ? value : value + 100;
+                        break;
+                    case FIELD_MONTH:
+                        tm.tm_mon = value - 1;
+                        break;
+                    case FIELD_DAY:
+                        tm.tm_mday = value;
+                        break;
+                    case FIELD_HOUR:
+                        tm.tm_hour = value;
+                        break;
+                    case FIELD_MINUTE:
+                        tm.tm_min = value;
+                        break;
+                    case FIELD_SECOND:
+                        tm.tm_sec = value;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            }
+            case STEP_MONTH_NAME: {
+                // Full names are tried first, like strptime.
+                int32_t month = 0;
+                for (; month < 12; ++month) {
+                    size_t len = strlen(kFullMonthNames[month]);
+                    if (strncasecmp(p, kFullMonthNames[month], len) == 0) {
+                        p += len;
+                        break;
+                    }
+                    if (strncasecmp(p, kShortMonthNames[month], 3) == 0) {
+                        p += 3;
+                        break;
+                    }
+                }
+                if (month == 12) {
+                    return NULL;
+                }
+                // A trailing short name may be the beginning of a full name.
+                if (&step == &mSteps.back()) {
+                    fixedWidth = false;
+                }
+                tm.tm_mon = month;
+                break;
+            }
+            case STEP_TIMEZONE: {
+                // Z, +hh, +hhmm or +hh:mm, the offset is not used since mktime ignores it.
+                while (IsSpace(*p)) {
+                    ++p;
+                }
+                if (*p == 'Z') {
+                    ++p;
+                    break;
+                }
+                if (*p != '+' && *p != '-') {
+                    return NULL;
+                }
+                ++p;
+                int32_t value = 0, digits = 0;
+                while (digits < 4 && IsDigit(*p)) {
+                    value = value * 10 + (*p++ - '0');
+                    ++digits;
+                    if (*p == ':' && digits == 2 && IsDigit(*(p + 1))) {
+                        ++p;
+                    }
+                }
+                if ((digits != 2 && digits != 4) || (digits == 4 && value % 100 >= 60)) {
+                    return NULL;
+                }
+                if (digits == 2) {
+                    fixedWidth = false;
+                }
+                break;
+            }
+        }
+    }
+    tm.tm_isdst = -1;
+    logTime = ToTime(tm);
+    return p;
+}
+
+time_t TimeFormatParser::ToTime(const struct tm& parsed) const {
+    const uint64_t key = MinuteKey(parsed);
+    if (key != 0) {
+        uint64_t lastMinute = mLastMinute.load(std::memory_order_relaxed);
+        if ((lastMinute >> 32) == key) {
+            return (time_t)(lastMinute & 0xFFFFFFFFULL) * 60 + parsed.tm_sec;
+        }
+    }
+    struct tm tm = parsed;
+    tm.tm_sec = 0;
+    time_t minuteStart = mktime(&tm);
+    if (key == 0 || minuteStart <= 0 || minuteStart % 60 != 0) {
+        tm = parsed;
+        return mktime(&tm);
+    }
+    mLastMinute.store((key << 32) | (uint64_t)(minuteStart / 60), std::memory_order_relaxed);
+    return minuteStart + parsed.tm_sec;
+}
+
+} // namespace logtail
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace logtail {
+
+// TimeFormatParser compiles a strptime format into a list of steps, so that time strings
+//  are parsed without interpreting the format again, and converted to time_t without
+//  mktime for logs in the same minute as the previous one.
+//
+// Only formats with year and the following directives are compiled:
+//  %Y %y %m %d %e %H %M %S %b %h %B %z %F %T %R %n %t %%.
+// They cover common layouts like "%Y-%m-%d %H:%M:%S" and "%d/%b/%Y:%H:%M:%S %z",
+//  trailing fractional seconds are left unparsed as strptime does. The result is the
+//  same as Strptime + mktime, %z is skipped since mktime ignores it.
+class TimeFormatParser {
+public:
+    // Compile returns NULL if @format is not supported, callers should use Strptime then.
+    static std::shared_ptr<TimeFormatParser> Compile(const std::string& format);
+
+    // Parse parses the beginning of @buf to @logTime (local time), returns the end of parsed
+    //  part, or NULL if @buf does not match the format.
+    // @fixedWidth is set to false if the parsed part can not be used as prefix to match
+    //  strings of the same second, e.g. some number is shorter than its field width.
+    // It can be called concurrently.
+    const char* Parse(const char* buf, time_t& logTime, bool& fixedWidth) const;
+
+private:
+    enum StepType { STEP_LITERAL, STEP_SPACE, STEP_NUMBER, STEP_MONTH_NAME, STEP_TIMEZONE };
+    enum Field { FIELD_NONE, FIELD_YEAR, FIELD_YEAR_OF_CENTURY, FIELD_MONTH, FIELD_DAY, FIELD_HOUR, FIELD_MINUTE, FIELD_SECOND };
+
+    struct Step {
+        StepType mType;
+        Field mField;
+        char mLiteral;
+        int32_t mWidth;
+        int32_t mMin;
+        int32_t mMax;
+    };
+
+    TimeFormatParser() = default;
+
+    bool CompileFormat(const char* format);
+    void AddNumber(Field field, int32_t width, int32_t min, int32_t max);
+    time_t ToTime(const struct tm& tm) const;
+
+    std::vector<Step> mSteps;
+    // Last parsed minute, minute key in high 32 bits and its epoch in minutes in low 32 bits.
+    mutable std::atomic<uint64_t> mLastMinute{0};
+};
+
+} // namespace logtail
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "Config.h"
+#include <atomic>
 #if defined(__linux__)
 #include <fnmatch.h>
 #endif
@@ -81,6 +82,11 @@ Config::AdvancedConfig::AdvancedConfig()
       mSearchCheckpointDirDepth(static_cast<uint16_t>(INT32_FLAG(search_checkpoint_default_dir_depth))) {
 }
 
+uint64_t Config::NewInstanceId() {
+    static std::atomic<uint64_t> sNextId(1);
+    return sNextId.fetch_add(1, std::memory_order_relaxed);
+}
+
 Config::Config(const std::string& basePath,
                const std::string& filePattern,
                LogType logType,
@@ -558,6 +564,7 @@ LogFileReader* Config::CreateLogFileReader(const std::string& dir,
                                        mDockerFileFlag);
         JsonLogFileReader* jsonLogFileReader = static_cast<JsonLogFileReader*>(reader);
         jsonLogFileReader->SetTimeKey(mTimeKey);
+        jsonLogFileReader->SetFastParse(mAdvancedConfig.mJsonFastParse);
     } else {
         LOG_ERROR(sLogger, ("not supported log type", mLogType)("dir", dir)("file", file));
     }
@@ -20,7 +20,9 @@
 #include <list>
 #include <boost/regex.hpp>
 #include <re2/re2.h>
+#include <re2/set.h>
 #include "DockerFileConfig.h"
+#include "common/CompressTools.h"
 #include "common/EncodingConverter.h"
 #include "common/LogstoreFeedbackQueue.h"
 #include "common/Flags.h"
@@ -80,6 +82,7 @@ public:
 
         bool mForceMultiConfig = false; // force collect file and ignore other config
         bool mExtractPartialFields = false;
+        bool mJsonFastParse = false; // scan JSON logs without DOM, see JsonObjectScanner.
         bool mPassTagsToPlugin = true; // pass file tags to plugin system.
         std::string mRawLogTag; // if mUploadRawLog is true, use this string as raw log tag
         int32_t mBatchSendInterval;
@@ -148,15 +151,26 @@ public:
     std::vector<std::string> mShardHashKey;
     bool mTailExisted;
     std::unordered_map<std::string, std::vector<SensitiveWordCastOption>> mSensitiveWordCastOptions;
+    // All regexes of mSensitiveWordCastOptions[key] in one set, to find matched options in one pass.
+    // Only for keys with multiple options.
+    std::unordered_map<std::string, std::shared_ptr<re2::RE2::Set>> mSensitiveWordCastSets;
     bool mUploadRawLog; // true to update raw log to sls
     bool mSimpleLogFlag;
     bool mTimeZoneAdjust;
     int mLogTimeZoneOffsetSecond;
     int32_t mCreateTime; // create time of this config
+    // Unique in the process, configs loaded again with the same name have different ids. Caches
+    //  computed from a config are checked by it.
+    uint64_t mInstanceId = NewInstanceId();
     int32_t
         mMaxSendBytesPerSecond; // limit for logstore, not just this config. so if we have multi configs with different
                                 // mMaxSendBytesPerSecond, this logstore's limit will be a random mMaxSendBytesPerSecond
     int32_t mSendRateExpireTime; // send rate expire time, along with mMaxSendBytesPerSecond
+    // read budget of logstore, shared by configs like mMaxSendBytesPerSecond, <= 0 means no limit
+    int64_t mMaxReadBytesPerSecond = -1;
+    // codec to compress data sent to SLS, it is set to logstore like mMaxSendBytesPerSecond
+    CompressType mCompressType = COMPRESS_LZ4;
+    int32_t mCompressLevel = 0; // for zstd, 0 means default level
     int64_t mLogDelayAlarmBytes; // if <=0, discard it, default 0.
     LogstoreFeedBackKey mLogstoreKey;
     int32_t mPriority; // default is 0(no priority); 1-3, max priority is 1
@@ -207,6 +221,8 @@ public:
     bool mObserverFlag = false; // network observer config flag
     std::string mObserverConfig; // network observer config detail
 
+    static uint64_t NewInstanceId();
+
     Config() {
         mSimpleLogFlag = false;
         mCreateTime = 0;
@@ -0,0 +1,200 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ConfigPathIndex.h"
+#if defined(__linux__)
+#include <fnmatch.h>
+#endif
+#include "common/FileSystemUtil.h"
+#include "common/StringTools.h"
+#include "config/Config.h"
+
+namespace logtail {
+
+// Characters which have special meaning in fnmatch patterns.
+static const char* kPatternSpecialChars = "*?[\\";
+
+FilePatternMatcher::FilePatternMatcher(const std::string& pattern) : mType(MATCH_FNMATCH), mPattern(pattern) {
+    if (pattern.find_first_not_of('*') == std::string::npos && !pattern.empty()) {
+        mType = MATCH_ALL;
+        return;
+    }
+    size_t pos = pattern.find_first_of(kPatternSpecialChars);
+    if (pos == std::string::npos) {
+        mType = MATCH_EXACT;
+        mLiteral = pattern;
+    } else if (pos == pattern.size() - 1 && pattern[pos] == '*') {
+        mType = MATCH_PREFIX;
+        mLiteral = pattern.substr(0, pos);
+    } else if (pos == 0 && pattern[0] == '*' && pattern.find_first_of(kPatternSpecialChars, 1) == std::string::npos) {
+        mType = MATCH_SUFFIX;
+        mLiteral = pattern.substr(1);
+    }
+}
+
+bool FilePatternMatcher::Match(const std::string& name) const {
+    switch (mType) {
+        case MATCH_ALL:
+            return true;
+        case MATCH_EXACT:
+            return name == mLiteral;
+        case MATCH_PREFIX:
+            return name.size() >= mLiteral.size() && name.compare(0, mLiteral.size(), mLiteral) == 0;
+        case MATCH_SUFFIX:
+            return name.size() >= mLiteral.size()
+                && name.compare(name.size() - mLiteral.size(), mLiteral.size(), mLiteral) == 0;
+        default:
+            return fnmatch(mPattern.c_str(), name.c_str(), 0) == 0;
+    }
+}
+
+ConfigPathIndex::ConfigPathIndex() : mRoot(new Node) {
+}
+
+ConfigPathIndex::~ConfigPathIndex() {
+}
+
+bool ConfigPathIndex::GetIndexKey(const Config* config, std::vector<std::string>& key) {
+    // Paths of docker file configs are mapped to container paths.
+    if (config->mDockerFileFlag) {
+        return false;
+    }
+    const bool isWildcard = !config->mWildcardPaths.empty();
+    const std::string& basePath = config->mBasePath;
+    size_t begin = 0;
+    while (begin < basePath.size()) {
+        size_t end = basePath.find(PATH_SEPARATOR[0], begin);
+        if (end == std::string::npos) {
+            end = basePath.size();
+        }
+        if (end > begin) {
+            std::string dirName = basePath.substr(begin, end - begin);
+            // Directories after the first wildcard one are matched by fnmatch.
+            if (isWildcard && dirName.find_first_of(kPatternSpecialChars) != std::string::npos) {
+                break;
+            }
+            key.push_back(dirName);
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+void ConfigPathIndex::Add(Config* config) {
+    if (mConfigKeys.find(config) != mConfigKeys.end()) {
+        Remove(config);
+    }
+    std::vector<std::string> key;
+    if (!GetIndexKey(config, key)) {
+        mUnindexedEntries.emplace_back(config, config->mFilePattern);
+        mConfigKeys[config] = std::make_pair(false, key);
+        return;
+    }
+    Node* node = mRoot.get();
+    for (const auto& dirName : key) {
+        std::unique_ptr<Node>& child = node->mChildren[dirName];
+        if (!child) {
+            child.reset(new Node);
+        }
+        node = child.get();
+    }
+    node->mEntries.emplace_back(config, config->mFilePattern);
+    mConfigKeys[config] = std::make_pair(true, std::move(key));
+}
+
+bool ConfigPathIndex::RemoveEntry(std::vector<Entry>& entries, const Config* config) {
+    for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+        if (iter->mConfig == config) {
+            entries.erase(iter);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConfigPathIndex::Remove(Config* config) {
+    auto keyIter = mConfigKeys.find(config);
+    if (keyIter == mConfigKeys.end()) {
+        return;
+    }
+    if (!keyIter->second.first) {
+        RemoveEntry(mUnindexedEntries, config);
+        mConfigKeys.erase(keyIter);
+        return;
+    }
+    const std::vector<std::string>& key = keyIter->second.second;
+    std::vector<Node*> nodes(1, mRoot.get());
+    for (const auto& dirName : key) {
+        auto iter = nodes.back()->mChildren.find(dirName);
+        if (iter == nodes.back()->mChildren.end()) {
+            break;
+        }
+        nodes.push_back(iter->second.get());
+    }
+    if (nodes.size() == key.size() + 1) {
+        RemoveEntry(nodes.back()->mEntries, config);
+        // Prune nodes which have no configs and children.
+        for (size_t i = key.size(); i > 0; --i) {
+            if (!nodes[i]->mEntries.empty() || !nodes[i]->mChildren.empty()) {
+                break;
+            }
+            nodes[i - 1]->mChildren.erase(key[i - 1]);
+        }
+    }
+    mConfigKeys.erase(keyIter);
+}
+
+void ConfigPathIndex::Clear() {
+    mRoot.reset(new Node);
+    mUnindexedEntries.clear();
+    mConfigKeys.clear();
+}
+
+void ConfigPathIndex::AppendCandidates(const std::vector<Entry>& entries,
+                                       const std::string& name,
+                                       std::vector<Config*>& candidates) {
+    for (const auto& entry : entries) {
+        if (name.empty() || entry.mFilePatternMatcher.Match(name)) {
+            candidates.push_back(entry.mConfig);
+        }
+    }
+}
+
+void ConfigPathIndex::FindCandidates(const std::string& path,
+                                     const std::string& name,
+                                     std::vector<Config*>& candidates) const {
+    const Node* node = mRoot.get();
+    AppendCandidates(node->mEntries, name, candidates);
+    size_t begin = 0;
+    std::string dirName;
+    while (begin < path.size() && !node->mChildren.empty()) {
+        size_t end = path.find(PATH_SEPARATOR[0], begin);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        if (end > begin) {
+            dirName.assign(path, begin, end - begin);
+            auto iter = node->mChildren.find(dirName);
+            if (iter == node->mChildren.end()) {
+                break;
+            }
+            node = iter->second.get();
+            AppendCandidates(node->mEntries, name, candidates);
+        }
+        begin = end + 1;
+    }
+    AppendCandidates(mUnindexedEntries, name, candidates);
+}
+
+} // namespace logtail
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace logtail {
+
+class Config;
+
+// FilePatternMatcher is the compiled form of Config::mFilePattern, common patterns like
+//  "*", "access.log", "*.log" or "app_*" are matched without fnmatch.
+class FilePatternMatcher {
+public:
+    explicit FilePatternMatcher(const std::string& pattern);
+
+    // Match returns the same result as fnmatch(pattern, name, 0) == 0.
+    bool Match(const std::string& name) const;
+
+private:
+    enum MatchType { MATCH_ALL, MATCH_EXACT, MATCH_PREFIX, MATCH_SUFFIX, MATCH_FNMATCH };
+
+    MatchType mType;
+    std::string mPattern;
+    // Literal part of pattern for MATCH_EXACT, MATCH_PREFIX and MATCH_SUFFIX.
+    std::string mLiteral;
+};
+
+// ConfigPathIndex is a prefix trie of directory names to find configs which may match a path,
+//  so that matching a path does not need to call Config::IsMatch for every config.
+//
+// A config is attached to the node of its constant path prefix: mBasePath, or the directories
+//  before the first wildcard directory if it is a wildcard path. Looking up a path visits the
+//  nodes of its directories only, configs attached to them and configs which can not be indexed
+//  (docker file configs, whose paths are container paths) are candidates, and the file name is
+//  checked by compiled file pattern.
+// Candidates must be checked with Config::IsMatch, the index is only a filter.
+//
+// It is not thread-safe, it is modified along with ConfigManagerBase::mNameConfigMap.
+class ConfigPathIndex {
+public:
+    ConfigPathIndex();
+    ~ConfigPathIndex();
+
+    void Add(Config* config);
+    void Remove(Config* config);
+    void Clear();
+    size_t Size() const { return mConfigKeys.size(); }
+
+    // FindCandidates appends configs which may match object (@path, @name) to @candidates.
+    void FindCandidates(const std::string& path, const std::string& name, std::vector<Config*>& candidates) const;
+
+private:
+    struct Entry {
+        Entry(Config* config, const std::string& filePattern) : mConfig(config), mFilePatternMatcher(filePattern) {}
+
+        Config* mConfig;
+        FilePatternMatcher mFilePatternMatcher;
+    };
+
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> mChildren;
+        std::vector<Entry> mEntries;
+    };
+
+    // GetIndexKey splits the constant path prefix of @config into directory names, returns false
+    //  if @config can not be indexed by path.
+    static bool GetIndexKey(const Config* config, std::vector<std::string>& key);
+    static void AppendCandidates(const std::vector<Entry>& entries,
+                                 const std::string& name,
+                                 std::vector<Config*>& candidates);
+    static bool RemoveEntry(std::vector<Entry>& entries, const Config* config);
+
+    std::unique_ptr<Node> mRoot;
+    std::vector<Entry> mUnindexedEntries;
+    // Index key of each config, used to remove it even if its path is changed after added.
+    std::unordered_map<const Config*, std::pair<bool, std::vector<std::string>>> mConfigKeys;
+};
+
+} // namespace logtail
@@ -55,6 +55,16 @@ void UserLogConfigParser::ParseAdvancedConfig(const Json::Value& originalVal, Co
             cfg.mAdvancedConfig.mExtractPartialFields = GetBoolValue(advancedVal, "extract_partial_fields");
         }
     }
+    // scan JSON_LOG lines without DOM, values are kept as they are written.
+    if (cfg.mLogType == JSON_LOG) {
+        const Json::Value& val = advancedVal["json_fast_parse"];
+        if (val.isBool()) {
+            cfg.mAdvancedConfig.mJsonFastParse = val.asBool();
+            LOG_INFO(sLogger,
+                     ("set json fast parse",
+                      cfg.mAdvancedConfig.mJsonFastParse)("project", cfg.mProjectName)("config", cfg.mConfigName));
+        }
+    }
     // raw log tag
     if (advancedVal.isMember("raw_log_tag") && advancedVal["raw_log_tag"].isString()) {
         std::string rawLogTag = GetStringValue(advancedVal, "raw_log_tag");
@@ -717,6 +717,15 @@ void ConfigManagerBase::LoadSingleUserConfig(const std::string& logName, const J
                     }
                     Sender::Instance()->SetLogstoreFlowControl(config->mLogstoreKey, maxSendBytesPerSecond, expireTime);
                 }
+                if (value.isMember("max_read_rate") && value["max_read_rate"].isInt()) {
+                    config->mMaxReadBytesPerSecond = value["max_read_rate"].asInt64();
+                    if (config->mMaxReadBytesPerSecond > 0) {
+                        LOG_INFO(sLogger,
+                                 ("set logstore read budget, project", config->mProjectName)(
+                                     "logstore", config->mCategory)("max read byteps", config->mMaxReadBytesPerSecond));
+                    }
+                }
+                GetCompressOption(value, config);
                 config->mPriority = 0;
                 if (value.isMember("priority") && value["priority"].isInt()) {
                     int32_t priority = value["priority"].asInt();
@@ -857,6 +866,7 @@ void ConfigManagerBase::LoadSingleUserConfig(const std::string& logName, const J
                         "max send byteps", config->mMaxSendBytesPerSecond)("expire", expireTime - (int32_t)time(NULL)));
                 Sender::Instance()->SetLogstoreFlowControl(config->mLogstoreKey, maxSendBytesPerSecond, expireTime);
             }
+            GetCompressOption(value, config);
 
             if (value.isMember("sensitive_keys") && value["sensitive_keys"].isArray()) {
                 GetSensitiveKeys(value["sensitive_keys"], config);
@@ -938,11 +948,17 @@ void ConfigManagerBase::LoadSingleUserConfig(const std::string& logName, const J
                 LOG_ERROR(sLogger,
                           ("duplicated config name, last will be deleted",
                            logName)("last", configIter->second->mBasePath)("new", config->mBasePath));
+                mConfigPathIndex.Remove(configIter->second);
                 delete configIter->second;
                 configIter->second = config;
             } else {
                 mNameConfigMap[logName] = config;
             }
+            // exclude __FUSE_CONFIG__ and configs without files from matching
+            if (config->mLogType != STREAM_LOG && config->mLogType != PLUGIN_LOG
+                && logName != STRING_FLAG(fuse_customized_config_name)) {
+                mConfigPathIndex.Add(config);
+            }
             InsertProject(config->mProjectName);
             InsertRegion(config->mRegion);
             UpdatePluginStats(rawValue);
@@ -1027,6 +1043,8 @@ LogFilterRule* ConfigManagerBase::GetFilterFule(const Json::Value& filterKeys, c
         try {
             rulePtr->FilterKeys.push_back(filterKeys[i].asString());
             rulePtr->FilterRegs.push_back(boost::regex(filterRegs[i].asString()));
+            rulePtr->RawLineSearchable.push_back(
+                LogFilter::IsRawLineSearchable(filterKeys[i].asString(), filterRegs[i].asString()));
         } catch (const exception& e) {
             LOG_WARNING(sLogger, ("The filter is invalid", e.what()));
             delete rulePtr;
@@ -1519,7 +1537,8 @@ Config* ConfigManagerBase::FindBestMatch(const string& path, const string& name)
             }
         }
     }
-    unordered_map<string, Config*>::iterator itr = mNameConfigMap.begin();
+    vector<Config*> candidates;
+    mConfigPathIndex.FindCandidates(path, name, candidates);
     Config* prevMatch = NULL;
     size_t prevLen = 0;
     int32_t preCreateTime = INT_MAX;
@@ -1527,39 +1546,32 @@ Config* ConfigManagerBase::FindBestMatch(const string& path, const string& name)
     uint32_t nameRepeat = 0;
     string logNameList;
     vector<Config*> multiConfigs;
-    for (; itr != mNameConfigMap.end(); ++itr) {
-        Config* config = itr->second;
-        if (config->mLogType != STREAM_LOG && config->mLogType != PLUGIN_LOG) {
-            // exclude __FUSE_CONFIG__
-            if (itr->first == STRING_FLAG(fuse_customized_config_name)) {
-                continue;
+    for (vector<Config*>::iterator itr = candidates.begin(); itr != candidates.end(); ++itr) {
+        Config* config = *itr;
+        bool match = config->IsMatch(path, name);
+        if (match) {
+            // if force multi config, do not send alarm
+            if (!name.empty() && !config->mAdvancedConfig.mForceMultiConfig) {
+                nameRepeat++;
+                logNameList.append("logstore:");
+                logNameList.append(config->mCategory);
+                logNameList.append(",config:");
+                logNameList.append(config->mConfigName);
+                logNameList.append(" ");
+                multiConfigs.push_back(config);
             }
 
-            bool match = config->IsMatch(path, name);
-            if (match) {
-                // if force multi config, do not send alarm
-                if (!name.empty() && !config->mAdvancedConfig.mForceMultiConfig) {
-                    nameRepeat++;
-                    logNameList.append("logstore:");
-                    logNameList.append(config->mCategory);
-                    logNameList.append(",config:");
-                    logNameList.append(config->mConfigName);
-                    logNameList.append(" ");
-                    multiConfigs.push_back(config);
-                }
-
-                // note: best config is the one which length is longest and create time is nearest
-                curLen = config->mBasePath.size();
-                if (prevLen < curLen) {
+            // note: best config is the one which length is longest and create time is nearest
+            curLen = config->mBasePath.size();
+            if (prevLen < curLen) {
+                prevMatch = config;
+                preCreateTime = config->mCreateTime;
+                prevLen = curLen;
+            } else if (prevLen == curLen && prevMatch != NULL) {
+                if (prevMatch->mCreateTime > config->mCreateTime) {
                     prevMatch = config;
                     preCreateTime = config->mCreateTime;
                     prevLen = curLen;
-                } else if (prevLen == curLen && prevMatch != NULL) {
-                    if (prevMatch->mCreateTime > config->mCreateTime) {
-                        prevMatch = config;
-                        preCreateTime = config->mCreateTime;
-                        prevLen = curLen;
-                    }
                 }
             }
         }
@@ -1609,19 +1621,13 @@ ConfigManagerBase::FindAllMatch(vector<Config*>& allConfig, const std::string& p
         }
     }
     bool alarmFlag = false;
-    unordered_map<string, Config*>::iterator itr = mNameConfigMap.begin();
-    for (; itr != mNameConfigMap.end(); ++itr) {
-        Config* config = itr->second;
-        if (config->mLogType != STREAM_LOG && config->mLogType != PLUGIN_LOG) {
-            // exclude __FUSE_CONFIG__
-            if (itr->first == STRING_FLAG(fuse_customized_config_name)) {
-                continue;
-            }
-
-            bool match = config->IsMatch(path, name);
-            if (match) {
-                allConfig.push_back(itr->second);
-            }
+    vector<Config*> candidates;
+    mConfigPathIndex.FindCandidates(path, name, candidates);
+    for (vector<Config*>::iterator itr = candidates.begin(); itr != candidates.end(); ++itr) {
+        Config* config = *itr;
+        bool match = config->IsMatch(path, name);
+        if (match) {
+            allConfig.push_back(config);
         }
     }
 
@@ -1657,7 +1663,8 @@ ConfigManagerBase::FindMatchWithForceFlag(std::vector<Config*>& allConfig, const
             }
         }
     }
-    auto itr = mNameConfigMap.begin();
+    vector<Config*> candidates;
+    mConfigPathIndex.FindCandidates(path, name, candidates);
     Config* prevMatch = NULL;
     size_t prevLen = 0;
     int32_t preCreateTime = INT_MAX;
@@ -1665,45 +1672,38 @@ ConfigManagerBase::FindMatchWithForceFlag(std::vector<Config*>& allConfig, const
     uint32_t nameRepeat = 0;
     string logNameList;
     vector<Config*> multiConfigs;
-    for (; itr != mNameConfigMap.end(); ++itr) {
-        Config* config = itr->second;
-        if (config->mLogType != STREAM_LOG && config->mLogType != PLUGIN_LOG) {
-            // exclude __FUSE_CONFIG__
-            if (itr->first == STRING_FLAG(fuse_customized_config_name)) {
-                continue;
+    for (auto itr = candidates.begin(); itr != candidates.end(); ++itr) {
+        Config* config = *itr;
+        bool match = config->IsMatch(path, name);
+        if (match) {
+            // if force multi config, do not send alarm
+            if (!name.empty() && !config->mAdvancedConfig.mForceMultiConfig) {
+                nameRepeat++;
+                logNameList.append("logstore:");
+                logNameList.append(config->mCategory);
+                logNameList.append(",config:");
+                logNameList.append(config->mConfigName);
+                logNameList.append(" ");
+                multiConfigs.push_back(config);
             }
-
-            bool match = config->IsMatch(path, name);
-            if (match) {
-                // if force multi config, do not send alarm
-                if (!name.empty() && !config->mAdvancedConfig.mForceMultiConfig) {
-                    nameRepeat++;
-                    logNameList.append("logstore:");
-                    logNameList.append(config->mCategory);
-                    logNameList.append(",config:");
-                    logNameList.append(config->mConfigName);
-                    logNameList.append(" ");
-                    multiConfigs.push_back(config);
-                }
-                if (!config->mAdvancedConfig.mForceMultiConfig) {
-                    // if not ForceMultiConfig, find best match in normal cofigs
-                    // note: best config is the one which length is longest and create time is nearest
-                    curLen = config->mBasePath.size();
-                    if (prevLen < curLen) {
+            if (!config->mAdvancedConfig.mForceMultiConfig) {
+                // if not ForceMultiConfig, find best match in normal cofigs
+                // note: best config is the one which length is longest and create time is nearest
+                curLen = config->mBasePath.size();
+                if (prevLen < curLen) {
+                    prevMatch = config;
+                    preCreateTime = config->mCreateTime;
+                    prevLen = curLen;
+                } else if (prevLen == curLen && prevMatch != NULL) {
+                    if (prevMatch->mCreateTime > config->mCreateTime) {
                         prevMatch = config;
                         preCreateTime = config->mCreateTime;
                         prevLen = curLen;
-                    } else if (prevLen == curLen && prevMatch != NULL) {
-                        if (prevMatch->mCreateTime > config->mCreateTime) {
-                            prevMatch = config;
-                            preCreateTime = config->mCreateTime;
-                            prevLen = curLen;
-                        }
                     }
-                } else {
-                    // save ForceMultiConfig
-                    allConfig.push_back(config);
                 }
+            } else {
+                // save ForceMultiConfig
+                allConfig.push_back(config);
             }
         }
     }
@@ -1786,6 +1786,7 @@ void ConfigManagerBase::RemoveAllConfigs() {
     }
 
     mNameConfigMap.clear();
+    mConfigPathIndex.Clear();
     ScopedSpinLock lock(mCacheFileConfigMapLock);
     mCacheFileConfigMap.clear();
     ScopedSpinLock allLock(mCacheFileAllConfigMapLock);
@@ -2263,6 +2264,32 @@ void ConfigManagerBase::GetSensitiveKeys(const Json::Value& value, Config* pConf
             // throw ExceptionBase(string("The sensitive key config is invalid, config : ") + pConfig->mConfigName);
         }
     }
+    pConfig->mSensitiveWordCastSets.clear();
+    for (const auto& iter : pConfig->mSensitiveWordCastOptions) {
+        if (iter.second.size() > 1) {
+            std::shared_ptr<re2::RE2::Set> regexSet = LogFilter::CompileSensitiveWordCastSet(iter.second);
+            if (regexSet) {
+                pConfig->mSensitiveWordCastSets[iter.first] = regexSet;
+            }
+        }
+    }
+}
+
+void ConfigManagerBase::GetCompressOption(const Json::Value& value, Config* pConfig) {
+    pConfig->mCompressType = COMPRESS_LZ4;
+    pConfig->mCompressLevel = GetIntValue(value, "compress_level", 0);
+    std::string compressType = GetStringValue(value, "compress_type", "");
+    if (!compressType.empty() && !StringToCompressType(compressType, pConfig->mCompressType)) {
+        LOG_ERROR(sLogger,
+                  ("invalid compress type, use lz4", compressType)("project", pConfig->mProjectName)(
+                      "logstore", pConfig->mCategory));
+        LogtailAlarm::GetInstance()->SendAlarm(CATEGORY_CONFIG_ALARM,
+                                               "invalid compress type: " + compressType,
+                                               pConfig->GetProjectName(),
+                                               pConfig->GetCategory());
+    }
+    Sender::Instance()->SetLogstoreCompressType(
+        pConfig->mLogstoreKey, pConfig->mCompressType, pConfig->mCompressLevel);
 }
 
 bool ConfigManagerBase::GetLocalConfigUpdate() {
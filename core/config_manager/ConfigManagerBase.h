@@ -28,6 +28,7 @@
 #include "common/MemoryBarrier.h"
 #include "common/LogstoreFeedbackQueue.h"
 #include "config/Config.h"
+#include "config/ConfigPathIndex.h"
 #include "common/MemoryBarrier.h"
 #include "common/Lock.h"
 #include "common/Thread.h"
@@ -70,6 +71,8 @@ protected:
     std::unordered_map<std::string, std::unordered_map<std::string, int>> mPluginStats;
 
     std::unordered_map<std::string, Config*> mNameConfigMap;
+    // index of file configs in mNameConfigMap by path, used by FindBestMatch and FindAllMatch
+    ConfigPathIndex mConfigPathIndex;
     EventHandler* mSharedHandler;
     // one modify handler corresponds to one "leaf" directory
     std::unordered_map<std::string, EventHandler*> mDirEventHandlerMap;
@@ -453,6 +456,7 @@ private:
     LogFilterRule* GetFilterFule(const Json::Value& filterKeys, const Json::Value& filterRegs);
     void GetRegexAndKeys(const Json::Value& value, Config* configPtr);
     void GetSensitiveKeys(const Json::Value& value, Config* pConfig);
+    void GetCompressOption(const Json::Value& value, Config* pConfig);
 
     /**
      * @brief Load user_local_config.json from sys_conf_dir
@@ -501,6 +505,7 @@ private:
 
     friend class EventDispatcherTest;
     friend class SenderUnittest;
+    friend class AggregatorUnittest;
     friend class UtilUnittest;
     friend class ConfigUpdatorUnittest;
     friend class ConfigMatchUnittest;
@@ -1275,12 +1275,9 @@ void EventDispatcherBase::DumpCheckPointPeriod(int32_t curTime) {
         LogInput::GetInstance()->HoldOn();
         DumpAllHandlersMeta(false);
 
-        if (!(CheckPointManager::Instance()->DumpCheckPointToLocal()))
-            LOG_WARNING(sLogger, ("dump checkpoint to local", "fail"));
-        else
-            LOG_DEBUG(sLogger, ("dump checkpoint to local", "success"));
-        // after save checkpoint, we should clear all checkpoint
-        CheckPointManager::Instance()->RemoveAllCheckPoint();
+        // checkpoints are written by the dump thread of checkpoint manager, and they are
+        // cleared here as before
+        CheckPointManager::Instance()->DumpCheckPointInBackground();
         LogInput::GetInstance()->Resume(false);
         LOG_INFO(sLogger, ("Finish dump checkpoint, LogInput resumed", curTime));
     }
@@ -31,6 +31,8 @@
 #include "fuse/FuseFileBlacklist.h"
 #include "common/LogFileCollectOffsetIndicator.h"
 #include "LogInput.h"
+#include "LogReaderThreadPool.h"
+#include "ReadScheduler.h"
 
 using namespace std;
 using namespace sls_logs;
@@ -300,6 +302,11 @@ ModifyHandler::ModifyHandler(const std::string& configName, Config* pConfig) : m
     } else {
         mReadFileTimeSlice = INT64_FLAG(read_file_time_slice);
     }
+    if (pConfig != NULL) {
+        ReadScheduler::GetInstance()->SetQuota(pConfig->mLogstoreKey,
+                                               ReadScheduler::GetWeight(pConfig->mPriority),
+                                               pConfig->mMaxReadBytesPerSecond);
+    }
     mLastOverflowErrorTime = 0;
 }
 
@@ -453,7 +460,8 @@ void ModifyHandler::Handle(const Event& event) {
             // only set when reader array size is 1
             if (readerArray.size() == (size_t)1) {
                 readerArray[0]->SetFileDeleted(true);
-                if (readerArray[0]->IsReadToEnd()) {
+                // check reading first, read position is updated by reader thread while reading
+                if (!readerArray[0]->IsReading() && readerArray[0]->IsReadToEnd()) {
                     // release fd as quick as possible
                     readerArray[0]->CloseFilePtr();
                 }
@@ -464,7 +472,8 @@ void ModifyHandler::Handle(const Event& event) {
             LogFileReaderPtrArray& readerArray = pair.second;
             for (auto& reader : readerArray) {
                 reader->SetContainerStopped();
-                if (reader->IsReadToEnd()) {
+                // check reading first, read position is updated by reader thread while reading
+                if (!reader->IsReading() && reader->IsReadToEnd()) {
                     // release fd as quick as possible
                     reader->CloseFilePtr();
                 }
@@ -563,6 +572,10 @@ void ModifyHandler::Handle(const Event& event) {
                 return;
             }
         } else {
+            // being read by reader thread, read again when current read finishes
+            if (devInodeIter->second->DelayIfReading()) {
+                return;
+            }
             devInodeIter->second->UpdateLogPath(logPath);
             readerArrayPtr = devInodeIter->second->GetReaderArray();
         }
@@ -571,6 +584,9 @@ void ModifyHandler::Handle(const Event& event) {
             return;
         }
         LogFileReaderPtr reader = (*readerArrayPtr)[0];
+        if (reader->DelayIfReading()) {
+            return;
+        }
         // If file modified, it means the file is existed, then we should set fileDeletedFlag to false
         // NOTE: This may override the correct delete flag, which will cause fd close delay!
         // reader->SetFileDeleted(false);
@@ -637,117 +653,32 @@ void ModifyHandler::Handle(const Event& event) {
             return;
         }
 
-        bool hasMoreData;
-        do {
-            if (!LogProcess::GetInstance()->IsValidToReadLog(reader->GetLogstoreKey())) {
-                static int32_t s_lastOutPutTime = 0;
-                int32_t curTime = time(NULL);
-                if (curTime - s_lastOutPutTime > 600) {
-                    s_lastOutPutTime = time(NULL);
-                    LOG_INFO(sLogger,
-                             ("logprocess queue is full, put modify event to event queue again",
-                              reader->GetLogPath())(reader->GetProjectName(), reader->GetCategory()));
-
-                    LogtailAlarm::GetInstance()->SendAlarm(
-                        PROCESS_QUEUE_BUSY_ALARM,
-                        string("logprocess queue is full, put modify event to event queue again, file:")
-                            + reader->GetLogPath() + " ,project:" + reader->GetProjectName()
-                            + " ,logstore:" + reader->GetCategory());
-                }
+        uint64_t nowMs = beginTime / 1000;
+        reader->MarkReadPending(nowMs);
+        // Logstore is read much more than others or out of its read budget, read it later. An event released by
+        // timeout is read now, or the logstore would be deferred forever.
+        if (!ReadScheduler::GetInstance()->TakeReleased(mConfigName, event, reader->GetDevInode())
+            && !ReadScheduler::GetInstance()->IsReadable(reader->GetLogstoreKey(), nowMs)) {
+            ReadScheduler::GetInstance()->Defer(
+                reader->GetLogstoreKey(), mConfigName, event, reader->GetDevInode(), nowMs);
+            return;
+        }
 
-                BlockedEventManager::GetInstance()->UpdateBlockEvent(
-                    reader->GetLogstoreKey(), mConfigName, event, reader->GetDevInode(), curTime);
+        if (LogReaderThreadPool::GetInstance()->IsEnabled()) {
+            // File size is refreshed by CheckFileSignatureAndOffset above, a head reader read to end by reader
+            // thread is moved to rotator map here, as what is done after inline reading.
+            if (readerArrayPtr->size() > (size_t)1 && reader->IsReadToEnd()) {
+                MoveHeadReaderToRotatorMap(readerArrayPtr, event, logPath);
                 return;
             }
-            LogBuffer* logBuffer = NULL;
-            hasMoreData = reader->ReadLog(logBuffer);
-            int32_t pushRetry = 0;
-            if (logBuffer != NULL) {
-                LogFileProfiler::GetInstance()->AddProfilingReadBytes(reader->GetConfigName(),
-                                                                      reader->GetRegion(),
-                                                                      reader->GetProjectName(),
-                                                                      reader->GetCategory(),
-                                                                      reader->GetConvertedPath(),
-                                                                      reader->GetDevInode().dev,
-                                                                      reader->GetDevInode().inode,
-                                                                      reader->GetFileSize(),
-                                                                      reader->GetLastFilePos(),
-                                                                      time(NULL));
-                logBuffer->SetDependecy(reader);
-                while (!LogProcess::GetInstance()->PushBuffer(logBuffer)) // 10ms
-                {
-                    ++pushRetry;
-                    if (pushRetry % 10 == 0)
-                        LogInput::GetInstance()->TryReadEvents(false);
-                }
-            }
-
-            if (!hasMoreData) {
-                if (reader->IsFileDeleted() || reader->IsContainerStopped()) {
-                    // release fd as quick as possible
-                    reader->CloseFilePtr();
-                }
-                break;
-            }
-            if (pushRetry >= 5 || GetCurrentTimeInMicroSeconds() - beginTime > mReadFileTimeSlice) {
-                LOG_DEBUG(
-                    sLogger,
-                    ("read log breakout", "file io cost 1 time slice (50ms) or push blocked")("pushRetry", pushRetry)(
-                        "begin time", beginTime)("path", event.GetSource())("file", event.GetObject()));
-                Event* ev = new Event(event);
-                ev->SetConfigName(mConfigName);
-                LogInput::GetInstance()->PushEventQueue(ev);
-                break;
-            }
-
-            // When loginput thread hold on, we should repush this event back.
-            // If we don't repush and this file has no modify event, this reader will never been read.
-            if (LogInput::GetInstance()->IsInterupt()) {
-                if (hasMoreData) {
-                    LOG_INFO(
-                        sLogger,
-                        ("read log interupt but has more data, reason", "log input thread hold on")(
-                            "action", "repush modify event to event queue")("begin time", beginTime)(
-                            "path", event.GetSource())("file", event.GetObject())("inode", reader->GetDevInode().inode)(
-                            "offset", reader->GetLastFilePos())("size", reader->GetFileSize()));
-                } else {
-                    LOG_DEBUG(
-                        sLogger,
-                        ("read log breakout, reason", "log input thread hold on")(
-                            "action", "repush modify event to event queue")("begin time", beginTime)(
-                            "path", event.GetSource())("file", event.GetObject())("inode", reader->GetDevInode().inode)(
-                            "offset", reader->GetLastFilePos())("size", reader->GetFileSize()));
-                }
-                Event* ev = new Event(event);
-                ev->SetConfigName(mConfigName);
-                LogInput::GetInstance()->PushEventQueue(ev);
-                break;
-            }
-        } while (true);
+            LogReaderThreadPool::GetInstance()->Submit(
+                reader, event, mConfigName, mReadFileTimeSlice, readerArrayPtr->size() > (size_t)1);
+            return;
+        }
 
-        if (!hasMoreData && readerArrayPtr->size() > (size_t)1) {
-            LOG_DEBUG(sLogger,
-                      ("read head rotate log done, move reader to rotator map",
-                       logPath)(ToString(readerArrayPtr->size()), mRotatorReaderMap.size())(
-                          ToString(reader->GetDevInode().inode), reader->GetLastFilePos())("DevInode map size",
-                                                                                           mDevInodeReaderMap.size()));
-            // when a rotated reader finish its reading, it's unlikely that there will be data again
-            // so release file fd as quick as possible (open again if new data coming)
-            reader->CloseFilePtr();
-            readerArrayPtr->pop_front();
-            mDevInodeReaderMap.erase(reader->GetDevInode());
-            mRotatorReaderMap[reader->GetDevInode()] = reader;
-            // need to push modify event again, but without dev inode
-            // use head dev + inode
-            Event* ev = new Event(event.GetSource(),
-                                  event.GetObject(),
-                                  event.GetType(),
-                                  event.GetWd(),
-                                  event.GetCookie(),
-                                  (*readerArrayPtr)[0]->GetDevInode().dev,
-                                  (*readerArrayPtr)[0]->GetDevInode().inode);
-            ev->SetConfigName(mConfigName);
-            LogInput::GetInstance()->PushEventQueue(ev);
+        ReadResult result = ReadAndPushLogs(reader, event, mConfigName, mReadFileTimeSlice, beginTime);
+        if (result == READ_RESULT_TO_END && readerArrayPtr->size() > (size_t)1) {
+            MoveHeadReaderToRotatorMap(readerArrayPtr, event, logPath);
         }
     }
     // if a file is created, and dev inode cannot found(this means it's a new file), create reader for this file, then
@@ -770,6 +701,144 @@ void ModifyHandler::Handle(const Event& event) {
     }
 }
 
+ModifyHandler::ReadResult ModifyHandler::ReadAndPushLogs(const LogFileReaderPtr& reader,
+                                                         const Event& event,
+                                                         const std::string& configName,
+                                                         uint64_t timeSlice,
+                                                         uint64_t beginTime) {
+    bool hasMoreData;
+    do {
+        if (!LogProcess::GetInstance()->IsValidToReadLog(reader->GetLogstoreKey())) {
+            static int32_t s_lastOutPutTime = 0;
+            int32_t curTime = time(NULL);
+            if (curTime - s_lastOutPutTime > 600) {
+                s_lastOutPutTime = time(NULL);
+                LOG_INFO(sLogger,
+                         ("logprocess queue is full, put modify event to event queue again",
+                          reader->GetLogPath())(reader->GetProjectName(), reader->GetCategory()));
+
+                LogtailAlarm::GetInstance()->SendAlarm(
+                    PROCESS_QUEUE_BUSY_ALARM,
+                    string("logprocess queue is full, put modify event to event queue again, file:")
+                        + reader->GetLogPath() + " ,project:" + reader->GetProjectName()
+                        + " ,logstore:" + reader->GetCategory());
+            }
+
+            BlockedEventManager::GetInstance()->UpdateBlockEvent(
+                reader->GetLogstoreKey(), configName, event, reader->GetDevInode(), curTime);
+            ReadScheduler::GetInstance()->SetBlocked(reader->GetLogstoreKey());
+            return READ_RESULT_BLOCKED;
+        }
+        LogBuffer* logBuffer = NULL;
+        int64_t lastFilePos = reader->GetLastFilePos();
+        hasMoreData = reader->ReadLog(logBuffer);
+        uint64_t nowMs = GetCurrentTimeInMilliSeconds();
+        if (reader->GetLastFilePos() > lastFilePos) {
+            ReadScheduler::GetInstance()->Charge(
+                reader->GetLogstoreKey(), reader->GetLastFilePos() - lastFilePos, hasMoreData, nowMs);
+        }
+        int32_t pushRetry = 0;
+        if (logBuffer != NULL) {
+            LogFileProfiler::GetInstance()->AddProfilingReadBytes(reader->GetProfilingHandle(),
+                                                                  reader->GetDevInode().dev,
+                                                                  reader->GetDevInode().inode,
+                                                                  reader->GetFileSize(),
+                                                                  reader->GetLastFilePos(),
+                                                                  time(NULL));
+            logBuffer->SetDependecy(reader);
+            while (!LogProcess::GetInstance()->PushBuffer(logBuffer)) // 10ms
+            {
+                ++pushRetry;
+                // reader threads must not touch event sources, which are owned by LogInput thread
+                if (pushRetry % 10 == 0 && !LogReaderThreadPool::IsReaderThread())
+                    LogInput::GetInstance()->TryReadEvents(false);
+            }
+        }
+
+        if (!hasMoreData) {
+            if (reader->IsFileDeleted() || reader->IsContainerStopped()) {
+                // release fd as quick as possible
+                reader->CloseFilePtr();
+            }
+            uint64_t pendingSinceMs = reader->ResetReadPending();
+            if (pendingSinceMs > 0 && nowMs >= pendingSinceMs) {
+                ReadScheduler::GetInstance()->RecordReadDelay(nowMs - pendingSinceMs, reader->GetLogPath());
+            }
+            return READ_RESULT_TO_END;
+        }
+        if (!ReadScheduler::GetInstance()->IsReadable(reader->GetLogstoreKey(), nowMs)) {
+            LOG_DEBUG(sLogger,
+                      ("read log breakout", "logstore is deferred by read scheduler")("path", event.GetSource())(
+                          "file", event.GetObject()));
+            ReadScheduler::GetInstance()->Defer(
+                reader->GetLogstoreKey(), configName, event, reader->GetDevInode(), nowMs);
+            return READ_RESULT_PAUSED;
+        }
+        if (pushRetry >= 5 || GetCurrentTimeInMicroSeconds() - beginTime > timeSlice) {
+            LOG_DEBUG(
+                sLogger,
+                ("read log breakout", "file io cost 1 time slice (50ms) or push blocked")("pushRetry", pushRetry)(
+                    "begin time", beginTime)("path", event.GetSource())("file", event.GetObject()));
+            Event* ev = new Event(event);
+            ev->SetConfigName(configName);
+            LogInput::GetInstance()->PushEventQueue(ev);
+            return READ_RESULT_PAUSED;
+        }
+
+        // When loginput thread hold on, we should repush this event back.
+        // If we don't repush and this file has no modify event, this reader will never been read.
+        if (LogInput::GetInstance()->IsInterupt()) {
+            if (hasMoreData) {
+                LOG_INFO(
+                    sLogger,
+                    ("read log interupt but has more data, reason", "log input thread hold on")(
+                        "action", "repush modify event to event queue")("begin time", beginTime)(
+                        "path", event.GetSource())("file", event.GetObject())("inode", reader->GetDevInode().inode)(
+                        "offset", reader->GetLastFilePos())("size", reader->GetFileSize()));
+            } else {
+                LOG_DEBUG(
+                    sLogger,
+                    ("read log breakout, reason", "log input thread hold on")(
+                        "action", "repush modify event to event queue")("begin time", beginTime)(
+                        "path", event.GetSource())("file", event.GetObject())("inode", reader->GetDevInode().inode)(
+                        "offset", reader->GetLastFilePos())("size", reader->GetFileSize()));
+            }
+            Event* ev = new Event(event);
+            ev->SetConfigName(configName);
+            LogInput::GetInstance()->PushEventQueue(ev);
+            return READ_RESULT_PAUSED;
+        }
+    } while (true);
+}
+
+void ModifyHandler::MoveHeadReaderToRotatorMap(LogFileReaderPtrArray* readerArrayPtr,
+                                               const Event& event,
+                                               const std::string& logPath) {
+    LogFileReaderPtr reader = (*readerArrayPtr)[0];
+    LOG_DEBUG(sLogger,
+              ("read head rotate log done, move reader to rotator map",
+               logPath)(ToString(readerArrayPtr->size()), mRotatorReaderMap.size())(
+                  ToString(reader->GetDevInode().inode), reader->GetLastFilePos())("DevInode map size",
+                                                                                   mDevInodeReaderMap.size()));
+    // when a rotated reader finish its reading, it's unlikely that there will be data again
+    // so release file fd as quick as possible (open again if new data coming)
+    reader->CloseFilePtr();
+    readerArrayPtr->pop_front();
+    mDevInodeReaderMap.erase(reader->GetDevInode());
+    mRotatorReaderMap[reader->GetDevInode()] = reader;
+    // need to push modify event again, but without dev inode
+    // use head dev + inode
+    Event* ev = new Event(event.GetSource(),
+                          event.GetObject(),
+                          event.GetType(),
+                          event.GetWd(),
+                          event.GetCookie(),
+                          (*readerArrayPtr)[0]->GetDevInode().dev,
+                          (*readerArrayPtr)[0]->GetDevInode().inode);
+    ev->SetConfigName(mConfigName);
+    LogInput::GetInstance()->PushEventQueue(ev);
+}
+
 void ModifyHandler::HandleTimeOut() {
     MakeSpaceForNewReader();
     DeleteTimeoutReader();
@@ -806,7 +875,7 @@ void ModifyHandler::HandleTimeOut() {
         }
         // only close file ptr when readerArray size is 1
         // because when many file is queued, if we close file ptr, maybe we can't find this file again
-        if (readerArray.size() == 1) {
+        if (readerArray.size() == 1 && !readerArray[0]->IsReading()) {
             if (readerArray[0]->CloseTimeoutFilePtr(nowTime)) {
                 ++closeFilePtrCount;
                 actioned = true;
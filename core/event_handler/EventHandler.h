@@ -79,11 +79,30 @@ private:
                                             const DevInode& devInode,
                                             bool forceBeginingFlag = false);
 
+    // Move head reader which is read to end to rotator map, and push modify event for the next reader.
+    void MoveHeadReaderToRotatorMap(LogFileReaderPtrArray* readerArrayPtr,
+                                    const Event& event,
+                                    const std::string& logPath);
+
     // no copy
     ModifyHandler(const ModifyHandler&);
     ModifyHandler& operator=(const ModifyHandler&);
 
 public:
+    enum ReadResult {
+        READ_RESULT_BLOCKED, // process queue is full, event is put into BlockedEventManager
+        READ_RESULT_PAUSED, // time slice is used up or input is holding on, event is pushed again
+        READ_RESULT_TO_END
+    };
+
+    // ReadAndPushLogs reads @reader and pushes log buffers to LogProcess until no more data or time slice
+    //  is used up. It is called in LogInput thread, or in reader threads if LogReaderThreadPool is enabled.
+    static ReadResult ReadAndPushLogs(const LogFileReaderPtr& reader,
+                                      const Event& event,
+                                      const std::string& configName,
+                                      uint64_t timeSlice,
+                                      uint64_t beginTime);
+
     ModifyHandler(const std::string& configName, Config* pConfig);
     virtual ~ModifyHandler();
     virtual void Handle(const Event& event);
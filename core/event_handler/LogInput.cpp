@@ -37,6 +37,8 @@
 #include "config_manager/ConfigManager.h"
 #include "logger/Logger.h"
 #include "EventHandler.h"
+#include "LogReaderThreadPool.h"
+#include "ReadScheduler.h"
 #include "HistoryFileImporter.h"
 
 using namespace std;
@@ -84,6 +86,7 @@ void LogInput::Start() {
         initialized = true;
 
     mInteruptFlag = false;
+    LogReaderThreadPool::GetInstance()->Start();
     new Thread([this]() { ProcessLoop(); });
 }
 
@@ -116,6 +119,8 @@ void LogInput::HoldOn() {
     mInteruptFlag = true;
     LOG_DEBUG(sLogger, ("LogInput HoldOn", ""));
     mAccessMainThreadRWL.lock();
+    LOG_DEBUG(sLogger, ("LogReaderThreadPool HoldOn", ""));
+    LogReaderThreadPool::GetInstance()->HoldOn();
     LOG_DEBUG(sLogger, ("LogProcess HoldOn", ""));
     LogProcess::GetInstance()->HoldOn();
     LOG_DEBUG(sLogger, ("LogInput HoldOn end", ""));
@@ -174,7 +179,7 @@ void LogInput::FlowControl() {
             return;
         usleep(FLOW_CONTROL_SLEEP_MICROSECONDS);
         ++i;
-        if (i % 5 == 0)
+        if (i % 5 == 0 && !LogReaderThreadPool::IsReaderThread())
             TryReadEvents(true);
     }
 
@@ -407,6 +412,8 @@ void LogInput::CheckAndUpdateCriticalMetric(int32_t curTime) {
     LogtailMonitor::Instance()->UpdateMetric("register_handler", EventDispatcher::GetInstance()->GetHandlerCount());
     LogtailMonitor::Instance()->UpdateMetric("reader_count", CheckPointManager::Instance()->GetReaderCount());
     LogtailMonitor::Instance()->UpdateMetric("multi_config", AppConfig::GetInstance()->IsAcceptMultiConfig());
+    LogReaderThreadPool::GetInstance()->UpdateMetrics(curTime);
+    ReadScheduler::GetInstance()->UpdateMetrics();
     mEventProcessCount = 0;
 }
 
@@ -449,6 +456,11 @@ void* LogInput::ProcessLoop() {
 
         curTime = time(NULL);
 
+        std::vector<Event*> readyEvents;
+        ReadScheduler::GetInstance()->GetReadyEvents(readyEvents, GetCurrentTimeInMilliSeconds());
+        if (readyEvents.size() > 0) {
+            PushEventQueue(readyEvents);
+        }
 
         if (curTime - lastCheckBlockedTime >= INT32_FLAG(check_block_event_interval)) {
             std::vector<Event*> pEventVec;
@@ -515,6 +527,7 @@ void* LogInput::ProcessLoop() {
 }
 
 void LogInput::PushEventQueue(std::vector<Event*>& eventVec) {
+    PTScopedLock lock(mEventQueueLock);
     for (std::vector<Event*>::iterator iter = eventVec.begin(); iter != eventVec.end(); ++iter) {
         string key;
         key.append((*iter)->GetSource())
@@ -552,6 +565,7 @@ void LogInput::PushEventQueue(Event* ev) {
         .append(">")
         .append(ev->GetConfigName());
     int64_t hashKey = HashSignatureString(key.c_str(), key.size());
+    PTScopedLock lock(mEventQueueLock);
     if (ev->GetType() == EVENT_MODIFY) {
         if (mModifyEventSet.find(hashKey) != mModifyEventSet.end()) {
             delete ev;
@@ -564,6 +578,7 @@ void LogInput::PushEventQueue(Event* ev) {
 }
 
 Event* LogInput::PopEventQueue() {
+    PTScopedLock lock(mEventQueueLock);
     if (mInotifyEventQueue.size() > 0) {
         Event* ev = mInotifyEventQueue.front();
         mInotifyEventQueue.pop();
@@ -584,6 +599,7 @@ void LogInput::CleanEnviroments() {
             break;
         delete ev;
     }
+    PTScopedLock lock(mEventQueueLock);
     mModifyEventSet.clear();
 }
 #endif
@@ -21,6 +21,7 @@
 #include <queue>
 #include <vector>
 #include <unordered_set>
+#include <atomic>
 #include "common/Lock.h"
 #include "common/LogRunnable.h"
 
@@ -66,6 +67,8 @@ private:
     Event* PopEventQueue();
     void CheckAndUpdateCriticalMetric(int32_t curTime);
 
+    // Events are also pushed by reader threads, see LogReaderThreadPool.
+    PTMutex mEventQueueLock;
     std::queue<Event*> mInotifyEventQueue;
     std::unordered_set<int64_t> mModifyEventSet;
     ReadWriteLock mAccessMainThreadRWL;
@@ -0,0 +1,125 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LogReaderThreadPool.h"
+#include "common/Flags.h"
+#include "common/StringTools.h"
+#include "common/TimeUtil.h"
+#include "event/Event.h"
+#include "monitor/Monitor.h"
+#include "logger/Logger.h"
+#include "EventHandler.h"
+#include "LogInput.h"
+
+DEFINE_FLAG_INT32(reader_thread_count,
+                  "count of threads to read log files, files are read in log input thread if less than 2",
+                  1);
+
+namespace logtail {
+
+static thread_local bool sIsReaderThread = false;
+
+void LogReaderThreadPool::Start() {
+    if (!mShards.empty() || INT32_FLAG(reader_thread_count) < 2) {
+        return;
+    }
+    for (int32_t i = 0; i < INT32_FLAG(reader_thread_count); ++i) {
+        mShards.emplace_back(new Shard);
+        mShards.back()->mPool.Start();
+    }
+    mLastUpdateMetricTime = time(NULL);
+    LOG_INFO(sLogger, ("start log reader threads, count", mShards.size()));
+}
+
+bool LogReaderThreadPool::Submit(const LogFileReaderPtr& reader,
+                                 const Event& event,
+                                 const std::string& configName,
+                                 uint64_t timeSlice,
+                                 bool repushOnReadToEnd) {
+    if (!reader->TryStartReading()) {
+        if (reader->DelayIfReading() || !reader->TryStartReading()) {
+            return false;
+        }
+    }
+    Shard* shard = mShards[GetShardIndex(reader->GetDevInode())].get();
+    ++mRunningCount;
+    shard->mPool.Add([this, shard, reader, event, configName, timeSlice, repushOnReadToEnd]() {
+        read(*shard, reader, event, configName, timeSlice, repushOnReadToEnd);
+    });
+    return true;
+}
+
+void LogReaderThreadPool::HoldOn() {
+    while (mRunningCount > 0) {
+        usleep(10 * 1000);
+    }
+}
+
+size_t LogReaderThreadPool::GetShardIndex(const DevInode& devInode) const {
+    // Inodes are usually allocated sequentially, mix the bits before modulo.
+    uint64_t hash = (uint64_t)DevInodeHash()(devInode) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)((hash >> 32) % mShards.size());
+}
+
+void LogReaderThreadPool::UpdateMetrics(int32_t curTime) {
+    if (mShards.empty()) {
+        return;
+    }
+    int32_t interval = curTime - mLastUpdateMetricTime;
+    if (interval <= 0) {
+        return;
+    }
+    for (size_t i = 0; i < mShards.size(); ++i) {
+        const std::string prefix = "reader_shard_" + ToString(i);
+        LogtailMonitor::Instance()->UpdateMetric(prefix + "_queue_depth", mShards[i]->mPool.Size());
+        LogtailMonitor::Instance()->UpdateMetric(prefix + "_read_bytes_ps",
+                                                 1.0 * mShards[i]->mReadBytes.exchange(0) / interval);
+    }
+    mLastUpdateMetricTime = curTime;
+}
+
+bool LogReaderThreadPool::IsReaderThread() {
+    return sIsReaderThread;
+}
+
+void LogReaderThreadPool::read(Shard& shard,
+                               const LogFileReaderPtr& reader,
+                               const Event& event,
+                               const std::string& configName,
+                               uint64_t timeSlice,
+                               bool repushOnReadToEnd) {
+    sIsReaderThread = true;
+    const int64_t beginPos = reader->GetLastFilePos();
+    bool repush = false;
+    if (LogInput::GetInstance()->IsInterupt()) {
+        // LogInput is holding on, read it again after resume.
+        repush = true;
+    } else {
+        ModifyHandler::ReadResult result
+            = ModifyHandler::ReadAndPushLogs(reader, event, configName, timeSlice, GetCurrentTimeInMicroSeconds());
+        repush = repushOnReadToEnd && result == ModifyHandler::READ_RESULT_TO_END;
+    }
+    const int64_t endPos = reader->GetLastFilePos();
+    if (endPos > beginPos) {
+        shard.mReadBytes += endPos - beginPos;
+    }
+    if (reader->FinishReading() || repush) {
+        Event* ev = new Event(event);
+        ev->SetConfigName(configName);
+        LogInput::GetInstance()->PushEventQueue(ev);
+    }
+    --mRunningCount;
+}
+
+} // namespace logtail
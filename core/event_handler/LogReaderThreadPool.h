@@ -0,0 +1,98 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/DevInode.h"
+#include "common/ThreadPool.h"
+#include "reader/LogFileReader.h"
+
+namespace logtail {
+
+class Event;
+
+// LogReaderThreadPool reads log files for ModifyHandler in multiple threads.
+//
+// Events, handlers and reader maps are still managed by LogInput thread, only the read loop of
+//  a file (ReadLog + PushBuffer) is dispatched to a shard selected by dev/inode of the file.
+// A reader is read by at most one thread at a time, so offsets and checkpoints of a file are
+//  updated in order. Modify events arriving while the reader is busy are merged and pushed
+//  again after current read finishes.
+class LogReaderThreadPool {
+public:
+    static LogReaderThreadPool* GetInstance() {
+        static auto singleton = new LogReaderThreadPool;
+        return singleton;
+    }
+
+    // Start creates reader threads according to flag reader_thread_count,
+    //  files are read in LogInput thread if the count is less than 2.
+    void Start();
+    bool IsEnabled() const { return !mShards.empty(); }
+
+    // Submit dispatches the read of @reader to its shard.
+    // Returns false if the reader is being read, the read is delayed until current one finishes.
+    // If @repushOnReadToEnd is set, a modify event is pushed again after the reader is read to end, so that
+    //  LogInput thread can move it to rotator map and continue with the next reader in array.
+    bool Submit(const LogFileReaderPtr& reader,
+                const Event& event,
+                const std::string& configName,
+                uint64_t timeSlice,
+                bool repushOnReadToEnd);
+
+    // HoldOn waits until all submitted reads finish, called by LogInput::HoldOn.
+    void HoldOn();
+
+    size_t GetShardCount() const { return mShards.size(); }
+    size_t GetShardIndex(const DevInode& devInode) const;
+
+    // UpdateMetrics reports queue depth and read bytes per second of each shard.
+    void UpdateMetrics(int32_t curTime);
+
+    // IsReaderThread returns true if current thread is a reader thread.
+    static bool IsReaderThread();
+
+private:
+    struct Shard {
+        Shard() : mPool(1) {}
+
+        ThreadPool mPool;
+        std::atomic<uint64_t> mReadBytes{0};
+    };
+
+    LogReaderThreadPool() {}
+    ~LogReaderThreadPool() {}
+
+    void read(Shard& shard,
+              const LogFileReaderPtr& reader,
+              const Event& event,
+              const std::string& configName,
+              uint64_t timeSlice,
+              bool repushOnReadToEnd);
+
+    std::vector<std::unique_ptr<Shard>> mShards;
+    std::atomic_int mRunningCount{0};
+    int32_t mLastUpdateMetricTime = 0;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class LogReaderThreadPoolUnittest;
+#endif
+};
+
+} // namespace logtail
@@ -0,0 +1,298 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ReadScheduler.h"
+#include <algorithm>
+#include <tuple>
+#include "common/Flags.h"
+#include "common/HashUtil.h"
+#include "common/LogstoreFeedbackQueue.h"
+#include "common/StringTools.h"
+#include "event/Event.h"
+#include "monitor/Monitor.h"
+
+DEFINE_FLAG_BOOL(enable_read_scheduler, "defer reads of logstores which are read much more than others", true);
+DEFINE_FLAG_INT64(read_scheduler_max_lag_bytes,
+                  "max weighted bytes a backlogged logstore can read ahead of the least read one",
+                  4 * 1024 * 1024);
+DEFINE_FLAG_INT32(read_scheduler_max_defer_ms, "max time a modify event is deferred by read scheduler", 1000);
+DEFINE_FLAG_INT32(read_scheduler_backlog_expire_ms,
+                  "a logstore is backlogged in this time after a read paused with more data",
+                  1000);
+
+namespace logtail {
+
+const uint64_t ReadScheduler::kDelayBucketBounds[] = {10, 100, 500, 1000, 5000, 30000};
+
+uint32_t ReadScheduler::GetWeight(int32_t priority) {
+    if (priority > 0 && priority <= MAX_CONFIG_PRIORITY_LEVEL) {
+        return 1U << (MAX_CONFIG_PRIORITY_LEVEL - priority + 1);
+    }
+    return 1;
+}
+
+ReadScheduler::~ReadScheduler() {
+    for (auto& item : mDeferredEvents) {
+        delete item.second.mEvent;
+    }
+}
+
+void ReadScheduler::SetQuota(const LogstoreFeedBackKey& key, uint32_t weight, int64_t maxBytesPerSecond) {
+    PTScopedLock lock(mLock);
+    LogstoreState& state = getState(key);
+    state.mWeight = weight > 0 ? weight : 1;
+    if (state.mMaxBytesPerSecond != maxBytesPerSecond) {
+        state.mMaxBytesPerSecond = maxBytesPerSecond;
+        state.mTokens = maxBytesPerSecond > 0 ? maxBytesPerSecond : 0;
+        state.mTokenUpdateTimeMs = 0;
+    }
+}
+
+bool ReadScheduler::IsReadable(const LogstoreFeedBackKey& key, uint64_t nowMs) {
+    if (!BOOL_FLAG(enable_read_scheduler)) {
+        return true;
+    }
+    PTScopedLock lock(mLock);
+    LogstoreState& state = getState(key);
+    if (isReadable(state, nowMs)) {
+        return true;
+    }
+    // Cached min virtual time may be stale, check again before deferring.
+    mMinUpdateTimeMs = 0;
+    return isReadable(state, nowMs);
+}
+
+void ReadScheduler::Charge(const LogstoreFeedBackKey& key, uint64_t bytes, bool hasMoreData, uint64_t nowMs) {
+    if (!BOOL_FLAG(enable_read_scheduler)) {
+        return;
+    }
+    PTScopedLock lock(mLock);
+    LogstoreState& state = getState(key);
+    bool backlogged = isBacklogged(state, nowMs);
+    if (hasMoreData) {
+        // A logstore becoming backlogged starts from current virtual time, neither credit of idle time nor debt
+        // of reads before is kept.
+        if (!backlogged) {
+            mMinUpdateTimeMs = 0;
+            updateMinVirtualTime(nowMs);
+            if (mHasBacklog) {
+                state.mVirtualTime = mMinVirtualTime;
+            }
+        }
+        state.mLastBacklogTimeMs = nowMs;
+    }
+    // Reads which keep up with the file are not charged, or virtual time of a busy logstore grows without
+    // bound and it is starved once backlogged.
+    if (hasMoreData || backlogged) {
+        state.mVirtualTime += 1.0 * bytes / state.mWeight;
+    }
+    if (state.mMaxBytesPerSecond > 0) {
+        refill(state, nowMs);
+        state.mTokens -= bytes;
+    }
+}
+
+void ReadScheduler::SetBlocked(const LogstoreFeedBackKey& key) {
+    PTScopedLock lock(mLock);
+    getState(key).mLastBacklogTimeMs = 0;
+}
+
+void ReadScheduler::Defer(const LogstoreFeedBackKey& key,
+                          const std::string& configName,
+                          const Event& event,
+                          const DevInode& devInode,
+                          uint64_t nowMs) {
+    Event* pEvent = new Event(event);
+    pEvent->SetConfigName(configName);
+    pEvent->SetDev(devInode.dev);
+    pEvent->SetInode(devInode.inode);
+    int64_t hashKey = GetEventKey(pEvent->GetSource(), pEvent->GetObject(), devInode, configName);
+    pEvent->SetHashKey(hashKey);
+
+    PTScopedLock lock(mLock);
+    DeferredEvent& deferred = mDeferredEvents[hashKey];
+    if (deferred.mEvent != NULL) {
+        delete deferred.mEvent;
+    } else {
+        deferred.mDeferTimeMs = nowMs;
+    }
+    deferred.mEvent = pEvent;
+    deferred.mLogstoreKey = key;
+}
+
+void ReadScheduler::GetReadyEvents(std::vector<Event*>& eventVec, uint64_t nowMs) {
+    // (virtual time, defer time, event)
+    std::vector<std::tuple<double, uint64_t, Event*>> readyEvents;
+    {
+        PTScopedLock lock(mLock);
+        if (mDeferredEvents.empty() && mReleasedEvents.empty()) {
+            return;
+        }
+        for (auto iter = mReleasedEvents.begin(); iter != mReleasedEvents.end();) {
+            if (nowMs - iter->second >= (uint64_t)INT32_FLAG(read_scheduler_max_defer_ms)) {
+                iter = mReleasedEvents.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        if (mDeferredEvents.empty()) {
+            return;
+        }
+        mMinUpdateTimeMs = 0;
+        for (auto iter = mDeferredEvents.begin(); iter != mDeferredEvents.end();) {
+            DeferredEvent& deferred = iter->second;
+            LogstoreState& state = getState(deferred.mLogstoreKey);
+            bool readable = !BOOL_FLAG(enable_read_scheduler) || isReadable(state, nowMs);
+            if (readable || nowMs - deferred.mDeferTimeMs >= (uint64_t)INT32_FLAG(read_scheduler_max_defer_ms)) {
+                if (!readable) {
+                    mReleasedEvents[iter->first] = nowMs;
+                }
+                readyEvents.emplace_back(state.mVirtualTime, deferred.mDeferTimeMs, deferred.mEvent);
+                iter = mDeferredEvents.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+    std::sort(readyEvents.begin(), readyEvents.end());
+    for (auto& item : readyEvents) {
+        eventVec.push_back(std::get<2>(item));
+    }
+}
+
+bool ReadScheduler::TakeReleased(const std::string& configName, const Event& event, const DevInode& devInode) {
+    int64_t hashKey = GetEventKey(event.GetSource(), event.GetObject(), devInode, configName);
+    PTScopedLock lock(mLock);
+    return mReleasedEvents.erase(hashKey) > 0;
+}
+
+void ReadScheduler::RecordReadDelay(uint64_t delayMs, const std::string& path) {
+    size_t bucket = 0;
+    while (bucket < kDelayBucketCount - 1 && delayMs > kDelayBucketBounds[bucket]) {
+        ++bucket;
+    }
+    PTScopedLock lock(mLock);
+    ++mDelayBuckets[bucket];
+    if (delayMs > mMaxDelayMs) {
+        mMaxDelayMs = delayMs;
+        mMaxDelayPath = path;
+    }
+}
+
+void ReadScheduler::UpdateMetrics() {
+    uint64_t buckets[kDelayBucketCount];
+    uint64_t maxDelayMs = 0;
+    std::string maxDelayPath;
+    size_t deferredCount = 0;
+    {
+        PTScopedLock lock(mLock);
+        std::copy(mDelayBuckets, mDelayBuckets + kDelayBucketCount, buckets);
+        std::fill(mDelayBuckets, mDelayBuckets + kDelayBucketCount, 0);
+        maxDelayMs = mMaxDelayMs;
+        maxDelayPath.swap(mMaxDelayPath);
+        mMaxDelayMs = 0;
+        deferredCount = mDeferredEvents.size();
+    }
+    for (size_t i = 0; i < kDelayBucketCount; ++i) {
+        std::string name = i < kDelayBucketCount - 1 ? "read_delay_le_" + ToString(kDelayBucketBounds[i]) + "ms"
+                                                     : "read_delay_gt_" + ToString(kDelayBucketBounds[i - 1]) + "ms";
+        LogtailMonitor::Instance()->UpdateMetric(name, buckets[i]);
+    }
+    LogtailMonitor::Instance()->UpdateMetric("read_delay_max_ms", maxDelayMs);
+    LogtailMonitor::Instance()->UpdateMetric("read_delay_max_file", maxDelayPath);
+    LogtailMonitor::Instance()->UpdateMetric("read_deferred_events", deferredCount);
+}
+
+size_t ReadScheduler::GetDeferredEventCount() {
+    PTScopedLock lock(mLock);
+    return mDeferredEvents.size();
+}
+
+int64_t ReadScheduler::GetEventKey(const std::string& source,
+                                   const std::string& object,
+                                   const DevInode& devInode,
+                                   const std::string& configName) {
+    std::string hashKeyStr;
+    hashKeyStr.append(source)
+        .append(">")
+        .append(object)
+        .append(">")
+        .append(ToString(devInode.dev))
+        .append(">")
+        .append(ToString(devInode.inode))
+        .append(">")
+        .append(configName);
+    return HashSignatureString(hashKeyStr.c_str(), hashKeyStr.size());
+}
+
+ReadScheduler::LogstoreState& ReadScheduler::getState(const LogstoreFeedBackKey& key) {
+    return mLogstoreStates[key];
+}
+
+bool ReadScheduler::isBacklogged(const LogstoreState& state, uint64_t nowMs) const {
+    return state.mLastBacklogTimeMs > 0
+        && nowMs < state.mLastBacklogTimeMs + (uint64_t)INT32_FLAG(read_scheduler_backlog_expire_ms);
+}
+
+void ReadScheduler::refill(LogstoreState& state, uint64_t nowMs) {
+    if (state.mTokenUpdateTimeMs > 0 && nowMs > state.mTokenUpdateTimeMs) {
+        state.mTokens += 1.0 * state.mMaxBytesPerSecond * (nowMs - state.mTokenUpdateTimeMs) / 1000;
+        if (state.mTokens > state.mMaxBytesPerSecond) {
+            state.mTokens = state.mMaxBytesPerSecond;
+        }
+    }
+    if (nowMs > state.mTokenUpdateTimeMs) {
+        state.mTokenUpdateTimeMs = nowMs;
+    }
+}
+
+bool ReadScheduler::isReadable(LogstoreState& state, uint64_t nowMs) {
+    if (state.mMaxBytesPerSecond > 0) {
+        refill(state, nowMs);
+        if (state.mTokens <= 0) {
+            return false;
+        }
+    }
+    updateMinVirtualTime(nowMs);
+    return !mHasBacklog
+        || state.mVirtualTime <= mMinVirtualTime + (double)INT64_FLAG(read_scheduler_max_lag_bytes);
+}
+
+void ReadScheduler::updateMinVirtualTime(uint64_t nowMs) {
+    // Refreshed for every 10ms, as there may be thousands of logstores.
+    if (mMinUpdateTimeMs > 0 && nowMs >= mMinUpdateTimeMs && nowMs - mMinUpdateTimeMs < 10) {
+        return;
+    }
+    mMinUpdateTimeMs = nowMs;
+    mHasBacklog = false;
+    for (auto& item : mLogstoreStates) {
+        LogstoreState& state = item.second;
+        if (!isBacklogged(state, nowMs)) {
+            continue;
+        }
+        // A throttled logstore can not catch up, others should not wait for it.
+        if (state.mMaxBytesPerSecond > 0) {
+            refill(state, nowMs);
+            if (state.mTokens <= 0) {
+                continue;
+            }
+        }
+        if (!mHasBacklog || state.mVirtualTime < mMinVirtualTime) {
+            mMinVirtualTime = state.mVirtualTime;
+            mHasBacklog = true;
+        }
+    }
+}
+
+} // namespace logtail
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/DevInode.h"
+#include "common/Lock.h"
+#include "common/LogstoreFeedbackKey.h"
+
+namespace logtail {
+
+class Event;
+
+// ReadScheduler shares read work of LogInput and reader threads among logstores by weighted fair
+//  queuing (start-time fair queuing on bytes read).
+//
+// Each logstore has a virtual time, which grows by bytes read divided by its weight (from config
+//  priority) while it is backlogged, and is reset to the min virtual time when it becomes backlogged.
+//  A logstore is backlogged if a read of it paused with more data recently. When several
+//  logstores are backlogged, the one whose virtual time is ahead of the slowest by more than
+//  flag read_scheduler_max_lag_bytes is deferred, and so is a logstore used up its bytes/s budget.
+//  Modify events of deferred logstores wait here and are released in virtual time order, so
+//  logstores read least are read first. An event waits at most read_scheduler_max_defer_ms, and an
+//  event released by timeout is read once without checking the logstore again (see TakeReleased).
+//
+// Collection delay of files, from the first modify event with unread data to read to end, is
+//  recorded in a histogram and reported by UpdateMetrics.
+class ReadScheduler {
+public:
+    static ReadScheduler* GetInstance() {
+        static ReadScheduler* singleton = new ReadScheduler;
+        return singleton;
+    }
+
+    // GetWeight returns weight of config @priority, in the same ratio as read time slice.
+    static uint32_t GetWeight(int32_t priority);
+
+    // SetQuota sets weight and bytes/s budget of logstore (<= 0 means no budget). Like send rate,
+    //  configs of the same logstore share its quota, and the last one wins.
+    void SetQuota(const LogstoreFeedBackKey& key, uint32_t weight, int64_t maxBytesPerSecond);
+
+    // IsReadable returns false if reads of the logstore should be deferred now.
+    bool IsReadable(const LogstoreFeedBackKey& key, uint64_t nowMs);
+
+    // Charge adds @bytes read from the logstore, @hasMoreData is true if the read paused before end.
+    void Charge(const LogstoreFeedBackKey& key, uint64_t bytes, bool hasMoreData, uint64_t nowMs);
+
+    // SetBlocked removes logstore from backlogged ones as its process queue is full.
+    void SetBlocked(const LogstoreFeedBackKey& key);
+
+    // Defer keeps a copy of @event until the logstore is readable, events of the same file are merged.
+    void Defer(const LogstoreFeedBackKey& key,
+               const std::string& configName,
+               const Event& event,
+               const DevInode& devInode,
+               uint64_t nowMs);
+
+    // GetReadyEvents moves deferred events which can be read now to @eventVec, in virtual time order
+    //  of their logstores.
+    void GetReadyEvents(std::vector<Event*>& eventVec, uint64_t nowMs);
+
+    // TakeReleased returns true if the event of file was released by timeout, and clears the mark. Such an
+    //  event should be read without IsReadable, or a lagging logstore would be deferred again and again.
+    bool TakeReleased(const std::string& configName, const Event& event, const DevInode& devInode);
+
+    // RecordReadDelay records collection delay of a file.
+    void RecordReadDelay(uint64_t delayMs, const std::string& path);
+
+    // UpdateMetrics reports delay histogram since last update and deferred event count.
+    void UpdateMetrics();
+
+    size_t GetDeferredEventCount();
+
+private:
+    struct LogstoreState {
+        uint32_t mWeight = 1;
+        int64_t mMaxBytesPerSecond = -1;
+        // Bytes can be read now in budget, refilled by mMaxBytesPerSecond up to one second of budget.
+        double mTokens = 0;
+        uint64_t mTokenUpdateTimeMs = 0;
+        // Bytes read while backlogged divided by weight, in units of bytes.
+        double mVirtualTime = 0;
+        uint64_t mLastBacklogTimeMs = 0;
+    };
+
+    struct DeferredEvent {
+        LogstoreFeedBackKey mLogstoreKey = 0;
+        Event* mEvent = NULL;
+        uint64_t mDeferTimeMs = 0;
+    };
+
+    // Upper bounds of delay buckets in ms, the last bucket has no upper bound.
+    static const uint64_t kDelayBucketBounds[];
+    static const size_t kDelayBucketCount = 7;
+
+    ReadScheduler() {}
+    ~ReadScheduler();
+
+    // GetEventKey returns the same key as LogInput::PushEventQueue, so that a released event is merged there.
+    static int64_t GetEventKey(const std::string& source,
+                               const std::string& object,
+                               const DevInode& devInode,
+                               const std::string& configName);
+
+    LogstoreState& getState(const LogstoreFeedBackKey& key);
+    bool isBacklogged(const LogstoreState& state, uint64_t nowMs) const;
+    void refill(LogstoreState& state, uint64_t nowMs);
+    bool isReadable(LogstoreState& state, uint64_t nowMs);
+    void updateMinVirtualTime(uint64_t nowMs);
+
+    PTMutex mLock;
+    std::unordered_map<LogstoreFeedBackKey, LogstoreState> mLogstoreStates;
+    std::unordered_map<int64_t, DeferredEvent> mDeferredEvents;
+    // Events released by timeout and their release time, the mark is dropped if it is not taken in time.
+    std::unordered_map<int64_t, uint64_t> mReleasedEvents;
+    // Min virtual time of backlogged logstores which are not throttled, refreshed every few ms.
+    double mMinVirtualTime = 0;
+    bool mHasBacklog = false;
+    uint64_t mMinUpdateTimeMs = 0;
+
+    uint64_t mDelayBuckets[kDelayBucketCount] = {0};
+    uint64_t mMaxDelayMs = 0;
+    std::string mMaxDelayPath;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class ReadSchedulerUnittest;
+#endif
+};
+
+} // namespace logtail
@@ -19,6 +19,7 @@
 #include "Monitor.h"
 #include "iostream"
 #include "profiler/LogtailAlarm.h"
+#include <atomic>
 #include <cstdint>
 #include <sstream>
 
@@ -150,6 +151,7 @@ struct NetworkStatistic {
     uint32_t mEbpfGCReleaseFDCount{0};
     uint32_t mEbpfDisableProcesses{0};
     uint32_t mEbpfUsingConnections{0};
+    uint32_t mWorkerDropEvents{0};
 
     void FlushMetrics() {
         static auto sMonitor = LogtailMonitor::Instance();
@@ -169,6 +171,7 @@ struct NetworkStatistic {
         sMonitor->UpdateMetric("observer_ebpf_disable_processes", mEbpfDisableProcesses);
         sMonitor->UpdateMetric("observer_ebpf_holding_connections", mEbpfUsingConnections);
         sMonitor->UpdateMetric("observer_ebpf_lost_count", mEbpfLostCount);
+        sMonitor->UpdateMetric("observer_worker_drop_events", mWorkerDropEvents);
         doClear();
     }
 
@@ -188,7 +191,8 @@ struct NetworkStatistic {
            << " mEbpfLostCount: " << statistic.mEbpfLostCount << " mEbpfGCCount: " << statistic.mEbpfGCCount
            << " mEbpfGCReleaseFDCount: " << statistic.mEbpfGCReleaseFDCount
            << " mEbpfDisableProcesses: " << statistic.mEbpfDisableProcesses
-           << " mEbpfUsingConnections: " << statistic.mEbpfUsingConnections;
+           << " mEbpfUsingConnections: " << statistic.mEbpfUsingConnections
+           << " mWorkerDropEvents: " << statistic.mWorkerDropEvents;
         return os;
     }
 
@@ -220,26 +224,28 @@ private:
         mEbpfDisableProcesses = 0;
         mEbpfUsingConnections = 0;
         mEbpfLostCount = 0;
+        mWorkerDropEvents = 0;
     }
 };
 
 // Global statistics for protocol
 struct ProtocolStatistic {
-    uint32_t mHTTPParseFailCount{0};
-    uint32_t mRedisParseFailCount{0};
-    uint32_t mMySQLParseFailCount{0};
-    uint32_t mPgSQLParseFailCount{0};
-    uint32_t mDNSParseFailCount{0};
-    uint32_t mHTTPDropCount{0};
-    uint32_t mRedisDropCount{0};
-    uint32_t mMySQLDropCount{0};
-    uint32_t mPgSQLDropCount{0};
-    uint32_t mDNSDropCount{0};
-    uint32_t mHTTPCount{0};
-    uint32_t mRedisCount{0};
-    uint32_t mMySQLCount{0};
-    uint32_t mPgSQLCount{0};
-    uint32_t mDNSCount{0};
+    // Counted by NetworkObserver workers concurrently.
+    std::atomic<uint32_t> mHTTPParseFailCount{0};
+    std::atomic<uint32_t> mRedisParseFailCount{0};
+    std::atomic<uint32_t> mMySQLParseFailCount{0};
+    std::atomic<uint32_t> mPgSQLParseFailCount{0};
+    std::atomic<uint32_t> mDNSParseFailCount{0};
+    std::atomic<uint32_t> mHTTPDropCount{0};
+    std::atomic<uint32_t> mRedisDropCount{0};
+    std::atomic<uint32_t> mMySQLDropCount{0};
+    std::atomic<uint32_t> mPgSQLDropCount{0};
+    std::atomic<uint32_t> mDNSDropCount{0};
+    std::atomic<uint32_t> mHTTPCount{0};
+    std::atomic<uint32_t> mRedisCount{0};
+    std::atomic<uint32_t> mMySQLCount{0};
+    std::atomic<uint32_t> mPgSQLCount{0};
+    std::atomic<uint32_t> mDNSCount{0};
 
     static ProtocolStatistic* GetInstance() {
         static auto ptr = new ProtocolStatistic();
@@ -31,6 +31,9 @@ namespace logtail {
 void ContainerProcessGroup::FlushOutMetrics(uint64_t timeNano,
                                             std::vector<sls_logs::Log>& allData,
                                             std::vector<std::pair<std::string, std::string>>& tags) {
+    for (auto& aggregator : mWorkerAggregators) {
+        mAggregator.Merge(*aggregator);
+    }
     auto& metaTags = mMetaPtr->GetFormattedMeta();
     mAggregator.FlushOutMetrics(timeNano, allData, metaTags, tags);
 }
@@ -48,6 +48,20 @@ struct ContainerProcessGroup {
         return mAllProcesses.empty();
     }
 
+    /**
+     * @brief GetWorkerAggregator returns the aggregators used by NetworkObserver worker, which are merged into
+     * mAggregator when flushing.
+     * @param index worker index
+     * @return
+     */
+    ProtocolEventAggregators& GetWorkerAggregator(size_t index) {
+        while (mWorkerAggregators.size() <= index) {
+            mWorkerAggregators.emplace_back(new ProtocolEventAggregators);
+            mWorkerAggregators.back()->SetProcessMeta(mMetaPtr);
+        }
+        return *mWorkerAggregators[index];
+    }
+
     void FlushOutMetrics(uint64_t timeNano,
                          std::vector<sls_logs::Log>& allData,
                          std::vector<std::pair<std::string, std::string>>& tags);
@@ -55,6 +69,7 @@ struct ContainerProcessGroup {
     std::unordered_set<uint32_t> mAllProcesses;
     ProcessMetaPtr mMetaPtr;
     ProtocolEventAggregators mAggregator;
+    std::vector<std::unique_ptr<ProtocolEventAggregators>> mWorkerAggregators;
 };
 
 typedef std::shared_ptr<ContainerProcessGroup> ContainerProcessGroupPtr;
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include <vector>
@@ -113,8 +114,9 @@ struct ProcessMeta {
     }
 
     bool PassFilterRules() {
-        if (this->mPassFilterRules != 0) {
-            return mPassFilterRules > 0;
+        int8_t passFilterRules = this->mPassFilterRules;
+        if (passFilterRules != 0) {
+            return passFilterRules > 0;
         }
         auto instance = NetworkConfig::GetInstance();
         std::string exception;
@@ -169,7 +171,8 @@ struct ProcessMeta {
 
 private:
     std::vector<std::pair<std::string, std::string> > mMetaInfo;
-    int8_t mPassFilterRules = 0;
+    // Checked by NetworkObserver workers concurrently.
+    std::atomic<int8_t> mPassFilterRules{0};
     friend class CGroupPathResolverUnittest;
 };
 
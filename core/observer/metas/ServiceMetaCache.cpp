@@ -55,6 +55,7 @@ void ServiceMetaCache::Put(const std::string& remoteIP, const std::string& host,
 
 
 void ServiceMetaManager::AddHostName(uint32_t pid, const std::string& hostname, const std::string& ip) {
+    std::lock_guard<std::mutex> lock(mAddHostNameMux);
     auto meta = mHostnameMetas.find(pid);
     if (meta == mHostnameMetas.end()) {
         meta = mHostnameMetas.insert(std::make_pair(pid, new ServiceMetaCache(200))).first;
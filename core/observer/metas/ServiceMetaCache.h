@@ -19,6 +19,7 @@
 
 #include <utility>
 #include <list>
+#include <mutex>
 #include <unordered_map>
 #include <ostream>
 #include "interface/type.h"
@@ -106,6 +107,9 @@ private:
 
 private:
     std::unordered_map<uint32_t, ServiceMetaCache*> mHostnameMetas;
+    // AddHostName is called by NetworkObserver workers concurrently, other methods are called
+    // by event loop thread while workers are paused.
+    std::mutex mAddHostNameMux;
     friend class HostnameMetaUnittest;
 };
 
@@ -44,6 +44,12 @@ DEFINE_FLAG_INT64(sls_observer_network_connection_closed_timeout,
 DEFINE_FLAG_INT32(sls_observer_network_no_data_sleep_interval_ms, "SLS Observer NetWork no data sleep interval ms", 10);
 DEFINE_FLAG_INT32(sls_observer_network_pcap_loop_count, "SLS Observer NetWork PCAP loop count", 100);
 DEFINE_FLAG_BOOL(sls_observer_network_protocol_stat, "SLS Observer NetWork protocol stat output", false);
+DEFINE_FLAG_INT32(sls_observer_network_worker_count,
+                  "SLS Observer NetWork worker count, packets are processed in event loop thread if less than 2",
+                  1);
+DEFINE_FLAG_INT64(sls_observer_network_worker_max_pending_size,
+                  "SLS Observer NetWork max size of packets pending for a worker, packets are dropped when exceeded",
+                  64LL * 1024LL * 1024LL);
 
 #define OBSERVER_CONFIG_TO_REGEX(jsonvalue, param) \
     { \
@@ -33,6 +33,8 @@ DECLARE_FLAG_INT64(sls_observer_network_connection_closed_timeout);
 DECLARE_FLAG_INT32(sls_observer_network_no_data_sleep_interval_ms);
 DECLARE_FLAG_INT32(sls_observer_network_pcap_loop_count);
 DECLARE_FLAG_BOOL(sls_observer_network_protocol_stat);
+DECLARE_FLAG_INT32(sls_observer_network_worker_count);
+DECLARE_FLAG_INT64(sls_observer_network_worker_max_pending_size);
 
 
 namespace logtail {
@@ -15,6 +15,7 @@
 #include "NetworkObserver.h"
 #include "logger/Logger.h"
 #include "ProcessObserver.h"
+#include "NetworkObserverWorker.h"
 #include "network/protocols/ProtocolEventAggregators.h"
 #include "metas/ContainerProcessGroup.h"
 #include "sources/pcap/PCAPWrapper.h"
@@ -42,6 +43,7 @@ DECLARE_FLAG_INT32(merge_log_count_limit);
 namespace logtail {
 
 NetworkObserver::~NetworkObserver() {
+    StopWorkers();
     for (auto iter = mAllProcesses.begin(); iter != mAllProcesses.end(); ++iter) {
         delete iter->second;
     }
@@ -51,6 +53,7 @@ void NetworkObserver::HoldOn(bool exitFlag) {
         mEBPFWrapper->HoldOn();
     }
     mEventLoopThreadRWL.lock();
+    WaitWorkersIdle();
     LOG_INFO(sLogger, ("hold on", "observer"));
 }
 
@@ -73,11 +76,8 @@ uint32_t NetworkObserver::EBPFConnectionGC(uint64_t nowTimeNs) {
     std::unordered_set<int32_t> pids;
     GetAllPids(pids);
     for (auto& connId : connIds) {
-        auto findIter = mAllProcesses.find(connId.tgid);
-        if (findIter != mAllProcesses.end()) {
-            if (findIter->second->HasConnection(EBPFWrapper::ConvertConnIdToSockHash(&connId))) {
-                continue;
-            }
+        if (HasConnection(connId.tgid, EBPFWrapper::ConvertConnIdToSockHash(&connId))) {
+            continue;
         }
         // check pid exists
         if (pids.find(connId.tgid) == pids.end()) {
@@ -109,26 +109,44 @@ void NetworkObserver::GarbageCollection(uint64_t nowTimeNs) {
     size_t maxSizeLimit = 1024 * 1024;
     ++mNetworkStatistic->mGCCount;
     ProtocolDebugStatistic::Clear();
-    for (auto iter = mAllProcesses.begin(); iter != mAllProcesses.end();) {
-        ProcessObserver* observer = iter->second;
-        if (observer->GarbageCollection(maxSizeLimit, nowTimeNs)) {
-            LOG_DEBUG(sLogger,
-                      ("delete processor observer when gc, meta", observer->GetProcessMeta()->ToString())("pid",
-                                                                                                          iter->first));
-            static ContainerProcessGroupManager* containerProcessGroupManager
-                = ContainerProcessGroupManager::GetInstance();
-            // @note we must us iter->first as pid (not processMeta->Pid), because processMeta may belong to other pid
-            // in the same container
-            containerProcessGroupManager->OnProcessDestroy(observer->GetProcessMeta().get(), iter->first);
-            mServiceMetaManager->OnProcessDestroy(iter->first);
-            delete observer;
-            iter = mAllProcesses.erase(iter);
-            ++mNetworkStatistic->mGCReleaseProcessCount;
-        } else {
-            ++iter;
+    // a process may have observers in several workers, it is destroyed after all of them are deleted.
+    std::unordered_map<uint32_t, ProcessMetaPtr> deletedProcesses;
+    auto gcProcesses = [&](std::unordered_map<uint32_t, ProcessObserver*>& processes) {
+        for (auto iter = processes.begin(); iter != processes.end();) {
+            ProcessObserver* observer = iter->second;
+            if (observer->GarbageCollection(maxSizeLimit, nowTimeNs)) {
+                LOG_DEBUG(sLogger,
+                          ("delete processor observer when gc, meta",
+                           observer->GetProcessMeta()->ToString())("pid", iter->first));
+                deletedProcesses[iter->first] = observer->GetProcessMeta();
+                delete observer;
+                iter = processes.erase(iter);
+                ++mNetworkStatistic->mGCReleaseProcessCount;
+            } else {
+                ++iter;
+            }
         }
-        mServiceMetaManager->GarbageTimeoutHostname(nowTimeNs / 1000000);
+    };
+    gcProcesses(mAllProcesses);
+    for (auto& worker : mWorkers) {
+        gcProcesses(worker->GetProcesses());
     }
+    static ContainerProcessGroupManager* containerProcessGroupManager = ContainerProcessGroupManager::GetInstance();
+    for (auto& item : deletedProcesses) {
+        bool alive = mAllProcesses.find(item.first) != mAllProcesses.end();
+        for (size_t i = 0; i < mWorkers.size() && !alive; ++i) {
+            auto& processes = mWorkers[i]->GetProcesses();
+            alive = processes.find(item.first) != processes.end();
+        }
+        if (alive) {
+            continue;
+        }
+        // @note we must us item.first as pid (not processMeta->Pid), because processMeta may belong to other pid
+        // in the same container
+        containerProcessGroupManager->OnProcessDestroy(item.second.get(), item.first);
+        mServiceMetaManager->OnProcessDestroy(item.first);
+    }
+    mServiceMetaManager->GarbageTimeoutHostname(nowTimeNs / 1000000);
 }
 
 void NetworkObserver::FlushOutMetrics(std::vector<sls_logs::Log>& allData) {
@@ -206,8 +224,15 @@ void NetworkObserver::FlushOutStatistics(std::vector<sls_logs::Log>& allData) {
 }
 
 ProcessObserver* NetworkObserver::GetProcess(PacketEventHeader* header, bool create) {
-    auto findIter = mAllProcesses.find(header->PID);
-    if (findIter != mAllProcesses.end()) {
+    return GetProcess(mAllProcesses, header, -1, create);
+}
+
+ProcessObserver* NetworkObserver::GetProcess(std::unordered_map<uint32_t, ProcessObserver*>& processes,
+                                             PacketEventHeader* header,
+                                             int32_t workerIndex,
+                                             bool create) {
+    auto findIter = processes.find(header->PID);
+    if (findIter != processes.end()) {
         return findIter->second;
     }
     if (!create) {
@@ -215,11 +240,14 @@ ProcessObserver* NetworkObserver::GetProcess(PacketEventHeader* header, bool cre
     }
     ProcessObserver* newProc = new ProcessObserver(header->TimeNano);
     static ContainerProcessGroupManager* containerProcessGroupManager = ContainerProcessGroupManager::GetInstance();
-    ProcessMetaPtr processMeta = containerProcessGroupManager->GetProcessMeta(header->PID);
-    ContainerProcessGroupPtr groupPtr
-        = containerProcessGroupManager->GetContainerProcessGroupPtr(processMeta, header->PID);
-    newProc->SetProcessGroup(groupPtr);
-    mAllProcesses.insert(std::make_pair(header->PID, newProc));
+    {
+        std::lock_guard<std::mutex> lock(mProcessGroupMux);
+        ProcessMetaPtr processMeta = containerProcessGroupManager->GetProcessMeta(header->PID);
+        ContainerProcessGroupPtr groupPtr
+            = containerProcessGroupManager->GetContainerProcessGroupPtr(processMeta, header->PID);
+        newProc->SetProcessGroup(groupPtr, workerIndex);
+    }
+    processes.insert(std::make_pair(header->PID, newProc));
     return newProc;
 }
 
@@ -250,6 +278,26 @@ int NetworkObserver::OnPacketEvent(void* event, size_t len) {
             }
         }
     }
+    if (!mWorkers.empty()) {
+        if (header->EventType == PacketEventType_None
+            || (header->EventType == PacketEventType_Data
+                && reinterpret_cast<PacketEventData*>((char*)event + sizeof(PacketEventHeader))->PtlType
+                    == ProtocolType_None)) {
+            return 0;
+        }
+        mWorkers[GetWorkerIndex(header->PID, header->SockHash)]->Push(event, len);
+        return 0;
+    }
+    if (!ProcessPacketEvent(event, mAllProcesses, -1) && this->mEBPFWrapper != nullptr) {
+        this->mEBPFWrapper->DisableProcess(header->PID);
+    }
+    return 0;
+}
+
+bool NetworkObserver::ProcessPacketEvent(void* event,
+                                         std::unordered_map<uint32_t, ProcessObserver*>& processes,
+                                         int32_t workerIndex) {
+    PacketEventHeader* header = static_cast<PacketEventHeader*>(event);
     switch (header->EventType) {
         case PacketEventType_None:
             break;
@@ -259,29 +307,81 @@ int NetworkObserver::OnPacketEvent(void* event, size_t len) {
             if (data->PtlType == ProtocolType_None) {
                 break;
             }
-            ProcessObserver* proc = GetProcess(header);
+            ProcessObserver* proc = GetProcess(processes, header, workerIndex, true);
             if (!proc->GetProcessMeta()->PassFilterRules()) {
-                if (this->mEBPFWrapper != nullptr) {
-                    this->mEBPFWrapper->DisableProcess(header->PID);
-                }
-                break;
+                return false;
             }
             proc->OnData(header, data);
         } break;
         case PacketEventType_Connected:
         case PacketEventType_Accepted:
             // create process
-            GetProcess(header);
+            GetProcess(processes, header, workerIndex, true);
             break;
         case PacketEventType_Closed: {
-            ProcessObserver* proc = GetProcess(header, false);
+            ProcessObserver* proc = GetProcess(processes, header, workerIndex, false);
             if (proc == NULL) {
                 break;
             }
             proc->ConnectionMarkDeleted(header);
         } break;
     }
-    return 0;
+    return true;
+}
+
+bool NetworkObserver::HasConnection(uint32_t pid, uint32_t sockHash) {
+    auto& processes = mWorkers.empty() ? mAllProcesses : mWorkers[GetWorkerIndex(pid, sockHash)]->GetProcesses();
+    auto findIter = processes.find(pid);
+    return findIter != processes.end() && findIter->second->HasConnection(sockHash);
+}
+
+void NetworkObserver::StartWorkers(size_t count) {
+    if (!mWorkers.empty() || count < 2) {
+        return;
+    }
+    LOG_INFO(sLogger, ("start observer network workers, count", count));
+    for (size_t i = 0; i < count; ++i) {
+        mWorkers.emplace_back(new NetworkObserverWorker(this, (int32_t)i));
+        mWorkers.back()->Start();
+    }
+}
+
+void NetworkObserver::StopWorkers() {
+    SubmitToWorkers();
+    for (auto& worker : mWorkers) {
+        worker->Stop();
+    }
+    mWorkers.clear();
+}
+
+void NetworkObserver::SubmitToWorkers() {
+    std::vector<uint32_t> disabledPids;
+    for (auto& worker : mWorkers) {
+        uint32_t dropCount = worker->Submit(disabledPids);
+        if (dropCount > 0) {
+            mNetworkStatistic->mWorkerDropEvents += dropCount;
+            LOG_DEBUG(sLogger, ("too many packets pending for observer network worker, drop count", dropCount));
+        }
+    }
+    if (this->mEBPFWrapper != nullptr) {
+        for (auto pid : disabledPids) {
+            this->mEBPFWrapper->DisableProcess(pid);
+        }
+    }
+}
+
+std::vector<std::unique_lock<std::mutex>> NetworkObserver::PauseWorkers() {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto& worker : mWorkers) {
+        locks.push_back(worker->Pause());
+    }
+    return locks;
+}
+
+void NetworkObserver::WaitWorkersIdle() {
+    for (auto& worker : mWorkers) {
+        worker->WaitIdle();
+    }
 }
 void NetworkObserver::OnProcessDestroyed(uint32_t pid, const char* command, size_t len) {
     auto findIter = mAllProcesses.find(pid);
@@ -427,22 +527,36 @@ void NetworkObserver::EventLoop() {
                 free(buf);
             }
         }
+        SubmitToWorkers();
+
+        // workers are paused when process observers, metas and aggregators are maintained
+        std::vector<std::unique_lock<std::mutex>> pausedWorkers;
+        bool needFlushMeta
+            = nowTimeNs - mLastFlushMetaTimeNs >= mConfig->mFlushMetaInterval * 1000ULL * 1000ULL * 1000ULL;
+        bool needGC
+            = nowTimeNs - mLastGCTimeNs >= INT64_FLAG(sls_observer_network_gc_interval) * 1000ULL * 1000ULL * 1000ULL;
+        bool needEbpfGC = mEBPFWrapper != NULL
+            && nowTimeNs - mLastEbpfGCTimeNs
+                > INT64_FLAG(sls_observer_network_ebpf_connection_gc_interval) * 1000ULL * 1000ULL * 1000ULL;
+        bool needFlushOut
+            = nowTimeNs - mLastFlushTimeNs >= mConfig->mFlushOutInterval * 1000ULL * 1000ULL * 1000ULL;
+        if (needFlushMeta || needGC || needEbpfGC || needFlushOut) {
+            pausedWorkers = PauseWorkers();
+        }
 
         // fetching metas
-        if (nowTimeNs - mLastFlushMetaTimeNs >= mConfig->mFlushMetaInterval * 1000ULL * 1000ULL * 1000ULL) {
+        if (needFlushMeta) {
             mLastFlushMetaTimeNs = nowTimeNs;
             ContainerProcessGroupManager::GetInstance()->Init();
             ContainerProcessGroupManager::GetInstance()->FlushMetas();
         }
 
         // GC
-        if (nowTimeNs - mLastGCTimeNs >= INT64_FLAG(sls_observer_network_gc_interval) * 1000ULL * 1000ULL * 1000ULL) {
+        if (needGC) {
             mLastGCTimeNs = nowTimeNs;
             GarbageCollection(nowTimeNs);
         }
-        if (mEBPFWrapper != NULL
-            && nowTimeNs - mLastEbpfGCTimeNs
-                > INT64_FLAG(sls_observer_network_ebpf_connection_gc_interval) * 1000ULL * 1000ULL * 1000ULL) {
+        if (needEbpfGC) {
             mLastEbpfGCTimeNs = nowTimeNs;
             mNetworkStatistic->mEbpfUsingConnections = EBPFConnectionGC(nowTimeNs);
         }
@@ -453,7 +567,7 @@ void NetworkObserver::EventLoop() {
         }
 
         // flush observer metrics
-        if (nowTimeNs - mLastFlushTimeNs >= mConfig->mFlushOutInterval * 1000ULL * 1000ULL * 1000ULL) {
+        if (needFlushOut) {
             mLastFlushTimeNs = nowTimeNs;
             std::vector<sls_logs::Log> allLogs;
             FlushOutMetrics(allLogs);
@@ -472,6 +586,7 @@ void NetworkObserver::EventLoop() {
                 mSenderFunc(allLogs, mConfig->mLastApplyedConfig);
             }
         }
+        pausedWorkers.clear();
 
         // flush profile metrics
         if ((nowTimeNs - lastProfilingTime) >= INT32_FLAG(monitor_interval) * 1000ULL * 1000ULL * 1000ULL) {
@@ -506,6 +621,8 @@ void NetworkObserver::BindSender() {
 
 inline void NetworkObserver::StartEventLoop() {
     if (!mEventLoopThread) {
+        StartWorkers(INT32_FLAG(sls_observer_network_worker_count) > 0 ? INT32_FLAG(sls_observer_network_worker_count)
+                                                                        : 1);
         mEventLoopThread = CreateThread([this]() { EventLoop(); });
     }
 }
@@ -21,6 +21,8 @@
 #include "NetworkConfig.h"
 #include <unordered_map>
 #include <ostream>
+#include <memory>
+#include <mutex>
 #include "log_pb/sls_logs.pb.h"
 #include "common/Thread.h"
 #include "common/Lock.h"
@@ -32,6 +34,7 @@
 
 namespace logtail {
 class ProcessObserver;
+class NetworkObserverWorker;
 class PCAPWrapper;
 class EBPFWrapper;
 
@@ -79,6 +82,61 @@ private:
      */
     ProcessObserver* GetProcess(PacketEventHeader* header, bool create = true);
 
+    /**
+     * @brief Get or create a new process observer in the process observers of event loop thread or a worker.
+     * @param processes the process observers owned by current thread.
+     * @param header the network packet meta data.
+     * @param workerIndex index of worker which owns processes, -1 means event loop thread.
+     * @param create whether create new process obj when not found
+     * @return ProcessObserver allocated in heap.
+     */
+    ProcessObserver* GetProcess(std::unordered_map<uint32_t, ProcessObserver*>& processes,
+                                PacketEventHeader* header,
+                                int32_t workerIndex,
+                                bool create);
+
+    /**
+     * @brief Process a packet event with process observers owned by current thread.
+     * @param event the packet event.
+     * @param processes the process observers owned by current thread.
+     * @param workerIndex index of worker which owns processes, -1 means event loop thread.
+     * @return false means the process of event doesn't pass filter rules and should be disabled.
+     */
+    bool ProcessPacketEvent(void* event, std::unordered_map<uint32_t, ProcessObserver*>& processes, int32_t workerIndex);
+
+    /**
+     * @brief HasConnection checks whether the connection is observed by event loop thread or its worker.
+     */
+    bool HasConnection(uint32_t pid, uint32_t sockHash);
+
+    size_t GetWorkerIndex(uint32_t pid, uint32_t sockHash) const {
+        uint64_t hashVal = (((uint64_t)pid << 32) | sockHash) * 0x9e3779b97f4a7c15ULL;
+        return (hashVal >> 32) % mWorkers.size();
+    }
+
+    /**
+     * @brief StartWorkers creates workers to process packet events when count is greater than 1.
+     */
+    void StartWorkers(size_t count);
+
+    /**
+     * @brief StopWorkers processes submitted events and destroys all workers with their process observers.
+     */
+    void StopWorkers();
+
+    /**
+     * @brief SubmitToWorkers hands events pushed since last submit over to workers, and disables processes found
+     * by workers.
+     */
+    void SubmitToWorkers();
+
+    /**
+     * @brief PauseWorkers blocks until workers finish current batch, workers are paused until the locks are released.
+     */
+    std::vector<std::unique_lock<std::mutex>> PauseWorkers();
+
+    void WaitWorkersIdle();
+
     /**
      * @brief BindSender bind different output ways, such as sls or plugins output ways.
      */
@@ -116,6 +174,10 @@ private:
     void StartEventLoop();
 
     std::unordered_map<uint32_t, ProcessObserver*> mAllProcesses;
+    // Packet events are processed by workers if not empty, sharded by pid and sock hash.
+    std::vector<std::unique_ptr<NetworkObserverWorker>> mWorkers;
+    // Held by workers when creating processes with ContainerProcessGroupManager.
+    std::mutex mProcessGroupMux;
     std::function<int(std::vector<sls_logs::Log>&, Config*)> mSenderFunc;
     ThreadPtr mEventLoopThread;
     ReadWriteLock mEventLoopThreadRWL;
@@ -137,6 +199,7 @@ private:
     EBPFWrapper* mEBPFWrapper = nullptr;
     NetworkConfig* mConfig;
 
+    friend class NetworkObserverWorker;
     friend class NetworkObserverUnittest;
     friend class PCAPWrapperUnittest;
     friend class EBPFWrapperUnittest;
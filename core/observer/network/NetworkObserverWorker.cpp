@@ -0,0 +1,145 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "NetworkObserverWorker.h"
+#include <cstring>
+#include "NetworkConfig.h"
+#include "NetworkObserver.h"
+#include "ProcessObserver.h"
+#include "interface/helper.h"
+#include "logger/Logger.h"
+
+namespace logtail {
+
+NetworkObserverWorker::NetworkObserverWorker(NetworkObserver* observer, int32_t index)
+    : mObserver(observer), mIndex(index) {
+}
+
+NetworkObserverWorker::~NetworkObserverWorker() {
+    Stop();
+    for (auto iter = mProcesses.begin(); iter != mProcesses.end(); ++iter) {
+        delete iter->second;
+    }
+}
+
+void NetworkObserverWorker::Start() {
+    if (!mThread.joinable()) {
+        mThread = std::thread([this]() { Run(); });
+    }
+}
+
+void NetworkObserverWorker::Stop() {
+    if (!mThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mPendingMux);
+        mStop = true;
+    }
+    mPendingCV.notify_one();
+    mThread.join();
+}
+
+void NetworkObserverWorker::Push(void* event, size_t len) {
+    PacketEventHeader* header = static_cast<PacketEventHeader*>(event);
+    PacketEventData* data = NULL;
+    size_t eventLen = sizeof(PacketEventHeader);
+    if (header->EventType == PacketEventType_Data && len >= sizeof(PacketEventHeader) + sizeof(PacketEventData)) {
+        data = reinterpret_cast<PacketEventData*>((char*)event + sizeof(PacketEventHeader));
+        eventLen += sizeof(PacketEventData) + data->BufferLen;
+    }
+    // keep events 8 bytes aligned, the buffer of data is rebound by BufferToPacketEvent.
+    size_t pos = mStaging.size();
+    mStaging.resize(pos + sizeof(uint64_t) + ((eventLen + 7) & ~(size_t)7));
+    char* dst = &mStaging[pos];
+    *(uint64_t*)dst = eventLen;
+    dst += sizeof(uint64_t);
+    if (data == NULL) {
+        memcpy(dst, event, sizeof(PacketEventHeader));
+    } else {
+        memcpy(dst, event, sizeof(PacketEventHeader) + sizeof(PacketEventData));
+        memcpy(dst + sizeof(PacketEventHeader) + sizeof(PacketEventData), data->Buffer, data->BufferLen);
+    }
+    ++mStagingCount;
+}
+
+uint32_t NetworkObserverWorker::Submit(std::vector<uint32_t>& disabledPids) {
+    uint32_t dropCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mPendingMux);
+        if (!mDisabledPids.empty()) {
+            disabledPids.insert(disabledPids.end(), mDisabledPids.begin(), mDisabledPids.end());
+            mDisabledPids.clear();
+        }
+        if (mStaging.empty()) {
+            return 0;
+        }
+        if (mPending.empty()) {
+            mPending.swap(mStaging);
+        } else if ((int64_t)mPending.size() < INT64_FLAG(sls_observer_network_worker_max_pending_size)) {
+            mPending.append(mStaging);
+        } else {
+            dropCount = mStagingCount;
+        }
+    }
+    mStaging.clear();
+    mStagingCount = 0;
+    if (dropCount == 0) {
+        mPendingCV.notify_one();
+    }
+    return dropCount;
+}
+
+void NetworkObserverWorker::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mPendingMux);
+    mIdleCV.wait(lock, [this]() { return !mBusy && mPending.empty(); });
+}
+
+void NetworkObserverWorker::Run() {
+    LOG_INFO(sLogger, ("start observer network worker", mIndex));
+    std::string batch;
+    std::vector<uint32_t> disabledPids;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mPendingMux);
+            mBusy = false;
+            mDisabledPids.insert(mDisabledPids.end(), disabledPids.begin(), disabledPids.end());
+            disabledPids.clear();
+            mIdleCV.notify_all();
+            mPendingCV.wait(lock, [this]() { return mStop || !mPending.empty(); });
+            if (mPending.empty()) {
+                break;
+            }
+            // the buffers are swapped back and forth, so that their capacity is reused.
+            batch.swap(mPending);
+            mBusy = true;
+        }
+        std::lock_guard<std::mutex> lock(mProcessMux);
+        for (size_t pos = 0; pos < batch.size();) {
+            uint64_t eventLen = *(uint64_t*)&batch[pos];
+            char* buffer = &batch[pos + sizeof(uint64_t)];
+            pos += sizeof(uint64_t) + ((eventLen + 7) & ~(uint64_t)7);
+            void* event = NULL;
+            int32_t len = 0;
+            BufferToPacketEvent(buffer, (int32_t)eventLen, event, len);
+            if (event != NULL && !mObserver->ProcessPacketEvent(event, mProcesses, mIndex)) {
+                disabledPids.push_back(static_cast<PacketEventHeader*>(event)->PID);
+            }
+        }
+        batch.clear();
+    }
+    LOG_INFO(sLogger, ("stop observer network worker", mIndex));
+}
+
+} // namespace logtail
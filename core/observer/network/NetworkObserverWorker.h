@@ -0,0 +1,109 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "interface/network.h"
+
+namespace logtail {
+class NetworkObserver;
+class ProcessObserver;
+
+/**
+ * @brief The NetworkObserverWorker class processes packet events of a shard of connections for NetworkObserver.
+ * Event loop thread copies events to the worker selected by pid and sock hash, so events of a connection are
+ * always processed by one worker in order. Works are as follows:
+ * * The worker owns ProcessObservers of its connections, a process with connections in several shards has one
+ *   ProcessObserver in each of them.
+ * * Protocol events are aggregated into the worker's own aggregators of ContainerProcessGroup, which are merged
+ *   when flushing.
+ * * Event loop thread pauses all workers before GC, flushing metas and metrics.
+ */
+class NetworkObserverWorker {
+public:
+    NetworkObserverWorker(NetworkObserver* observer, int32_t index);
+
+    ~NetworkObserverWorker();
+
+    void Start();
+
+    /**
+     * @brief Stop processes submitted events and waits for the worker thread to exit.
+     */
+    void Stop();
+
+    /**
+     * @brief Push copies the event to staging buffer, only called by event loop thread.
+     */
+    void Push(void* event, size_t len);
+
+    /**
+     * @brief Submit hands staging events over to worker thread, staging events are dropped if too many events are
+     * pending.
+     * @param disabledPids appended with pids which don't pass filter rules, found since last submit
+     * @return count of dropped events
+     */
+    uint32_t Submit(std::vector<uint32_t>& disabledPids);
+
+    /**
+     * @brief WaitIdle blocks until all submitted events are processed.
+     */
+    void WaitIdle();
+
+    /**
+     * @brief Pause blocks until current batch is processed, and worker is paused until the lock is released.
+     */
+    std::unique_lock<std::mutex> Pause() { return std::unique_lock<std::mutex>(mProcessMux); }
+
+    /**
+     * @brief GetProcesses can only be called when worker is paused or stopped.
+     */
+    std::unordered_map<uint32_t, ProcessObserver*>& GetProcesses() { return mProcesses; }
+
+private:
+    void Run();
+
+    NetworkObserver* mObserver;
+    int32_t mIndex;
+
+    // Held while processing a batch.
+    std::mutex mProcessMux;
+    std::unordered_map<uint32_t, ProcessObserver*> mProcesses;
+
+    // Events pushed since last submit, only accessed by event loop thread.
+    std::string mStaging;
+    uint32_t mStagingCount = 0;
+
+    std::mutex mPendingMux;
+    std::condition_variable mPendingCV;
+    std::condition_variable mIdleCV;
+    // Events submitted and not processed yet, each one is 8 bytes length and 8 bytes aligned event.
+    std::string mPending;
+    std::vector<uint32_t> mDisabledPids;
+    bool mBusy = false;
+    bool mStop = false;
+    std::thread mThread;
+
+    friend class NetworkObserverUnittest;
+};
+
+} // namespace logtail
@@ -69,9 +69,15 @@ public:
 
     ProtocolEventAggregators* GetAggregator() { return mAllAggregator; }
 
-    void SetProcessGroup(ContainerProcessGroupPtr& groupPtr) {
+    /**
+     * @brief SetProcessGroup
+     * @param groupPtr
+     * @param workerIndex index of NetworkObserver worker which owns this process, -1 means event loop thread.
+     */
+    void SetProcessGroup(ContainerProcessGroupPtr& groupPtr, int32_t workerIndex = -1) {
         mProcessGroupPtr = groupPtr;
-        mAllAggregator = &mProcessGroupPtr->mAggregator;
+        mAllAggregator = workerIndex < 0 ? &mProcessGroupPtr->mAggregator
+                                         : &mProcessGroupPtr->GetWorkerAggregator(workerIndex);
     }
 
     /**
@@ -16,6 +16,23 @@
 
 namespace logtail {
 
+void ProtocolEventAggregators::Merge(ProtocolEventAggregators& other) {
+    if (other.mDNSAggregators != NULL) {
+        GetDNSAggregator()->Merge(*other.mDNSAggregators);
+    }
+    if (other.mHTTPAggregators != NULL) {
+        GetHTTPAggregator()->Merge(*other.mHTTPAggregators);
+    }
+    if (other.mMySQLAggregators != NULL) {
+        GetMySQLAggregator()->Merge(*other.mMySQLAggregators);
+    }
+    if (other.mRedisAggregators != NULL) {
+        GetRedisAggregator()->Merge(*other.mRedisAggregators);
+    }
+    if (other.mPgSQLAggregators != NULL) {
+        GetPgSQLAggregator()->Merge(*other.mPgSQLAggregators);
+    }
+}
 
 void ProtocolEventAggregators::FlushOutMetrics(uint64_t timeNano,
                                                std::vector<sls_logs::Log>& allData,
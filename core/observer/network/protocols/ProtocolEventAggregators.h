@@ -105,6 +105,9 @@ public:
 
     void SetProcessMeta(const ProcessMetaPtr& metaPtr) { mMetaPtr = metaPtr; }
 
+    // Merge moves aggregated results of @other into this, see CommonProtocolEventAggregator::Merge.
+    void Merge(ProtocolEventAggregators& other);
+
     void FlushOutMetrics(uint64_t timeNano,
                          std::vector<sls_logs::Log>& allData,
                          std::vector<std::pair<std::string, std::string> >& processTags,
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "interface/protocol.h"
+#include <cstring>
 #include <deque>
 #include "log_pb/sls_logs.pb.h"
 #include "Logger.h"
@@ -42,22 +43,28 @@ inline void AddAnyLogContent(sls_logs::Log* log, const std::string& key, const s
     content->set_value(value);
 }
 
+// CommonAggKey is the connection part of protocol aggregation keys. It is built for every
+//  event, so it only keeps raw values and they are converted to strings in ToPB.
 struct CommonAggKey {
     CommonAggKey() = default;
     CommonAggKey(PacketEventHeader* header)
-        : HashVal(0),
-          RemoteIp(SockAddressToString(header->DstAddr)),
-          RemotePort(std::to_string(header->RoleType == PacketRoleType::Server ? 0 : header->DstPort)),
-          Role(PacketRoleTypeToString(header->RoleType)),
+        : RemoteAddr(header->DstAddr),
+          RemotePort(header->RoleType == PacketRoleType::Server ? 0 : header->DstPort),
+          Role(header->RoleType),
           Pid(header->PID) {
-        HashVal = XXH32(Role.c_str(), Role.size(), HashVal);
-        HashVal = XXH32(RemoteIp.c_str(), RemoteIp.size(), HashVal);
-        HashVal = XXH32(RemotePort.c_str(), RemotePort.size(), HashVal);
+        HashVal = ComputeHash();
+    }
+
+    uint64_t ComputeHash() const {
+        uint64_t hashVal = RemoteAddr.Type == SockAddressType_IPV4
+            ? MixHash(RemoteAddr.Addr.IPV4, 0)
+            : MixHash(RemoteAddr.Addr.IPV6[1], MixHash(RemoteAddr.Addr.IPV6[0], 0));
+        return MixHash(((uint64_t)RemotePort << 32) | (uint64_t)Role, hashVal);
     }
 
     friend std::ostream& operator<<(std::ostream& os, const CommonAggKey& key) {
-        os << "HashVal: " << key.HashVal << " RemoteIp: " << key.RemoteIp << " RemotePort: " << key.RemotePort
-           << " Role: " << key.Role << " Pid: " << key.Pid;
+        os << "HashVal: " << key.HashVal << " RemoteIp: " << SockAddressToString(key.RemoteAddr)
+           << " RemotePort: " << key.RemotePort << " Role: " << PacketRoleTypeToString(key.Role) << " Pid: " << key.Pid;
         return os;
     }
 
@@ -65,12 +72,13 @@ struct CommonAggKey {
         static auto sServiceMetaManager = ServiceMetaManager::GetInstance();
         auto content = log->add_contents();
         content->set_key("role");
-        content->set_value(Role);
+        content->set_value(PacketRoleTypeToString(Role));
+        std::string remoteIp = SockAddressToString(RemoteAddr);
         Json::Value root;
-        root["remote_ip"] = RemoteIp;
-        root["remote_port"] = RemotePort;
-        if (Role == "client") {
-            auto& serviceMeta = sServiceMetaManager->GetOrPutServiceMeta(Pid, RemoteIp, protocolType);
+        root["remote_ip"] = remoteIp;
+        root["remote_port"] = std::to_string(RemotePort);
+        if (Role == PacketRoleType::Client) {
+            auto& serviceMeta = sServiceMetaManager->GetOrPutServiceMeta(Pid, remoteIp, protocolType);
             root["remote_type"] = ServiceCategoryToString(
                 serviceMeta.Empty() ? DetectRemoteServiceCategory(protocolType) : serviceMeta.Category);
             if (!serviceMeta.Host.empty()) {
@@ -82,11 +90,19 @@ struct CommonAggKey {
         content->set_value(Json::FastWriter().write(root));
     }
 
-    uint64_t HashVal;
-    std::string RemoteIp;
-    std::string RemotePort;
-    std::string Role;
-    uint32_t Pid;
+    // MixHash combines @value into @seed with the finalizer of splitmix64.
+    static uint64_t MixHash(uint64_t value, uint64_t seed) {
+        uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t HashVal = 0;
+    SockAddress RemoteAddr{};
+    uint16_t RemotePort = 0;
+    PacketRoleType Role = PacketRoleType::Unknown;
+    uint32_t Pid = 0;
 };
 
 struct CommonProtocolEventInfo {
@@ -114,6 +130,83 @@ struct CommonProtocolEventInfo {
     int32_t RespBytes;
 };
 
+// LatencyHistogram is a log-linear histogram of latencies with fixed memory. Every power of two
+//  range is split into kSubBucketCount linear buckets, and a percentile is reported as the middle
+//  of its bucket, so the relative error is at most 1 / (2 * kSubBucketCount). Latencies less than
+//  2^kMinExponent ns are counted in linear buckets of the first range, and latencies no less than
+//  2^kMaxExponent ns are counted in the last bucket.
+struct LatencyHistogram {
+    static const int32_t kSubBucketBits = 2;
+    static const int32_t kSubBucketCount = 1 << kSubBucketBits;
+    // 4.096us
+    static const int32_t kMinExponent = 12;
+    // 68.7s
+    static const int32_t kMaxExponent = 36;
+    static const int32_t kBucketCount = (kMaxExponent - kMinExponent + 1) * kSubBucketCount;
+
+    LatencyHistogram() { Clear(); }
+
+    void Clear() { memset(Buckets, 0, sizeof(Buckets)); }
+
+    void Add(int64_t latencyNs) { ++Buckets[BucketIndex(latencyNs)]; }
+
+    void Merge(const LatencyHistogram& histogram) {
+        for (int32_t i = 0; i < kBucketCount; ++i) {
+            Buckets[i] += histogram.Buckets[i];
+        }
+    }
+
+    // Percentile returns the latency which @percent of latencies are no greater than, 0 if empty.
+    int64_t Percentile(double percent) const {
+        uint64_t totalCount = 0;
+        for (int32_t i = 0; i < kBucketCount; ++i) {
+            totalCount += Buckets[i];
+        }
+        if (totalCount == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(percent / 100 * totalCount + 0.5);
+        rank = rank == 0 ? 1 : (rank > totalCount ? totalCount : rank);
+        uint64_t count = 0;
+        int32_t index = 0;
+        for (; index < kBucketCount - 1; ++index) {
+            count += Buckets[index];
+            if (count >= rank) {
+                break;
+            }
+        }
+        return BucketLowerBound(index) + BucketWidth(index) / 2;
+    }
+
+    static int32_t BucketIndex(int64_t latencyNs) {
+        uint64_t value = latencyNs < 0 ? 0 : (uint64_t)latencyNs;
+        if (value < (1ULL << kMinExponent)) {
+            return (int32_t)(value >> (kMinExponent - kSubBucketBits));
+        }
+        int32_t exponent = 63 - __builtin_clzll(value);
+        if (exponent >= kMaxExponent) {
+            return kBucketCount - 1;
+        }
+        int32_t subIndex = (int32_t)(value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+        return (exponent - kMinExponent + 1) * kSubBucketCount + subIndex;
+    }
+
+    static int64_t BucketLowerBound(int32_t index) {
+        if (index < kSubBucketCount) {
+            return (int64_t)index << (kMinExponent - kSubBucketBits);
+        }
+        int32_t exponent = index / kSubBucketCount - 1 + kMinExponent;
+        return (1LL << exponent) + ((int64_t)(index % kSubBucketCount) << (exponent - kSubBucketBits));
+    }
+
+    static int64_t BucketWidth(int32_t index) {
+        int32_t exponent = index < kSubBucketCount ? kMinExponent : index / kSubBucketCount - 1 + kMinExponent;
+        return 1LL << (exponent - kSubBucketBits);
+    }
+
+    uint32_t Buckets[kBucketCount];
+};
+
 struct CommonProtocolAggResult {
     CommonProtocolAggResult() : TotalCount(0), TotalLatencyNs(0), TotalReqBytes(0), TotalRespBytes(0) {}
     void Clear() {
@@ -121,6 +214,7 @@ struct CommonProtocolAggResult {
         TotalLatencyNs = 0;
         TotalReqBytes = 0;
         TotalRespBytes = 0;
+        Latency.Clear();
     }
 
     bool IsEmpty() const { return TotalCount == 0; }
@@ -130,6 +224,7 @@ struct CommonProtocolAggResult {
         TotalLatencyNs += info.LatencyNs;
         TotalReqBytes += info.ReqBytes;
         TotalRespBytes += info.RespBytes;
+        Latency.Add(info.LatencyNs);
     }
 
     void Merge(CommonProtocolAggResult& aggResult) {
@@ -137,6 +232,7 @@ struct CommonProtocolAggResult {
         TotalLatencyNs += aggResult.TotalLatencyNs;
         TotalReqBytes += aggResult.TotalReqBytes;
         TotalRespBytes += aggResult.TotalRespBytes;
+        Latency.Merge(aggResult.Latency);
     }
 
     void ToPB(sls_logs::Log* log) const {
@@ -144,12 +240,16 @@ struct CommonProtocolAggResult {
         AddAnyLogContent(log, "total_latency_ns", TotalLatencyNs);
         AddAnyLogContent(log, "total_req_bytes", TotalReqBytes);
         AddAnyLogContent(log, "total_resp_bytes", TotalRespBytes);
+        AddAnyLogContent(log, "latency_p50_ns", Latency.Percentile(50));
+        AddAnyLogContent(log, "latency_p90_ns", Latency.Percentile(90));
+        AddAnyLogContent(log, "latency_p99_ns", Latency.Percentile(99));
     }
 
     int64_t TotalCount;
     int64_t TotalLatencyNs;
     int64_t TotalReqBytes;
     int64_t TotalRespBytes;
+    LatencyHistogram Latency;
 };
 
 template <typename ProtocolEventKey>
@@ -263,16 +363,15 @@ public:
 
     // AddEvent 增加一个事件
     bool AddEvent(ProtocolEvent* event) {
-        ProtocolEventKey eventKey;
-        event->GetKey(eventKey);
-        ProtocolEventKey& patternKey = mPatternGenerator.GetPattern(eventKey);
+        // The event is owned by caller and dropped after added, so its key is used in place
+        // instead of being copied for every event.
+        ProtocolEventKey& patternKey = mPatternGenerator.GetPattern(event->Key);
         uint64_t hashVal = patternKey.Hash();
         auto findRst = mProtocolEventAggMap.find(hashVal);
         if (findRst == mProtocolEventAggMap.end()) {
-            if ((eventKey.ConnKey.Role == PacketRoleTypeToString(PacketRoleType::Client)
-                 && this->mProtocolEventAggMap.size() >= mClientAggMaxSize)
-                || (eventKey.ConnKey.Role == PacketRoleTypeToString(PacketRoleType::Server)
-                    && this->mProtocolEventAggMap.size() >= mServerAggMaxSize)) {
+            PacketRoleType role = patternKey.ConnKey.Role;
+            if ((role == PacketRoleType::Client && this->mProtocolEventAggMap.size() >= mClientAggMaxSize)
+                || (role == PacketRoleType::Server && this->mProtocolEventAggMap.size() >= mServerAggMaxSize)) {
                 if (sLogger->should_log(spdlog::level::debug)) {
                     LogMaker maker;
                     sLogger->log(spdlog::level::debug,
@@ -328,6 +427,35 @@ public:
         }
     }
 
+    // Merge moves aggregated results of @other into this aggregator and clears them in @other,
+    //  items which are empty in @other are released like FlushLogs.
+    void Merge(CommonProtocolEventAggregator& other) {
+        for (auto iter = other.mProtocolEventAggMap.begin(); iter != other.mProtocolEventAggMap.end();) {
+            ProtocolEventAggItem* otherItem = iter->second;
+            if (otherItem->AggResult.IsEmpty()) {
+                other.mAggItemManager.Delete(otherItem);
+                iter = other.mProtocolEventAggMap.erase(iter);
+                continue;
+            }
+            auto findRst = mProtocolEventAggMap.find(iter->first);
+            if (findRst == mProtocolEventAggMap.end()) {
+                PacketRoleType role = otherItem->GetKey().ConnKey.Role;
+                if ((role == PacketRoleType::Client && this->mProtocolEventAggMap.size() >= mClientAggMaxSize)
+                    || (role == PacketRoleType::Server && this->mProtocolEventAggMap.size() >= mServerAggMaxSize)) {
+                    otherItem->Clear();
+                    ++iter;
+                    continue;
+                }
+                ProtocolEventAggItem* item = mAggItemManager.Create();
+                item->SetKey(otherItem->GetKey());
+                findRst = mProtocolEventAggMap.insert(std::make_pair(iter->first, item)).first;
+            }
+            findRst->second->Merge(*otherItem);
+            otherItem->Clear();
+            ++iter;
+        }
+    }
+
 protected:
     ProtocolPatternGenerator& mPatternGenerator;
     ProtocolEventAggItemManager mAggItemManager;
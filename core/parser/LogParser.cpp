@@ -159,7 +159,8 @@ static bool StdRegexLogLineParser(const char* buffer,
                                   const string& logPath,
                                   ParseLogError& error,
                                   uint32_t& logGroupSize,
-                                  int32_t tzOffsetSecond) {
+                                  int32_t tzOffsetSecond,
+                                  const TimeFormatParser* timeFormatParser) {
     std::regex stdReg;
     std::string exception;
     try {
@@ -235,7 +236,8 @@ static bool StdRegexLogLineParser(const char* buffer,
                                         region,
                                         logPath,
                                         error,
-                                        tzOffsetSecond)) {
+                                        tzOffsetSecond,
+                                        timeFormatParser)) {
         parseSuccess = false;
         if (error == PARSE_LOG_HISTORY_ERROR)
             return false;
@@ -277,7 +279,8 @@ bool LogParser::RegexLogLineParser(const char* buffer,
                                    const string& logPath,
                                    ParseLogError& error,
                                    uint32_t& logGroupSize,
-                                   int32_t tzOffsetSecond) {
+                                   int32_t tzOffsetSecond,
+                                   const TimeFormatParser* timeFormatParser) {
     boost::match_results<const char*> what;
     string exception;
     uint64_t preciseTimestamp = 0;
@@ -301,7 +304,8 @@ bool LogParser::RegexLogLineParser(const char* buffer,
                                      logPath,
                                      error,
                                      logGroupSize,
-                                     tzOffsetSecond);
+                                     tzOffsetSecond,
+                                     timeFormatParser);
 #endif
 
         if (!exception.empty()) {
@@ -361,7 +365,8 @@ bool LogParser::RegexLogLineParser(const char* buffer,
                              region,
                              logPath,
                              error,
-                             tzOffsetSecond)) {
+                             tzOffsetSecond,
+                             timeFormatParser)) {
         parseSuccess = false;
         if (error == PARSE_LOG_HISTORY_ERROR)
             return false;
@@ -477,7 +482,8 @@ bool LogParser::ParseLogTime(const char* buffer,
                              const string& region,
                              const string& logPath,
                              ParseLogError& error,                                             
-                             int32_t tzOffsetSecond) {
+                             int32_t tzOffsetSecond,
+                             const TimeFormatParser* timeFormatParser) {
     if (IsPrefixString(curTimeStr, timeStr) == false) {
         struct tm tm;
         memset(&tm, 0, sizeof(tm));
@@ -486,32 +492,47 @@ bool LogParser::ParseLogTime(const char* buffer,
         // NOTE: This method can only work until 2286/11/21 1:46:39 (9999999999).
         bool keepTimeStr = (strcmp("%s", timeFormat) != 0);
         const char* strptimeResult = NULL;
-        if (keepTimeStr) {
-            strptimeResult = Strptime(curTimeStr.c_str(), timeFormat, &tm, specifiedYear);
-        } else {
-            strptimeResult = Strptime(curTimeStr.substr(0, 10).c_str(), timeFormat, &tm);
+        if (keepTimeStr && timeFormatParser != NULL) {
+            // The parsed part is kept as prefix if it has fixed width, so that logs of
+            // the same second skip parsing even if strftime formats it differently.
+            bool fixedWidth = false;
+            strptimeResult = timeFormatParser->Parse(curTimeStr.c_str(), logTime, fixedWidth);
+            if (strptimeResult != NULL) {
+                if (fixedWidth) {
+                    timeStr.assign(curTimeStr.c_str(), strptimeResult);
+                } else {
+                    timeStr = ConvertToTimeStamp(logTime, timeFormat);
+                }
+            }
         }
         if (NULL == strptimeResult) {
-            if (AppConfig::GetInstance()->IsLogParseAlarmValid()) {
-                if (LogtailAlarm::GetInstance()->IsLowLevelAlarmValid()) {
-                    LOG_WARNING(sLogger,
-                                ("parse time fail", curTimeStr)("project", projectName)("logstore", category)(
-                                    "file", logPath)("keep time str", keepTimeStr));
-                }
-                LogtailAlarm::GetInstance()->SendAlarm(PARSE_TIME_FAIL_ALARM,
-                                                       curTimeStr + " " + timeFormat
-                                                           + " flag: " + std::to_string(keepTimeStr),
-                                                       projectName,
-                                                       category,
-                                                       region);
+            if (keepTimeStr) {
+                strptimeResult = Strptime(curTimeStr.c_str(), timeFormat, &tm, specifiedYear);
+            } else {
+                strptimeResult = Strptime(curTimeStr.substr(0, 10).c_str(), timeFormat, &tm);
             }
+            if (NULL == strptimeResult) {
+                if (AppConfig::GetInstance()->IsLogParseAlarmValid()) {
+                    if (LogtailAlarm::GetInstance()->IsLowLevelAlarmValid()) {
+                        LOG_WARNING(sLogger,
+                                    ("parse time fail", curTimeStr)("project", projectName)("logstore", category)(
+                                        "file", logPath)("keep time str", keepTimeStr));
+                    }
+                    LogtailAlarm::GetInstance()->SendAlarm(PARSE_TIME_FAIL_ALARM,
+                                                           curTimeStr + " " + timeFormat
+                                                               + " flag: " + std::to_string(keepTimeStr),
+                                                           projectName,
+                                                           category,
+                                                           region);
+                }
 
-            error = PARSE_LOG_TIMEFORMAT_ERROR;
-            return false;
+                error = PARSE_LOG_TIMEFORMAT_ERROR;
+                return false;
+            }
+            tm.tm_isdst = -1;
+            logTime = mktime(&tm);
+            timeStr = ConvertToTimeStamp(logTime, timeFormat);
         }
-        tm.tm_isdst = -1;
-        logTime = mktime(&tm);
-        timeStr = ConvertToTimeStamp(logTime, timeFormat);
 
         if (preciseTimestampConfig.enabled) {
             preciseTimestamp = GetPreciseTimestamp(logTime, strptimeResult, preciseTimestampConfig, tzOffsetSecond);
@@ -766,6 +787,14 @@ void LogParser::AddLog(Log* logPtr, const string& key, const string& value, uint
     logGroupSize += key.size() + value.size() + 5;
 }
 
+void LogParser::AddLog(
+    Log* logPtr, const char* key, size_t keySize, const char* value, size_t valueSize, uint32_t& logGroupSize) {
+    Log_Content* logContentPtr = logPtr->add_contents();
+    logContentPtr->set_key(key, keySize);
+    logContentPtr->set_value(value, valueSize);
+    logGroupSize += keySize + valueSize + 5;
+}
+
 
 void LogParser::AdjustLogTime(sls_logs::Log* logPtr, int mLogTimeZoneOffsetSecond, int timeZoneOffsetSecond) {
     logPtr->set_time(logPtr->time() - mLogTimeZoneOffsetSecond + timeZoneOffsetSecond);
@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <boost/regex.hpp>
 #include <vector>
+#include "common/TimeFormatParser.h"
 #include "common/TimeUtil.h"
 #include "config_manager/ConfigManager.h"
 
@@ -72,8 +73,9 @@ public:
 
     // RegexLogLineParser parses @buffer according to @reg.
     // Log time parsing: use @timeIndex to decide which field should be considered
-    // as log time, and @timeFormat is used to parse it (strptime). @timeStr and
-    // @logTime is the parsed result in string and time_t format.
+    // as log time, and @timeFormat is used to parse it (strptime), or @timeFormatParser
+    // compiled from it if not NULL. @timeStr and @logTime is the parsed result in
+    // string and time_t format.
     static bool RegexLogLineParser(const char* buffer,
                                    const boost::regex& reg,
                                    sls_logs::LogGroup& logGroup,
@@ -91,7 +93,8 @@ public:
                                    const std::string& logPath,
                                    ParseLogError& error,
                                    uint32_t& logGroupSize,
-                                   int32_t mTzOffsetSecond);
+                                   int32_t mTzOffsetSecond,
+                                   const TimeFormatParser* timeFormatParser = NULL);
     // RegexLogLineParser with specified log time.
     static bool RegexLogLineParser(const char* buffer,
                                    const boost::regex& reg,
@@ -108,6 +111,13 @@ public:
 
     static void AddLog(sls_logs::Log* logPtr, const std::string& key, const std::string& value, uint32_t& logGroupSize);
 
+    static void AddLog(sls_logs::Log* logPtr,
+                       const char* key,
+                       size_t keySize,
+                       const char* value,
+                       size_t valueSize,
+                       uint32_t& logGroupSize);
+
     static int32_t GetApsaraLogMicroTime(const char* buffer);
 
     static bool IsPrefixString(const std::string& all, const std::string& prefix);
@@ -129,7 +139,8 @@ public:
                              const std::string& region,
                              const std::string& logPath,
                              ParseLogError& error,
-                             int32_t tzOffsetSecond);
+                             int32_t tzOffsetSecond,
+                             const TimeFormatParser* timeFormatParser = NULL);
 
     static void AdjustLogTime(sls_logs::Log* logPtr, int logTimeZoneOffsetSecond, int localTimeZoneOffsetSecond);
 
@@ -21,10 +21,14 @@
 #include <deque>
 #include <unordered_map>
 #include <ctime>
+#include <memory>
+#include "common/FileSystemUtil.h"
 #include "common/SplitedFilePath.h"
 
 namespace logtail {
 
+typedef std::shared_ptr<const std::vector<fsutil::Entry>> DirEntriesPtr;
+
 struct DirFileCache {
     DirFileCache() {}
     DirFileCache(bool configMatched) : mConfigMatched(configMatched) {}
@@ -44,6 +48,15 @@ struct DirFileCache {
     void SetLastEventTime(int32_t curTime) { mLastEventTime = curTime; }
     int32_t GetLastEventTime() const { return mLastEventTime; }
 
+    // Entries of the directory listed at @listTime, they can be reused while LMD of the
+    // directory is unchanged. Only used by directory cache.
+    void SetEntries(const DirEntriesPtr& entries, int32_t listTime) {
+        mEntries = entries;
+        mListTime = listTime;
+    }
+    const DirEntriesPtr& GetEntries() const { return mEntries; }
+    int32_t GetListTime() const { return mListTime; }
+
 private:
     // It indicates if the related file/dir has generated event.
     bool mEventFlag = false;
@@ -54,6 +67,9 @@ private:
     uint64_t mLastCheckRound = 0;
     // Last modified time on filesystem in nanoseconds.
     int64_t mLastModifyTime = 0;
+
+    DirEntriesPtr mEntries;
+    int32_t mListTime = 0;
 };
 
 typedef std::unordered_map<std::string, DirFileCache> DirCheckCacheMap;
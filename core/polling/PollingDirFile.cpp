@@ -56,6 +56,8 @@ DEFINE_FLAG_INT32(polling_max_stat_count, "max stat count in each round", 100000
 DEFINE_FLAG_INT32(polling_max_stat_count_per_dir, "max stat count per dir in each round", 100000);
 DEFINE_FLAG_INT32(polling_max_stat_count_per_config, "max stat count per config in each round", 100000);
 DEFINE_FLAG_INT32(polling_modify_repush_interval, "polling modify event repush interval, seconds", 10);
+DEFINE_FLAG_INT32(polling_stat_thread_count, "threads to stat files in parallel for each polling thread", 3);
+DEFINE_FLAG_BOOL(polling_skip_unchanged_dir, "reuse entries of directories whose modify time is unchanged", true);
 DECLARE_FLAG_INT32(wildcard_max_sub_dir_count);
 
 using namespace std;
@@ -66,6 +68,9 @@ static const int64_t NANO_CONVERTING = 1000000000;
 
 void PollingDirFile::Start() {
     ClearCache();
+    if (!mStatPool) {
+        mStatPool.reset(new PollingStatPool(std::max(INT32_FLAG(polling_stat_thread_count), 0)));
+    }
     mRuningFlag = true;
     mThreadPtr = CreateThread([this]() { Polling(); });
 }
@@ -108,6 +113,7 @@ void PollingDirFile::Polling() {
         LOG_DEBUG(sLogger, ("start dir file polling, mCurrentRound", mCurrentRound));
         {
             PTScopedLock thradLock(mPollingThreadLock);
+            uint64_t roundStartTime = GetCurrentTimeInMilliSeconds();
             mStatCount = 0;
             mNewFileVec.clear();
             ++mCurrentRound;
@@ -218,6 +224,9 @@ void PollingDirFile::Polling() {
                 ClearUnavailableFileAndDir();
             }
             ClearTimeoutFileAndDir();
+
+            mRoundLatency.Add(GetCurrentTimeInMilliSeconds() - roundStartTime);
+            LogtailMonitor::Instance()->UpdateMetric("polling_dir_round_latency", mRoundLatency.ToString());
         }
 
         // Sleep for a while, by default, 5s on Linux, 1s on Windows.
@@ -234,7 +243,8 @@ void PollingDirFile::Polling() {
 // NOTE: So, we can not find changes in subdirectories of the directory according to LMD.
 bool PollingDirFile::CheckAndUpdateDirMatchCache(const string& dirPath,
                                                  const fsutil::PathStat& statBuf,
-                                                 bool& newFlag) {
+                                                 bool& newFlag,
+                                                 DirEntriesPtr& entries) {
     int64_t sec, nsec;
     statBuf.GetLastWriteTime(sec, nsec);
     int64_t modifyTime = NANO_CONVERTING * sec + nsec;
@@ -261,10 +271,30 @@ bool PollingDirFile::CheckAndUpdateDirMatchCache(const string& dirPath,
     }
 
     // Already cached, update last round and modified time.
+    // Entries listed before are still valid if LMD is unchanged. They are not reused if they were
+    // listed in the same second as LMD, because LMD is in seconds on some filesystems. Directories
+    // are listed again regularly in case LMD is not updated as expected.
     newFlag = false;
-    iter->second.SetCheckRound(mCurrentRound);
-    iter->second.SetLastModifyTime(modifyTime);
-    return true; // iter->second.HasMatchedConfig().
+    auto& dirCache = iter->second;
+    if (dirCache.GetEntries()) {
+        if (dirCache.GetLastModifyTime() == modifyTime && dirCache.GetListTime() > sec + 1
+            && mCurrentRound % INT32_FLAG(check_not_exist_file_dir_round) != 0) {
+            entries = dirCache.GetEntries();
+        } else {
+            dirCache.SetEntries(DirEntriesPtr(), 0);
+        }
+    }
+    dirCache.SetCheckRound(mCurrentRound);
+    dirCache.SetLastModifyTime(modifyTime);
+    return true; // dirCache.HasMatchedConfig().
+}
+
+void PollingDirFile::UpdateDirEntries(const string& dirPath, const DirEntriesPtr& entries, int32_t listTime) {
+    ScopedSpinLock lock(mCacheLock);
+    auto iter = mDirCacheMap.find(dirPath);
+    if (iter != mDirCacheMap.end()) {
+        iter->second.SetEntries(entries, listTime);
+    }
 }
 
 bool PollingDirFile::CheckAndUpdateFileMatchCache(const string& fileDir,
@@ -329,110 +359,178 @@ bool PollingDirFile::PollingNormalConfigPath(
 
     string dirPath = obj.empty() ? srcPath : PathJoin(srcPath, obj);
     bool isNewDirectory = false;
-    if (!CheckAndUpdateDirMatchCache(dirPath, statBuf, isNewDirectory))
+    DirEntriesPtr cachedEntries;
+    if (!CheckAndUpdateDirMatchCache(dirPath, statBuf, isNewDirectory, cachedEntries))
         return true;
     if (isNewDirectory) {
         PollingEventQueue::GetInstance()->PushEvent(new Event(srcPath, obj, EVENT_CREATE | EVENT_ISDIR, -1, 0));
     }
 
-    // Iterate directories and files in dirPath.
+    // Iterate directories and files in dirPath, entries are read from cache if the directory
+    // has not been modified since last listing.
     fsutil::Dir dir(dirPath);
-    if (!dir.Open()) {
-        auto err = GetErrno();
-        if (fsutil::Dir::IsENOENT(err)) {
-            LOG_DEBUG(sLogger, ("Open dir error, ENOENT, dir", dirPath.c_str()));
-            return false;
-        } else {
-            LogtailAlarm::GetInstance()->SendAlarm(LOGDIR_PERMINSSION_ALARM,
-                                                   string("Failed to open dir : ") + dirPath
-                                                       + ";\terrno : " + ToString(err),
-                                                   pConfig->GetProjectName(),
-                                                   pConfig->GetCategory());
-            LOG_ERROR(sLogger, ("Open dir error", dirPath.c_str())("error", ErrnoToString(err)));
+    std::shared_ptr<std::vector<fsutil::Entry>> listedEntries;
+    int32_t listTime = 0;
+    if (!cachedEntries) {
+        listTime = static_cast<int32_t>(time(NULL));
+        if (!dir.Open()) {
+            auto err = GetErrno();
+            if (fsutil::Dir::IsENOENT(err)) {
+                LOG_DEBUG(sLogger, ("Open dir error, ENOENT, dir", dirPath.c_str()));
+                return false;
+            } else {
+                LogtailAlarm::GetInstance()->SendAlarm(LOGDIR_PERMINSSION_ALARM,
+                                                       string("Failed to open dir : ") + dirPath
+                                                           + ";\terrno : " + ToString(err),
+                                                       pConfig->GetProjectName(),
+                                                       pConfig->GetCategory());
+                LOG_ERROR(sLogger, ("Open dir error", dirPath.c_str())("error", ErrnoToString(err)));
+            }
+            return true;
         }
-        return true;
-    }
-    int32_t nowStatCount = 0;
-    fsutil::Entry ent;
-    while (ent = dir.ReadNext(false)) {
-        if (!mRuningFlag || mHoldOnFlag)
-            break;
-
-        if (++mStatCount % INT32_FLAG(dirfile_stat_count) == 0) {
-            usleep(INT32_FLAG(dirfile_stat_sleep) * 1000);
+        if (BOOL_FLAG(polling_skip_unchanged_dir)) {
+            listedEntries = std::make_shared<std::vector<fsutil::Entry>>();
         }
+    }
 
-        if (mStatCount > INT32_FLAG(polling_max_stat_count)) {
-            LOG_WARNING(sLogger,
-                        ("total dir's polling stat count is exceeded",
-                         nowStatCount)(dirPath, mStatCount)(pConfig->mProjectName, pConfig->mCategory));
-            LogtailAlarm::GetInstance()->SendAlarm(STAT_LIMIT_ALARM,
-                                                   string("total dir's polling stat count is exceeded, now count:")
-                                                       + ToString(nowStatCount) + " total count:" + ToString(mStatCount)
-                                                       + " path: " + dirPath + " project:" + pConfig->mProjectName
-                                                       + " logstore:" + pConfig->mCategory);
-            break;
-        }
+    const size_t batchSize = static_cast<size_t>(std::max(INT32_FLAG(dirfile_stat_count), 1));
+    size_t cachedIndex = 0;
+    bool listFinished = false;
+    bool stop = false;
+    int32_t nowStatCount = 0;
+    vector<PollingEntry> batchEntries;
+    vector<string> batchPaths;
+    while (!stop) {
+        // Collect entries matched by configs, and stat them in batch.
+        batchEntries.clear();
+        batchPaths.clear();
+        while (batchEntries.size() < batchSize) {
+            fsutil::Entry ent;
+            if (cachedEntries) {
+                if (cachedIndex < cachedEntries->size()) {
+                    ent = (*cachedEntries)[cachedIndex++];
+                }
+            } else {
+                ent = dir.ReadNext(false);
+                if (ent && listedEntries) {
+                    listedEntries->push_back(ent);
+                }
+            }
+            if (!ent) {
+                listFinished = true;
+                stop = true;
+                break;
+            }
+            if (!mRuningFlag || mHoldOnFlag) {
+                stop = true;
+                break;
+            }
 
-        if (++nowStatCount > INT32_FLAG(polling_max_stat_count_per_dir)) {
-            LOG_WARNING(sLogger,
-                        ("this dir's polling stat count is exceeded",
-                         nowStatCount)(dirPath, mStatCount)(pConfig->mProjectName, pConfig->mCategory));
-            LogtailAlarm::GetInstance()->SendAlarm(STAT_LIMIT_ALARM,
-                                                   string("this dir's polling stat count is exceeded, now count:")
-                                                       + ToString(nowStatCount) + " total count:" + ToString(mStatCount)
-                                                       + " path: " + dirPath + " project:" + pConfig->mProjectName
-                                                       + " logstore:" + pConfig->mCategory,
-                                                   pConfig->mRegion);
-            break;
-        }
+            if (++mStatCount % INT32_FLAG(dirfile_stat_count) == 0) {
+                usleep(INT32_FLAG(dirfile_stat_sleep) * 1000);
+            }
 
-        // If the type of item is raw directory or file, use MatchDirPattern or FindBestMatch
-        // to check if there are configs that match it.
-        auto entName = ent.Name();
-        string item = PathJoin(dirPath, entName);
-        bool needCheckDirMatch = true;
-        bool needFindBestMatch = true;
-        if (ent.IsDir()) {
-            // Have to call MatchDirPattern, because we have no idea which config matches
-            // the directory according to cache.
-            // TODO: Refactor directory cache, maintain all configs that match the directory.
-            needCheckDirMatch = false;
-            if (!ConfigManager::GetInstance()->MatchDirPattern(pConfig, item)) {
-                continue;
+            if (mStatCount > INT32_FLAG(polling_max_stat_count)) {
+                LOG_WARNING(sLogger,
+                            ("total dir's polling stat count is exceeded",
+                             nowStatCount)(dirPath, mStatCount)(pConfig->mProjectName, pConfig->mCategory));
+                LogtailAlarm::GetInstance()->SendAlarm(
+                    STAT_LIMIT_ALARM,
+                    string("total dir's polling stat count is exceeded, now count:") + ToString(nowStatCount)
+                        + " total count:" + ToString(mStatCount) + " path: " + dirPath
+                        + " project:" + pConfig->mProjectName + " logstore:" + pConfig->mCategory);
+                stop = true;
+                break;
             }
-        } else if (ent.IsRegFile()) {
-            // TODO: Add file cache looking up here: we can skip the file if it is in cache
-            // and the match flag is false (no config matches it).
-            // There is a cache in FindBestMatch, so the overhead is acceptable now.
-            needFindBestMatch = false;
-            if (ConfigManager::GetInstance()->FindBestMatch(dirPath, entName) == NULL) {
-                continue;
+
+            if (++nowStatCount > INT32_FLAG(polling_max_stat_count_per_dir)) {
+                LOG_WARNING(sLogger,
+                            ("this dir's polling stat count is exceeded",
+                             nowStatCount)(dirPath, mStatCount)(pConfig->mProjectName, pConfig->mCategory));
+                LogtailAlarm::GetInstance()->SendAlarm(
+                    STAT_LIMIT_ALARM,
+                    string("this dir's polling stat count is exceeded, now count:") + ToString(nowStatCount)
+                        + " total count:" + ToString(mStatCount) + " path: " + dirPath
+                        + " project:" + pConfig->mProjectName + " logstore:" + pConfig->mCategory,
+                    pConfig->mRegion);
+                stop = true;
+                break;
             }
-        } else {
-            // Symbolic link should be passed, while other types file should ignore.
-            if (!ent.IsSymbolic()) {
-                LOG_DEBUG(sLogger, ("should ignore, other type file", item.c_str()));
-                continue;
+
+            // If the type of item is raw directory or file, use MatchDirPattern or FindBestMatch
+            // to check if there are configs that match it.
+            auto entName = ent.Name();
+            string item = PathJoin(dirPath, entName);
+            bool needCheckDirMatch = true;
+            bool needFindBestMatch = true;
+            if (ent.IsDir()) {
+                // Have to call MatchDirPattern, because we have no idea which config matches
+                // the directory according to cache.
+                // TODO: Refactor directory cache, maintain all configs that match the directory.
+                needCheckDirMatch = false;
+                if (!ConfigManager::GetInstance()->MatchDirPattern(pConfig, item)) {
+                    continue;
+                }
+            } else if (ent.IsRegFile()) {
+                // TODO: Add file cache looking up here: we can skip the file if it is in cache
+                // and the match flag is false (no config matches it).
+                // There is a cache in FindBestMatch, so the overhead is acceptable now.
+                needFindBestMatch = false;
+                if (ConfigManager::GetInstance()->FindBestMatch(dirPath, entName) == NULL) {
+                    continue;
+                }
+            } else {
+                // Symbolic link should be passed, while other types file should ignore.
+                if (!ent.IsSymbolic()) {
+                    LOG_DEBUG(sLogger, ("should ignore, other type file", item.c_str()));
+                    continue;
+                }
             }
+            batchEntries.push_back(PollingEntry{entName, needCheckDirMatch, needFindBestMatch});
+            batchPaths.push_back(std::move(item));
         }
 
-        // Mainly for symbolic (Linux), we need to use stat to dig out the real type.
-        fsutil::PathStat buf;
-        if (!fsutil::PathStat::stat(item, buf)) {
-            LOG_DEBUG(sLogger, ("get file info error", item.c_str())("errno", errno));
+        PollingNormalEntries(pConfig, dirPath, batchEntries, batchPaths, depth);
+    }
+
+    // Only entries of a complete listing can be reused.
+    if (listedEntries && listFinished) {
+        UpdateDirEntries(dirPath, listedEntries, listTime);
+    }
+    return true;
+}
+
+void PollingDirFile::PollingNormalEntries(const Config* pConfig,
+                                          const string& dirPath,
+                                          const vector<PollingEntry>& entries,
+                                          const vector<string>& paths,
+                                          int depth) {
+    // Mainly for symbolic (Linux), we need to use stat to dig out the real type.
+    vector<PollingStatResult> statResults;
+    mStatPool->Stat(paths, statResults);
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!mRuningFlag || mHoldOnFlag)
+            break;
+
+        const string& entName = entries[i].mName;
+        const string& item = paths[i];
+        if (!statResults[i].mSuccess) {
+            LOG_DEBUG(sLogger, ("get file info error", item.c_str())("errno", statResults[i].mErrno));
             continue;
         }
+        const fsutil::PathStat& buf = statResults[i].mStat;
 
         // For directory, poll recursively; for file, update cache and add to mNewFileVec so that
         // it can be pushed to PollingModify at the end of polling.
         // If needCheckDirMatch or needFindBestMatch is true, that means the item is a symbolic link.
         // We should check file type again to make sure that the original file which linked by
         // a symbolic file is DIR or REG.
-        if (buf.IsDir() && (!needCheckDirMatch || ConfigManager::GetInstance()->MatchDirPattern(pConfig, item))) {
+        if (buf.IsDir()
+            && (!entries[i].mNeedCheckDirMatch || ConfigManager::GetInstance()->MatchDirPattern(pConfig, item))) {
             PollingNormalConfigPath(pConfig, dirPath, entName, buf, depth + 1);
         } else if (buf.IsRegFile()) {
-            if (CheckAndUpdateFileMatchCache(dirPath, entName, buf, needFindBestMatch)) {
+            if (CheckAndUpdateFileMatchCache(dirPath, entName, buf, entries[i].mNeedFindBestMatch)) {
                 LOG_DEBUG(sLogger, ("add to modify event", entName)("round", mCurrentRound));
                 mNewFileVec.push_back(SplitedFilePath(dirPath, entName));
             }
@@ -442,8 +540,6 @@ bool PollingDirFile::PollingNormalConfigPath(
             continue;
         }
     }
-
-    return true;
 }
 
 // PollingWildcardConfigPath will iterate mWildcardPaths one by one, and according to
@@ -512,65 +608,92 @@ bool PollingDirFile::PollingWildcardConfigPath(const Config* pConfig, const stri
         }
         return true;
     }
-    fsutil::Entry ent;
+    const size_t batchSize = static_cast<size_t>(std::max(INT32_FLAG(dirfile_stat_count), 1));
     int32_t dirCount = 0;
-    while (ent = dir.ReadNext(false)) {
-        if (!mRuningFlag || mHoldOnFlag)
-            break;
+    bool stop = false;
+    vector<string> batchNames;
+    vector<string> batchPaths;
+    vector<PollingStatResult> statResults;
+    while (!stop) {
+        // Collect entries and stat them in batch.
+        batchNames.clear();
+        batchPaths.clear();
+        while (batchNames.size() < batchSize) {
+            fsutil::Entry ent = dir.ReadNext(false);
+            if (!ent || !mRuningFlag || mHoldOnFlag) {
+                stop = true;
+                break;
+            }
 
-        if (dirCount >= INT32_FLAG(wildcard_max_sub_dir_count)) {
-            LOG_WARNING(
-                sLogger,
-                ("too many sub directoried for path", dirPath)("dirCount", dirCount)("basePath", pConfig->mBasePath));
-            break;
-        }
+            if (++mStatCount % INT32_FLAG(dirfile_stat_count) == 0)
+                usleep(INT32_FLAG(dirfile_stat_sleep) * 1000);
+
+            if (mStatCount > INT32_FLAG(polling_max_stat_count)) {
+                LOG_WARNING(sLogger,
+                            ("total dir's polling stat count is exceeded", "")(dirPath, mStatCount)(
+                                pConfig->mProjectName, pConfig->mCategory));
+                LogtailAlarm::GetInstance()->SendAlarm(
+                    STAT_LIMIT_ALARM,
+                    string("total dir's polling stat count is exceeded, total count:" + ToString(mStatCount)
+                           + " path: " + dirPath + " project:" + pConfig->mProjectName
+                           + " logstore:" + pConfig->mCategory));
+                stop = true;
+                break;
+            }
 
-        if (++mStatCount % INT32_FLAG(dirfile_stat_count) == 0)
-            usleep(INT32_FLAG(dirfile_stat_sleep) * 1000);
-
-        if (mStatCount > INT32_FLAG(polling_max_stat_count)) {
-            LOG_WARNING(sLogger,
-                        ("total dir's polling stat count is exceeded", "")(dirPath, mStatCount)(pConfig->mProjectName,
-                                                                                                pConfig->mCategory));
-            LogtailAlarm::GetInstance()->SendAlarm(
-                STAT_LIMIT_ALARM,
-                string("total dir's polling stat count is exceeded, total count:" + ToString(mStatCount) + " path: "
-                       + dirPath + " project:" + pConfig->mProjectName + " logstore:" + pConfig->mCategory));
-            break;
+            batchNames.push_back(ent.Name());
+            batchPaths.push_back(PathJoin(dirPath, batchNames.back()));
         }
+        mStatPool->Stat(batchPaths, statResults);
 
-        auto entName = ent.Name();
-        string item = PathJoin(dirPath, entName);
-        fsutil::PathStat buf;
-        if (!fsutil::PathStat::stat(item, buf)) {
-            LOG_WARNING(sLogger, ("get file info fail", item.c_str())("errno", GetErrno()));
-            continue;
-        }
-        if (buf.IsDir()) {
-            ++dirCount;
-
-            // Use the next part to match the entry name.
-            size_t dirIndex = 0;
-            if (!BOOL_FLAG(enable_root_path_collection)) {
-                // Handle special path /.
-                dirIndex = pConfig->mWildcardPaths[depth].size() + 1;
-                if (dirIndex == (size_t)2) {
-                    dirIndex = 1;
-                }
-            } else {
-                // A better logic, but only enabled when flag enable_root_path_collection
-                //   is set for backward compatibility.
-                dirIndex = pConfig->mWildcardPaths[depth].size();
-                if (PATH_SEPARATOR[0] == pConfig->mWildcardPaths[depth + 1][dirIndex]) {
-                    ++dirIndex;
-                }
+        for (size_t i = 0; i < batchNames.size(); ++i) {
+            if (!mRuningFlag || mHoldOnFlag) {
+                stop = true;
+                break;
+            }
+
+            if (dirCount >= INT32_FLAG(wildcard_max_sub_dir_count)) {
+                LOG_WARNING(sLogger,
+                            ("too many sub directoried for path", dirPath)("dirCount", dirCount)("basePath",
+                                                                                                pConfig->mBasePath));
+                stop = true;
+                break;
             }
-            if (fnmatch(&(pConfig->mWildcardPaths[depth + 1].at(dirIndex)), entName.c_str(), FNM_PATHNAME) == 0) {
-                if (finish) {
-                    hasMatchFlag = true;
-                    PollingNormalConfigPath(pConfig, item, string(), buf, 0);
+
+            const string& entName = batchNames[i];
+            const string& item = batchPaths[i];
+            if (!statResults[i].mSuccess) {
+                LOG_WARNING(sLogger, ("get file info fail", item.c_str())("errno", statResults[i].mErrno));
+                continue;
+            }
+            const fsutil::PathStat& buf = statResults[i].mStat;
+            if (buf.IsDir()) {
+                ++dirCount;
+
+                // Use the next part to match the entry name.
+                size_t dirIndex = 0;
+                if (!BOOL_FLAG(enable_root_path_collection)) {
+                    // Handle special path /.
+                    dirIndex = pConfig->mWildcardPaths[depth].size() + 1;
+                    if (dirIndex == (size_t)2) {
+                        dirIndex = 1;
+                    }
                 } else {
-                    hasMatchFlag |= PollingWildcardConfigPath(pConfig, item, depth + 1);
+                    // A better logic, but only enabled when flag enable_root_path_collection
+                    //   is set for backward compatibility.
+                    dirIndex = pConfig->mWildcardPaths[depth].size();
+                    if (PATH_SEPARATOR[0] == pConfig->mWildcardPaths[depth + 1][dirIndex]) {
+                        ++dirIndex;
+                    }
+                }
+                if (fnmatch(&(pConfig->mWildcardPaths[depth + 1].at(dirIndex)), entName.c_str(), FNM_PATHNAME)
+                    == 0) {
+                    if (finish) {
+                        hasMatchFlag = true;
+                        PollingNormalConfigPath(pConfig, item, string(), buf, 0);
+                    } else {
+                        hasMatchFlag |= PollingWildcardConfigPath(pConfig, item, depth + 1);
+                    }
                 }
             }
         }
@@ -16,17 +16,15 @@
 
 #pragma once
 #include <map>
+#include <memory>
 #include "common/LogRunnable.h"
 #include "common/Lock.h"
 #include "common/Thread.h"
 #include "PollingCache.h"
+#include "PollingStat.h"
 
 namespace logtail {
 
-namespace fsutil {
-    class PathStat;
-}
-
 class Config;
 
 class PollingDirFile : public LogRunnable {
@@ -78,6 +76,21 @@ private:
                                  const fsutil::PathStat& statBuf,
                                  int depth);
 
+    // PollingEntry is an entry of directory which matches the config and has to be stated.
+    struct PollingEntry {
+        std::string mName;
+        bool mNeedCheckDirMatch;
+        bool mNeedFindBestMatch;
+    };
+
+    // PollingNormalEntries stats @paths of @entries in @dirPath with the stat pool, then
+    // polls sub directories recursively and updates cache of files.
+    void PollingNormalEntries(const Config* config,
+                              const std::string& dirPath,
+                              const std::vector<PollingEntry>& entries,
+                              const std::vector<std::string>& paths,
+                              int depth);
+
     // PollingWildcardConfigPath polls config with wildcard base path recursively.
     // It will use PollingNormalConfigPath to poll if the path becomes normal.
     // @return true if at least one directory was found during polling.
@@ -89,9 +102,17 @@ private:
     // @dirPath: absolute path of the directory.
     // @statBuf: stat of the directory.
     // @newFlag: a boolean to indicate caller that it is a new directory, generate event for it.
+    // @entries: entries listed before, it is set only if the directory has not been modified
+    //   since then, so the caller can skip listing it.
     // @return a boolean to indicate should the directory be continued to poll.
     //   It will returns true always now (might change in future).
-    bool CheckAndUpdateDirMatchCache(const std::string& dirPath, const fsutil::PathStat& statBuf, bool& newFlag);
+    bool CheckAndUpdateDirMatchCache(const std::string& dirPath,
+                                     const fsutil::PathStat& statBuf,
+                                     bool& newFlag,
+                                     DirEntriesPtr& entries);
+
+    // UpdateDirEntries saves entries of a directory which is listed completely at @listTime.
+    void UpdateDirEntries(const std::string& dirPath, const DirEntriesPtr& entries, int32_t listTime);
 
     // CheckAndUpdateFileMatchCache updates file cache (add if not existing).
     // @fileDir+@fileName: absolute path of the file.
@@ -141,6 +162,10 @@ private:
     // The sequence number of current round, uint64_t is used to avoid overflow.
     uint64_t mCurrentRound;
 
+    // Entries of directories are stated in batches of dirfile_stat_count by the pool.
+    std::unique_ptr<PollingStatPool> mStatPool;
+    PollingLatencyHistogram mRoundLatency;
+
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class PollingUnittest;
 #endif
@@ -35,6 +35,7 @@ DEFINE_FLAG_INT32(modify_stat_count, "sleep when dir file stat count up to", 100
 DEFINE_FLAG_INT32(modify_stat_sleepMs, "sleep time when dir file stat up to 1000, ms", 10);
 DEFINE_FLAG_INT32(modify_cache_max, "max modify chache size, if exceed, delete 0.2 oldest", 100000);
 DEFINE_FLAG_INT32(modify_cache_make_space_interval, "second", 600);
+DECLARE_FLAG_INT32(polling_stat_thread_count);
 
 namespace logtail {
 
@@ -46,6 +47,9 @@ PollingModify::~PollingModify() {
 
 void PollingModify::Start() {
     ClearCache();
+    if (!mStatPool) {
+        mStatPool.reset(new PollingStatPool(std::max(INT32_FLAG(polling_stat_thread_count), 0)));
+    }
     mRuningFlag = true;
     mThreadPtr = CreateThread([this]() { Polling(); });
 }
@@ -230,50 +234,68 @@ void PollingModify::Polling() {
 
             vector<SplitedFilePath> deletedFileVec;
             vector<Event*> pollingEventVec;
-            int32_t statCount = 0;
             LogtailMonitor::Instance()->UpdateMetric("polling_modify_size", mModifyCacheMap.size());
-            for (auto iter = mModifyCacheMap.begin(); iter != mModifyCacheMap.end(); ++iter) {
-                if (!mRuningFlag || mHoldOnFlag)
-                    break;
-
-                const SplitedFilePath& filePath = iter->first;
-                ModifyCheckCache& modifyCache = iter->second;
-                fsutil::PathStat logFileStat;
-                if (!fsutil::PathStat::stat(PathJoin(filePath.mFileDir, filePath.mFileName), logFileStat)) {
-                    if (errno == ENOENT) {
-                        LOG_DEBUG(sLogger, ("file deleted", PathJoin(filePath.mFileDir, filePath.mFileName)));
-                        if (UpdateDeletedFile(filePath, modifyCache, pollingEventVec)) {
-                            deletedFileVec.push_back(filePath);
+            uint64_t roundStartTime = GetCurrentTimeInMilliSeconds();
+            const size_t batchSize = static_cast<size_t>(std::max(INT32_FLAG(modify_stat_count), 1));
+            vector<ModifyCheckCacheMap::iterator> batchIters;
+            vector<string> batchPaths;
+            vector<PollingStatResult> statResults;
+            auto iter = mModifyCacheMap.begin();
+            while (iter != mModifyCacheMap.end() && mRuningFlag && !mHoldOnFlag) {
+                batchIters.clear();
+                batchPaths.clear();
+                for (; iter != mModifyCacheMap.end() && batchIters.size() < batchSize; ++iter) {
+                    batchIters.push_back(iter);
+                    batchPaths.push_back(PathJoin(iter->first.mFileDir, iter->first.mFileName));
+                }
+                mStatPool->Stat(batchPaths, statResults);
+
+                for (size_t i = 0; i < batchIters.size(); ++i) {
+                    const SplitedFilePath& filePath = batchIters[i]->first;
+                    ModifyCheckCache& modifyCache = batchIters[i]->second;
+                    const PollingStatResult& statResult = statResults[i];
+                    if (!statResult.mSuccess) {
+                        if (statResult.mErrno == ENOENT) {
+                            LOG_DEBUG(sLogger, ("file deleted", batchPaths[i]));
+                            if (UpdateDeletedFile(filePath, modifyCache, pollingEventVec)) {
+                                deletedFileVec.push_back(filePath);
+                            }
+                        } else {
+                            LOG_DEBUG(sLogger, ("get file info error", batchPaths[i]));
                         }
                     } else {
-                        LOG_DEBUG(sLogger, ("get file info error", PathJoin(filePath.mFileDir, filePath.mFileName)));
+                        const fsutil::PathStat& logFileStat = statResult.mStat;
+                        int64_t sec, nsec;
+                        logFileStat.GetLastWriteTime(sec, nsec);
+                        timespec mtim{sec, nsec};
+                        auto devInode = logFileStat.GetDevInode();
+                        UpdateFile(filePath,
+                                   modifyCache,
+                                   devInode.dev,
+                                   devInode.inode,
+                                   logFileStat.GetFileSize(),
+                                   mtim,
+                                   pollingEventVec);
                     }
-                } else {
-                    int64_t sec, nsec;
-                    logFileStat.GetLastWriteTime(sec, nsec);
-                    timespec mtim{sec, nsec};
-                    auto devInode = logFileStat.GetDevInode();
-                    UpdateFile(filePath,
-                               modifyCache,
-                               devInode.dev,
-                               devInode.inode,
-                               logFileStat.GetFileSize(),
-                               mtim,
-                               pollingEventVec);
                 }
 
-                ++statCount;
-                if (statCount % INT32_FLAG(modify_stat_count) == 0) {
+                // Push events batch by batch, so that modifications found early in a long round
+                // can be processed without waiting for the end of the round.
+                if (pollingEventVec.size() > 0) {
+                    PollingEventQueue::GetInstance()->PushEvent(pollingEventVec);
+                    pollingEventVec.clear();
+                }
+                if (iter != mModifyCacheMap.end()) {
                     usleep(1000 * INT32_FLAG(modify_stat_sleepMs));
                 }
             }
 
-            if (pollingEventVec.size() > 0) {
-                PollingEventQueue::GetInstance()->PushEvent(pollingEventVec);
-            }
             for (size_t i = 0; i < deletedFileVec.size(); ++i) {
                 mModifyCacheMap.erase(deletedFileVec[i]);
             }
+
+            mRoundLatency.Add(GetCurrentTimeInMilliSeconds() - roundStartTime);
+            LogtailMonitor::Instance()->UpdateMetric("polling_modify_round_latency", mRoundLatency.ToString());
         }
 
         // Sleep for a while, by default, 1s.
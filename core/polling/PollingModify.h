@@ -16,8 +16,10 @@
 
 #pragma once
 #include "PollingCache.h"
+#include "PollingStat.h"
 #include <map>
 #include <deque>
+#include <memory>
 #include <vector>
 #include "common/Lock.h"
 #include "common/Thread.h"
@@ -108,6 +110,10 @@ private:
 
     ModifyCheckCacheMap mModifyCacheMap;
 
+    // Files in cache are stated in batches of modify_stat_count by the pool.
+    std::unique_ptr<PollingStatPool> mStatPool;
+    PollingLatencyHistogram mRoundLatency;
+
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class PollingUnittest;
     bool FindNewFile(const std::string& dir, const std::string& fileName);
@@ -0,0 +1,139 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PollingStat.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+namespace logtail {
+
+// Paths taken by a thread at a time, small enough to balance slow stats between threads.
+static const size_t kStatChunkSize = 8;
+
+static const int64_t kLatencyBucketBounds[] = {1, 10, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000, 60000};
+static const size_t kLatencyBucketBoundCount = sizeof(kLatencyBucketBounds) / sizeof(kLatencyBucketBounds[0]);
+
+PollingStatPool::PollingStatPool(size_t threadCount, int64_t parallelStatLatencyNs)
+    : mThreadCount(threadCount), mParallelStatLatencyNs(parallelStatLatencyNs) {
+    if (mThreadCount > 0) {
+        mThreadPool.reset(new ThreadPool(mThreadCount));
+        mThreadPool->Start();
+    }
+}
+
+PollingStatPool::~PollingStatPool() {
+    if (mThreadPool) {
+        mThreadPool->Stop();
+    }
+}
+
+void PollingStatPool::Stat(const std::vector<std::string>& paths, std::vector<PollingStatResult>& results) {
+    results.clear();
+    results.resize(paths.size());
+    if (paths.empty()) {
+        return;
+    }
+    mPaths = &paths;
+    mResults = &results;
+    mNextIndex = 0;
+
+    // Stat the first chunk to estimate latency of stat, and wake up workers only if the
+    // filesystem is slow and there are chunks left for them.
+    auto startTime = std::chrono::steady_clock::now();
+    size_t firstSize = StatChunk();
+    int64_t firstCost
+        = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    size_t workerCount = 0;
+    if (firstSize > 0 && firstCost / static_cast<int64_t>(firstSize) >= mParallelStatLatencyNs) {
+        size_t leftChunkCount = (paths.size() - firstSize + kStatChunkSize - 1) / kStatChunkSize;
+        workerCount = std::min(mThreadCount, leftChunkCount > 0 ? leftChunkCount - 1 : 0);
+    }
+    if (workerCount > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mActiveCount = workerCount;
+        }
+        for (size_t i = 0; i < workerCount; ++i) {
+            mThreadPool->Add([this]() {
+                while (StatChunk() > 0) {
+                }
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (--mActiveCount == 0) {
+                    mCond.notify_all();
+                }
+            });
+        }
+    }
+    while (StatChunk() > 0) {
+    }
+    if (workerCount > 0) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCond.wait(lock, [this]() { return mActiveCount == 0; });
+    }
+    mPaths = NULL;
+    mResults = NULL;
+}
+
+size_t PollingStatPool::StatChunk() {
+    const size_t size = mPaths->size();
+    size_t begin = mNextIndex.fetch_add(kStatChunkSize);
+    if (begin >= size) {
+        return 0;
+    }
+    size_t end = std::min(begin + kStatChunkSize, size);
+    for (size_t i = begin; i < end; ++i) {
+        PollingStatResult& result = (*mResults)[i];
+        result.mSuccess = fsutil::PathStat::stat((*mPaths)[i], result.mStat);
+        if (!result.mSuccess) {
+            result.mErrno = errno;
+        }
+    }
+    return end - begin;
+}
+
+PollingLatencyHistogram::PollingLatencyHistogram() : mBuckets(kLatencyBucketBoundCount + 1, 0) {
+}
+
+int64_t PollingLatencyHistogram::GetBucketBound(size_t i) {
+    return i < kLatencyBucketBoundCount ? kLatencyBucketBounds[i] : INT64_MAX;
+}
+
+void PollingLatencyHistogram::Add(int64_t latencyMs) {
+    size_t i = std::lower_bound(kLatencyBucketBounds, kLatencyBucketBounds + kLatencyBucketBoundCount, latencyMs)
+        - kLatencyBucketBounds;
+    ++mBuckets[i];
+    ++mCount;
+}
+
+std::string PollingLatencyHistogram::ToString() const {
+    std::string result;
+    for (size_t i = 0; i < mBuckets.size(); ++i) {
+        if (mBuckets[i] == 0) {
+            continue;
+        }
+        if (!result.empty()) {
+            result.append(",");
+        }
+        if (i < kLatencyBucketBoundCount) {
+            result.append("<=" + std::to_string(kLatencyBucketBounds[i]) + "ms:");
+        } else {
+            result.append(">" + std::to_string(kLatencyBucketBounds[i - 1]) + "ms:");
+        }
+        result.append(std::to_string(mBuckets[i]));
+    }
+    return result;
+}
+
+} // namespace logtail
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/FileSystemUtil.h"
+#include "common/ThreadPool.h"
+
+namespace logtail {
+
+struct PollingStatResult {
+    bool mSuccess = false;
+    // errno of the failed stat, it is thread local so it is saved by the stating thread.
+    int mErrno = 0;
+    fsutil::PathStat mStat;
+};
+
+// PollingStatPool stats a batch of paths with a small pool of worker threads, so that
+//  polling rounds are not serialized on the latency of stat on overlay or NFS filesystems.
+// The calling thread takes part in stating, so a pool of 0 threads stats serially, and
+//  workers are only used when stat is slow.
+// Stat can only be called by one thread at a time, each polling thread owns its pool.
+class PollingStatPool {
+public:
+    // Workers are woken up only if stat is slower than @parallelStatLatencyNs, otherwise waking
+    //  them costs more than stating serially, such as local filesystems with warm dentry cache.
+    explicit PollingStatPool(size_t threadCount, int64_t parallelStatLatencyNs = 10000);
+    ~PollingStatPool();
+
+    size_t GetThreadCount() const { return mThreadCount; }
+
+    // Stat stats all @paths and returns when all of them are done, @results are in the
+    //  same order as @paths.
+    void Stat(const std::vector<std::string>& paths, std::vector<PollingStatResult>& results);
+
+private:
+    PollingStatPool(const PollingStatPool&) = delete;
+    PollingStatPool& operator=(const PollingStatPool&) = delete;
+
+    // StatChunk stats next chunk of current batch, returns the count of stated paths.
+    size_t StatChunk();
+
+    size_t mThreadCount;
+    int64_t mParallelStatLatencyNs;
+    std::unique_ptr<ThreadPool> mThreadPool;
+
+    // Current batch, set by Stat and read by workers.
+    const std::vector<std::string>* mPaths = NULL;
+    std::vector<PollingStatResult>* mResults = NULL;
+    std::atomic<size_t> mNextIndex{0};
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    // Count of workers which are stating current batch.
+    size_t mActiveCount = 0;
+};
+
+// PollingLatencyHistogram counts latencies of polling rounds in fixed buckets.
+class PollingLatencyHistogram {
+public:
+    PollingLatencyHistogram();
+
+    void Add(int64_t latencyMs);
+    uint64_t GetCount() const { return mCount; }
+    // Bucket @i counts latencies not greater than GetBucketBound(@i), the last bucket
+    //  counts all larger ones.
+    size_t GetBucketCount() const { return mBuckets.size(); }
+    static int64_t GetBucketBound(size_t i);
+    uint64_t GetBucket(size_t i) const { return mBuckets[i]; }
+
+    // ToString formats non-empty buckets, such as "<=100ms:3,<=200ms:1,>10000ms:1".
+    std::string ToString() const;
+
+private:
+    std::vector<uint64_t> mBuckets;
+    uint64_t mCount = 0;
+};
+
+} // namespace logtail
@@ -37,6 +37,9 @@ public:
 public:
     virtual bool Match(const sls_logs::Log& log, const LogGroupContext& context) { return true; }
 
+    // MayMatchRawLine returns false only if the log parsed from raw @line is sure not to match.
+    virtual bool MayMatchRawLine(const char* line) { return true; }
+
 public:
     FilterNodeType GetNodeType() const { return nodeType; }
 
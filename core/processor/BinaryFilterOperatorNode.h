@@ -40,6 +40,17 @@ public:
         return false;
     }
 
+    virtual bool MayMatchRawLine(const char* line) {
+        if (BOOST_LIKELY(left && right)) {
+            if (op == AND_OPERATOR) {
+                return left->MayMatchRawLine(line) && right->MayMatchRawLine(line);
+            } else if (op == OR_OPERATOR) {
+                return left->MayMatchRawLine(line) || right->MayMatchRawLine(line);
+            }
+        }
+        return false;
+    }
+
 private:
     FilterOperator op;
     BaseFilterNodePtr left;
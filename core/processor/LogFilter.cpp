@@ -13,10 +13,13 @@
 // limitations under the License.
 
 #include "LogFilter.h"
+#include <algorithm>
+#include <cstring>
 #include <re2/re2.h>
 #include "profiler/LogtailAlarm.h"
 #include "app_config/AppConfig.h"
 #include "common/util.h"
+#include "common/Constants.h"
 #include "sdk/Common.h"
 #include "logger/Logger.h"
 #include "config_manager/ConfigManager.h"
@@ -59,6 +62,7 @@ bool LogFilter::InitFilter(const string& configName) {
             for (uint32_t i = 0; i < keys.size(); i++) {
                 filterRule->FilterKeys.push_back(keys[i].asString());
                 filterRule->FilterRegs.push_back(boost::regex(regs[i].asString()));
+                filterRule->RawLineSearchable.push_back(IsRawLineSearchable(keys[i].asString(), regs[i].asString()));
             }
             mFilters[projectName + "_" + category] = filterRule;
         }
@@ -148,7 +152,7 @@ LogFilter::Filter(const sls_logs::LogGroup& logGroup, BaseFilterNodePtr node, co
 
 bool LogFilter::IsMatched(const Log& log, const LogFilterRule& rule, const LogGroupContext& context) {
     const std::vector<std::string>& keys = rule.FilterKeys;
-    const std::vector<boost::regex> regs = rule.FilterRegs;
+    const std::vector<boost::regex>& regs = rule.FilterRegs;
     string exception;
     for (uint32_t i = 0; i < keys.size(); i++) {
         bool found = false;
@@ -179,6 +183,89 @@ bool LogFilter::IsMatched(const Log& log, const LogFilterRule& rule, const LogGr
     return true;
 }
 
+bool LogFilter::IsRawLineSearchable(const std::string& key, const std::string& regStr) {
+    // Values of these keys are not from the raw line.
+    if (key == LOG_RESERVED_KEY_FILE_OFFSET) {
+        return false;
+    }
+    bool inBracket = false;
+    for (size_t i = 0; i < regStr.size(); ++i) {
+        const char c = regStr[i];
+        if (c == '\\') {
+            if (++i == regStr.size()) {
+                return false;
+            }
+            if (!inBracket && strchr("bBAzZG<>`'", regStr[i]) != NULL) {
+                return false;
+            }
+            continue;
+        }
+        if (inBracket) {
+            if (c == ']') {
+                inBracket = false;
+            }
+            continue;
+        }
+        switch (c) {
+            case '[':
+                inBracket = true;
+                // ']' right after '[' or '[^' is a literal.
+                if (i + 1 < regStr.size() && regStr[i + 1] == '^') {
+                    ++i;
+                }
+                if (i + 1 < regStr.size() && regStr[i + 1] == ']') {
+                    ++i;
+                }
+                break;
+            case '^':
+            case '$':
+                return false;
+            case '(':
+                // Lookarounds and named groups.
+                if (i + 2 < regStr.size() && regStr[i + 1] == '?' && strchr("=!<", regStr[i + 2]) != NULL) {
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+bool LogFilter::MayMatchRawLine(const char* line, const LogFilterRule& rule) {
+    boost::match_results<const char*> what;
+    for (size_t i = 0; i < rule.FilterRegs.size() && i < rule.RawLineSearchable.size(); ++i) {
+        if (!rule.RawLineSearchable[i]) {
+            continue;
+        }
+        // Keep the line if the search fails with exception, the filter will report it after parsing.
+        string exception;
+        if (!BoostRegexSearch(line, rule.FilterRegs[i], exception, what) && exception.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogFilter::MayMatchRawLine(const Config* config, const char* line) {
+    if (config->mAdvancedConfig.mFilterExpressionRoot.get() != NULL) {
+        return config->mAdvancedConfig.mFilterExpressionRoot->MayMatchRawLine(line);
+    }
+    if (config->mFilterRule) {
+        return MayMatchRawLine(line, *config->mFilterRule);
+    }
+    if (mFilters.empty()) {
+        return true;
+    }
+    std::unordered_map<std::string, LogFilterRule*>::iterator it
+        = mFilters.find(config->mProjectName + "_" + config->mCategory);
+    if (it == mFilters.end()) {
+        return true;
+    }
+    return MayMatchRawLine(line, *(it->second));
+}
+
 void LogFilter::CastSensitiveWords(sls_logs::LogGroup& logGroup, const Config* pConfig) {
     if (pConfig->mSensitiveWordCastOptions.empty() || logGroup.logs_size() == 0) {
         return;
@@ -194,6 +281,39 @@ void LogFilter::CastSensitiveWords(sls_logs::LogGroup& logGroup, const Config* p
     }
 }
 
+std::shared_ptr<re2::RE2::Set>
+LogFilter::CompileSensitiveWordCastSet(const std::vector<SensitiveWordCastOption>& options) {
+    std::shared_ptr<re2::RE2::Set> regexSet(new re2::RE2::Set(RE2::DefaultOptions, RE2::UNANCHORED));
+    for (size_t i = 0; i < options.size(); ++i) {
+        // Invalid regexes are skipped when casting, a placeholder keeps indexes aligned.
+        const std::string& pattern
+            = (options[i].mRegex && options[i].mRegex->ok()) ? options[i].mRegex->pattern() : std::string("$^");
+        string error;
+        if (regexSet->Add(pattern, &error) != (int)i) {
+            LOG_WARNING(sLogger, ("add sensitive regex to set fail", error)("regex", pattern));
+            return std::shared_ptr<re2::RE2::Set>();
+        }
+    }
+    if (!regexSet->Compile()) {
+        LOG_WARNING(sLogger, ("compile sensitive regex set fail", "cast with each regex"));
+        return std::shared_ptr<re2::RE2::Set>();
+    }
+    return regexSet;
+}
+
+bool LogFilter::MatchSensitiveWordCastSet(const re2::RE2::Set& regexSet,
+                                          const std::string& value,
+                                          std::vector<int>& matchedOptions) {
+    matchedOptions.clear();
+    re2::RE2::Set::ErrorInfo errorInfo;
+    if (!regexSet.Match(value, &matchedOptions, &errorInfo) && errorInfo.kind != re2::RE2::Set::kNoError) {
+        // DFA out of memory, try every option.
+        return false;
+    }
+    std::sort(matchedOptions.begin(), matchedOptions.end());
+    return true;
+}
+
 void LogFilter::CastOneSensitiveWord(sls_logs::Log_Content* pContent, const Config* pConfig) {
     const string& key = pContent->key();
     std::unordered_map<std::string, std::vector<SensitiveWordCastOption> >::const_iterator findRst
@@ -203,11 +323,27 @@ void LogFilter::CastOneSensitiveWord(sls_logs::Log_Content* pContent, const Conf
     }
     const std::vector<SensitiveWordCastOption>& optionVec = findRst->second;
     string* pVal = pContent->mutable_value();
+    // Find matched options in one pass if they are compiled into a set, options not matched are
+    // skipped since they would not replace anything. Matching is redone after each replacement.
+    const re2::RE2::Set* regexSet = NULL;
+    std::vector<int> matchedOptions;
+    std::unordered_map<std::string, std::shared_ptr<re2::RE2::Set> >::const_iterator setIter
+        = pConfig->mSensitiveWordCastSets.find(key);
+    if (setIter != pConfig->mSensitiveWordCastSets.end()
+        && MatchSensitiveWordCastSet(*(setIter->second), *pVal, matchedOptions)) {
+        if (matchedOptions.empty()) {
+            return;
+        }
+        regexSet = setIter->second.get();
+    }
     for (size_t i = 0; i < optionVec.size(); ++i) {
         const SensitiveWordCastOption& opt = optionVec[i];
         if (!opt.mRegex || !opt.mRegex->ok()) {
             continue;
         }
+        if (regexSet != NULL && !std::binary_search(matchedOptions.begin(), matchedOptions.end(), (int)i)) {
+            continue;
+        }
         bool rst = false;
 
         if (opt.option == SensitiveWordCastOption::CONST_OPTION) {
@@ -259,6 +395,11 @@ void LogFilter::CastOneSensitiveWord(sls_logs::Log_Content* pContent, const Conf
             }
         }
 
+        if (rst && regexSet != NULL && i + 1 < optionVec.size()
+            && !MatchSensitiveWordCastSet(*regexSet, *pVal, matchedOptions)) {
+            regexSet = NULL;
+        }
+
         // if (!rst)
         //{
         //     LOG_WARNING(sLogger, ("cast sensitive word fail", opt.constValue)(pConfig->mProjectName,
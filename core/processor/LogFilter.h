@@ -17,6 +17,7 @@
 #pragma once
 #include <unordered_map>
 #include <boost/regex.hpp>
+#include <re2/set.h>
 #include <vector>
 #include <string>
 #include "log_pb/sls_logs.pb.h"
@@ -25,10 +26,13 @@
 namespace logtail {
 
 class Config;
+struct SensitiveWordCastOption;
 
 struct LogFilterRule {
     std::vector<std::string> FilterKeys;
     std::vector<boost::regex> FilterRegs;
+    // RawLineSearchable[i] is true if FilterRegs[i] can be searched on raw lines, see IsRawLineSearchable.
+    std::vector<bool> RawLineSearchable;
 };
 
 class LogFilter {
@@ -36,8 +40,12 @@ private:
     std::unordered_map<std::string, LogFilterRule*> mFilters;
 
     bool IsMatched(const sls_logs::Log& log, const LogFilterRule& rule, const LogGroupContext& context);
+    static bool MayMatchRawLine(const char* line, const LogFilterRule& rule);
 
     static void CastOneSensitiveWord(sls_logs::Log_Content* pContent, const Config* pConfig);
+    static bool MatchSensitiveWordCastSet(const re2::RE2::Set& regexSet,
+                                          const std::string& value,
+                                          std::vector<int>& matchedOptions);
     LogFilter() {}
 
     ~LogFilter() {
@@ -67,6 +75,21 @@ public:
 
     static void CastSensitiveWords(sls_logs::LogGroup& logGroup, const Config* pConfig);
 
+    // CompileSensitiveWordCastSet compiles regexes of @options into one set, the index of each regex in
+    // the set is its index in @options. Returns NULL if any regex can not be added.
+    static std::shared_ptr<re2::RE2::Set>
+    CompileSensitiveWordCastSet(const std::vector<SensitiveWordCastOption>& options);
+
+    // IsRawLineSearchable returns true if any value of @key fully matching @regStr leaves a substring
+    // matching @regStr in the raw line, so raw lines without such substring can be discarded before
+    // parsing. Anchors, word boundaries and lookarounds depend on the context of the value, patterns
+    // with them are not searchable.
+    static bool IsRawLineSearchable(const std::string& key, const std::string& regStr);
+
+    // MayMatchRawLine returns false if the log parsed from @line is sure to be discarded by filters
+    // of @config. It is only valid for logs whose values are substrings of raw lines (regex logs).
+    bool MayMatchRawLine(const Config* config, const char* line);
+
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class LogFilterUnittest;
 #endif
@@ -24,6 +24,7 @@
 #include "common/TimeUtil.h"
 #include "common/LogtailCommonFlags.h"
 #include "common/LogGroupContext.h"
+#include "common/ReadBufferPool.h"
 #include "plugin/LogtailPlugin.h"
 #include "reader/LogFileReader.h"
 #include "monitor/Monitor.h"
@@ -41,6 +42,7 @@
 #include "logger/Logger.h"
 #include "aggregator/Aggregator.h"
 #include "fuse/FuseFileBlacklist.h"
+#include "processor/LogFilter.h"
 #include "common/LogFileCollectOffsetIndicator.h"
 
 
@@ -58,6 +60,7 @@ DEFINE_FLAG_BOOL(enable_chinese_tag_path, "Enable Chinese __tag__.__path__", tru
 #endif
 DEFINE_FLAG_STRING(raw_log_tag, "", "__raw__");
 DEFINE_FLAG_INT32(default_flush_merged_buffer_interval, "default flush merged buffer, seconds", 1);
+DEFINE_FLAG_BOOL(enable_filter_pushdown, "discard lines of regex logs by filters before parsing", true);
 
 namespace logtail {
 
@@ -243,6 +246,11 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                 sMonitor->UpdateMetric("eo_process_queue_full", eoInvalidCount);
                 sMonitor->UpdateMetric("eo_process_queue_total", eoTotalCount);
             }
+
+            static auto sReadBufferPool = ReadBufferPool::GetInstance();
+            sMonitor->UpdateMetric("read_buffer_pool_free", sReadBufferPool->GetFreeBlockCount());
+            sMonitor->UpdateMetric("read_buffer_pool_hit", sReadBufferPool->GetHitCount());
+            sMonitor->UpdateMetric("read_buffer_pool_miss", sReadBufferPool->GetMissCount());
         }
 
         if (threadNo == 0) {
@@ -289,7 +297,6 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                 LOG_INFO(sLogger,
                          ("can not find config while processing log, maybe config update",
                           logPath)(logFileReader->GetProjectName(), logFileReader->GetCategory()));
-                delete[] logBuffer->buffer;
                 delete logBuffer;
                 continue;
             }
@@ -341,7 +348,6 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                                                                   passingTags);
                 }
 
-                delete[] logBuffer->buffer;
                 delete logBuffer;
                 continue;
             }
@@ -365,6 +371,7 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
             uint64_t parseTimeFailures = 0;
             uint64_t historyFailures = 0;
             uint64_t sendFailures = 0;
+            uint64_t filterEarlyDrops = 0;
             string errorLine;
             //////////////////////////////////////////////
 
@@ -402,7 +409,17 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                 uint32_t logGroupSize = 0;
                 int32_t successLogSize = 0;
                 int32_t parseStartTime = (int32_t)time(NULL);
+                // Values of regex logs are substrings of the line, filters can be searched on the line
+                // to discard it before parsing. Precise timestamp is a value computed by parsing, and
+                // exactly once needs positions of all parsed logs.
+                static LogFilter* filterPtr = LogFilter::Instance();
+                const bool filterRawLine = BOOL_FLAG(enable_filter_pushdown) && config->mLogType == REGEX_LOG
+                    && !config->mAdvancedConfig.mEnablePreciseTimestamp && !logBuffer->exactlyOnceCheckpoint;
                 for (uint32_t i = 0; i < lines; i++) {
+                    if (filterRawLine && !filterPtr->MayMatchRawLine(config, buffer + logIndex[i])) {
+                        ++filterEarlyDrops;
+                        continue;
+                    }
                     if (!logFileReader->ParseLogLine(
                             buffer + logIndex[i], logGroup, error, lastLogLineTime, lastLogTimeStr, logGroupSize)) {
                         ++parseFailures;
@@ -550,6 +567,7 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                                             logFileReader->GetFuseMode(),
                                             logFileReader->GetMarkOffsetFlag(),
                                             logBuffer->exactlyOnceCheckpoint);
+                    context.mRoutingKeyCache = logFileReader->GetRoutingKeyCache();
                     if (!Sender::Instance()->Send(projectName,
                                                   logFileReader->GetSourceId(),
                                                   logGroup,
@@ -571,11 +589,8 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                 }
             }
 
-            LogFileProfiler::GetInstance()->AddProfilingData(config->mConfigName,
-                                                             config->mRegion,
-                                                             projectName,
-                                                             category,
-                                                             logPath,
+            ProfilingHandle profilingHandle = logFileReader->GetProfilingHandle();
+            LogFileProfiler::GetInstance()->AddProfilingData(profilingHandle,
                                                              readBytes,
                                                              skipBytes,
                                                              splitLines,
@@ -585,13 +600,15 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                                                              historyFailures,
                                                              sendFailures,
                                                              errorLine);
+            if (filterEarlyDrops > 0) {
+                LogFileProfiler::GetInstance()->AddProfilingFilterDrops(profilingHandle, filterEarlyDrops, 0);
+            }
             LOG_DEBUG(sLogger,
                       ("project", projectName)("logstore", category)("filename", logPath)("read_bytes", readBytes)(
                           "line_feed", lineFeed)("split_lines", splitLines)("parse_failures", parseFailures)(
                           "parse_time_failures", parseTimeFailures)("regex_match_failures", regexMatchFailures)(
                           "history_failures", historyFailures));
 
-            delete[] logBuffer->buffer;
             delete logBuffer;
         }
     }
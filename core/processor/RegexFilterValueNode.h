@@ -19,6 +19,7 @@
 
 #include <boost/regex.hpp>
 #include "BaseFilterNode.h"
+#include "LogFilter.h"
 #include "common/util.h"
 #include "app_config/AppConfig.h"
 #include "profiler/LogtailAlarm.h"
@@ -29,7 +30,10 @@ namespace logtail {
 class RegexFilterValueNode : public BaseFilterNode {
 public:
     RegexFilterValueNode(const std::string& key, const std::string& exp)
-        : BaseFilterNode(VALUE_NODE), key(key), reg(exp) {}
+        : BaseFilterNode(VALUE_NODE),
+          key(key),
+          reg(exp),
+          rawLineSearchable(LogFilter::IsRawLineSearchable(key, exp)) {}
 
     virtual ~RegexFilterValueNode() {}
 
@@ -54,9 +58,19 @@ public:
         return false;
     }
 
+    virtual bool MayMatchRawLine(const char* line) {
+        if (!rawLineSearchable) {
+            return true;
+        }
+        std::string exception;
+        boost::match_results<const char*> what;
+        return BoostRegexSearch(line, reg, exception, what) || !exception.empty();
+    }
+
 private:
     std::string key;
     boost::regex reg;
+    bool rawLineSearchable;
 };
 
 } // namespace logtail
@@ -39,6 +39,66 @@ string LogFileProfiler::mOsDetail;
 string LogFileProfiler::mUsername;
 int32_t LogFileProfiler::mSystemBootTime = -1;
 
+ProfilingCounter::ProfilingCounter() {
+    for (size_t i = 0; i < kShardCount; ++i) {
+        mShards[i].store(NULL, std::memory_order_relaxed);
+    }
+    mFileDev.store(0, std::memory_order_relaxed);
+    mFileInode.store(0, std::memory_order_relaxed);
+    mFileSize.store(0, std::memory_order_relaxed);
+    mReadOffset.store(0, std::memory_order_relaxed);
+    mLastReadTime.store(0, std::memory_order_relaxed);
+    mHasErrorLine.store(false, std::memory_order_relaxed);
+}
+
+ProfilingCounter::~ProfilingCounter() {
+    for (size_t i = 0; i < kShardCount; ++i) {
+        delete mShards[i].load(std::memory_order_relaxed);
+    }
+}
+
+ProfilingCounter::Shard* ProfilingCounter::AllocateShard(std::atomic<Shard*>& slot) {
+    Shard* shard = new Shard;
+    for (size_t field = 0; field < FIELD_COUNT; ++field) {
+        shard->mValues[field].store(0, std::memory_order_relaxed);
+    }
+    // Another thread of the same shard index may have allocated it.
+    Shard* expected = NULL;
+    if (!slot.compare_exchange_strong(expected, shard, std::memory_order_acq_rel)) {
+        delete shard;
+        return expected;
+    }
+    return shard;
+}
+
+size_t ProfilingCounter::GetShardIndex() {
+    static std::atomic<size_t> sNextIndex(0);
+    static thread_local size_t sIndex = sNextIndex.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+    return sIndex;
+}
+
+void ProfilingCounter::SetReadInfo(
+    uint64_t dev, uint64_t inode, uint64_t fileSize, uint64_t readOffset, int32_t lastReadTime) {
+    mFileDev.store(dev, std::memory_order_relaxed);
+    mFileInode.store(inode, std::memory_order_relaxed);
+    mFileSize.store(fileSize, std::memory_order_relaxed);
+    mReadOffset.store(readOffset, std::memory_order_relaxed);
+    mLastReadTime.store(lastReadTime, std::memory_order_relaxed);
+    Add(READ_COUNT, 1);
+    Add(READ_DELAY_SUM, fileSize > readOffset ? fileSize - readOffset : 0);
+}
+
+void ProfilingCounter::SetErrorLine(const std::string& errorLine) {
+    if (errorLine.empty() || mHasErrorLine.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mErrorLineLock);
+    if (mErrorLine.empty()) {
+        mErrorLine = errorLine;
+        mHasErrorLine.store(true, std::memory_order_relaxed);
+    }
+}
+
 LogFileProfiler::LogFileProfiler() {
     srand(time(NULL));
     mSendInterval = INT32_FLAG(profile_data_send_interval);
@@ -107,6 +167,12 @@ bool LogFileProfiler::GetProfileData(LogGroup& logGroup, LogStoreStatistic* stat
     contentPtr->set_key("time_format_failures");
     contentPtr->set_value(ToString(statistic->mParseTimeFailures));
     contentPtr = logPtr->add_contents();
+    contentPtr->set_key("filter_early_drop_lines");
+    contentPtr->set_value(ToString(statistic->mFilterEarlyDrops));
+    contentPtr = logPtr->add_contents();
+    contentPtr->set_key("filter_late_drop_lines");
+    contentPtr->set_value(ToString(statistic->mFilterLateDrops));
+    contentPtr = logPtr->add_contents();
     contentPtr->set_key("file_dev");
     contentPtr->set_value(ToString(statistic->mFileDev));
     contentPtr = logPtr->add_contents();
@@ -219,8 +285,13 @@ void LogFileProfiler::SendProfileData(bool forceSend) {
             if (statisticsMap.size() > (size_t)0) {
                 std::unordered_map<string, LogStoreStatistic*>::iterator iter = statisticsMap.begin();
                 for (; iter != statisticsMap.end();) {
+                    if (DrainCounter(iter->second)) {
+                        iter->second->mLastUpdateTime = curTime;
+                    }
                     GetProfileData(logGroup, iter->second);
-                    if ((curTime - iter->second->mLastUpdateTime) > mSendInterval * 3) {
+                    // Statistics with counters held by readers are kept.
+                    if ((curTime - iter->second->mLastUpdateTime) > mSendInterval * 3
+                        && (!iter->second->mCounter || iter->second->mCounter.use_count() == 1)) {
                         delete iter->second;
                         iter = statisticsMap.erase(iter);
                     } else {
@@ -325,6 +396,33 @@ void LogFileProfiler::AddProfilingSkipBytes(const std::string& configName,
     }
 }
 
+void LogFileProfiler::AddProfilingFilterDrops(const std::string& configName,
+                                              const std::string& region,
+                                              const std::string& projectName,
+                                              const std::string& category,
+                                              const std::string& filename,
+                                              uint64_t earlyDrops,
+                                              uint64_t lateDrops) {
+    if (filename.size() > (size_t)0) {
+        // logstore statistics
+        AddProfilingFilterDrops(configName, region, projectName, category, "", earlyDrops, lateDrops);
+    }
+    string key = projectName + "_" + category + "_" + filename;
+    std::lock_guard<std::mutex> lock(mStatisticLock);
+    LogstoreSenderStatisticsMap& statisticsMap = *MakesureRegionStatisticsMapUnlocked(region);
+    std::unordered_map<string, LogStoreStatistic*>::iterator iter = statisticsMap.find(key);
+    if (iter != statisticsMap.end()) {
+        (iter->second)->mFilterEarlyDrops += earlyDrops;
+        (iter->second)->mFilterLateDrops += lateDrops;
+        (iter->second)->mLastUpdateTime = time(NULL);
+    } else {
+        LogStoreStatistic* statistic = new LogStoreStatistic(configName, projectName, category, filename);
+        statistic->mFilterEarlyDrops += earlyDrops;
+        statistic->mFilterLateDrops += lateDrops;
+        statisticsMap.insert(std::pair<string, LogStoreStatistic*>(key, statistic));
+    }
+}
+
 void LogFileProfiler::AddProfilingReadBytes(const std::string& configName,
                                             const std::string& region,
                                             const std::string& projectName,
@@ -353,6 +451,131 @@ void LogFileProfiler::AddProfilingReadBytes(const std::string& configName,
     }
 }
 
+ProfilingHandle LogFileProfiler::GetProfilingHandle(const std::string& configName,
+                                                    const std::string& region,
+                                                    const std::string& projectName,
+                                                    const std::string& category,
+                                                    const std::string& filename) {
+    ProfilingHandle handle;
+    std::lock_guard<std::mutex> lock(mStatisticLock);
+    LogstoreSenderStatisticsMap& statisticsMap = *MakesureRegionStatisticsMapUnlocked(region);
+    handle.mFileCounter = GetCounterUnlocked(statisticsMap, configName, projectName, category, filename);
+    handle.mLogstoreCounter = GetCounterUnlocked(statisticsMap, configName, projectName, category, "");
+    return handle;
+}
+
+void LogFileProfiler::AddProfilingData(const ProfilingHandle& handle,
+                                       uint64_t readBytes,
+                                       uint64_t skipBytes,
+                                       uint64_t splitLines,
+                                       uint64_t parseFailures,
+                                       uint64_t regexMatchFailures,
+                                       uint64_t parseTimeFailures,
+                                       uint64_t historyFailures,
+                                       uint64_t sendFailures,
+                                       const std::string& errorLine) {
+    ProfilingCounter* counters[] = {handle.mFileCounter.get(), handle.mLogstoreCounter.get()};
+    for (ProfilingCounter* counter : counters) {
+        counter->Add(ProfilingCounter::READ_BYTES, readBytes);
+        counter->Add(ProfilingCounter::SKIP_BYTES, skipBytes);
+        counter->Add(ProfilingCounter::SPLIT_LINES, splitLines);
+        counter->Add(ProfilingCounter::PARSE_FAILURES, parseFailures);
+        counter->Add(ProfilingCounter::REGEX_MATCH_FAILURES, regexMatchFailures);
+        counter->Add(ProfilingCounter::PARSE_TIME_FAILURES, parseTimeFailures);
+        counter->Add(ProfilingCounter::HISTORY_FAILURES, historyFailures);
+        counter->Add(ProfilingCounter::SEND_FAILURES, sendFailures);
+    }
+    // Only file statistics have error line.
+    handle.mFileCounter->SetErrorLine(errorLine);
+}
+
+void LogFileProfiler::AddProfilingFilterDrops(const ProfilingHandle& handle, uint64_t earlyDrops, uint64_t lateDrops) {
+    ProfilingCounter* counters[] = {handle.mFileCounter.get(), handle.mLogstoreCounter.get()};
+    for (ProfilingCounter* counter : counters) {
+        counter->Add(ProfilingCounter::FILTER_EARLY_DROPS, earlyDrops);
+        counter->Add(ProfilingCounter::FILTER_LATE_DROPS, lateDrops);
+    }
+}
+
+void LogFileProfiler::AddProfilingReadBytes(const ProfilingHandle& handle,
+                                            uint64_t dev,
+                                            uint64_t inode,
+                                            uint64_t fileSize,
+                                            uint64_t readOffset,
+                                            int32_t lastReadTime) {
+    handle.mFileCounter->SetReadInfo(dev, inode, fileSize, readOffset, lastReadTime);
+    handle.mLogstoreCounter->SetReadInfo(dev, inode, fileSize, readOffset, lastReadTime);
+}
+
+std::shared_ptr<ProfilingCounter> LogFileProfiler::GetCounterUnlocked(LogstoreSenderStatisticsMap& statisticsMap,
+                                                                      const std::string& configName,
+                                                                      const std::string& projectName,
+                                                                      const std::string& category,
+                                                                      const std::string& filename) {
+    string key = projectName + "_" + category + "_" + filename;
+    std::unordered_map<string, LogStoreStatistic*>::iterator iter = statisticsMap.find(key);
+    LogStoreStatistic* statistic = NULL;
+    if (iter != statisticsMap.end()) {
+        statistic = iter->second;
+    } else {
+        statistic = new LogStoreStatistic(configName, projectName, category, filename);
+        statisticsMap.insert(std::pair<string, LogStoreStatistic*>(key, statistic));
+    }
+    if (!statistic->mCounter) {
+        statistic->mCounter = std::make_shared<ProfilingCounter>();
+    }
+    return statistic->mCounter;
+}
+
+bool LogFileProfiler::DrainCounter(LogStoreStatistic* statistic) {
+    ProfilingCounter* counter = statistic->mCounter.get();
+    if (counter == NULL) {
+        return false;
+    }
+    uint64_t values[ProfilingCounter::FIELD_COUNT] = {0};
+    for (size_t i = 0; i < ProfilingCounter::kShardCount; ++i) {
+        ProfilingCounter::Shard* shard = counter->mShards[i].load(std::memory_order_acquire);
+        if (shard == NULL) {
+            continue;
+        }
+        for (size_t field = 0; field < ProfilingCounter::FIELD_COUNT; ++field) {
+            values[field] += shard->mValues[field].exchange(0, std::memory_order_relaxed);
+        }
+    }
+    bool updated = false;
+    for (size_t field = 0; field < ProfilingCounter::FIELD_COUNT; ++field) {
+        updated = updated || values[field] > 0;
+    }
+    statistic->mReadBytes += values[ProfilingCounter::READ_BYTES];
+    statistic->mSkipBytes += values[ProfilingCounter::SKIP_BYTES];
+    statistic->mSplitLines += values[ProfilingCounter::SPLIT_LINES];
+    statistic->mParseFailures += values[ProfilingCounter::PARSE_FAILURES];
+    statistic->mRegexMatchFailures += values[ProfilingCounter::REGEX_MATCH_FAILURES];
+    statistic->mParseTimeFailures += values[ProfilingCounter::PARSE_TIME_FAILURES];
+    statistic->mHistoryFailures += values[ProfilingCounter::HISTORY_FAILURES];
+    statistic->mSendFailures += values[ProfilingCounter::SEND_FAILURES];
+    statistic->mFilterEarlyDrops += values[ProfilingCounter::FILTER_EARLY_DROPS];
+    statistic->mFilterLateDrops += values[ProfilingCounter::FILTER_LATE_DROPS];
+    if (values[ProfilingCounter::READ_COUNT] > 0) {
+        statistic->mFileDev = counter->mFileDev.load(std::memory_order_relaxed);
+        statistic->mFileInode = counter->mFileInode.load(std::memory_order_relaxed);
+        statistic->mFileSize = counter->mFileSize.load(std::memory_order_relaxed);
+        statistic->mReadOffset = counter->mReadOffset.load(std::memory_order_relaxed);
+        statistic->mLastReadTime = counter->mLastReadTime.load(std::memory_order_relaxed);
+        statistic->mReadCount += values[ProfilingCounter::READ_COUNT];
+        statistic->mReadDelaySum += values[ProfilingCounter::READ_DELAY_SUM];
+    }
+    if (counter->mHasErrorLine.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(counter->mErrorLineLock);
+        if (statistic->mErrorLine.empty()) {
+            statistic->mErrorLine.swap(counter->mErrorLine);
+        }
+        counter->mErrorLine.clear();
+        counter->mHasErrorLine.store(false, std::memory_order_relaxed);
+    }
+    return updated;
+}
+
 void LogFileProfiler::DumpToLocal(int32_t curTime, bool forceSend, Json::Value& detail, Json::Value& logstore) {
     Json::Value root;
     root["version"] = ILOGTAIL_VERSION;
@@ -470,8 +693,8 @@ uint64_t LogFileProfiler::GetProfilingLines(const std::string& projectName,
     std::unordered_map<std::string, LogStoreStatistic*>::iterator iter = statisticMap.find(key);
     if (iter == statisticMap.end())
         return 0;
-    else
-        return (iter->second->mSplitLines - iter->second->mParseFailures);
+    DrainCounter(iter->second);
+    return (iter->second->mSplitLines - iter->second->mParseFailures);
 }
 
 void LogFileProfiler::CleanEnviroments() {
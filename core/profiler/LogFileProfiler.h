@@ -16,6 +16,8 @@
 
 #pragma once
 #include <stdint.h>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <mutex>
 #include <unordered_map>
@@ -32,6 +34,86 @@ namespace logtail {
 class Config;
 struct LoggroupTimeValue;
 
+// ProfilingCounter counts profiling data of a file (or a logstore) without lock. Counters are
+//  sharded by thread, so processing threads adding to the same logstore do not contend on a cache
+//  line. They are drained into statistics by LogFileProfiler::SendProfileData.
+// A shard is allocated at the first add from its threads, a file is usually read and processed by
+//  a few threads, so counters of idle files are small.
+class ProfilingCounter {
+public:
+    enum Field {
+        READ_BYTES,
+        SKIP_BYTES,
+        SPLIT_LINES,
+        PARSE_FAILURES,
+        REGEX_MATCH_FAILURES,
+        PARSE_TIME_FAILURES,
+        HISTORY_FAILURES,
+        SEND_FAILURES,
+        FILTER_EARLY_DROPS,
+        FILTER_LATE_DROPS,
+        READ_COUNT,
+        READ_DELAY_SUM,
+        FIELD_COUNT
+    };
+
+    ProfilingCounter();
+    ~ProfilingCounter();
+
+    void Add(Field field, uint64_t value) {
+        if (value > 0) {
+            std::atomic<Shard*>& slot = mShards[GetShardIndex()];
+            Shard* shard = slot.load(std::memory_order_acquire);
+            if (shard == NULL) {
+                shard = AllocateShard(slot);
+            }
+            shard->mValues[field].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    // SetReadInfo keeps info of the last read, ++READ_COUNT and adds the unread bytes to READ_DELAY_SUM.
+    void SetReadInfo(uint64_t dev, uint64_t inode, uint64_t fileSize, uint64_t readOffset, int32_t lastReadTime);
+
+    // SetErrorLine keeps the first error line since last drain.
+    void SetErrorLine(const std::string& errorLine);
+
+private:
+    static const size_t kShardCount = 8;
+
+    // Padding is used instead of alignas, heap allocation is not over-aligned before C++17.
+    //  Values of two shards are at least 64 bytes apart.
+    struct Shard {
+        std::atomic<uint64_t> mValues[FIELD_COUNT];
+        char mPad[64];
+    };
+
+    static size_t GetShardIndex();
+    // AllocateShard sets @slot to a new shard if it is still NULL, returns the shard in @slot.
+    static Shard* AllocateShard(std::atomic<Shard*>& slot);
+
+    std::atomic<Shard*> mShards[kShardCount];
+    std::atomic<uint64_t> mFileDev;
+    std::atomic<uint64_t> mFileInode;
+    std::atomic<uint64_t> mFileSize;
+    std::atomic<uint64_t> mReadOffset;
+    std::atomic<int32_t> mLastReadTime;
+    std::atomic<bool> mHasErrorLine;
+    std::mutex mErrorLineLock;
+    std::string mErrorLine;
+
+    friend class LogFileProfiler;
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class LogFileProfilerUnittest;
+#endif
+};
+
+// ProfilingHandle is kept by a reader, to add profiling data of its file and logstore without
+//  building keys or taking the statistic lock.
+struct ProfilingHandle {
+    std::shared_ptr<ProfilingCounter> mFileCounter;
+    std::shared_ptr<ProfilingCounter> mLogstoreCounter;
+};
+
 // Collect the log file's profile such as lines processed.
 class LogFileProfiler {
 public:
@@ -61,6 +143,16 @@ public:
                                const std::string& filename,
                                uint64_t skipBytes);
 
+    // AddProfilingFilterDrops counts lines discarded by filters, @earlyDrops before parsing and
+    // @lateDrops after parsing.
+    void AddProfilingFilterDrops(const std::string& configName,
+                                 const std::string& region,
+                                 const std::string& projectName,
+                                 const std::string& category,
+                                 const std::string& filename,
+                                 uint64_t earlyDrops,
+                                 uint64_t lateDrops);
+
     void AddProfilingReadBytes(const std::string& configName,
                                const std::string& region,
                                const std::string& projectName,
@@ -72,6 +164,33 @@ public:
                                uint64_t readOffset,
                                int32_t lastReadTime);
 
+    // GetProfilingHandle returns counters of the file and its logstore, which are reported together
+    //  with data added by the methods above. @filename should not be empty.
+    ProfilingHandle GetProfilingHandle(const std::string& configName,
+                                       const std::string& region,
+                                       const std::string& projectName,
+                                       const std::string& category,
+                                       const std::string& filename);
+
+    // Same as the methods above, but for the file of @handle, the hot path is a few atomic adds.
+    void AddProfilingData(const ProfilingHandle& handle,
+                          uint64_t readBytes,
+                          uint64_t skipBytes,
+                          uint64_t splitLines,
+                          uint64_t parseFailures,
+                          uint64_t regexMatchFailures,
+                          uint64_t parseTimeFailures,
+                          uint64_t historyFailures,
+                          uint64_t sendFailures,
+                          const std::string& errorLine);
+    void AddProfilingFilterDrops(const ProfilingHandle& handle, uint64_t earlyDrops, uint64_t lateDrops);
+    void AddProfilingReadBytes(const ProfilingHandle& handle,
+                               uint64_t dev,
+                               uint64_t inode,
+                               uint64_t fileSize,
+                               uint64_t readOffset,
+                               int32_t lastReadTime);
+
     void SendProfileData(bool forceSend = false);
 
     void SetProfileInterval(int32_t interval) { mSendInterval = interval; }
@@ -120,6 +239,8 @@ private:
             mLastReadTime = 0;
             mReadCount = 0;
             mReadDelaySum = 0;
+            mFilterEarlyDrops = 0;
+            mFilterLateDrops = 0;
         }
 
         void Reset() {
@@ -138,6 +259,8 @@ private:
             mParseTimeFailures = 0;
             mHistoryFailures = 0;
             mSendFailures = 0;
+            mFilterEarlyDrops = 0;
+            mFilterLateDrops = 0;
             mErrorLine.clear();
         }
 
@@ -175,6 +298,10 @@ private:
         uint64_t mHistoryFailures;
         // how many lines send fails
         uint64_t mSendFailures;
+        // how many lines discarded by filters before parsing
+        uint64_t mFilterEarlyDrops;
+        // how many lines discarded by filters after parsing
+        uint64_t mFilterLateDrops;
         // one sample error line
         std::string mErrorLine;
         int32_t mLastUpdateTime;
@@ -189,6 +316,8 @@ private:
         // mReadDelaySum += mFileSize - mReadOffset every call
         // then average delay is mReadDelaySum / mReadCount
         uint64_t mReadDelaySum;
+        // Counters added by holders of ProfilingHandle, drained into the fields above when sending.
+        std::shared_ptr<ProfilingCounter> mCounter;
     };
 
     std::string mDumpFileName;
@@ -209,10 +338,18 @@ private:
     bool GetProfileData(sls_logs::LogGroup& logGroup, LogStoreStatistic* statistic);
 
     LogstoreSenderStatisticsMap* MakesureRegionStatisticsMapUnlocked(const std::string& region);
+    std::shared_ptr<ProfilingCounter> GetCounterUnlocked(LogstoreSenderStatisticsMap& statisticsMap,
+                                                         const std::string& configName,
+                                                         const std::string& projectName,
+                                                         const std::string& category,
+                                                         const std::string& filename);
+    // DrainCounter adds values of statistic's counter to it, returns true if there is any.
+    bool DrainCounter(LogStoreStatistic* statistic);
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class EventDispatcherTest;
     friend class SenderUnittest;
+    friend class LogFileProfilerUnittest;
 
     uint64_t
     GetProfilingLines(const std::string& projectName, const std::string& category, const std::string& filename);
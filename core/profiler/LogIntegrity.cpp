@@ -796,13 +796,12 @@ void LogIntegrity::FillLogTimeInfo(LogIntegrityInfo* info, const std::string& na
 }
 
 std::string LogIntegrity::GetLastLogLine(MergeItem* item) {
-    const LogGroup& logGroup = item->mLogGroup;
-    if (logGroup.logs_size() < 1) {
-        LOG_ERROR(sLogger, ("invalid log group, size", logGroup.logs_size()));
+    Log lastLogLine;
+    if (!item->GetLastLog(lastLogLine)) {
+        LOG_ERROR(sLogger, ("invalid log group, size", item->mLines));
         return "";
     }
 
-    const Log& lastLogLine = logGroup.logs(logGroup.logs_size() - 1);
     if (lastLogLine.contents_size() != 1) {
         LOG_ERROR(sLogger, ("invalid log group, content size", lastLogLine.contents_size()));
         return "";
@@ -55,6 +55,7 @@ DelimiterLogFileReader::DelimiterLogFileReader(const std::string& projectName,
                     dockerFileFlag) {
     mLogType = DELIMITER_LOG;
     mTimeFormat = timeFormat;
+    mTimeFormatParser = TimeFormatParser::Compile(mTimeFormat);
     mSeparator = separator;
     if (!separator.empty())
         mSeparatorChar = mSeparator.data()[0];
@@ -183,7 +184,8 @@ bool DelimiterLogFileReader::ParseLogLine(const char* buffer,
                                              mRegion,
                                              mLogPath,
                                              error,
-                                             mTzOffsetSecond)) {
+                                             mTzOffsetSecond,
+                                             mTimeFormatParser.get())) {
                     parseSuccess = false;
                     if (error == PARSE_LOG_HISTORY_ERROR)
                         return false;
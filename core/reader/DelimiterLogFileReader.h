@@ -69,6 +69,8 @@ protected:
     bool mAutoExtend;
     bool mAcceptNoEnoughKeys;
     std::string mTimeFormat;
+    // Compiled mTimeFormat, NULL if it is not supported.
+    std::shared_ptr<TimeFormatParser> mTimeFormatParser;
     uint32_t mTimeIndex;
     std::vector<std::string> mColumnKeys;
     bool mExtractPartialFields;
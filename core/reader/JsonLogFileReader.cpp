@@ -16,6 +16,7 @@
 #include <ctime>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include "common/JsonObjectScanner.h"
 #include "profiler/LogtailAlarm.h"
 #include "parser/LogParser.h"
 #include "log_pb/sls_logs.pb.h"
@@ -48,6 +49,7 @@ JsonLogFileReader::JsonLogFileReader(const std::string& projectName,
                     dockerFileFlag) {
     mLogType = JSON_LOG;
     mTimeFormat = timeFormat;
+    mTimeFormatParser = TimeFormatParser::Compile(mTimeFormat);
     mTimeKey.clear();
     mUseSystemTime = true;
 }
@@ -66,6 +68,8 @@ bool JsonLogFileReader::ParseLogLine(const char* buffer,
                                      time_t& lastLogLineTime,
                                      std::string& lastLogTimeStr,
                                      uint32_t& logGroupSize) {
+    if (mFastParse)
+        return ParseLogLineFast(buffer, logGroup, error, lastLogLineTime, lastLogTimeStr, logGroupSize);
     if (strlen(buffer) == 0)
         return true;
 
@@ -118,7 +122,8 @@ bool JsonLogFileReader::ParseLogLine(const char* buffer,
                                          mRegion,
                                          mLogPath,
                                          error,
-                                         mTzOffsetSecond)) {
+                                         mTzOffsetSecond,
+                                         mTimeFormatParser.get())) {
                 parseSuccess = false;
                 if (error == PARSE_LOG_HISTORY_ERROR)
                     return false;
@@ -160,6 +165,91 @@ bool JsonLogFileReader::ParseLogLine(const char* buffer,
     return false;
 }
 
+bool JsonLogFileReader::ParseLogLineFast(const char* buffer,
+                                         sls_logs::LogGroup& logGroup,
+                                         ParseLogError& error,
+                                         time_t& lastLogLineTime,
+                                         std::string& lastLogTimeStr,
+                                         uint32_t& logGroupSize) {
+    if (buffer[0] == '\0')
+        return true;
+
+    if (logGroup.logs_size() == 0) {
+        logGroup.set_category(mCategory);
+        logGroup.set_topic(mTopicName);
+    }
+    // Processor threads may parse lines of the same reader.
+    static thread_local JsonObjectScanner sScanner;
+    bool parseSuccess = true;
+    uint64_t preciseTimestamp = 0;
+    if (!sScanner.Scan(buffer)) {
+        if (LogtailAlarm::GetInstance()->IsLowLevelAlarmValid()) {
+            LOG_WARNING(sLogger,
+                        ("parse json log fail, log", buffer)("offset", sScanner.ErrorOffset())(
+                            "error", sScanner.Error())("project", mProjectName)("logstore", mCategory)("file", mLogPath));
+            LogtailAlarm::GetInstance()->SendAlarm(
+                PARSE_LOG_FAIL_ALARM, string("parse json fail:") + string(buffer), mProjectName, mCategory, mRegion);
+        }
+        error = PARSE_LOG_FORMAT_ERROR;
+        parseSuccess = false;
+    } else if (!mUseSystemTime) {
+        const JsonMember* timeMember = sScanner.FindMember(mTimeKey);
+        if (timeMember != NULL
+            && (timeMember->type == JSON_VALUE_STRING || JsonObjectScanner::IsInteger(*timeMember))) {
+            if (!LogParser::ParseLogTime(buffer,
+                                         lastLogTimeStr,
+                                         lastLogLineTime,
+                                         preciseTimestamp,
+                                         timeMember->value.as_string(),
+                                         mTimeFormat.c_str(),
+                                         mPreciseTimestampConfig,
+                                         mSpecifiedYear,
+                                         mProjectName,
+                                         mCategory,
+                                         mRegion,
+                                         mLogPath,
+                                         error,
+                                         mTzOffsetSecond,
+                                         mTimeFormatParser.get())) {
+                parseSuccess = false;
+                if (error == PARSE_LOG_HISTORY_ERROR)
+                    return false;
+            }
+        } else {
+            if (LogtailAlarm::GetInstance()->IsLowLevelAlarmValid()) {
+                LOG_WARNING(sLogger,
+                            ("parse json log fail, log", buffer)("invalid time key", mTimeKey)("project", mProjectName)(
+                                "logstore", mCategory)("file", mLogPath));
+                LogtailAlarm::GetInstance()->SendAlarm(PARSE_LOG_FAIL_ALARM,
+                                                       string("found no time_key: ") + mTimeKey
+                                                           + ", log:" + string(buffer),
+                                                       mProjectName,
+                                                       mCategory,
+                                                       mRegion);
+            }
+            error = PARSE_LOG_FORMAT_ERROR;
+            parseSuccess = false;
+        }
+    }
+
+    if (parseSuccess) {
+        Log* logPtr = logGroup.add_logs();
+        logPtr->set_time(mUseSystemTime ? time(NULL) : lastLogLineTime);
+        for (const JsonMember& member : sScanner.Members()) {
+            LogParser::AddLog(
+                logPtr, member.key.data(), member.key.size(), member.value.data(), member.value.size(), logGroupSize);
+        }
+        if (!mUseSystemTime && mPreciseTimestampConfig.enabled) {
+            LogParser::AddLog(logPtr, mPreciseTimestampConfig.key, std::to_string(preciseTimestamp), logGroupSize);
+        }
+        return true;
+    } else if (!mDiscardUnmatch) {
+        LogParser::AddUnmatchLog(buffer, logGroup, logGroupSize);
+        return true;
+    }
+    return false;
+}
+
 std::string JsonLogFileReader::RapidjsonValueToString(const rapidjson::Value& value) {
     if (value.IsString())
         return value.GetString();
@@ -38,6 +38,11 @@ public:
                       bool dockerFileFlag = false);
 
     void SetTimeKey(const std::string& timeKey);
+
+    // SetFastParse selects JsonObjectScanner to parse lines. Different from rapidjson, numbers are
+    // kept as they are written, and objects and arrays are copied raw instead of re-stringified.
+    void SetFastParse(bool fastParse) { mFastParse = fastParse; }
+
     std::vector<int32_t> LogSplit(char* buffer, int32_t size, int32_t& lineFeed);
 
 protected:
@@ -51,12 +56,21 @@ protected:
     int32_t LastMatchedLine(char* buffer, int32_t size, int32_t& rollbackLineFeedCount);
 
 private:
+    bool ParseLogLineFast(const char* buffer,
+                          sls_logs::LogGroup& logGroup,
+                          ParseLogError& error,
+                          time_t& lastLogLineTime,
+                          std::string& lastLogTimeStr,
+                          uint32_t& logGroupSize);
     bool FindJsonMatch(char* buffer, int32_t beginIdx, int32_t size, int32_t& endIdx, bool& startWithBlock);
     std::string RapidjsonValueToString(const rapidjson::Value& value);
 
     std::string mTimeKey;
     std::string mTimeFormat;
+    // Compiled mTimeFormat, NULL if it is not supported.
+    std::shared_ptr<TimeFormatParser> mTimeFormatParser;
     bool mUseSystemTime;
+    bool mFastParse = false;
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class LogFileReaderUnittest;
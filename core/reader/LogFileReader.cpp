@@ -31,6 +31,7 @@
 #include "common/FileSystemUtil.h"
 #include "common/RandomUtil.h"
 #include "common/Constants.h"
+#include "common/LineFeedScanner.h"
 #include "sdk/Common.h"
 #include "logger/Logger.h"
 #include "checkpoint/CheckPointManager.h"
@@ -59,6 +60,15 @@ DEFINE_FLAG_INT32(skip_first_modify_time, "second ", 5 * 60);
 DEFINE_FLAG_INT32(max_reader_open_files, "max fd count that reader can open max", 100000);
 DEFINE_FLAG_INT32(truncate_pos_skip_bytes, "skip more xx bytes when truncate", 0);
 DEFINE_FLAG_INT32(max_fix_pos_bytes, "", 128 * 1024);
+DEFINE_FLAG_INT32(reader_carry_over_max_bytes,
+                  "max bytes of the unconsumed tail kept by a reader for next read, 0 to read it again",
+                  512 * 1024);
+DEFINE_FLAG_INT64(reader_read_ahead_max_bytes,
+                  "max bytes of buffers held by read ahead of all readers, read ahead is skipped if exceeded",
+                  64 * 1024 * 1024);
+#if defined(_MSC_VER)
+DECLARE_FLAG_BOOL(enable_chinese_tag_path);
+#endif
 
 namespace logtail {
 
@@ -66,6 +76,7 @@ namespace logtail {
     ("log path", mLogPath)("real path", mRealLogPath)("config", mConfigName)("inode", mDevInode.inode)
 
 size_t LogFileReader::BUFFER_SIZE = 1024 * 512; // 512KB
+std::atomic<int64_t> LogFileReader::sReadAheadBytes{0};
 
 void LogFileReader::DumpMetaToMem(bool checkConfigFlag) {
     if (checkConfigFlag) {
@@ -922,7 +933,7 @@ bool LogFileReader::ReadLog(LogBuffer*& logBuffer) {
         }
     }
 
-    char* buffer = NULL;
+    ReadBufferPtr buffer;
     size_t size = 0;
     FileInfo* fileInfo = NULL;
     TruncateInfo* truncateInfo = NULL;
@@ -944,11 +955,7 @@ bool LogFileReader::ReadLog(LogBuffer*& logBuffer) {
         }
     } else {
         // if size == 0 and pointers below is not NULL(memory allocated in GetRawData),
-        // then we should delete pointers in case of memory leak
-        if (buffer != NULL) {
-            delete[] buffer;
-        }
-
+        // then we should delete pointers in case of memory leak, buffer is released by its handle.
         if (fileInfo != NULL) {
             delete fileInfo;
         }
@@ -1090,6 +1097,12 @@ bool LogFileReader::CloseTimeoutFilePtr(int32_t curTime) {
 }
 
 void LogFileReader::CloseFilePtr() {
+    releaseReadAhead();
+    clearCarryOver();
+    {
+        std::lock_guard<std::mutex> lock(mProfilingHandleLock);
+        mProfilingHandle = ProfilingHandle();
+    }
     if (mLogFileOp.IsOpen()) {
         LOG_DEBUG(sLogger, ("start close LogFileReader", mLogPath));
 
@@ -1131,6 +1144,23 @@ uint64_t LogFileReader::GetLogstoreKey() const {
     return mEOOption ? mEOOption->fbKey : mLogstoreKey;
 }
 
+ProfilingHandle LogFileReader::GetProfilingHandle() {
+    // Copied under lock, as the handle may be released by CloseFilePtr in another thread.
+    std::lock_guard<std::mutex> lock(mProfilingHandleLock);
+    if (!mProfilingHandle.mFileCounter) {
+        // The same file name as reported by LogProcess.
+        std::string logPath = GetConvertedPath();
+#if defined(_MSC_VER)
+        if (BOOL_FLAG(enable_chinese_tag_path)) {
+            logPath = EncodingConverter::GetInstance()->FromACPToUTF8(logPath);
+        }
+#endif
+        mProfilingHandle = LogFileProfiler::GetInstance()->GetProfilingHandle(
+            mConfigName, mRegion, mProjectName, mCategory, logPath);
+    }
+    return mProfilingHandle;
+}
+
 bool LogFileReader::CheckDevInode() {
     fsutil::PathStat statBuf;
     if (mLogFileOp.Stat(statBuf) != 0) {
@@ -1243,64 +1273,63 @@ void LogFileReader::SetReadBufferSize(int32_t bufSize) {
     }
     LOG_INFO(sLogger, ("set max read buffer size", bufSize));
     BUFFER_SIZE = bufSize;
+    ReadBufferPool::GetInstance()->SetBlockSize(BUFFER_SIZE + 1);
 }
 
 vector<int32_t> LogFileReader::LogSplit(char* buffer, int32_t size, int32_t& lineFeed) {
+    vector<int32_t> lineFeedPos;
+    FindLineFeeds(buffer, size, lineFeedPos);
+    lineFeed = lineFeedPos.size() + 1;
+
     vector<int32_t> index;
-    int begIndex = 0;
-    int endIndex = 0;
-    lineFeed = 0;
+    if (mLogBeginRegPtr == NULL) {
+        // Every line is a log, no need to check line by line.
+        index.reserve(lineFeed);
+        index.push_back(0);
+        for (size_t i = 0; i < lineFeedPos.size(); ++i) {
+            buffer[lineFeedPos[i]] = '\0';
+            index.push_back(lineFeedPos[i] + 1);
+        }
+        return index;
+    }
+
+    int32_t begIndex = 0;
     string exception;
-    while (endIndex < size) {
-        if (buffer[endIndex] == '\n') {
-            lineFeed++;
+    for (size_t i = 0; i <= lineFeedPos.size(); ++i) {
+        // The last line is terminated by buffer[size].
+        bool isLastLine = (i == lineFeedPos.size());
+        int32_t endIndex = isLastLine ? size : lineFeedPos[i];
+        if (!isLastLine) {
             buffer[endIndex] = '\0';
-            exception.clear();
-            if (mLogBeginRegPtr == NULL || BoostRegexMatch(buffer + begIndex, *mLogBeginRegPtr, exception)) {
-                index.push_back(begIndex);
-                if (begIndex > 0) {
-                    buffer[begIndex - 1] = '\0';
-                }
-            } else if (!exception.empty()) {
-                if (AppConfig::GetInstance()->IsLogParseAlarmValid()) {
-                    if (LogtailAlarm::GetInstance()->IsLowLevelAlarmValid()) {
-                        LOG_ERROR(sLogger,
-                                  ("regex_match in LogSplit fail, exception",
-                                   exception)("project", mProjectName)("logstore", mCategory)("file", mLogPath));
-                    }
-                    LogtailAlarm::GetInstance()->SendAlarm(REGEX_MATCH_ALARM,
-                                                           "regex_match in LogSplit fail:" + exception,
-                                                           mProjectName,
-                                                           mCategory,
-                                                           mRegion);
-                }
+        }
+        exception.clear();
+        if (IsLogBeginLine(buffer + begIndex, endIndex - begIndex, exception)) {
+            // the last log should be terminated
+            if (begIndex > 0) {
+                buffer[begIndex - 1] = '\0';
             }
+            index.push_back(begIndex);
+        } else if (!exception.empty()) {
+            SendLogSplitRegexAlarm(exception);
+        }
+        if (!isLastLine) {
             buffer[endIndex] = '\n';
-            begIndex = endIndex + 1;
         }
-        endIndex++;
+        begIndex = endIndex + 1;
     }
-    lineFeed++;
-    exception.clear();
-    if (mLogBeginRegPtr == NULL || BoostRegexMatch(buffer + begIndex, *mLogBeginRegPtr, exception)) {
-        // the last second log should be terminated
-        if (begIndex > 0) {
-            buffer[begIndex - 1] = '\0';
-        }
-        // save the last log
-        index.push_back(begIndex);
-    } else if (!exception.empty()) {
-        if (AppConfig::GetInstance()->IsLogParseAlarmValid()) {
-            if (LogtailAlarm::GetInstance()->IsLowLevelAlarmValid()) {
-                LOG_ERROR(sLogger,
-                          ("regex_match in LogSplit fail, exception",
-                           exception)("project", mProjectName)("logstore", mCategory)("file", mLogPath));
-            }
-            LogtailAlarm::GetInstance()->SendAlarm(
-                REGEX_MATCH_ALARM, "regex_match in LogSplit fail:" + exception, mProjectName, mCategory, mRegion);
+    return index;
+}
+
+void LogFileReader::SendLogSplitRegexAlarm(const std::string& exception) {
+    if (AppConfig::GetInstance()->IsLogParseAlarmValid()) {
+        if (LogtailAlarm::GetInstance()->IsLowLevelAlarmValid()) {
+            LOG_ERROR(sLogger,
+                      ("regex_match in LogSplit fail, exception",
+                       exception)("project", mProjectName)("logstore", mCategory)("file", mLogPath));
         }
+        LogtailAlarm::GetInstance()->SendAlarm(
+            REGEX_MATCH_ALARM, "regex_match in LogSplit fail:" + exception, mProjectName, mCategory, mRegion);
     }
-    return index;
 }
 
 bool LogFileReader::ParseLogTime(const char* buffer,
@@ -1401,7 +1430,7 @@ bool LogFileReader::GetLogTimeByOffset(const char* buffer,
  * "SingleLineLog_1\nSingleLineLog_2\nxxx" -> "SingleLineLog_1\nSingleLineLog_2\0"
  */
 bool LogFileReader::GetRawData(
-    char*& bufferptr, size_t* size, int64_t fileSize, FileInfo*& fileInfo, TruncateInfo*& truncateInfo) {
+    ReadBufferPtr& buffer, size_t* size, int64_t fileSize, FileInfo*& fileInfo, TruncateInfo*& truncateInfo) {
     *size = 0;
 
     // Truncate, return false to indicate no more data.
@@ -1411,12 +1440,12 @@ bool LogFileReader::GetRawData(
 
     bool moreData = false;
     if (mFileEncoding == ENCODING_GBK)
-        ReadGBK(bufferptr, size, fileSize, moreData, truncateInfo);
+        ReadGBK(buffer, size, fileSize, moreData, truncateInfo);
     else
-        ReadUTF8(bufferptr, size, fileSize, moreData, truncateInfo);
+        ReadUTF8(buffer, size, fileSize, moreData, truncateInfo);
 
     int64_t delta = fileSize - mLastFilePos;
-    if (delta > mReadDelayAlarmBytes && bufferptr != NULL) {
+    if (delta > mReadDelayAlarmBytes && buffer) {
         int32_t curTime = time(NULL);
         if (mReadDelayTime == 0)
             mReadDelayTime = curTime;
@@ -1429,7 +1458,7 @@ bool LogFileReader::GetRawData(
                 READ_LOG_DELAY_ALARM,
                 string("fall behind ") + ToString(delta) + " bytes, file size:" + ToString(fileSize)
                     + ", now position:" + ToString(mLastFilePos) + ", path:" + mLogPath
-                    + ", now read log content:" + std::string(bufferptr, *size < 256 ? *size : 256),
+                    + ", now read log content:" + std::string(buffer.get(), *size < 256 ? *size : 256),
                 mProjectName,
                 mCategory,
                 mRegion);
@@ -1446,7 +1475,7 @@ bool LogFileReader::GetRawData(
             READ_LOG_DELAY_ALARM,
             string("force set file pos to file size, fall behind ") + ToString(delta)
                 + " bytes, file size:" + ToString(fileSize) + ", now position:" + ToString(mLastFilePos)
-                + ", path:" + mLogPath + ", now read log content:" + std::string(bufferptr, *size < 256 ? *size : 256),
+                + ", path:" + mLogPath + ", now read log content:" + std::string(buffer.get(), *size < 256 ? *size : 256),
             mProjectName,
             mCategory,
             mRegion);
@@ -1515,12 +1544,29 @@ void LogFileReader::setExactlyOnceCheckpointAfterRead(size_t readSize) {
     cpt.set_read_length(readSize);
 }
 
-void LogFileReader::ReadUTF8(char*& bufferptr, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo) {
+void LogFileReader::ReadUTF8(
+    ReadBufferPtr& buffer, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo) {
     bool fromCpt = false;
     size_t READ_BYTE = getNextReadSize(end, fromCpt);
-    bufferptr = new char[READ_BYTE + 1];
-    bufferptr[READ_BYTE] = '\0';
-    size_t nbytes = ReadFile(mLogFileOp, bufferptr, READ_BYTE, mLastFilePos, &truncateInfo);
+    size_t nbytes = 0;
+    int32_t checkedSize = 0;
+    if (fromCpt) {
+        clearCarryOver();
+    }
+    if (fromCpt || !takeReadAhead(buffer, READ_BYTE, nbytes, checkedSize)) {
+        buffer = ReadBufferPool::GetInstance()->Acquire(READ_BYTE + 1);
+        buffer.get()[READ_BYTE] = '\0';
+        nbytes = takeCarryOver(buffer.get(), READ_BYTE, end, checkedSize);
+        if (nbytes == 0) {
+            nbytes = ReadFile(mLogFileOp, buffer.get(), READ_BYTE, mLastFilePos, &truncateInfo);
+        } else if (nbytes < READ_BYTE) {
+            int64_t offset = mLastFilePos + nbytes;
+            nbytes += ReadFile(mLogFileOp, buffer.get() + nbytes, READ_BYTE - nbytes, offset);
+            buffer.get()[nbytes] = '\0';
+        }
+    }
+    char* bufferptr = buffer.get();
+    size_t readBytes = nbytes;
     mLastReadPos = mLastFilePos + nbytes;
     LOG_DEBUG(sLogger, ("read bytes", nbytes)("last read pos", mLastReadPos));
     moreData = (nbytes == BUFFER_SIZE);
@@ -1529,14 +1575,27 @@ void LogFileReader::ReadUTF8(char*& bufferptr, size_t* size, int64_t end, bool&
         nbytes--;
         adjustFlag = true;
     }
+    size_t lineEnd = nbytes;
+    bool scanned = false;
     if ((nbytes > 0 && (adjustFlag || moreData) && mLogBeginRegPtr) || mLogType == JSON_LOG) {
         int32_t rollbackLineFeedCount;
-        nbytes = LastMatchedLine(bufferptr, nbytes, rollbackLineFeedCount);
+        if (mLogType == JSON_LOG) {
+            nbytes = LastMatchedLine(bufferptr, nbytes, rollbackLineFeedCount);
+        } else {
+            nbytes = lastMatchedLine(bufferptr, nbytes, checkedSize, rollbackLineFeedCount);
+            scanned = true;
+        }
     }
 
     if (moreData && nbytes == 0) {
         nbytes = READ_BYTE;
     }
+    // JsonLogFileReader::LastMatchedLine terminates lines it has checked, so only the last
+    //  incomplete line can be carried over.
+    if (mLogType != JSON_LOG || nbytes >= lineEnd) {
+        bool checked = scanned && nbytes <= lineEnd;
+        saveCarryOver(bufferptr, nbytes, readBytes, checked ? static_cast<int32_t>(lineEnd - nbytes) : 0);
+    }
     if (nbytes == 0)
         bufferptr[0] = '\0';
     else
@@ -1548,15 +1607,126 @@ void LogFileReader::ReadUTF8(char*& bufferptr, size_t* size, int64_t end, bool&
     *size = nbytes;
     setExactlyOnceCheckpointAfterRead(*size);
     mLastFilePos += nbytes;
+    if (moreData && !fromCpt) {
+        submitReadAhead();
+    }
 
     LOG_DEBUG(sLogger, ("read size", *size)("last file pos", mLastFilePos));
 }
 
-void LogFileReader::ReadGBK(char*& bufferptr, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo) {
+void LogFileReader::submitReadAhead() {
+    static AsyncReadEngine* sEngine = AsyncReadEngine::GetInstance();
+    if (mIsFuseMode || mEOOption || !sEngine->IsEnabled() || !mLogFileOp.IsOpen()) {
+        return;
+    }
+    releaseReadAhead();
+    // Buffers of lagging readers are held until their next read, so they are limited in total.
+    const int64_t bufferSize = static_cast<int64_t>(BUFFER_SIZE + 1);
+    if (sReadAheadBytes.fetch_add(bufferSize) + bufferSize > INT64_FLAG(reader_read_ahead_max_bytes)) {
+        sReadAheadBytes.fetch_sub(bufferSize);
+        return;
+    }
+    ReadBufferPtr buffer = ReadBufferPool::GetInstance()->Acquire(BUFFER_SIZE + 1);
+    // Carry-over is copied to the head of the buffer when the chunk is taken.
+    mReadAheadHeadSize = mCarryOver.size();
+    mReadAhead = sEngine->Submit(mLogFileOp.GetFd(),
+                                 ReadBufferPtr(buffer, buffer.get() + mReadAheadHeadSize),
+                                 BUFFER_SIZE - mReadAheadHeadSize,
+                                 mLastFilePos + mReadAheadHeadSize);
+    if (mReadAhead) {
+        mReadAheadBytes = bufferSize;
+    } else {
+        sReadAheadBytes.fetch_sub(bufferSize);
+    }
+}
+
+void LogFileReader::releaseReadAhead() {
+    if (mReadAhead) {
+        mReadAhead.reset();
+        sReadAheadBytes.fetch_sub(mReadAheadBytes);
+        mReadAheadBytes = 0;
+    }
+}
+
+bool LogFileReader::takeReadAhead(ReadBufferPtr& buffer, size_t readSize, size_t& nbytes, int32_t& checkedSize) {
+    AsyncReadRequestPtr request = mReadAhead;
+    // The chunk becomes the buffer of current read, or is dropped.
+    releaseReadAhead();
+    size_t headSize = mReadAheadHeadSize;
+    // Position is moved (truncate, skip) or file is reopened since submitted.
+    if (!request || request->offset != mLastFilePos + static_cast<int64_t>(headSize)
+        || request->fd != mLogFileOp.GetFd() || readSize > headSize + request->size
+        || (headSize > 0 && (mCarryOverOffset != mLastFilePos || mCarryOver.size() != headSize))) {
+        return false;
+    }
+    int64_t result = AsyncReadEngine::GetInstance()->Wait(request);
+    if (result < 0) {
+        LOG_WARNING(sLogger, ("read ahead failed, read again", mLogPath)("error", strerror(-result)));
+        return false;
+    }
+    buffer = ReadBufferPtr(request->buffer, request->buffer.get() - headSize);
+    memcpy(buffer.get(), mCarryOver.data(), headSize);
+    checkedSize = mCarryOverCheckedSize;
+    clearCarryOver();
+    nbytes = headSize + static_cast<size_t>(result);
+    if (nbytes > readSize) {
+        nbytes = readSize;
+    } else if (nbytes < readSize) {
+        // File grew after read ahead was submitted.
+        int64_t offset = mLastFilePos + nbytes;
+        nbytes += ReadFile(mLogFileOp, buffer.get() + nbytes, readSize - nbytes, offset);
+    }
+    buffer.get()[nbytes] = '\0';
+    return true;
+}
+
+size_t LogFileReader::takeCarryOver(char* buffer, size_t readSize, int64_t fileEnd, int32_t& checkedSize) {
+    size_t carrySize = mCarryOver.size();
+    bool valid = carrySize > 0 && mCarryOverOffset == mLastFilePos && carrySize <= readSize
+        && mLastFilePos + static_cast<int64_t>(carrySize) <= fileEnd;
+    if (valid) {
+        memcpy(buffer, mCarryOver.data(), carrySize);
+        checkedSize = mCarryOverCheckedSize;
+    }
+    clearCarryOver();
+    return valid ? carrySize : 0;
+}
+
+void LogFileReader::saveCarryOver(const char* buffer, size_t consumed, size_t readSize, int32_t checkedSize) {
+    clearCarryOver();
+    // Holes of fuse files are skipped by ReadFile, so bytes are not continuous.
+    if (consumed >= readSize || mIsFuseMode
+        || readSize - consumed > static_cast<size_t>(INT32_FLAG(reader_carry_over_max_bytes))) {
+        return;
+    }
+    // '\0' may be unwritten part of a preallocated file, so the tail is read again.
+    if (memchr(buffer + consumed, '\0', readSize - consumed) != NULL) {
+        return;
+    }
+    mCarryOver.assign(buffer + consumed, readSize - consumed);
+    mCarryOverOffset = mLastFilePos + consumed;
+    mCarryOverCheckedSize = checkedSize;
+}
+
+void LogFileReader::ReadGBK(
+    ReadBufferPtr& buffer, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo) {
     bool fromCpt = false;
     size_t READ_BYTE = getNextReadSize(end, fromCpt);
-    char* gbkBuffer = new char[READ_BYTE + 1];
-    size_t readCharCount = ReadFile(mLogFileOp, gbkBuffer, READ_BYTE, mLastFilePos, &truncateInfo);
+    ReadBufferPtr gbkBufferHandle = ReadBufferPool::GetInstance()->Acquire(READ_BYTE + 1);
+    char* gbkBuffer = gbkBufferHandle.get();
+    // Carry-over is raw GBK bytes, lines are not checked as regex works on converted lines.
+    int32_t checkedSize = 0;
+    if (fromCpt) {
+        clearCarryOver();
+    }
+    size_t readCharCount = takeCarryOver(gbkBuffer, READ_BYTE, end, checkedSize);
+    if (readCharCount == 0) {
+        readCharCount = ReadFile(mLogFileOp, gbkBuffer, READ_BYTE, mLastFilePos, &truncateInfo);
+    } else if (readCharCount < READ_BYTE) {
+        int64_t offset = mLastFilePos + readCharCount;
+        readCharCount += ReadFile(mLogFileOp, gbkBuffer + readCharCount, READ_BYTE - readCharCount, offset);
+    }
+    gbkBuffer[readCharCount] = '\0';
     mLastReadPos = mLastFilePos + readCharCount;
     size_t originReadCount = readCharCount;
     moreData = (readCharCount == BUFFER_SIZE);
@@ -1570,29 +1740,39 @@ void LogFileReader::ReadGBK(char*& bufferptr, size_t* size, int64_t end, bool& m
         if (moreData)
             readCharCount = READ_BYTE;
         else {
-            delete[] gbkBuffer;
             *size = 0;
+            saveCarryOver(gbkBuffer, 0, originReadCount, 0);
             return;
         }
     }
-    gbkBuffer[readCharCount] = '\0';
 
+    // Line feeds are found while converting, the output is in a pooled buffer of the same size.
     vector<size_t> lineFeedPos;
-    for (size_t idx = 0; idx < readCharCount - 1; ++idx) {
-        if (gbkBuffer[idx] == '\n')
-            lineFeedPos.push_back(idx);
-    }
-    lineFeedPos.push_back(readCharCount - 1);
-
     size_t srcLength = readCharCount;
-    size_t desLength = 0;
-    bufferptr = NULL;
-    EncodingConverter::GetInstance()->ConvertGbk2Utf8(gbkBuffer, &srcLength, bufferptr, &desLength, lineFeedPos);
-    size_t resultCharCount = desLength;
+    buffer = ReadBufferPool::GetInstance()->Acquire(READ_BYTE + 1);
+    size_t resultCharCount = EncodingConverter::GetInstance()->ConvertGbk2Utf8Lines(
+        gbkBuffer, &srcLength, buffer.get(), READ_BYTE, lineFeedPos);
+    if (srcLength == 0) {
+        // The first line is too long to be held, a GBK byte is converted to at most 3 bytes.
+        lineFeedPos.clear();
+        srcLength = readCharCount;
+        buffer = ReadBufferPool::GetInstance()->Acquire(readCharCount * 3 + 1);
+        resultCharCount = EncodingConverter::GetInstance()->ConvertGbk2Utf8Lines(
+            gbkBuffer, &srcLength, buffer.get(), readCharCount * 3, lineFeedPos);
+    }
+    if (srcLength < readCharCount) {
+        // Lines left are carried over to next read.
+        readCharCount = srcLength;
+        moreData = true;
+    }
+    if (lineFeedPos.empty() || lineFeedPos.back() != readCharCount - 1) {
+        lineFeedPos.push_back(readCharCount - 1);
+    }
+    char* bufferptr = buffer.get();
 
-    delete[] gbkBuffer;
     if (resultCharCount == 0) {
         *size = 0;
+        saveCarryOver(gbkBuffer, readCharCount, originReadCount, 0);
         mLastFilePos += readCharCount;
         return;
     }
@@ -1610,6 +1790,9 @@ void LogFileReader::ReadGBK(char*& bufferptr, size_t* size, int64_t end, bool& m
     if (rollbackLineFeedCount > 0 && lineFeedCount >= (1 + rollbackLineFeedCount))
         readCharCount -= lineFeedPos[lineFeedCount - 1] - lineFeedPos[lineFeedCount - 1 - rollbackLineFeedCount];
 
+    saveCarryOver(gbkBuffer, readCharCount, originReadCount, 0);
+    gbkBufferHandle.reset();
+
     bufferptr[resultCharCount - 1] = '\0';
     if (!moreData && fromCpt && mLastReadPos < end) {
         moreData = true;
@@ -1703,18 +1886,26 @@ LogFileReader::FileCompareResult LogFileReader::CompareToFile(const string& file
 }
 
 int32_t LogFileReader::LastMatchedLine(char* buffer, int32_t size, int32_t& rollbackLineFeedCount) {
+    return lastMatchedLine(buffer, size, 0, rollbackLineFeedCount);
+}
+
+int32_t
+LogFileReader::lastMatchedLine(char* buffer, int32_t size, int32_t checkedSize, int32_t& rollbackLineFeedCount) {
     int endPs = size - 1; // buffer[size] = 0 , buffer[size-1] = '\n'
     int begPs = size - 2;
+    // The line starting at begPs + 1 is checked, lines before checkedSize are not.
+    int minBegPs = checkedSize > 1 ? checkedSize - 1 : 0;
     string exception;
     rollbackLineFeedCount = 0;
-    while (begPs >= 0) {
+    while (begPs >= minBegPs) {
         if (buffer[begPs] == '\n') {
             rollbackLineFeedCount++;
             char temp = buffer[endPs];
             buffer[endPs] = '\0';
             // ignore regex match fail, no need log here
-            if (BoostRegexMatch(buffer + begPs + 1, *mLogBeginRegPtr, exception)) {
-                buffer[begPs + 1] = '\0';
+            if (IsLogBeginLine(buffer + begPs + 1, endPs - begPs - 1, exception)) {
+                // The matched line is kept as it is, it may be carried over to next read.
+                buffer[endPs] = temp;
                 return begPs + 1;
             }
             buffer[endPs] = temp;
@@ -1779,6 +1970,7 @@ CommonRegLogFileReader::CommonRegLogFileReader(const std::string& projectName,
                     dockerFileFlag) {
     mLogType = REGEX_LOG;
     mTimeFormat = timeFormat;
+    mTimeFormatParser = TimeFormatParser::Compile(mTimeFormat);
     mTimeKey = "time";
 }
 
@@ -1836,7 +2028,8 @@ bool CommonRegLogFileReader::ParseLogLine(const char* buffer,
                                                 mLogPath,
                                                 error,
                                                 logGroupSize,
-                                                mTzOffsetSecond);
+                                                mTzOffsetSecond,
+                                                mTimeFormatParser.get());
         } else {
             // if "time" field not exist in user config or timeformat empty, set current system time for logs
             if (format.mIsWholeLineMode) {
@@ -21,17 +21,24 @@
 #include <unordered_set>
 #include <deque>
 #include <atomic>
+#include <mutex>
 #include "parser/LogParser.h"
 #include "common/TimeUtil.h"
+#include "common/TimeFormatParser.h"
 #include "common/GlobalPara.h"
 #include "common/StringTools.h"
 #include "common/EncodingConverter.h"
 #include "common/DevInode.h"
 #include "common/LogFileOperator.h"
+#include "common/RegexPrefilter.h"
+#include "common/ReadBufferPool.h"
+#include "common/AsyncReadEngine.h"
 #include "log_pb/sls_logs.pb.h"
 #include "config/LogType.h"
 #include "common/FileInfo.h"
 #include "checkpoint/RangeCheckpoint.h"
+#include "profiler/LogFileProfiler.h"
+#include "common/LogGroupContext.h"
 
 namespace logtail {
 
@@ -90,8 +97,11 @@ public:
             delete mLogBeginRegPtr;
             mLogBeginRegPtr = NULL;
         }
+        mLogBeginPrefilter.Clear();
+        mCarryOverCheckedSize = 0;
         if (reg.empty() == false && reg != ".*") {
             mLogBeginRegPtr = new boost::regex(reg.c_str());
+            mLogBeginPrefilter.Reset(reg);
         }
     }
 
@@ -227,6 +237,46 @@ public:
 
     bool IsReadToEnd() const { return mLastReadPos == mLastFileSize; }
 
+    // Used by LogReaderThreadPool, a reader is read by at most one reader thread at a time.
+    // TryStartReading returns false if the reader is being read by other thread.
+    bool TryStartReading() {
+        bool expected = false;
+        return mReadingFlag.compare_exchange_strong(expected, true);
+    }
+    // FinishReading returns true if a read is requested (DelayIfReading) during current reading.
+    bool FinishReading() {
+        mReadingFlag = false;
+        return mPendingReadFlag.exchange(false);
+    }
+    bool IsReading() const { return mReadingFlag; }
+    // MarkReadPending records the time a read is requested first since last read to end, which is
+    //  used to measure collection delay of the file.
+    void MarkReadPending(uint64_t nowMs) {
+        uint64_t expected = 0;
+        mReadPendingSinceMs.compare_exchange_strong(expected, nowMs);
+    }
+    // ResetReadPending returns the time recorded by MarkReadPending, 0 if not marked.
+    uint64_t ResetReadPending() { return mReadPendingSinceMs.exchange(0); }
+    // GetProfilingHandle returns profiling counters of the file, created at the first call after the file
+    //  is opened, so reading and processing threads add profiling data without building keys.
+    // Counters are released when the file is closed, so that statistics of idle files can be removed.
+    ProfilingHandle GetProfilingHandle();
+    // GetRoutingKeyCache returns routing keys of log groups computed by aggregator for the file.
+    const RoutingKeyCachePtr& GetRoutingKeyCache() const { return mRoutingKeyCache; }
+    // DelayIfReading requests a read after current reading and returns true if the reader is being read.
+    bool DelayIfReading() {
+        if (!mReadingFlag) {
+            return false;
+        }
+        mPendingReadFlag = true;
+        // Double check, reading may finish before the pending flag is set.
+        if (mReadingFlag) {
+            return true;
+        }
+        mPendingReadFlag = false;
+        return false;
+    }
+
     LogFileReaderPtrArray* GetReaderArray();
 
     void SetReaderArray(LogFileReaderPtrArray* readerArray);
@@ -317,9 +367,9 @@ public:
 
 protected:
     virtual bool
-    GetRawData(char*& bufferptr, size_t* size, int64_t fileSize, FileInfo*& fileInfo, TruncateInfo*& trncateInfo);
-    void ReadUTF8(char*& bufferptr, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo);
-    void ReadGBK(char*& bufferptr, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo);
+    GetRawData(ReadBufferPtr& buffer, size_t* size, int64_t fileSize, FileInfo*& fileInfo, TruncateInfo*& trncateInfo);
+    void ReadUTF8(ReadBufferPtr& buffer, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo);
+    void ReadGBK(ReadBufferPtr& buffer, size_t* size, int64_t end, bool& moreData, TruncateInfo*& truncateInfo);
 
     size_t
     ReadFile(LogFileOperator& logFileOp, void* buf, size_t size, int64_t& offset, TruncateInfo** truncateInfo = NULL);
@@ -335,6 +385,17 @@ protected:
     static int32_t ParseTime(const char* buffer, const std::string& timeFormat);
     void SetFilePosBackwardToFixedPos(LogFileOperator& logFileOp);
 
+    // Check if @line (@size bytes, null terminated) matches the log begin regex, lines
+    //  rejected by mLogBeginPrefilter skip the regex.
+    bool IsLogBeginLine(const char* line, size_t size, std::string& exception) const {
+        return mLogBeginPrefilter.MayMatch(line, size) && BoostRegexMatch(line, *mLogBeginRegPtr, exception);
+    }
+    void SendLogSplitRegexAlarm(const std::string& exception);
+
+    // LastMatchedLine of the base reader, lines starting in (0, @checkedSize) are skipped as they
+    //  are known not to be log begin lines.
+    int32_t lastMatchedLine(char* buffer, int32_t size, int32_t checkedSize, int32_t& rollbackLineFeedCount);
+
     bool CheckForFirstOpen(FileReadPolicy policy = BACKWARD_TO_FIXED_POS);
     void FixLastFilePos(LogFileOperator& logFileOp, int64_t endOffset);
 
@@ -357,6 +418,7 @@ protected:
     std::string mTopicName;
     time_t mLastUpdateTime;
     boost::regex* mLogBeginRegPtr;
+    RegexPrefilter mLogBeginPrefilter;
     FileEncoding mFileEncoding;
     bool mDiscardUnmatch;
     LogType mLogType;
@@ -393,6 +455,13 @@ protected:
     int32_t mTzOffsetSecond;
     bool mAdjustApsaraMicroTimezone;
 
+    std::atomic_bool mReadingFlag{false};
+    std::atomic_bool mPendingReadFlag{false};
+    std::atomic<uint64_t> mReadPendingSinceMs{0};
+    std::mutex mProfilingHandleLock;
+    ProfilingHandle mProfilingHandle;
+    RoutingKeyCachePtr mRoutingKeyCache{std::make_shared<RoutingKeyCache>()};
+
 private:
     // Initialized when the exactly once feature is enabled.
     struct ExactlyOnceOption {
@@ -415,6 +484,20 @@ private:
     };
     std::shared_ptr<ExactlyOnceOption> mEOOption;
 
+    AsyncReadRequestPtr mReadAhead;
+    // Bytes of buffers held by mReadAhead of all readers, limited by flag reader_read_ahead_max_bytes.
+    static std::atomic<int64_t> sReadAheadBytes;
+    int64_t mReadAheadBytes = 0;
+    // Bytes reserved before the read ahead chunk in its buffer, for mCarryOver at submit time.
+    size_t mReadAheadHeadSize = 0;
+
+    // Unconsumed tail of last read (an incomplete line or multiline log), which is the file content
+    //  of [mCarryOverOffset, mLastReadPos). Next read starts with it instead of reading it again.
+    std::string mCarryOver;
+    int64_t mCarryOverOffset = -1;
+    // Lines of mCarryOver starting in (0, mCarryOverCheckedSize) are known not to be log begin lines.
+    int32_t mCarryOverCheckedSize = 0;
+
     // Select next checkpoint to recover from toReplayCheckpoints.
     // Called before read.
     //
@@ -446,6 +529,36 @@ private:
     // Update current checkpoint's read offset and length after success read.
     void setExactlyOnceCheckpointAfterRead(size_t readSize);
 
+    // Submit read of next chunk to AsyncReadEngine, so that the disk works while current
+    //  chunk is split and parsed. Only for UTF8 files in non-fuse mode without exactly once.
+    void submitReadAhead();
+    // Drop mReadAhead and return its buffer to the read ahead budget.
+    void releaseReadAhead();
+
+    // Take the read ahead chunk if it starts from mLastFilePos (after carry-over), @readSize bytes
+    //  are filled.
+    // @return false if there is no available read ahead chunk.
+    bool takeReadAhead(ReadBufferPtr& buffer, size_t readSize, size_t& nbytes, int32_t& checkedSize);
+
+    // Copy carry-over to the head of @buffer if it starts from mLastFilePos and the file is not
+    //  truncated, carry-over is dropped anyway.
+    // @return bytes copied, and @checkedSize is set to mCarryOverCheckedSize.
+    size_t takeCarryOver(char* buffer, size_t readSize, int64_t fileEnd, int32_t& checkedSize);
+
+    // Keep [@consumed, @readSize) of @buffer for next read if it is not too large.
+    // Called before the buffer is modified for processing.
+    void saveCarryOver(const char* buffer, size_t consumed, size_t readSize, int32_t checkedSize);
+
+    void clearCarryOver() {
+        // Large tails are rare, don't keep their memory for idle readers.
+        if (mCarryOver.capacity() > 4096) {
+            std::string().swap(mCarryOver);
+        }
+        mCarryOver.clear();
+        mCarryOverOffset = -1;
+        mCarryOverCheckedSize = 0;
+    }
+
     // Return primary key of current reader by combining meta.
     //
     // Conflict resolve: file signature will be stored in primary checkpoint.
@@ -518,12 +631,15 @@ private:
     friend class SenderUnittest;
     friend class AppConfigUnittest;
     friend class ModifyHandlerUnittest;
+    friend class LogSplitUnittest;
     void UpdateReaderManual();
 #endif
 };
 
 struct LogBuffer {
+    // Points to the memory held by bufferHandle, which is released with LogBuffer.
     char* buffer;
+    ReadBufferPtr bufferHandle;
     int32_t bufferSize;
     LogFileReaderPtr logFileReader;
     FileInfoPtr fileInfo;
@@ -533,11 +649,11 @@ struct LogBuffer {
     // Current buffer's offset in file, for log position meta feature.
     uint64_t beginOffset;
 
-    LogBuffer(char* buf,
+    LogBuffer(const ReadBufferPtr& buf,
               int32_t size,
               const FileInfoPtr& fileInfo = FileInfoPtr(),
               const TruncateInfoPtr& truncateInfo = TruncateInfoPtr())
-        : buffer(buf), bufferSize(size), fileInfo(fileInfo), truncateInfo(truncateInfo) {}
+        : buffer(buf.get()), bufferHandle(buf), bufferSize(size), fileInfo(fileInfo), truncateInfo(truncateInfo) {}
     void SetDependecy(const LogFileReaderPtr& reader) { logFileReader = reader; }
 };
 
@@ -569,6 +685,8 @@ protected:
 
     std::string mTimeKey;
     std::string mTimeFormat;
+    // Compiled mTimeFormat, NULL if it is not supported.
+    std::shared_ptr<TimeFormatParser> mTimeFormatParser;
     std::vector<UserDefinedFormat> mUserDefinedFormat;
     std::vector<int32_t> mTimeIndex;
 
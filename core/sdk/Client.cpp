@@ -218,21 +218,23 @@ namespace sdk {
                                                       const std::string& logstore,
                                                       const std::string& compressedLogGroup,
                                                       uint32_t rawSize,
-                                                      const std::string& hashKey) {
+                                                      const std::string& hashKey,
+                                                      const std::string& compressType) {
         map<string, string> httpHeader;
         httpHeader[CONTENT_TYPE] = TYPE_LOG_PROTOBUF;
         if (!mKeyProvider.empty()) {
             httpHeader[X_LOG_KEYPROVIDER] = mKeyProvider;
         }
         httpHeader[X_LOG_BODYRAWSIZE] = std::to_string(rawSize);
-        httpHeader[X_LOG_COMPRESSTYPE] = LOG_LZ4;
+        httpHeader[X_LOG_COMPRESSTYPE] = compressType;
         return SynPostLogStoreLogs(project, logstore, compressedLogGroup, httpHeader, hashKey);
     }
 
     PostLogStoreLogsResponse Client::PostLogStoreLogPackageList(const std::string& project,
                                                                 const std::string& logstore,
                                                                 const std::string& packageListData,
-                                                                const std::string& hashKey) {
+                                                                const std::string& hashKey,
+                                                                const std::string& compressType) {
         map<string, string> httpHeader;
         httpHeader[CONTENT_TYPE] = TYPE_LOG_PROTOBUF;
         if (!mKeyProvider.empty()) {
@@ -240,7 +242,7 @@ namespace sdk {
         }
         httpHeader[X_LOG_MODE] = LOG_MODE_BATCH_GROUP;
         httpHeader[X_LOG_BODYRAWSIZE] = std::to_string(packageListData.size());
-        httpHeader[X_LOG_COMPRESSTYPE] = LOG_LZ4;
+        httpHeader[X_LOG_COMPRESSTYPE] = compressType;
         return SynPostLogStoreLogs(project, logstore, packageListData, httpHeader, hashKey);
     }
 
@@ -250,14 +252,15 @@ namespace sdk {
                                   uint32_t rawSize,
                                   PostLogStoreLogsClosure* callBack,
                                   const std::string& hashKey,
-                                  int64_t hashKeySeqID) {
+                                  int64_t hashKeySeqID,
+                                  const std::string& compressType) {
         map<string, string> httpHeader;
         httpHeader[CONTENT_TYPE] = TYPE_LOG_PROTOBUF;
         if (!mKeyProvider.empty()) {
             httpHeader[X_LOG_KEYPROVIDER] = mKeyProvider;
         }
         httpHeader[X_LOG_BODYRAWSIZE] = std::to_string(rawSize);
-        httpHeader[X_LOG_COMPRESSTYPE] = LOG_LZ4;
+        httpHeader[X_LOG_COMPRESSTYPE] = compressType;
         AsynPostLogStoreLogs(project, logstore, compressedLogGroup, httpHeader, callBack, hashKey, hashKeySeqID);
     }
 
@@ -265,7 +268,8 @@ namespace sdk {
                                             const std::string& logstore,
                                             const std::string& packageListData,
                                             PostLogStoreLogsClosure* callBack,
-                                            const std::string& hashKey) {
+                                            const std::string& hashKey,
+                                            const std::string& compressType) {
         map<string, string> httpHeader;
         httpHeader[CONTENT_TYPE] = TYPE_LOG_PROTOBUF;
         if (!mKeyProvider.empty()) {
@@ -273,7 +277,7 @@ namespace sdk {
         }
         httpHeader[X_LOG_MODE] = LOG_MODE_BATCH_GROUP;
         httpHeader[X_LOG_BODYRAWSIZE] = std::to_string(packageListData.size());
-        httpHeader[X_LOG_COMPRESSTYPE] = LOG_LZ4;
+        httpHeader[X_LOG_COMPRESSTYPE] = compressType;
         AsynPostLogStoreLogs(project, logstore, packageListData, httpHeader, callBack, hashKey, kInvalidHashKeySeqID);
     }
 
@@ -90,7 +90,7 @@ namespace sdk {
         /////////////////////////////////////Internal Interface For Logtail////////////////////////////////////////
         /** Sync Put data to LOG service. Unsuccessful opertaion will cause an LOGException.
          * @param project The project name
-         * @param serialized data of logGroup, LZ4 comressed
+         * @param serialized data of logGroup, compressed with codec @compressType
          * @rawSize before compress
          * @return request_id.
          */
@@ -98,7 +98,8 @@ namespace sdk {
                                                   const std::string& logstore,
                                                   const std::string& compressedLogGroup,
                                                   uint32_t rawSize,
-                                                  const std::string& hashKey = "");
+                                                  const std::string& hashKey = "",
+                                                  const std::string& compressType = LOG_LZ4);
         /** Sync Put data to LOG service. Unsuccessful opertaion will cause an LOGException.
          * @param project The project name
          * @param serialized data of logPackageList, consist of several LogGroup
@@ -107,10 +108,11 @@ namespace sdk {
         PostLogStoreLogsResponse PostLogStoreLogPackageList(const std::string& project,
                                                             const std::string& logstore,
                                                             const std::string& packageListData,
-                                                            const std::string& hashKey = "");
+                                                            const std::string& hashKey = "",
+                                                            const std::string& compressType = LOG_LZ4);
         /** Async Put data to LOG service. Unsuccessful opertaion will cause an LOGException.
          * @param project The project name
-         * @param serialized data of logGroup, LZ4 comressed
+         * @param serialized data of logGroup, compressed with codec @compressType
          * @rawSize before compress
          * @return request_id.
          */
@@ -120,7 +122,8 @@ namespace sdk {
                               uint32_t rawSize,
                               PostLogStoreLogsClosure* callBack,
                               const std::string& hashKey = "",
-                              int64_t hashKeySeqID = kInvalidHashKeySeqID);
+                              int64_t hashKeySeqID = kInvalidHashKeySeqID,
+                              const std::string& compressType = LOG_LZ4);
         /** Async Put data to LOG service. Unsuccessful opertaion will cause an LOGException.
          * @param project The project name
          * @param serialized data of logPackageList, consist of several LogGroup
@@ -130,7 +133,8 @@ namespace sdk {
                                         const std::string& logstore,
                                         const std::string& packageListData,
                                         PostLogStoreLogsClosure* callBack,
-                                        const std::string& hashKey = "");
+                                        const std::string& hashKey = "",
+                                        const std::string& compressType = LOG_LZ4);
 
         PostLogStoreLogsResponse PostLogUsingWebTracking(const std::string& project,
                                                          const std::string& logstore,
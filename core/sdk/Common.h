@@ -142,6 +142,7 @@ namespace sdk {
     extern const char* const LOGE_SHARD_WRITE_QUOTA_EXCEED;
     extern const char* const LOGE_SHARD_READ_QUOTA_EXCEED;
     extern const char* const LOG_LZ4; //= "lz4";
+    extern const char* const LOG_ZSTD; //= "zstd";
 
     extern const char* const LOG_ERROR_CODE; //= "errorCode";
     extern const char* const LOG_ERROR_MESSAGE; //= "errorMessage";
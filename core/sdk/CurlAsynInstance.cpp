@@ -14,14 +14,26 @@
 
 #include "CurlAsynInstance.h"
 #include "Closure.h"
+#include "CurlHandlePool.h"
 #include "Exception.h"
 #include "Result.h"
 #include <curl/curl.h>
 #include <curl/multi.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include "logger/Logger.h"
 #include "app_config/AppConfig.h"
+#include "common/Flags.h"
 #include "common/TimeUtil.h"
 
+DEFINE_FLAG_INT32(curl_io_thread_count, "count of threads to send requests asynchronously", 1);
+
 using namespace std;
 
 namespace logtail {
@@ -42,19 +54,58 @@ namespace sdk {
                           curl_slist*& headers);
 
 
+    static int64_t SteadyNowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
     CurlAsynInstance::CurlAsynInstance() {
-        for (int i = 0; i < LOGTAIL_SDK_CURL_THREAD_POOL_SIZE; ++i) {
-            mMainThreads.push_back(new boost::thread(boost::bind(&CurlAsynInstance::Run, this)));
+        const int32_t threadCount = std::max(1, INT32_FLAG(curl_io_thread_count));
+        for (int32_t i = 0; i < threadCount; ++i) {
+            IoThread* ioThread = new IoThread;
+            ioThread->mMultiHandle = curl_multi_init();
+            if (ioThread->mMultiHandle == NULL) {
+                LOG_ERROR(sLogger, ("Init multi curl error", ""));
+                delete ioThread;
+                continue;
+            }
+#if defined(__linux__)
+            if (!InitEventLoop(ioThread)) {
+                curl_multi_cleanup(ioThread->mMultiHandle);
+                delete ioThread;
+                continue;
+            }
+#endif
+            ioThread->mThread = new boost::thread(boost::bind(&CurlAsynInstance::Run, this, ioThread));
+            mIoThreads.push_back(ioThread);
         }
     }
 
     CurlAsynInstance::~CurlAsynInstance() {
-        for (int i = 0; i < LOGTAIL_SDK_CURL_THREAD_POOL_SIZE; ++i) {
-            mMainThreads[i]->join();
-            delete mMainThreads[i];
+        for (auto ioThread : mIoThreads) {
+            ioThread->mThread->join();
+            delete ioThread->mThread;
+            delete ioThread;
         }
     }
 
+    void CurlAsynInstance::AddRequest(AsynRequest* request) {
+        if (mIoThreads.empty()) {
+            request->mCallBack->OnFail(request->mResponse, LOGE_UNKNOWN_ERROR, "Init curl I/O thread fail.");
+            delete request;
+            return;
+        }
+        IoThread* ioThread = mIoThreads[std::hash<std::string>()(request->mHost) % mIoThreads.size()];
+        ioThread->mRequestQueue.push(request);
+#if defined(__linux__)
+        uint64_t count = 1;
+        if (write(ioThread->mWakeupFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+            LOG_WARNING(sLogger, ("wake up curl I/O thread failed, errno", errno));
+        }
+#endif
+    }
+
     static bool AddRequestToMultiHandler(CURLM* multi_handle, AsynRequest* request) {
         curl_slist* headers = NULL;
         CURL* curl = PackCurlRequest(request->mHTTPMethod,
@@ -78,6 +129,8 @@ namespace sdk {
         curl_easy_setopt(curl, CURLOPT_PRIVATE, request);
         auto addRst = curl_multi_add_handle(multi_handle, curl);
         if (addRst != CURLM_OK) {
+            curl_slist_free_all(headers);
+            CurlHandlePool::GetInstance()->Release(request->mHost, curl, false);
             request->mCallBack->OnFail(
                 request->mResponse, LOGE_UNKNOWN_ERROR, "curl_multi_add_handle failed: " + std::to_string(addRst));
             delete request;
@@ -95,15 +148,15 @@ namespace sdk {
             case CURLE_OK:
                 break;
             case CURLE_OPERATION_TIMEDOUT:
-                curl_easy_cleanup(curl);
+                CurlHandlePool::GetInstance()->Release(request->mHost, curl, false);
                 request->mCallBack->OnFail(request->mResponse, LOGE_REQUEST_ERROR, "Request operation timeout.");
                 return;
             case CURLE_COULDNT_CONNECT:
-                curl_easy_cleanup(curl);
+                CurlHandlePool::GetInstance()->Release(request->mHost, curl, false);
                 request->mCallBack->OnFail(request->mResponse, LOGE_REQUEST_ERROR, "Can not connect to server.");
                 return;
             default:
-                curl_easy_cleanup(curl);
+                CurlHandlePool::GetInstance()->Release(request->mHost, curl, false);
                 request->mCallBack->OnFail(request->mResponse,
                                            LOGE_REQUEST_ERROR,
                                            string("Request operation failed, curl error code : ")
@@ -113,7 +166,7 @@ namespace sdk {
 
         long http_code = 0;
         if ((res = curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code)) != CURLE_OK) {
-            curl_easy_cleanup(curl);
+            CurlHandlePool::GetInstance()->Release(request->mHost, curl, false);
             request->mCallBack->OnFail(request->mResponse,
                                        LOGE_UNKNOWN_ERROR,
                                        string("Get curl response code error, curl error code : ")
@@ -121,7 +174,7 @@ namespace sdk {
             return;
         }
         request->mCallBack->mHTTPMessage.statusCode = (int32_t)http_code;
-        curl_easy_cleanup(curl);
+        CurlHandlePool::GetInstance()->Release(request->mHost, curl, true);
         if (!request->mCallBack->mHTTPMessage.IsLogServiceResponse()) {
             request->mCallBack->OnFail(request->mResponse, LOGE_REQUEST_ERROR, "Get invalid response");
             return;
@@ -184,24 +237,134 @@ namespace sdk {
         }
     }
 
-    void CurlAsynInstance::Run() {
-        CURLM* multi_handle = curl_multi_init();
-        if (multi_handle == NULL) {
-            LOG_ERROR(sLogger, ("Init multi curl error", ""));
-            return;
-        }
+    void CurlAsynInstance::Run(IoThread* ioThread) {
+#if defined(__linux__)
+        EventLoop(ioThread);
+#else
         while (true) {
             AsynRequest* request = NULL;
-            if (mRequestQueue.wait_and_pop(request)) {
-                if (!AddRequestToMultiHandler(multi_handle, request)) {
+            if (ioThread->mRequestQueue.wait_and_pop(request)) {
+                if (!AddRequestToMultiHandler(ioThread->mMultiHandle, request)) {
                     continue;
                 }
             }
-            MultiHandlerLoop(multi_handle);
+            MultiHandlerLoop(ioThread);
         }
+#endif
     }
 
-    bool CurlAsynInstance::MultiHandlerLoop(CURLM* multi_handle) {
+#if defined(__linux__)
+    // curl tells which events of socket @s it waits for, the socket is registered to epoll of
+    //  the I/O thread accordingly.
+    static int on_socket_update(CURL* easy, curl_socket_t s, int what, void* userp, void* socketp) {
+        const int epollFd = *static_cast<int*>(userp);
+        if (what == CURL_POLL_REMOVE) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, s, NULL);
+            return 0;
+        }
+        struct epoll_event event;
+        event.events = 0;
+        event.data.fd = s;
+        if (what & CURL_POLL_IN) {
+            event.events |= EPOLLIN;
+        }
+        if (what & CURL_POLL_OUT) {
+            event.events |= EPOLLOUT;
+        }
+        if (epoll_ctl(epollFd, EPOLL_CTL_MOD, s, &event) != 0) {
+            if (errno != ENOENT || epoll_ctl(epollFd, EPOLL_CTL_ADD, s, &event) != 0) {
+                LOG_ERROR(sLogger, ("register curl socket to epoll failed, errno", errno)("socket", s));
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    static int on_timer_update(CURLM* multi, long timeoutMs, void* userp) {
+        *static_cast<int64_t*>(userp) = timeoutMs < 0 ? -1 : SteadyNowMs() + timeoutMs;
+        return 0;
+    }
+
+    bool CurlAsynInstance::InitEventLoop(IoThread* ioThread) {
+        ioThread->mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+        ioThread->mWakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = ioThread->mWakeupFd;
+        if (ioThread->mEpollFd < 0 || ioThread->mWakeupFd < 0
+            || epoll_ctl(ioThread->mEpollFd, EPOLL_CTL_ADD, ioThread->mWakeupFd, &event) != 0) {
+            LOG_ERROR(sLogger, ("init curl event loop failed, errno", errno));
+            if (ioThread->mEpollFd >= 0) {
+                close(ioThread->mEpollFd);
+            }
+            if (ioThread->mWakeupFd >= 0) {
+                close(ioThread->mWakeupFd);
+            }
+            return false;
+        }
+        curl_multi_setopt(ioThread->mMultiHandle, CURLMOPT_SOCKETFUNCTION, on_socket_update);
+        curl_multi_setopt(ioThread->mMultiHandle, CURLMOPT_SOCKETDATA, &ioThread->mEpollFd);
+        curl_multi_setopt(ioThread->mMultiHandle, CURLMOPT_TIMERFUNCTION, on_timer_update);
+        curl_multi_setopt(ioThread->mMultiHandle, CURLMOPT_TIMERDATA, &ioThread->mTimerDeadlineMs);
+        return true;
+    }
+
+    void CurlAsynInstance::EventLoop(IoThread* ioThread) {
+        static const int kMaxEvents = 256;
+        // Upper bound of waiting, curl always sets a timer when there are transfers.
+        static const int64_t kMaxWaitMs = 1000;
+        struct epoll_event events[kMaxEvents];
+        CURLM* multiHandle = ioThread->mMultiHandle;
+        int running = 0;
+        while (true) {
+            int64_t waitMs = kMaxWaitMs;
+            if (ioThread->mTimerDeadlineMs >= 0) {
+                waitMs = std::max<int64_t>(0, std::min(waitMs, ioThread->mTimerDeadlineMs - SteadyNowMs()));
+            }
+            int eventCount = epoll_wait(ioThread->mEpollFd, events, kMaxEvents, (int)waitMs);
+            if (eventCount < 0) {
+                if (errno != EINTR) {
+                    LOG_ERROR(sLogger, ("epoll_wait failed, errno", errno));
+                    usleep(100 * 1000);
+                }
+                eventCount = 0;
+            }
+            for (int i = 0; i < eventCount; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == ioThread->mWakeupFd) {
+                    uint64_t count = 0;
+                    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                        LOG_WARNING(sLogger, ("read curl wakeup fd failed, errno", errno));
+                    }
+                    AsynRequest* request = NULL;
+                    while (ioThread->mRequestQueue.try_pop(request)) {
+                        AddRequestToMultiHandler(multiHandle, request);
+                    }
+                    continue;
+                }
+                int action = 0;
+                if (events[i].events & EPOLLIN) {
+                    action |= CURL_CSELECT_IN;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    action |= CURL_CSELECT_OUT;
+                }
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    action |= CURL_CSELECT_ERR;
+                }
+                curl_multi_socket_action(multiHandle, fd, action, &running);
+            }
+            if (ioThread->mTimerDeadlineMs >= 0 && SteadyNowMs() >= ioThread->mTimerDeadlineMs) {
+                // The timer is one-shot, curl sets a new one in the callback if needed.
+                ioThread->mTimerDeadlineMs = -1;
+                curl_multi_socket_action(multiHandle, CURL_SOCKET_TIMEOUT, 0, &running);
+            }
+            check_multi_info(multiHandle);
+        }
+    }
+#else
+    bool CurlAsynInstance::MultiHandlerLoop(IoThread* ioThread) {
+        CURLM* multi_handle = ioThread->mMultiHandle;
         int still_running = 1;
         /* we start some action by calling perform right away */
 
@@ -252,7 +415,7 @@ namespace sdk {
            to sleep 100ms, which is the minimum suggested value in the
            curl_multi_fdset() doc. */
             AsynRequest* request = NULL;
-            if (mRequestQueue.try_pop(request)) {
+            if (ioThread->mRequestQueue.try_pop(request)) {
                 if (AddRequestToMultiHandler(multi_handle, request)) {
                     ++still_running;
                     continue;
@@ -287,7 +450,7 @@ namespace sdk {
         }
         return true;
     }
-
+#endif
 
 } // namespace sdk
 } // namespace logtail
@@ -23,8 +23,6 @@
 namespace logtail {
 namespace sdk {
 
-#define LOGTAIL_SDK_CURL_THREAD_POOL_SIZE (1)
-
     class CurlAsynInstance {
     public:
         static CurlAsynInstance* GetInstance() {
@@ -82,15 +80,34 @@ namespace sdk {
             }
         };
 
-        void AddRequest(AsynRequest* request) { mRequestQueue.push(request); }
+        // AddRequest dispatches @request to an I/O thread by host, so requests to the same
+        //  host reuse connections cached in the same multi handle.
+        void AddRequest(AsynRequest* request);
 
-        void Run();
+    private:
+        // IoThread drives a multi handle, on Linux it waits for socket events with epoll and
+        //  calls curl_multi_socket_action only for sockets that are ready.
+        struct IoThread {
+            RequestQueue<AsynRequest*> mRequestQueue;
+            CURLM* mMultiHandle = NULL;
+            int mEpollFd = -1;
+            // Written by AddRequest to wake up epoll_wait.
+            int mWakeupFd = -1;
+            // Deadline (ms, steady clock) set by curl timer callback, -1 if no timer.
+            int64_t mTimerDeadlineMs = -1;
+            boost::thread* mThread = NULL;
+        };
 
-        bool MultiHandlerLoop(CURLM* multiHandler);
+        void Run(IoThread* ioThread);
 
-    private:
-        RequestQueue<AsynRequest*> mRequestQueue;
-        std::vector<boost::thread*> mMainThreads;
+#if defined(__linux__)
+        bool InitEventLoop(IoThread* ioThread);
+        void EventLoop(IoThread* ioThread);
+#else
+        bool MultiHandlerLoop(IoThread* ioThread);
+#endif
+
+        std::vector<IoThread*> mIoThreads;
     };
 
 } // namespace sdk
@@ -0,0 +1,97 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CurlHandlePool.h"
+#include "common/Flags.h"
+#include "logger/Logger.h"
+
+DEFINE_FLAG_INT32(curl_idle_handle_count_per_host, "max count of idle curl handles kept for each host", 64);
+
+namespace logtail {
+namespace sdk {
+
+    CurlHandlePool::CurlHandlePool() {
+        mShare = curl_share_init();
+        if (mShare == NULL) {
+            LOG_WARNING(sLogger, ("init curl share failed", "DNS and TLS session caches are not shared"));
+            return;
+        }
+        curl_share_setopt(mShare, CURLSHOPT_LOCKFUNC, LockShare);
+        curl_share_setopt(mShare, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+        curl_share_setopt(mShare, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    CurlHandlePool::~CurlHandlePool() {
+        for (auto& iter : mIdleHandles) {
+            for (CURL* curl : iter.second) {
+                curl_easy_cleanup(curl);
+            }
+        }
+        if (mShare != NULL) {
+            curl_share_cleanup(mShare);
+        }
+    }
+
+    void CurlHandlePool::LockShare(CURL* curl, curl_lock_data data, curl_lock_access access, void* userptr) {
+        static_cast<CurlHandlePool*>(userptr)->mShareLocks[data].lock();
+    }
+
+    void CurlHandlePool::UnlockShare(CURL* curl, curl_lock_data data, void* userptr) {
+        static_cast<CurlHandlePool*>(userptr)->mShareLocks[data].unlock();
+    }
+
+    CURL* CurlHandlePool::Acquire(const std::string& host) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto iter = mIdleHandles.find(host);
+            if (iter != mIdleHandles.end() && !iter->second.empty()) {
+                CURL* curl = iter->second.back();
+                iter->second.pop_back();
+                return curl;
+            }
+        }
+        CURL* curl = curl_easy_init();
+        if (curl != NULL && mShare != NULL) {
+            curl_easy_setopt(curl, CURLOPT_SHARE, mShare);
+        }
+        return curl;
+    }
+
+    void CurlHandlePool::Release(const std::string& host, CURL* curl, bool reusable) {
+        if (curl == NULL) {
+            return;
+        }
+        if (reusable) {
+            // Options are reset, live connections, caches and the share are kept.
+            curl_easy_reset(curl);
+            std::lock_guard<std::mutex> lock(mMutex);
+            std::vector<CURL*>& handles = mIdleHandles[host];
+            if (handles.size() < (size_t)INT32_FLAG(curl_idle_handle_count_per_host)) {
+                handles.push_back(curl);
+                return;
+            }
+        }
+        curl_easy_cleanup(curl);
+    }
+
+    size_t CurlHandlePool::GetIdleCount(const std::string& host) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto iter = mIdleHandles.find(host);
+        return iter == mIdleHandles.end() ? 0 : iter->second.size();
+    }
+
+} // namespace sdk
+} // namespace logtail
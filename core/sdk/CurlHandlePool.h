@@ -0,0 +1,64 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+
+namespace logtail {
+namespace sdk {
+
+    // CurlHandlePool keeps idle easy handles by host, so connections and TLS sessions cached
+    //  in a handle are reused by following requests to the same host instead of being set up
+    //  again for each request.
+    // All handles share one DNS cache and TLS session cache, so a handle new to a host can
+    //  still resume TLS sessions created by others.
+    class CurlHandlePool {
+    public:
+        static CurlHandlePool* GetInstance() {
+            static auto singleton = new CurlHandlePool;
+            return singleton;
+        }
+
+        // Acquire returns an idle handle of @host, or a new one if there is none.
+        CURL* Acquire(const std::string& host);
+
+        // Release gives @curl back to the pool. Handles which are not @reusable (request
+        //  failed, connection may be broken) or exceed the idle limit are cleaned up.
+        void Release(const std::string& host, CURL* curl, bool reusable);
+
+        size_t GetIdleCount(const std::string& host);
+
+    private:
+        CurlHandlePool();
+        ~CurlHandlePool();
+
+        static void LockShare(CURL* curl, curl_lock_data data, curl_lock_access access, void* userptr);
+        static void UnlockShare(CURL* curl, curl_lock_data data, void* userptr);
+
+        CURLSH* mShare = NULL;
+        std::mutex mShareLocks[CURL_LOCK_DATA_LAST];
+
+        std::mutex mMutex;
+        std::unordered_map<std::string, std::vector<CURL*>> mIdleHandles;
+    };
+
+} // namespace sdk
+} // namespace logtail
@@ -15,6 +15,7 @@
 #include "CurlImp.h"
 #include "Exception.h"
 #include "CurlAsynInstance.h"
+#include "CurlHandlePool.h"
 #include "DNSCache.h"
 #include "app_config/AppConfig.h"
 #include <curl/curl.h>
@@ -84,7 +85,7 @@ namespace sdk {
                           curl_slist*& headers) {
         static DnsCache* dnsCache = DnsCache::GetInstance();
 
-        CURL* curl = curl_easy_init();
+        CURL* curl = CurlHandlePool::GetInstance()->Acquire(host);
         if (curl == NULL)
             return NULL;
 
@@ -161,15 +162,15 @@ namespace sdk {
             case CURLE_OK:
                 break;
             case CURLE_OPERATION_TIMEDOUT:
-                curl_easy_cleanup(curl);
+                CurlHandlePool::GetInstance()->Release(host, curl, false);
                 throw LOGException(LOGE_CLIENT_OPERATION_TIMEOUT, "Request operation timeout.");
                 break;
             case CURLE_COULDNT_CONNECT:
-                curl_easy_cleanup(curl);
+                CurlHandlePool::GetInstance()->Release(host, curl, false);
                 throw LOGException(LOGE_REQUEST_TIMEOUT, "Can not connect to server.");
                 break;
             default:
-                curl_easy_cleanup(curl);
+                CurlHandlePool::GetInstance()->Release(host, curl, false);
                 throw LOGException(LOGE_REQUEST_ERROR,
                                    string("Request operation failed, curl error code : ") + curl_easy_strerror(res));
                 break;
@@ -177,12 +178,12 @@ namespace sdk {
 
         long http_code = 0;
         if ((res = curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code)) != CURLE_OK) {
-            curl_easy_cleanup(curl);
+            CurlHandlePool::GetInstance()->Release(host, curl, false);
             throw LOGException(LOGE_UNKNOWN_ERROR,
                                string("Get curl response code error, curl error code : ") + curl_easy_strerror(res));
         }
         httpMessage.statusCode = (int32_t)http_code;
-        curl_easy_cleanup(curl);
+        CurlHandlePool::GetInstance()->Release(host, curl, true);
         if (!httpMessage.IsLogServiceResponse()) {
             throw LOGException(LOGE_REQUEST_ERROR, "Get invalid response");
         }
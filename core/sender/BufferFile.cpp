@@ -0,0 +1,252 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BufferFile.h"
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_MSC_VER)
+#include <io.h>
+#endif
+#include "common/ErrorUtil.h"
+#include "common/FileSystemUtil.h"
+#include "common/StringTools.h"
+
+namespace logtail {
+
+BufferFileWriter::~BufferFileWriter() {
+    Close();
+}
+
+bool BufferFileWriter::Open(const std::string& fileName, const std::string& header) {
+    Close();
+    FILE* file = FileAppendOpen(fileName.c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+    // Batches are written with one fwrite, nothing is left in stdio buffer if it fails, so the
+    //  file can be truncated to drop the partial batch.
+    setvbuf(file, NULL, _IONBF, 0);
+    FSeek(file, 0, SEEK_END);
+    mFile = file;
+    mFileName = fileName;
+    mFileSize = FTell(file);
+    if (mFileSize <= 0) {
+        mFileSize = 0;
+        mPending.append(header);
+    }
+    return true;
+}
+
+void BufferFileWriter::Close() {
+    if (mFile == NULL) {
+        return;
+    }
+    std::string errorMessage;
+    Commit(false, errorMessage);
+    // Records which can not be written are dropped with the file.
+    mPending.clear();
+    mPendingCount = 0;
+    fclose(mFile);
+    mFile = NULL;
+    mFileName.clear();
+    mFileSize = 0;
+}
+
+void BufferFileWriter::Append(const EncryptionStateMeta& meta,
+                              const std::string& encodedInfo,
+                              const char* data,
+                              int32_t dataSize) {
+    mPending.append((const char*)&meta, sizeof(meta));
+    mPending.append(encodedInfo);
+    mPending.append(data, dataSize);
+    ++mPendingCount;
+}
+
+bool BufferFileWriter::Commit(bool sync, std::string& errorMessage) {
+    if (mPending.empty()) {
+        return true;
+    }
+    size_t nbytes = fwrite(mPending.data(), 1, mPending.size(), mFile);
+    if (nbytes != mPending.size() || fflush(mFile) != 0) {
+        errorMessage = std::string("write file error:") + mFileName + ", error:" + ErrnoToString(GetErrno())
+            + ", nbytes:" + ToString(nbytes) + ", records:" + ToString(mPendingCount);
+        // Drop the partial batch, or the reader meets a torn record, and keep pending records
+        //  to retry with next commit.
+        if (nbytes > 0 && !rollbackPartialWrite()) {
+            errorMessage += std::string(", truncate error:") + ErrnoToString(GetErrno());
+            mFileSize += nbytes;
+            mPending.clear();
+            mPendingCount = 0;
+        }
+        return false;
+    }
+    bool result = true;
+    if (sync) {
+#if defined(__linux__)
+        int ret = fdatasync(fileno(mFile));
+#elif defined(_MSC_VER)
+        int ret = _commit(_fileno(mFile));
+#endif
+        if (ret != 0) {
+            errorMessage = std::string("sync file error:") + mFileName + ", error:" + ErrnoToString(GetErrno());
+            result = false;
+        }
+    }
+    mFileSize += nbytes;
+    // Keep capacity for next batch.
+    mPending.clear();
+    mPendingCount = 0;
+    return result;
+}
+
+bool BufferFileWriter::rollbackPartialWrite() {
+#if defined(__linux__)
+    return ftruncate(fileno(mFile), mFileSize) == 0;
+#elif defined(_MSC_VER)
+    return _chsize_s(_fileno(mFile), mFileSize) == 0;
+#endif
+}
+
+BufferFileReader::~BufferFileReader() {
+    Close();
+}
+
+bool BufferFileReader::Open(const std::string& fileName, int32_t pos) {
+    Close();
+    mFile = FileReadOnlyOpen(fileName.c_str(), "rb");
+    if (!mFile) {
+        return false;
+    }
+    mFileName = fileName;
+    mRecordPos = mReadPos = mNextPos = pos;
+    if (FSeek(mFile, pos, SEEK_SET) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void BufferFileReader::Close() {
+    if (mFile != NULL) {
+        fclose(mFile);
+        mFile = NULL;
+    }
+#if defined(__linux__)
+    if (mWriteFd >= 0) {
+        close(mWriteFd);
+        mWriteFd = -1;
+    }
+#elif defined(_MSC_VER)
+    if (mWriteFile != NULL) {
+        fclose(mWriteFile);
+        mWriteFile = NULL;
+    }
+#endif
+}
+
+bool BufferFileReader::ReadMeta(EncryptionStateMeta& meta, int32_t& encodedInfoSize, std::string& errorMessage) {
+    errorMessage.clear();
+    // Skip body of previous record if it is not read.
+    if (mReadPos != mNextPos) {
+        if (FSeek(mFile, mNextPos, SEEK_SET) != 0) {
+            errorMessage
+                = std::string("seek file error, error:") + ErrnoToString(GetErrno()) + ", pos:" + ToString(mNextPos);
+            return false;
+        }
+        mReadPos = mNextPos;
+    }
+    auto nbytes = fread(static_cast<void*>(&meta), sizeof(char), sizeof(meta), mFile);
+    if (nbytes == 0 && feof(mFile)) {
+        return false;
+    }
+    if (nbytes != sizeof(meta)) {
+        errorMessage = std::string("read encryption file meta error, error:") + ErrnoToString(GetErrno())
+            + ", nbytes:" + ToString(nbytes) + ", pos:" + ToString(mReadPos);
+        return false;
+    }
+    encodedInfoSize = meta.mEncodedInfoSize;
+    if (encodedInfoSize > BUFFER_META_BASE_SIZE) {
+        encodedInfoSize -= BUFFER_META_BASE_SIZE;
+    }
+    if (meta.mEncryptionSize < 0 || encodedInfoSize < 0) {
+        errorMessage = std::string("meta of encryption file invalid, meta.mEncryptionSize:")
+            + ToString(meta.mEncryptionSize) + ", meta.mEncodedInfoSize:" + ToString(meta.mEncodedInfoSize);
+        return false;
+    }
+    mRecordPos = mReadPos;
+    mReadPos += sizeof(meta);
+    mNextPos = mReadPos + encodedInfoSize + meta.mEncryptionSize;
+    return true;
+}
+
+bool BufferFileReader::ReadBody(int32_t encodedInfoSize,
+                                int32_t encryptionSize,
+                                std::string& encodedInfo,
+                                std::string& encryption,
+                                std::string& errorMessage) {
+    encodedInfo.resize(encodedInfoSize);
+    auto nbytes = encodedInfoSize > 0 ? fread(&encodedInfo[0], sizeof(char), encodedInfoSize, mFile) : 0;
+    mReadPos += nbytes;
+    if (nbytes != static_cast<size_t>(encodedInfoSize)) {
+        errorMessage = std::string("read encoded info from file error, error:") + ErrnoToString(GetErrno())
+            + ", encodedInfoSize:" + ToString(encodedInfoSize) + ", nbytes:" + ToString(nbytes);
+        return false;
+    }
+    encryption.resize(encryptionSize);
+    nbytes = encryptionSize > 0 ? fread(&encryption[0], sizeof(char), encryptionSize, mFile) : 0;
+    mReadPos += nbytes;
+    if (nbytes != static_cast<size_t>(encryptionSize)) {
+        errorMessage = std::string("read encryption from file error, error:") + ErrnoToString(GetErrno())
+            + ", meta.mEncryptionSize:" + ToString(encryptionSize) + ", nbytes:" + ToString(nbytes);
+        return false;
+    }
+    return true;
+}
+
+bool BufferFileReader::WriteBackMeta(const EncryptionStateMeta& meta, std::string& errorMessage) {
+#if defined(__linux__)
+    if (mWriteFd < 0) {
+        mWriteFd = open(mFileName.c_str(), O_WRONLY);
+        if (mWriteFd < 0) {
+            errorMessage = std::string("open secondary file for write meta fail:") + mFileName + ",reason:"
+                + ErrnoToString(GetErrno());
+            return false;
+        }
+    }
+    if (pwrite(mWriteFd, &meta, sizeof(meta), mRecordPos) != (ssize_t)sizeof(meta)) {
+        errorMessage = std::string("write secondary file for write meta fail:") + mFileName + ",reason:"
+            + ErrnoToString(GetErrno());
+        return false;
+    }
+#elif defined(_MSC_VER)
+    if (mWriteFile == NULL) {
+        mWriteFile = FileWriteOnlyOpen(mFileName.c_str(), "wb");
+        if (mWriteFile == NULL) {
+            errorMessage = std::string("open secondary file for write meta fail:") + mFileName + ",reason:"
+                + ErrnoToString(GetErrno());
+            return false;
+        }
+    }
+    if (FSeek(mWriteFile, mRecordPos, SEEK_SET) != 0 || fwrite(&meta, 1, sizeof(meta), mWriteFile) != sizeof(meta)
+        || fflush(mWriteFile) != 0) {
+        errorMessage = std::string("write secondary file for write meta fail:") + mFileName + ",reason:"
+            + ErrnoToString(GetErrno());
+        return false;
+    }
+#endif
+    return true;
+}
+
+} // namespace logtail
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace logtail {
+
+// mEncodedInfoSize of records whose encoded info is LogtailBufferMeta is added by this,
+//  encoded info of old records is project name.
+const int32_t BUFFER_META_BASE_SIZE = 65536;
+
+// Meta of each record in encryption buffer file, followed by encoded info and encrypted
+//  data. It is written back in place when the record is handled.
+struct EncryptionStateMeta {
+    int32_t mLogDataSize;
+    int32_t mEncryptionSize;
+    int32_t mEncodedInfoSize;
+    int32_t mTimeStamp;
+    int32_t mHandled;
+    int32_t mRetryTime;
+};
+
+// BufferFileWriter appends records to a buffer file, which is one segment of the local
+//  secondary buffer. The file is kept open until it is closed or another file is opened,
+//  records are encoded into a pending batch and written with one write by Commit.
+// It is not thread-safe.
+class BufferFileWriter {
+public:
+    BufferFileWriter() = default;
+    ~BufferFileWriter();
+
+    // Open closes current file and opens @fileName for append, @header is written first
+    //  if the file is empty.
+    bool Open(const std::string& fileName, const std::string& header);
+    // Close commits pending records and closes current file, records failed to write are dropped.
+    void Close();
+    bool IsOpen() const { return mFile != NULL; }
+    const std::string& GetFileName() const { return mFileName; }
+    // GetFileSize returns the size of current file, including pending records.
+    int64_t GetFileSize() const { return mFileSize + (int64_t)mPending.size(); }
+    size_t GetPendingCount() const { return mPendingCount; }
+
+    // Append encodes a record into the pending batch.
+    void Append(const EncryptionStateMeta& meta, const std::string& encodedInfo, const char* data, int32_t dataSize);
+    // Commit writes pending records to file, and flushes them to disk if @sync is true.
+    //  If the write fails, the file is truncated to its size before the commit and pending records
+    //  are kept for next commit, @errorMessage is set then. Pending records are dropped only if
+    //  the file can not be truncated.
+    bool Commit(bool sync, std::string& errorMessage);
+
+private:
+    BufferFileWriter(const BufferFileWriter&) = delete;
+    BufferFileWriter& operator=(const BufferFileWriter&) = delete;
+
+    // Truncate current file to mFileSize, the size before a failed commit.
+    bool rollbackPartialWrite();
+
+    FILE* mFile = NULL;
+    std::string mFileName;
+    int64_t mFileSize = 0;
+    // Encoded records not written yet, reused between batches.
+    std::string mPending;
+    size_t mPendingCount = 0;
+};
+
+// BufferFileReader reads records of a buffer file sequentially with the file kept open,
+//  and writes metas of handled records back in place.
+// It is not thread-safe.
+class BufferFileReader {
+public:
+    BufferFileReader() = default;
+    ~BufferFileReader();
+
+    // Open opens @fileName and seeks to the first record at @pos.
+    bool Open(const std::string& fileName, int32_t pos);
+    void Close();
+    const std::string& GetFileName() const { return mFileName; }
+    // GetPosition returns the offset of next record.
+    int32_t GetPosition() const { return mNextPos; }
+
+    // ReadMeta reads the meta of next record, @encodedInfoSize is set to the actual size of
+    //  encoded info. It returns false at the end of file, or if the meta is broken and
+    //  @errorMessage is set then.
+    bool ReadMeta(EncryptionStateMeta& meta, int32_t& encodedInfoSize, std::string& errorMessage);
+    // ReadBody reads the encoded info and encrypted data of the record whose meta was just read,
+    //  it must be called right after ReadMeta. The record is skipped if it is not called.
+    bool ReadBody(int32_t encodedInfoSize,
+                  int32_t encryptionSize,
+                  std::string& encodedInfo,
+                  std::string& encryption,
+                  std::string& errorMessage);
+    // WriteBackMeta overwrites the meta of the record whose meta was just read.
+    bool WriteBackMeta(const EncryptionStateMeta& meta, std::string& errorMessage);
+
+private:
+    BufferFileReader(const BufferFileReader&) = delete;
+    BufferFileReader& operator=(const BufferFileReader&) = delete;
+
+    FILE* mFile = NULL;
+#if defined(__linux__)
+    int mWriteFd = -1;
+#elif defined(_MSC_VER)
+    FILE* mWriteFile = NULL;
+#endif
+    std::string mFileName;
+    // Offset of the record whose meta was just read.
+    int32_t mRecordPos = 0;
+    // Offset of file stream, and offset of next record.
+    int32_t mReadPos = 0;
+    int32_t mNextPos = 0;
+};
+
+} // namespace logtail
@@ -24,6 +24,7 @@
 #include "common/Constants.h"
 #include "common/StringTools.h"
 #include "common/CompressTools.h"
+#include "ZstdDictionaryManager.h"
 #include "common/FileEncryption.h"
 #include "common/ExceptionBase.h"
 #include "common/FileSystemUtil.h"
@@ -97,13 +98,19 @@ DEFINE_FLAG_INT32(reset_region_concurrency_error_count,
 DEFINE_FLAG_INT32(unknow_error_try_max, "discard data when try times > this value", 5);
 DEFINE_FLAG_INT32(test_unavailable_endpoint_interval, "test unavailable endpoint interval", 60);
 DEFINE_FLAG_INT32(sending_cost_time_alarm_interval, "sending log group cost too much time, second", 10);
+DEFINE_FLAG_BOOL(enable_buffer_file_zstd_dict,
+                  "store buffer files compressed by zstd with dictionaries trained for each logstore",
+                  false);
+DEFINE_FLAG_BOOL(enable_buffer_file_fsync,
+                 "fsync buffer file after each batch of log groups is written to it, disabled by default since "
+                 "it is only needed to survive power failure",
+                 false);
 DEFINE_FLAG_INT32(log_group_wait_in_queue_alarm_interval,
                   "log group wait in queue alarm interval, may blocked by concurrency or quota, second",
                   10);
 
 namespace logtail {
 const string Sender::BUFFER_FILE_NAME_PREFIX = "logtail_buffer_file_";
-const int32_t Sender::BUFFER_META_BASE_SIZE = 65536;
 
 std::atomic_int gNetworkErrorCount{0};
 
@@ -403,9 +410,12 @@ Sender* Sender::Instance() {
 }
 
 ///////////////////////////////for debug & ut//////////////////////////////////
-bool Sender::ParseLogGroupFromLZ4(const std::string& logData, int32_t rawSize, LogGroup& logGroupPb) {
+bool Sender::ParseLogGroupFromLZ4(const std::string& logData,
+                                  int32_t rawSize,
+                                  LogGroup& logGroupPb,
+                                  CompressType compressType) {
     string uncompressed;
-    if (!UncompressLz4(logData, rawSize, uncompressed)) {
+    if (!UncompressData(compressType, logData, rawSize, uncompressed)) {
         LOG_ERROR(sLogger, ("uncompress logData", "fail")("rawSize", rawSize));
         return false;
     }
@@ -419,10 +429,11 @@ bool Sender::ParseLogGroupFromLZ4(const std::string& logData, int32_t rawSize, L
 void Sender::ParseLogGroupFromString(const std::string& logData,
                                      SEND_DATA_TYPE dataType,
                                      int32_t rawSize,
-                                     std::vector<sls_logs::LogGroup>& logGroupVec) {
+                                     std::vector<sls_logs::LogGroup>& logGroupVec,
+                                     CompressType compressType) {
     if (dataType == LOGGROUP_LZ4_COMPRESSED) {
         LogGroup logGroupPb;
-        if (Sender::ParseLogGroupFromLZ4(logData, rawSize, logGroupPb))
+        if (Sender::ParseLogGroupFromLZ4(logData, rawSize, logGroupPb, compressType))
             logGroupVec.push_back(logGroupPb);
         else
             LOG_ERROR(sLogger, ("ParseLogGroupFromLZ4", "fail")("dataType", dataType));
@@ -433,7 +444,8 @@ void Sender::ParseLogGroupFromString(const std::string& logData,
                 LogGroup logGroupPb;
                 if (Sender::ParseLogGroupFromLZ4(logPackageList.packages(pIdx).data(),
                                                  logPackageList.packages(pIdx).uncompress_size(),
-                                                 logGroupPb))
+                                                 logGroupPb,
+                                                 compressType))
                     logGroupVec.push_back(logGroupPb);
                 else
                     LOG_ERROR(sLogger, ("ParseLogGroupFromLZ4", "fail")("dataType", dataType));
@@ -503,7 +515,8 @@ bool Sender::DumpDebugFile(LoggroupTimeValue* value, bool sendPerformance) {
         return WriteToFile(value, sendPerformance);
     else {
         vector<LogGroup> logGroupVec;
-        Sender::ParseLogGroupFromString(value->mLogData, value->mDataType, value->mRawSize, logGroupVec);
+        Sender::ParseLogGroupFromString(
+            value->mLogData, value->mDataType, value->mRawSize, logGroupVec, value->mCompressType);
         for (vector<LogGroup>::iterator iter = logGroupVec.begin(); iter != logGroupVec.end(); ++iter) {
             if (!WriteToFile(value->mProjectName, *iter, sendPerformance))
                 return false;
@@ -749,8 +762,7 @@ bool Sender::LoadFileToSend(time_t timeLine, std::vector<std::string>& filesToSe
     sort(filesToSend.begin(), filesToSend.end());
     return true;
 }
-bool Sender::ReadNextEncryption(int32_t& pos,
-                                const std::string& filename,
+bool Sender::ReadNextEncryption(BufferFileReader& reader,
                                 std::string& encryption,
                                 EncryptionStateMeta& meta,
                                 bool& readResult,
@@ -758,67 +770,19 @@ bool Sender::ReadNextEncryption(int32_t& pos,
     bufferMeta.Clear();
     readResult = false;
     encryption.clear();
-    int retryTimes = 0;
-
-    FILE* fin = NULL;
-    while (true) {
-        retryTimes++;
-        fin = FileReadOnlyOpen(filename.c_str(), "rb");
-        if (fin)
-            break;
-        if (retryTimes >= 3) {
-            string errorStr = ErrnoToString(GetErrno());
-            LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                                   string("open file error:") + filename + ",error:" + errorStr);
-            LOG_ERROR(sLogger, ("open file error", filename)("error", errorStr));
-            return false;
+    const string& filename = reader.GetFileName();
+    int32_t encodedInfoSize = 0;
+    string errorMessage;
+    if (!reader.ReadMeta(meta, encodedInfoSize, errorMessage)) {
+        if (!errorMessage.empty()) {
+            LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM, errorMessage + ", file:" + filename);
+            LOG_ERROR(sLogger, ("read buffer file error", filename)("error", errorMessage));
         }
-        usleep(5000);
-    }
-    fseek(fin, 0, SEEK_END);
-    auto const currentSize = ftell(fin);
-    if (currentSize == pos) {
-        fclose(fin);
-        return false;
-    }
-    fseek(fin, pos, SEEK_SET);
-    auto nbytes = fread(static_cast<void*>(&meta), sizeof(char), sizeof(meta), fin);
-    if (nbytes != sizeof(meta)) {
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("read encryption file meta error:") + filename
-                                                   + ", error:" + errorStr + ", meta.mEncryptionSize:"
-                                                   + ToString(meta.mEncryptionSize) + ", nbytes: " + ToString(nbytes)
-                                                   + ", pos: " + ToString(pos) + ", ftell: " + ToString(currentSize));
-        LOG_ERROR(sLogger,
-                  ("read encryption file meta error",
-                   filename)("error", errorStr)("nbytes", nbytes)("pos", pos)("ftell", currentSize));
-        fclose(fin);
-        return false;
-    }
-
-    bool pbMeta = false;
-    int32_t encodedInfoSize = meta.mEncodedInfoSize;
-    if (encodedInfoSize > BUFFER_META_BASE_SIZE) {
-        encodedInfoSize -= BUFFER_META_BASE_SIZE;
-        pbMeta = true;
-    }
-
-    if (meta.mEncryptionSize < 0 || encodedInfoSize < 0) {
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("meta of encryption file invalid:" + filename
-                                                      + ", meta.mEncryptionSize:" + ToString(meta.mEncryptionSize)
-                                                      + ", meta.mEncodedInfoSize:" + ToString(meta.mEncodedInfoSize)));
-        LOG_ERROR(sLogger,
-                  ("meta of encryption file invalid", filename)("meta.mEncryptionSize", meta.mEncryptionSize)(
-                      "meta.mEncodedInfoSize", meta.mEncodedInfoSize));
-        fclose(fin);
         return false;
     }
+    const bool pbMeta = meta.mEncodedInfoSize > BUFFER_META_BASE_SIZE;
 
-    pos += sizeof(meta) + encodedInfoSize + meta.mEncryptionSize;
     if ((time(NULL) - meta.mTimeStamp) > INT32_FLAG(log_expire_time) || meta.mHandled == 1) {
-        fclose(fin);
         if (meta.mHandled != 1) {
             LOG_WARNING(sLogger, ("timeout buffer file, meta.mTimeStamp", meta.mTimeStamp));
             LogtailAlarm::GetInstance()->SendAlarm(DISCARD_SECONDARY_ALARM,
@@ -827,30 +791,20 @@ bool Sender::ReadNextEncryption(int32_t& pos,
         return true;
     }
 
-    char* buffer = new char[encodedInfoSize + 1];
-    nbytes = fread(buffer, sizeof(char), encodedInfoSize, fin);
-    if (nbytes != static_cast<size_t>(encodedInfoSize)) {
-        fclose(fin);
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("read projectname from file error:") + filename
-                                                   + ", error:" + errorStr + ", meta.mEncodedInfoSize:"
-                                                   + ToString(meta.mEncodedInfoSize) + ", nbytes:" + ToString(nbytes));
-        LOG_ERROR(sLogger,
-                  ("read encodedInfo from file error",
-                   filename)("error", errorStr)("meta.mEncodedInfoSize", meta.mEncodedInfoSize)("nbytes", nbytes));
-        delete[] buffer;
+    string encodedInfo;
+    if (!reader.ReadBody(encodedInfoSize, meta.mEncryptionSize, encodedInfo, encryption, errorMessage)) {
+        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM, errorMessage + ", file:" + filename);
+        LOG_ERROR(sLogger, ("read buffer file error", filename)("error", errorMessage));
+        encryption.clear();
         return true;
     }
-    string encodedInfo = string(buffer, encodedInfoSize);
-    delete[] buffer;
     if (pbMeta) {
         if (!bufferMeta.ParseFromString(encodedInfo)) {
-            fclose(fin);
             LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
                                                    string("parse buffer meta from file error:") + filename);
             LOG_ERROR(sLogger, ("parse buffer meta from file error", filename)("buffer meta", encodedInfo));
             bufferMeta.Clear();
+            encryption.clear();
             return true;
         }
     } else {
@@ -858,26 +812,7 @@ bool Sender::ReadNextEncryption(int32_t& pos,
         bufferMeta.set_endpoint(AppConfig::GetInstance()->GetDefaultRegion()); // new mode
         bufferMeta.set_aliuid("");
     }
-
-    buffer = new char[meta.mEncryptionSize + 1];
-    nbytes = fread(buffer, sizeof(char), meta.mEncryptionSize, fin);
-    if (nbytes != static_cast<size_t>(meta.mEncryptionSize)) {
-        fclose(fin);
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("read encryption from file error:") + filename
-                                                   + ",error:" + errorStr + ",meta.mEncryptionSize:"
-                                                   + ToString(meta.mEncryptionSize) + ", nbytes:" + ToString(nbytes));
-        LOG_ERROR(sLogger,
-                  ("read encryption from file error",
-                   filename)("error", errorStr)("meta.mEncryptionSize", meta.mEncryptionSize)("nbytes", nbytes));
-        delete[] buffer;
-        return true;
-    }
-    encryption = string(buffer, meta.mEncryptionSize);
     readResult = true;
-    delete[] buffer;
-    fclose(fin);
     return true;
 }
 
@@ -898,6 +833,10 @@ void Sender::DaemonBufferSender() {
             sleep(mCheckPeriod);
             continue;
         }
+        if (filesToSend.empty()) {
+            // Dictionaries of previous runs are only used by buffer files created before.
+            ZstdDictionaryManager::GetInstance()->RemoveUnusedDictionaries(GetBufferFilePath());
+        }
         mIsSendingBuffer = true;
         int32_t fileToSendCount = int32_t(filesToSend.size());
         int32_t bufferFileNumValue = AppConfig::GetInstance()->GetNumOfBufferFile();
@@ -953,10 +892,21 @@ void Sender::SendEncryptionBuffer(const std::string& filename, int32_t keyVersio
     EncryptionStateMeta meta;
     bool readResult;
     bool writeBack = false;
-    int32_t pos = INT32_FLAG(file_encryption_header_length);
     LogtailBufferMeta bufferMeta;
     int32_t discardCount = 0;
-    while (ReadNextEncryption(pos, filename, encryption, meta, readResult, bufferMeta)) {
+    // The file is read sequentially with one open, handled metas are written back in place.
+    BufferFileReader reader;
+    for (int retryTimes = 1; !reader.Open(filename, INT32_FLAG(file_encryption_header_length)); ++retryTimes) {
+        if (retryTimes >= 3) {
+            string errorStr = ErrnoToString(GetErrno());
+            LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
+                                                   string("open file error:") + filename + ",error:" + errorStr);
+            LOG_ERROR(sLogger, ("open file error", filename)("error", errorStr));
+            return;
+        }
+        usleep(5000);
+    }
+    while (ReadNextEncryption(reader, encryption, meta, readResult, bufferMeta)) {
         logData.clear();
         bool sendResult = false;
         if (!readResult || bufferMeta.project().empty()) {
@@ -966,9 +916,10 @@ void Sender::SendEncryptionBuffer(const std::string& filename, int32_t keyVersio
             discardCount++;
         }
         if (!sendResult) {
-            char* des = new char[meta.mLogDataSize];
+            // Decrypt to logData directly, its buffer is reused by records.
+            logData.resize(meta.mLogDataSize);
             if (!FileEncryption::GetInstance()->Decrypt(
-                    encryption.c_str(), meta.mEncryptionSize, des, meta.mLogDataSize, keyVersion)) {
+                    encryption.c_str(), meta.mEncryptionSize, &logData[0], meta.mLogDataSize, keyVersion)) {
                 sendResult = true;
                 discardCount++;
                 LOG_ERROR(sLogger,
@@ -979,11 +930,10 @@ void Sender::SendEncryptionBuffer(const std::string& filename, int32_t keyVersio
                                                               + ", key_version:" + ToString(keyVersion)
                                                               + ", meta.mLogDataSize:" + ToString(meta.mLogDataSize)));
             } else {
-                if (bufferMeta.has_logstore())
-                    logData = string(des, meta.mLogDataSize);
-                else {
+                if (!bufferMeta.has_logstore()) {
                     // compatible to old buffer file (logGroup string), convert to LZ4 compressed
-                    string logGroupStr = string(des, meta.mLogDataSize);
+                    string logGroupStr;
+                    logGroupStr.swap(logData);
                     LogGroup logGroup;
                     if (!logGroup.ParseFromString(logGroupStr)) {
                         sendResult = true;
@@ -1006,6 +956,13 @@ void Sender::SendEncryptionBuffer(const std::string& filename, int32_t keyVersio
                         bufferMeta.set_rawsize(meta.mLogDataSize);
                     }
                 }
+                if (!sendResult && bufferMeta.dictid() != 0 && !UncompressWithDictionary(bufferMeta, logData)) {
+                    sendResult = true;
+                    LOG_ERROR(sLogger,
+                              ("uncompress buffer data with zstd dictionary fail, projectName is",
+                               bufferMeta.project())("dictionary id", bufferMeta.dictid()));
+                    discardCount++;
+                }
                 if (!sendResult) {
                     string errorCode;
                     SendResult res = SendBufferFileData(bufferMeta, logData, errorCode);
@@ -1025,23 +982,22 @@ void Sender::SendEncryptionBuffer(const std::string& filename, int32_t keyVersio
                         sleep(INT32_FLAG(quota_exceed_wait_interval));
                 }
             }
-            delete[] des;
         }
-        if (sendResult)
-            meta.mHandled = 1;
         LOG_DEBUG(sLogger,
                   ("send LogGroup from local buffer file", filename)("rawsize", bufferMeta.rawsize())("sendResult",
                                                                                                       sendResult));
-        WriteBackMeta(pos - meta.mEncryptionSize - sizeof(meta)
-                          - (meta.mEncodedInfoSize > BUFFER_META_BASE_SIZE
-                                 ? (meta.mEncodedInfoSize - BUFFER_META_BASE_SIZE)
-                                 : meta.mEncodedInfoSize),
-                      (char*)&meta,
-                      sizeof(meta),
-                      filename);
-        if (!sendResult)
+        if (sendResult) {
+            // only changed meta is written back
+            meta.mHandled = 1;
+            string errorMessage;
+            if (!reader.WriteBackMeta(meta, errorMessage)) {
+                LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM, errorMessage);
+                LOG_ERROR(sLogger, ("can not write back meta", filename)("error", errorMessage));
+            }
+        } else
             writeBack = true;
     }
+    reader.Close();
     if (!writeBack) {
         remove(filename.c_str());
         if (discardCount > 0) {
@@ -1078,52 +1034,6 @@ bool Sender::CreateNewFile() {
     return true;
 }
 
-bool Sender::WriteBackMeta(int32_t pos, const void* buf, int32_t length, const string& filename) {
-    // TODO: Why not use fopen or fstream???
-    // TODO: Make sure and merge them.
-#if defined(__linux__)
-    int fd = open(filename.c_str(), O_WRONLY);
-    if (fd < 0) {
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("open secondary file for write meta fail:") + filename
-                                                   + ",reason:" + errorStr);
-        LOG_ERROR(sLogger, ("open file error", filename));
-        return false;
-    }
-    lseek(fd, pos, SEEK_SET);
-    if (write(fd, buf, length) < 0) {
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("write secondary file for write meta fail:") + filename
-                                                   + ",reason:" + errorStr);
-        LOG_ERROR(sLogger, ("can not write back meta", filename));
-    }
-    close(fd);
-    return true;
-#elif defined(_MSC_VER)
-    FILE* f = FileWriteOnlyOpen(filename.c_str(), "wb");
-    if (!f) {
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("open secondary file for write meta fail:") + filename
-                                                   + ",reason:" + errorStr);
-        LOG_ERROR(sLogger, ("open file error", filename));
-        return false;
-    }
-    fseek(f, pos, SEEK_SET);
-    auto nbytes = fwrite(buf, 1, length, f);
-    if (nbytes != length) {
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("write secondary file for write meta fail:") + filename
-                                                   + ",reason:" + errorStr);
-        LOG_ERROR(sLogger, ("can not write back meta", filename));
-    }
-    fclose(f);
-    return true;
-#endif
-}
 bool Sender::RemoveSender() {
     mBufferSenderThreadIsRunning = false;
     mSenderQueue.Signal();
@@ -1180,8 +1090,14 @@ void Sender::WriteSecondary() {
                 LOG_DEBUG(sLogger, ("Write LogGroup to Secondary File, logs", (*itr)->mLogLines));
                 delete *itr;
             }
+            // group commit: log groups dumped in this round are written with one write
+            FlushBufferFile();
             logGroupToDump.clear();
         }
+        // buffer file replaced by CreateNewFile is closed, then it can be read and deleted by SendBufferThread
+        if (mBufferFileWriter.IsOpen() && mBufferFileWriter.GetFileName() != GetBufferFileName()) {
+            mBufferFileWriter.Close();
+        }
     }
     LOG_INFO(sLogger, ("DumpSecondaryThread", "exit"));
 }
@@ -1426,34 +1342,29 @@ bool Sender::SendToBufferFile(LoggroupTimeValue* dataPtr) {
         CreateNewFile();
         bufferFileName = GetBufferFileName();
     }
-    // if file not exist, create it new
-    FILE* fout = FileAppendOpen(bufferFileName.c_str(), "ab");
-    if (!fout) {
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("open file error:") + bufferFileName + ",error:" + errorStr);
-        LOG_ERROR(sLogger, ("open buffer file error", bufferFileName));
-        return false;
-    }
-
-    if (ftell(fout) == (streampos)0) {
-        string header = GetBufferFileHeader();
-        auto nbytes = fwrite(header.c_str(), 1, header.size(), fout);
-        if (header.size() != nbytes) {
+    // if file not exist, create it new; records of previous file are committed before it is closed
+    if (mBufferFileWriter.GetFileName() != bufferFileName) {
+        FlushBufferFile();
+        if (!mBufferFileWriter.Open(bufferFileName, GetBufferFileHeader())) {
             string errorStr = ErrnoToString(GetErrno());
             LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                                   string("write file error:") + bufferFileName + ", error:" + errorStr
-                                                       + ", nbytes:" + ToString(nbytes));
-            LOG_ERROR(sLogger, ("error write encryption header", bufferFileName)("error", errorStr)("nbytes", nbytes));
-            fclose(fout);
+                                                   string("open file error:") + bufferFileName + ",error:" + errorStr);
+            LOG_ERROR(sLogger, ("open buffer file error", bufferFileName));
             return false;
         }
     }
 
+    // Only log groups are stored with dictionary, each package of a package list is small.
+    uint32_t dictId = 0;
+    string dictCompressed;
+    if (BOOL_FLAG(enable_buffer_file_zstd_dict) && dataPtr->mDataType == LOGGROUP_LZ4_COMPRESSED) {
+        dictId = CompressWithDictionary(dataPtr, dictCompressed);
+    }
+    const string& logData = dictId != 0 ? dictCompressed : dataPtr->mLogData;
+
     char* des;
     int32_t desLength;
-    if (!FileEncryption::GetInstance()->Encrypt(dataPtr->mLogData.c_str(), dataPtr->mLogData.size(), des, desLength)) {
-        fclose(fout);
+    if (!FileEncryption::GetInstance()->Encrypt(logData.c_str(), logData.size(), des, desLength)) {
         LOG_ERROR(sLogger, ("encrypt error, project_name", dataPtr->mProjectName));
         LogtailAlarm::GetInstance()->SendAlarm(ENCRYPT_DECRYPT_FAIL_ALARM,
                                                string("encrypt error, project_name:" + dataPtr->mProjectName));
@@ -1468,46 +1379,45 @@ bool Sender::SendToBufferFile(LoggroupTimeValue* dataPtr) {
     bufferMeta.set_datatype(int32_t(dataPtr->mDataType));
     bufferMeta.set_rawsize(dataPtr->mRawSize);
     bufferMeta.set_shardhashkey(dataPtr->mShardHashKey);
+    bufferMeta.set_compresstype(int32_t(dataPtr->mCompressType));
+    if (dictId != 0) {
+        bufferMeta.set_dictid(dictId);
+    }
     string encodedInfo;
     bufferMeta.SerializeToString(&encodedInfo);
 
     EncryptionStateMeta meta;
     int32_t encodedInfoSize = encodedInfo.size();
     meta.mEncodedInfoSize = encodedInfoSize + BUFFER_META_BASE_SIZE;
-    meta.mLogDataSize = dataPtr->mLogData.size();
+    meta.mLogDataSize = logData.size();
     meta.mTimeStamp = time(NULL);
     meta.mHandled = 0;
     meta.mRetryTime = 0;
     meta.mEncryptionSize = desLength;
-    char* buffer = new char[sizeof(meta) + encodedInfoSize + meta.mEncryptionSize];
-    memcpy(buffer, (char*)&meta, sizeof(meta));
-    memcpy(buffer + sizeof(meta), encodedInfo.c_str(), encodedInfoSize);
-    memcpy(buffer + sizeof(meta) + encodedInfoSize, des, desLength);
+    // Written to file by FlushBufferFile with other records of this round.
+    mBufferFileWriter.Append(meta, encodedInfo, des, desLength);
     delete[] des;
-    const auto bytesToWrite = sizeof(meta) + encodedInfoSize + meta.mEncryptionSize;
-    auto nbytes = fwrite(buffer, 1, bytesToWrite, fout);
-    if (nbytes != bytesToWrite) {
-        string errorStr = ErrnoToString(GetErrno());
-        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM,
-                                               string("write file error:") + bufferFileName + ", error:" + errorStr
-                                                   + ", nbytes:" + ToString(nbytes));
-        LOG_ERROR(
-            sLogger,
-            ("write meta of buffer file", "fail")("filename", bufferFileName)("errorStr", errorStr)("nbytes", nbytes));
-        delete[] buffer;
-        fclose(fout);
-        return false;
-    }
-    delete[] buffer;
-    if (BOOL_FLAG(enable_mock_send))
-        fflush(fout);
-    if (ftell(fout) > AppConfig::GetInstance()->GetLocalFileSize())
+    if (mBufferFileWriter.GetFileSize() > AppConfig::GetInstance()->GetLocalFileSize()) {
+        FlushBufferFile();
         CreateNewFile();
-    fclose(fout);
+    }
     LOG_DEBUG(sLogger, ("write buffer file", bufferFileName)("loglines", dataPtr->mLogLines));
     return true;
 }
 
+bool Sender::FlushBufferFile() {
+    const size_t count = mBufferFileWriter.GetPendingCount();
+    string errorMessage;
+    if (!mBufferFileWriter.Commit(BOOL_FLAG(enable_buffer_file_fsync), errorMessage)) {
+        LogtailAlarm::GetInstance()->SendAlarm(SECONDARY_READ_WRITE_ALARM, errorMessage);
+        LOG_ERROR(sLogger,
+                  ("write buffer file", "fail")("filename", mBufferFileWriter.GetFileName())("error", errorMessage)(
+                      "log groups", count));
+        return false;
+    }
+    return true;
+}
+
 void Sender::FlowControl(int32_t dataSize, SEND_THREAD_TYPE type) {
     int64_t curTime = GetCurrentTimeInMicroSeconds();
     int32_t idx = int32_t(type);
@@ -1551,8 +1461,9 @@ bool Sender::SendPb(Config* pConfig,
                                                      time(NULL),
                                                      shardHash,
                                                      pConfig->mLogstoreKey);
+    pData->mCompressType = pConfig->mCompressType;
     // apsara::timing::TimeInNsec startT = apsara::timing::GetCurrentTimeInNanoSeconds();
-    if (!CompressLz4(pbBuffer, pbSize, pData->mLogData)) {
+    if (!CompressData(pConfig->mCompressType, pbBuffer, pbSize, pData->mLogData, pConfig->mCompressLevel)) {
         LOG_ERROR(sLogger,
                   ("compress data fail", "discard data")("projectName", pConfig->mProjectName)("logstore",
                                                                                                pConfig->mCategory));
@@ -1727,6 +1638,7 @@ SendResult Sender::SendToNetSync(sdk::Client* sendClient,
                                  const LogtailBufferMeta& bufferMeta,
                                  const std::string& logData,
                                  std::string& errorCode) {
+    const string compressType = CompressTypeToString(static_cast<CompressType>(bufferMeta.compresstype()));
     int32_t retryTimes = 0;
     while (true) {
         ++retryTimes;
@@ -1750,24 +1662,21 @@ SendResult Sender::SendToNetSync(sdk::Client* sendClient,
                                                                    0);
                 return SEND_OK;
 #endif
-                if (bufferMeta.has_shardhashkey() && !bufferMeta.shardhashkey().empty())
-                    sendClient->PostLogStoreLogs(bufferMeta.project(),
-                                                 bufferMeta.logstore(),
-                                                 logData,
-                                                 bufferMeta.rawsize(),
-                                                 bufferMeta.shardhashkey());
-                else
-                    sendClient->PostLogStoreLogs(
-                        bufferMeta.project(), bufferMeta.logstore(), logData, bufferMeta.rawsize());
+                sendClient->PostLogStoreLogs(bufferMeta.project(),
+                                             bufferMeta.logstore(),
+                                             logData,
+                                             bufferMeta.rawsize(),
+                                             bufferMeta.has_shardhashkey() ? bufferMeta.shardhashkey() : "",
+                                             compressType);
             } else {
 #ifdef LOGTAIL_RUNTIME_PLUGIN
                 return SEND_OK;
 #endif
-                if (bufferMeta.has_shardhashkey() && !bufferMeta.shardhashkey().empty())
-                    sendClient->PostLogStoreLogPackageList(
-                        bufferMeta.project(), bufferMeta.logstore(), logData, bufferMeta.shardhashkey());
-                else
-                    sendClient->PostLogStoreLogPackageList(bufferMeta.project(), bufferMeta.logstore(), logData);
+                sendClient->PostLogStoreLogPackageList(bufferMeta.project(),
+                                                       bufferMeta.logstore(),
+                                                       logData,
+                                                       bufferMeta.has_shardhashkey() ? bufferMeta.shardhashkey() : "",
+                                                       compressType);
             }
             return SEND_OK;
         } catch (sdk::LOGException& ex) {
@@ -1891,26 +1800,25 @@ void Sender::SendToNetAsync(LoggroupTimeValue* dataPtr) {
         }
     } else if (dataPtr->mDataType == LOGGROUP_LZ4_COMPRESSED) {
         const auto& hashKey = exactlyOnceCpt ? exactlyOnceCpt->data.hash_key() : dataPtr->mShardHashKey;
-        if (hashKey.empty()) {
-            sendClient->PostLogStoreLogs(
-                dataPtr->mProjectName, dataPtr->mLogstore, dataPtr->mLogData, dataPtr->mRawSize, sendClosure);
-        } else {
-            int64_t hashKeySeqID = exactlyOnceCpt ? exactlyOnceCpt->data.sequence_id() : sdk::kInvalidHashKeySeqID;
-            sendClient->PostLogStoreLogs(dataPtr->mProjectName,
-                                         dataPtr->mLogstore,
-                                         dataPtr->mLogData,
-                                         dataPtr->mRawSize,
-                                         sendClosure,
-                                         hashKey,
-                                         hashKeySeqID);
+        int64_t hashKeySeqID = sdk::kInvalidHashKeySeqID;
+        if (!hashKey.empty() && exactlyOnceCpt) {
+            hashKeySeqID = exactlyOnceCpt->data.sequence_id();
         }
+        sendClient->PostLogStoreLogs(dataPtr->mProjectName,
+                                     dataPtr->mLogstore,
+                                     dataPtr->mLogData,
+                                     dataPtr->mRawSize,
+                                     sendClosure,
+                                     hashKey,
+                                     hashKeySeqID,
+                                     CompressTypeToString(dataPtr->mCompressType));
     } else {
-        if (dataPtr->mShardHashKey.empty())
-            sendClient->PostLogStoreLogPackageList(
-                dataPtr->mProjectName, dataPtr->mLogstore, dataPtr->mLogData, sendClosure);
-        else
-            sendClient->PostLogStoreLogPackageList(
-                dataPtr->mProjectName, dataPtr->mLogstore, dataPtr->mLogData, sendClosure, dataPtr->mShardHashKey);
+        sendClient->PostLogStoreLogPackageList(dataPtr->mProjectName,
+                                               dataPtr->mLogstore,
+                                               dataPtr->mLogData,
+                                               sendClosure,
+                                               dataPtr->mShardHashKey,
+                                               CompressTypeToString(dataPtr->mCompressType));
     }
 }
 
@@ -2034,7 +1942,10 @@ void Sender::SendLZ4Compressed(const std::string& projectName,
     data->mLogTimeInMinute = logTimeInMinute;
     data->mLogGroupContext.mSeqNum = ++mLogGroupContextSeq;
 
-    if (!CompressLz4(oriData, data->mLogData)) {
+    int32_t compressLevel = 0;
+    data->mCompressType
+        = GetLogstoreCompressType(GenerateLogstoreFeedBackKey(projectName, logGroup.category()), compressLevel);
+    if (!CompressData(data->mCompressType, oriData, data->mLogData, compressLevel)) {
         LOG_ERROR(sLogger,
                   ("compress data fail", "discard data")("projectName", projectName)("logstore", logGroup.category()));
         LogtailAlarm::GetInstance()->SendAlarm(
@@ -2047,8 +1958,7 @@ void Sender::SendLZ4Compressed(const std::string& projectName,
 
 void Sender::SendLZ4Compressed(std::vector<MergeItem*>& sendDataVec) {
     for (auto item : sendDataVec) {
-        string oriData;
-        item->mLogGroup.SerializeToString(&oriData);
+        const string& oriData = item->SerializeLogGroup();
         mLogGroupContextSeq++;
         auto& context = item->mLogGroupContext;
         auto& cpt = context.mExactlyOnceCheckpoint;
@@ -2069,7 +1979,9 @@ void Sender::SendLZ4Compressed(std::vector<MergeItem*>& sendDataVec) {
                                                         context);
         data->mLogTimeInMinute = item->mLogTimeInMinute;
 
-        if (!CompressLz4(oriData, data->mLogData)) {
+        int32_t compressLevel = 0;
+        data->mCompressType = GetLogstoreCompressType(item->mLogstoreKey, compressLevel);
+        if (!CompressData(data->mCompressType, oriData, data->mLogData, compressLevel)) {
             LOG_ERROR(sLogger,
                       ("compress data fail",
                        "discard data")("projectName", item->mProjectName)("logstore", item->mLogGroup.category()));
@@ -2099,11 +2011,15 @@ void Sender::SendLogPackageList(std::vector<MergeItem*>& sendDataVec) {
     int32_t bytes = 0;
     int32_t lines = 0;
     uint32_t totalLogGroupCount = sendDataVec.size();
+    if (totalLogGroupCount == 0) {
+        return;
+    }
+    int32_t compressLevel = 0;
+    const CompressType compressType = GetLogstoreCompressType(sendDataVec[0]->mLogstoreKey, compressLevel);
     for (uint32_t idx = 0; idx < totalLogGroupCount; ++idx) {
         string compressedData;
-        string oriData;
-        sendDataVec[idx]->mLogGroup.SerializeToString(&oriData);
-        if (!CompressLz4(oriData, compressedData)) {
+        const string& oriData = sendDataVec[idx]->SerializeLogGroup();
+        if (!CompressData(compressType, oriData, compressedData, compressLevel)) {
             LOG_ERROR(sLogger,
                       ("compress data fail", "discard data")("projectName", sendDataVec[idx]->mProjectName)(
                           "logstore", sendDataVec[idx]->mLogGroup.category()));
@@ -2138,6 +2054,7 @@ void Sender::SendLogPackageList(std::vector<MergeItem*>& sendDataVec) {
                                                             sendDataVec[idx]->mLogstoreKey,
                                                             sendDataVec[idx]->mLogGroupContext);
             data->mLogTimeInMinute = sendDataVec[idx]->mLogTimeInMinute;
+            data->mCompressType = compressType;
             logPackageList.SerializeToString(&(data->mLogData));
             logPackageList.Clear();
             bytes = 0;
@@ -2401,6 +2318,64 @@ void Sender::SetLogstoreFlowControl(const LogstoreFeedBackKey& logstoreKey,
     mSenderQueue.SetLogstoreFlowControl(logstoreKey, maxSendBytesPerSecond, expireTime);
 }
 
+void Sender::SetLogstoreCompressType(const LogstoreFeedBackKey& logstoreKey,
+                                     CompressType compressType,
+                                     int32_t level) {
+    PTScopedLock lock(mLogstoreCompressLock);
+    if (compressType == COMPRESS_LZ4) {
+        mLogstoreCompressMap.erase(logstoreKey);
+    } else {
+        mLogstoreCompressMap[logstoreKey] = std::make_pair(compressType, level);
+    }
+}
+
+CompressType Sender::GetLogstoreCompressType(const LogstoreFeedBackKey& logstoreKey, int32_t& level) {
+    PTScopedLock lock(mLogstoreCompressLock);
+    auto iter = mLogstoreCompressMap.find(logstoreKey);
+    if (iter == mLogstoreCompressMap.end()) {
+        level = 0;
+        return COMPRESS_LZ4;
+    }
+    level = iter->second.second;
+    return iter->second.first;
+}
+
+// CompressWithDictionary compresses data of @dataPtr by zstd with dictionary of the logstore,
+//  returns id of the dictionary, or 0 if the dictionary is not trained or it does not help.
+uint32_t Sender::CompressWithDictionary(const LoggroupTimeValue* dataPtr, std::string& compressed) {
+    string rawData;
+    if (!UncompressData(dataPtr->mCompressType, dataPtr->mLogData, dataPtr->mRawSize, rawData)) {
+        return 0;
+    }
+    auto dict
+        = ZstdDictionaryManager::GetInstance()->GetDictionary(dataPtr->mLogstoreKey, rawData, GetBufferFilePath());
+    if (!dict || !CompressZstd(rawData.data(), rawData.size(), compressed, 0, dict.get())
+        || compressed.size() >= dataPtr->mLogData.size()) {
+        return 0;
+    }
+    return dict->GetId();
+}
+
+// UncompressWithDictionary converts data stored with zstd dictionary back to the codec to send.
+bool Sender::UncompressWithDictionary(LogtailBufferMeta& bufferMeta, std::string& logData) {
+    auto dict = ZstdDictionaryManager::GetInstance()->FindDictionary(bufferMeta.dictid(), GetBufferFilePath());
+    string rawData;
+    if (!dict || !UncompressZstd(logData.data(), logData.size(), bufferMeta.rawsize(), rawData, dict.get())) {
+        return false;
+    }
+    int32_t compressLevel = 0;
+    const LogstoreFeedBackKey logstoreKey = GenerateLogstoreFeedBackKey(bufferMeta.project(), bufferMeta.logstore());
+    const CompressType compressType = static_cast<CompressType>(bufferMeta.compresstype());
+    if (GetLogstoreCompressType(logstoreKey, compressLevel) != compressType) {
+        compressLevel = 0;
+    }
+    if (!CompressData(compressType, rawData, logData, compressLevel)) {
+        return false;
+    }
+    bufferMeta.clear_dictid();
+    return true;
+}
+
 
 SlsClientInfo::SlsClientInfo(sdk::Client* client, int32_t updateTime) {
     sendClient = client;
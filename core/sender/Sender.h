@@ -29,6 +29,7 @@
 #include "log_pb/logtail_buffer_meta.pb.h"
 #include "aggregator/Aggregator.h"
 #include "SenderQueueParam.h"
+#include "BufferFile.h"
 
 namespace logtail {
 
@@ -188,16 +189,6 @@ private:
 
     LogstoreSenderQueue<SenderQueueParam> mSenderQueue;
 
-    // for encryption buffer file
-    struct EncryptionStateMeta {
-        int32_t mLogDataSize;
-        int32_t mEncryptionSize;
-        int32_t mEncodedInfoSize;
-        int32_t mTimeStamp;
-        int32_t mHandled;
-        int32_t mRetryTime;
-    };
-
     volatile bool mFlushLog;
     std::string mBufferFilePath;
     std::atomic_int mSendingLogGroupCount{0};
@@ -207,6 +198,8 @@ private:
     volatile time_t mBufferDivideTime;
     volatile bool mIsSendingBuffer;
     std::string mBufferFileName;
+    // writer of current buffer file, only used by DumpSecondaryThread
+    BufferFileWriter mBufferFileWriter;
 
     struct SendStatistic {
         int32_t mBeginTime;
@@ -260,7 +253,13 @@ private:
     bool mStopRealIpThread = false;
 
     const static std::string BUFFER_FILE_NAME_PREFIX;
-    const static int32_t BUFFER_META_BASE_SIZE;
+
+    PTMutex mLogstoreCompressLock;
+    // Codec and level of logstores which do not use lz4.
+    std::unordered_map<LogstoreFeedBackKey, std::pair<CompressType, int32_t>> mLogstoreCompressMap;
+    CompressType GetLogstoreCompressType(const LogstoreFeedBackKey& logstoreKey, int32_t& level);
+    uint32_t CompressWithDictionary(const LoggroupTimeValue* dataPtr, std::string& compressed);
+    bool UncompressWithDictionary(sls_logs::LogtailBufferMeta& bufferMeta, std::string& logData);
 
     void ForceUpdateRealIp(const std::string& region);
     void UpdateSendClientRealIp(sdk::Client* client, const std::string& region);
@@ -272,9 +271,8 @@ private:
     void WriteSecondary();
     bool LoadFileToSend(time_t timeLine, std::vector<std::string>& filesToSend);
     bool CreateNewFile();
-    bool WriteBackMeta(const int32_t pos, const void* buf, int32_t length, const std::string& filename);
-    bool ReadNextEncryption(int32_t& pos,
-                            const std::string& filename,
+    bool FlushBufferFile();
+    bool ReadNextEncryption(BufferFileReader& reader,
                             std::string& encryption,
                             EncryptionStateMeta& meta,
                             bool& readResult,
@@ -378,11 +376,15 @@ public:
                              int32_t rawSize);
     void (*MockIntegritySend)(LoggroupTimeValue* data);
     sdk::GetRealIpResponse (*MockGetRealIp)(const std::string& projectName, const std::string& logstore);
-    static bool ParseLogGroupFromLZ4(const std::string& logData, int32_t rawSize, sls_logs::LogGroup& logGroupPb);
+    static bool ParseLogGroupFromLZ4(const std::string& logData,
+                                     int32_t rawSize,
+                                     sls_logs::LogGroup& logGroupPb,
+                                     CompressType compressType = COMPRESS_LZ4);
     static void ParseLogGroupFromString(const std::string& logData,
                                         SEND_DATA_TYPE dataType,
                                         int32_t rawSize,
-                                        std::vector<sls_logs::LogGroup>& logGroupVec);
+                                        std::vector<sls_logs::LogGroup>& logGroupVec,
+                                        CompressType compressType = COMPRESS_LZ4);
     static bool LZ4CompressLogGroup(const sls_logs::LogGroup& logGroup, std::string& compressed, int32_t& rawSize);
 
     void AddEndpointEntry(const std::string& region,
@@ -419,6 +421,8 @@ public:
     LogstoreSenderStatistics GetSenderStatistics(const LogstoreFeedBackKey& key);
     void
     SetLogstoreFlowControl(const LogstoreFeedBackKey& logstoreKey, int32_t maxSendBytesPerSecond, int32_t expireTime);
+    // SetLogstoreCompressType sets codec to compress data of logstore, lz4 is used by default.
+    void SetLogstoreCompressType(const LogstoreFeedBackKey& logstoreKey, CompressType compressType, int32_t level);
     bool SendPb(Config* pConfig,
                 char* pbBuffer,
                 int32_t pbSize,
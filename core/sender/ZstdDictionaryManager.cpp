@@ -0,0 +1,140 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ZstdDictionaryManager.h"
+#include <cstdio>
+#include <unordered_set>
+#include "common/Flags.h"
+#include "common/FileSystemUtil.h"
+#include "common/StringTools.h"
+#include "logger/Logger.h"
+
+DEFINE_FLAG_INT32(zstd_dict_sample_bytes,
+                  "bytes of sampled log groups to train zstd dictionary of a logstore",
+                  1024 * 1024);
+DEFINE_FLAG_INT32(zstd_dict_capacity, "max size of zstd dictionary", 64 * 1024);
+DEFINE_FLAG_INT32(zstd_dict_compress_level, "zstd level to compress buffer files with dictionary", 3);
+
+namespace logtail {
+
+static const std::string kDictionaryFilePrefix = "zstd_dict_";
+// Samples are truncated, the beginning of a log group is as good as the whole one for training.
+static const size_t kMaxSampleSize = 64 * 1024;
+static const size_t kMinSampleCount = 8;
+// Not limited by flag zstd_dict_capacity, dictionaries may be saved with a larger capacity before.
+static const uint32_t kMaxDictionaryFileSize = 4 * 1024 * 1024;
+
+std::string ZstdDictionaryManager::GetDictionaryFileName(uint32_t id) {
+    return kDictionaryFilePrefix + ToString(id);
+}
+
+std::shared_ptr<ZstdDictionary> ZstdDictionaryManager::GetDictionary(const LogstoreFeedBackKey& key,
+                                                                     const std::string& rawData,
+                                                                     const std::string& dir) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    LogstoreSamples& samples = mLogstoreSamples[key];
+    if (samples.mDictionary) {
+        return samples.mDictionary;
+    }
+    samples.mSamples.emplace_back(rawData.substr(0, kMaxSampleSize));
+    samples.mBytes += samples.mSamples.back().size();
+    if (samples.mBytes < (size_t)INT32_FLAG(zstd_dict_sample_bytes) || samples.mSamples.size() < kMinSampleCount) {
+        return std::shared_ptr<ZstdDictionary>();
+    }
+
+    std::shared_ptr<ZstdDictionary> dict = ZstdDictionary::Train(
+        samples.mSamples, (size_t)INT32_FLAG(zstd_dict_capacity), INT32_FLAG(zstd_dict_compress_level));
+    std::vector<std::string>().swap(samples.mSamples);
+    samples.mBytes = 0;
+    if (!dict) {
+        LOG_WARNING(sLogger, ("train zstd dictionary failed", "sample again")("logstore key", key));
+        return dict;
+    }
+    // Buffer files must not refer to a dictionary which is not on disk.
+    if (!OverwriteFile(dir + GetDictionaryFileName(dict->GetId()), dict->GetContent())) {
+        LOG_WARNING(sLogger, ("save zstd dictionary failed", dir)("dictionary id", dict->GetId()));
+        return std::shared_ptr<ZstdDictionary>();
+    }
+    LOG_INFO(sLogger,
+             ("train zstd dictionary, logstore key", key)("dictionary id", dict->GetId())("size",
+                                                                                          dict->GetContent().size()));
+    samples.mDictionary = dict;
+    mDictionaries[dict->GetId()] = dict;
+    return dict;
+}
+
+std::shared_ptr<ZstdDictionary> ZstdDictionaryManager::FindDictionary(uint32_t id, const std::string& dir) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto iter = mDictionaries.find(id);
+    if (iter != mDictionaries.end()) {
+        return iter->second;
+    }
+    std::string content;
+    const std::string fileName = dir + GetDictionaryFileName(id);
+    if (!ReadFileContent(fileName, content, kMaxDictionaryFileSize) || content.empty()) {
+        LOG_ERROR(sLogger, ("read zstd dictionary failed", fileName));
+        return std::shared_ptr<ZstdDictionary>();
+    }
+    std::shared_ptr<ZstdDictionary> dict = ZstdDictionary::Load(content, INT32_FLAG(zstd_dict_compress_level));
+    if (!dict || dict->GetId() != id) {
+        LOG_ERROR(sLogger, ("invalid zstd dictionary", fileName));
+        return std::shared_ptr<ZstdDictionary>();
+    }
+    mDictionaries[id] = dict;
+    return dict;
+}
+
+void ZstdDictionaryManager::RemoveUnusedDictionaries(const std::string& dir) {
+    // Hold the lock during scanning, or a dictionary saved meanwhile may be taken as unused.
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::unordered_set<uint32_t> usedIds;
+    for (const auto& samples : mLogstoreSamples) {
+        if (samples.second.mDictionary) {
+            usedIds.insert(samples.second.mDictionary->GetId());
+        }
+    }
+    std::vector<uint32_t> unusedIds;
+    for (auto iter = mDictionaries.begin(); iter != mDictionaries.end();) {
+        if (usedIds.find(iter->first) == usedIds.end()) {
+            unusedIds.push_back(iter->first);
+            iter = mDictionaries.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    // Files of previous runs which are never loaded are found by scanning directory once.
+    if (!mScanned) {
+        std::vector<std::string> fileNames;
+        mScanned = GetAllFiles(dir, kDictionaryFilePrefix + "*", fileNames);
+        for (const auto& fileName : fileNames) {
+            uint32_t id = 0;
+            try {
+                id = StringTo<uint32_t>(fileName.substr(kDictionaryFilePrefix.size()));
+            } catch (...) {
+                continue;
+            }
+            if (usedIds.find(id) == usedIds.end()) {
+                unusedIds.push_back(id);
+            }
+        }
+    }
+    for (uint32_t id : unusedIds) {
+        const std::string fileName = dir + GetDictionaryFileName(id);
+        if (remove(fileName.c_str()) == 0) {
+            LOG_INFO(sLogger, ("remove unused zstd dictionary", fileName));
+        }
+    }
+}
+
+} // namespace logtail
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2022 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/CompressTools.h"
+#include "common/LogstoreFeedbackKey.h"
+
+namespace logtail {
+
+// ZstdDictionaryManager trains a zstd dictionary for each logstore from sampled log groups,
+//  records written to buffer files are compressed with them to keep more data on disk when
+//  network is unavailable.
+//
+// SLS can not decompress data compressed with custom dictionaries, so the dictionaries are
+//  only used for buffer files, records are compressed again without dictionary before sending.
+// Dictionaries are saved in buffer file directory so that buffer files can still be read
+//  after restart.
+class ZstdDictionaryManager {
+public:
+    static ZstdDictionaryManager* GetInstance() {
+        static auto singleton = new ZstdDictionaryManager;
+        return singleton;
+    }
+
+    // GetDictionary samples @rawData (serialized log group) of logstore @key and returns the
+    //  dictionary of the logstore, which is trained and saved to @dir once enough samples
+    //  are collected. Returns NULL before that.
+    std::shared_ptr<ZstdDictionary>
+    GetDictionary(const LogstoreFeedBackKey& key, const std::string& rawData, const std::string& dir);
+
+    // FindDictionary returns dictionary @id, it is loaded from @dir if not in memory.
+    std::shared_ptr<ZstdDictionary> FindDictionary(uint32_t id, const std::string& dir);
+
+    // RemoveUnusedDictionaries removes dictionaries of previous runs from memory and @dir,
+    //  it must be called only when there is no buffer file to send.
+    void RemoveUnusedDictionaries(const std::string& dir);
+
+    static std::string GetDictionaryFileName(uint32_t id);
+
+private:
+    struct LogstoreSamples {
+        std::vector<std::string> mSamples;
+        size_t mBytes = 0;
+        std::shared_ptr<ZstdDictionary> mDictionary;
+    };
+
+    ZstdDictionaryManager() = default;
+
+    std::mutex mMutex;
+    std::unordered_map<LogstoreFeedBackKey, LogstoreSamples> mLogstoreSamples;
+    // All dictionaries by id, including ones of previous runs loaded from disk.
+    std::unordered_map<uint32_t, std::shared_ptr<ZstdDictionary>> mDictionaries;
+    bool mScanned = false;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class CompressToolsUnittest;
+#endif
+};
+
+} // namespace logtail
@@ -192,6 +192,17 @@ namespace bfs = boost::filesystem;
 
 #define UNIT_TEST_CASE(suite, case) APSARA_UNIT_TEST_CASE(suite, case, 0)
 
+// Benchmarks are slow and run only if env LOGTAIL_UNITTEST_BENCHMARK is set, such as
+//  LOGTAIL_UNITTEST_BENCHMARK=1 ./reader_log_split_unittest --gtest_filter=*Benchmark*
+#define UNIT_BENCHMARK_CASE(suite, case) \
+    TEST_F(suite, case) { \
+        if (getenv("LOGTAIL_UNITTEST_BENCHMARK") == NULL) { \
+            APSARA_LOG_INFO(sLogger, ("skip benchmark", #case)("enable by env", "LOGTAIL_UNITTEST_BENCHMARK")); \
+            return; \
+        } \
+        case(); \
+    }
+
 #define UNIT_TEST_MAIN \
     int main(int argc, char** argv) { \
         logtail::Logger::Instance().InitGlobalLoggers(); \
@@ -0,0 +1,283 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "checkpoint/CheckPointStore.h"
+#include "common/FileSystemUtil.h"
+#include "common/RuntimeUtil.h"
+#include "logger/Logger.h"
+
+namespace logtail {
+
+class CheckPointStoreUnittest : public ::testing::Test {
+public:
+    void TestDumpAndLoad();
+    void TestIncrementalDump();
+    void TestBrokenRecord();
+    void TestRewrite();
+    void BenchmarkDump();
+
+protected:
+    void SetUp() override {
+        mRootDir = GetProcessExecutionDir() + "CheckPointStoreUnittest" + PATH_SEPARATOR;
+        bfs::remove_all(mRootDir);
+        bfs::create_directories(mRootDir);
+        mStoreFile = mRootDir + "logtail_check_point.bin";
+    }
+    void TearDown() override { bfs::remove_all(mRootDir); }
+
+    std::vector<CheckPointPtr> CreateCheckPoints(size_t count) {
+        std::vector<CheckPointPtr> cpts;
+        for (size_t i = 0; i < count; ++i) {
+            std::string fileName = "/var/log/app_" + std::to_string(i % 100) + "/access_" + std::to_string(i) + ".log";
+            cpts.push_back(std::make_shared<CheckPoint>(
+                fileName, i * 100, 1024, i * 7 + 1, DevInode(2049, 10000 + i), "config_" + std::to_string(i % 3)));
+            cpts.back()->mLastUpdateTime = 1600000000 + i;
+        }
+        return cpts;
+    }
+
+    static std::vector<const CheckPoint*> ToPointers(const std::vector<CheckPointPtr>& cpts) {
+        std::vector<const CheckPoint*> pointers;
+        for (auto& cpt : cpts) {
+            pointers.push_back(cpt.get());
+        }
+        return pointers;
+    }
+
+    // LoadAndCheck loads @mStoreFile with a new store and checks that it holds @expected.
+    void LoadAndCheck(const std::vector<CheckPointPtr>& expected, const std::vector<DirCheckPointPtr>& expectedDirs) {
+        CheckPointStore store(mStoreFile);
+        std::vector<CheckPointPtr> cpts;
+        std::vector<DirCheckPointPtr> dirCpts;
+        std::string errorMessage;
+        APSARA_TEST_TRUE_FATAL(store.Load(cpts, dirCpts, errorMessage));
+        APSARA_TEST_EQUAL(errorMessage, "");
+        APSARA_TEST_EQUAL_FATAL(cpts.size(), expected.size());
+        std::map<std::pair<uint64_t, std::string>, CheckPointPtr> cptMap;
+        for (auto& cpt : cpts) {
+            cptMap[std::make_pair(cpt->mDevInode.inode, cpt->mConfigName)] = cpt;
+        }
+        for (auto& cpt : expected) {
+            auto it = cptMap.find(std::make_pair(cpt->mDevInode.inode, cpt->mConfigName));
+            APSARA_TEST_TRUE_FATAL(it != cptMap.end());
+            const CheckPoint& loaded = *it->second;
+            APSARA_TEST_EQUAL(loaded.mFileName, cpt->mFileName);
+            APSARA_TEST_EQUAL(loaded.mRealFileName, cpt->mRealFileName);
+            APSARA_TEST_EQUAL(loaded.mOffset, cpt->mOffset);
+            APSARA_TEST_EQUAL(loaded.mSignatureSize, cpt->mSignatureSize);
+            APSARA_TEST_EQUAL(loaded.mSignatureHash, cpt->mSignatureHash);
+            APSARA_TEST_EQUAL(loaded.mLastUpdateTime, cpt->mLastUpdateTime);
+            APSARA_TEST_EQUAL(loaded.mFileOpenFlag, cpt->mFileOpenFlag);
+            APSARA_TEST_TRUE(loaded.mDevInode == cpt->mDevInode);
+        }
+        APSARA_TEST_EQUAL_FATAL(dirCpts.size(), expectedDirs.size());
+        for (size_t i = 0; i < expectedDirs.size(); ++i) {
+            bool found = false;
+            for (auto& dirCpt : dirCpts) {
+                if (dirCpt->mParentName == expectedDirs[i]->mParentName) {
+                    found = true;
+                    APSARA_TEST_EQUAL(dirCpt->mUpdateTime, expectedDirs[i]->mUpdateTime);
+                    APSARA_TEST_TRUE(dirCpt->mSubDir == expectedDirs[i]->mSubDir);
+                }
+            }
+            APSARA_TEST_TRUE_DESC(found, expectedDirs[i]->mParentName);
+        }
+        APSARA_TEST_EQUAL(store.GetLiveCount(), expected.size() + expectedDirs.size());
+    }
+
+    std::string mRootDir;
+    std::string mStoreFile;
+};
+
+UNIT_TEST_CASE(CheckPointStoreUnittest, TestDumpAndLoad);
+UNIT_TEST_CASE(CheckPointStoreUnittest, TestIncrementalDump);
+UNIT_TEST_CASE(CheckPointStoreUnittest, TestBrokenRecord);
+UNIT_TEST_CASE(CheckPointStoreUnittest, TestRewrite);
+UNIT_BENCHMARK_CASE(CheckPointStoreUnittest, BenchmarkDump);
+
+void CheckPointStoreUnittest::TestDumpAndLoad() {
+    std::vector<CheckPointPtr> cpts = CreateCheckPoints(10);
+    cpts[3]->mRealFileName = "/var/log/app_3/access_3.log.1";
+    cpts[4]->mFileOpenFlag = 1;
+    std::vector<DirCheckPointPtr> dirCpts;
+    dirCpts.push_back(std::make_shared<DirCheckPoint>("/var/log"));
+    dirCpts.back()->mSubDir.insert("/var/log/app_0");
+    dirCpts.back()->mSubDir.insert("/var/log/app_1");
+    dirCpts.push_back(std::make_shared<DirCheckPoint>("/var/log/empty"));
+    std::vector<const DirCheckPoint*> dirPointers = {dirCpts[0].get(), dirCpts[1].get()};
+
+    {
+        CheckPointStore store(mStoreFile);
+        std::vector<CheckPointPtr> loaded;
+        std::vector<DirCheckPointPtr> loadedDirs;
+        std::string errorMessage;
+        // Not exist.
+        APSARA_TEST_FALSE(store.Load(loaded, loadedDirs, errorMessage));
+        APSARA_TEST_EQUAL(errorMessage, "");
+        APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), dirPointers, errorMessage));
+        APSARA_TEST_EQUAL(store.GetLastAppendCount(), cpts.size() + dirCpts.size());
+    }
+    LoadAndCheck(cpts, dirCpts);
+
+    // Not a checkpoint store.
+    std::ofstream(mStoreFile) << "{\"check_point\":{}}";
+    CheckPointStore store(mStoreFile);
+    std::vector<CheckPointPtr> loaded;
+    std::vector<DirCheckPointPtr> loadedDirs;
+    std::string errorMessage;
+    APSARA_TEST_FALSE(store.Load(loaded, loadedDirs, errorMessage));
+    APSARA_TEST_NOT_EQUAL(errorMessage, "");
+}
+
+void CheckPointStoreUnittest::TestIncrementalDump() {
+    std::vector<CheckPointPtr> cpts = CreateCheckPoints(100);
+    std::vector<DirCheckPointPtr> dirCpts;
+    CheckPointStore store(mStoreFile);
+    std::string errorMessage;
+    APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), {}, errorMessage));
+    APSARA_TEST_EQUAL(store.GetLastAppendCount(), 100UL);
+
+    // Nothing changed, nothing written.
+    int64_t fileSize = store.GetFileSize();
+    APSARA_TEST_TRUE(store.Dump(ToPointers(CreateCheckPoints(100)), {}, errorMessage));
+    APSARA_TEST_EQUAL(store.GetLastAppendCount(), 0UL);
+    APSARA_TEST_EQUAL(store.GetFileSize(), fileSize);
+    APSARA_TEST_EQUAL((int64_t)bfs::file_size(mStoreFile), fileSize);
+
+    // Update one, delete one and add one.
+    cpts[10]->mOffset += 4096;
+    cpts.erase(cpts.begin() + 20);
+    cpts.push_back(CreateCheckPoints(101).back());
+    APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), {}, errorMessage));
+    APSARA_TEST_EQUAL(store.GetLastAppendCount(), 3UL);
+    APSARA_TEST_TRUE(store.GetFileSize() > fileSize);
+    APSARA_TEST_TRUE(store.GetFileSize() < fileSize + fileSize / 10);
+    LoadAndCheck(cpts, dirCpts);
+
+    // Another config of the same file is another checkpoint.
+    cpts.push_back(std::make_shared<CheckPoint>(*cpts[0]));
+    cpts.back()->mConfigName = "config_other";
+    APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), {}, errorMessage));
+    APSARA_TEST_EQUAL(store.GetLastAppendCount(), 1UL);
+    LoadAndCheck(cpts, dirCpts);
+
+    // Dump after load is incremental too.
+    CheckPointStore reloaded(mStoreFile);
+    std::vector<CheckPointPtr> loaded;
+    std::vector<DirCheckPointPtr> loadedDirs;
+    APSARA_TEST_TRUE(reloaded.Load(loaded, loadedDirs, errorMessage));
+    cpts.pop_back();
+    APSARA_TEST_TRUE(reloaded.Dump(ToPointers(cpts), {}, errorMessage));
+    APSARA_TEST_EQUAL(reloaded.GetLastAppendCount(), 1UL);
+    LoadAndCheck(cpts, dirCpts);
+}
+
+void CheckPointStoreUnittest::TestBrokenRecord() {
+    std::vector<CheckPointPtr> cpts = CreateCheckPoints(10);
+    CheckPointStore store(mStoreFile);
+    std::string errorMessage;
+    APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), {}, errorMessage));
+    int64_t validSize = store.GetFileSize();
+    cpts[0]->mOffset += 1;
+    cpts[1]->mOffset += 1;
+    APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), {}, errorMessage));
+
+    // Truncate the last record, as if the process crashed while appending.
+    bfs::resize_file(mStoreFile, store.GetFileSize() - 3);
+    CheckPointStore reloaded(mStoreFile);
+    std::vector<CheckPointPtr> loaded;
+    std::vector<DirCheckPointPtr> loadedDirs;
+    APSARA_TEST_TRUE(reloaded.Load(loaded, loadedDirs, errorMessage));
+    APSARA_TEST_NOT_EQUAL(errorMessage, "");
+    APSARA_TEST_EQUAL(loaded.size(), cpts.size());
+    APSARA_TEST_TRUE(reloaded.GetFileSize() > validSize);
+    for (auto& cpt : loaded) {
+        if (cpt->mDevInode == cpts[0]->mDevInode) {
+            APSARA_TEST_EQUAL(cpt->mOffset, cpts[0]->mOffset);
+        } else if (cpt->mDevInode == cpts[1]->mDevInode) {
+            APSARA_TEST_EQUAL(cpt->mOffset, cpts[1]->mOffset - 1);
+        }
+    }
+
+    // The broken record is dropped by rewriting the file.
+    errorMessage.clear();
+    APSARA_TEST_TRUE(reloaded.Dump(ToPointers(cpts), {}, errorMessage));
+    APSARA_TEST_EQUAL(reloaded.GetLastAppendCount(), cpts.size());
+    LoadAndCheck(cpts, {});
+}
+
+void CheckPointStoreUnittest::TestRewrite() {
+    std::vector<CheckPointPtr> cpts = CreateCheckPoints(2000);
+    CheckPointStore store(mStoreFile);
+    std::string errorMessage;
+    int64_t maxFileSize = 0;
+    bool rewritten = false;
+    for (int round = 0; round < 30; ++round) {
+        for (auto& cpt : cpts) {
+            cpt->mOffset += 100;
+        }
+        APSARA_TEST_TRUE_FATAL(store.Dump(ToPointers(cpts), {}, errorMessage));
+        APSARA_TEST_EQUAL(store.GetLastAppendCount(), cpts.size());
+        maxFileSize = std::max(maxFileSize, store.GetFileSize());
+        rewritten = rewritten || (round > 0 && store.GetFileSize() < maxFileSize);
+    }
+    APSARA_TEST_TRUE(rewritten);
+    APSARA_TEST_TRUE(maxFileSize < 2 * 1024 * 1024);
+    LoadAndCheck(cpts, {});
+}
+
+// Periodic dumps of 100000 file checkpoints, 1% of them are changed between dumps.
+void CheckPointStoreUnittest::BenchmarkDump() {
+    const size_t kCount = 100000;
+    std::vector<CheckPointPtr> cpts = CreateCheckPoints(kCount);
+    CheckPointStore store(mStoreFile);
+    std::string errorMessage;
+    auto start = std::chrono::steady_clock::now();
+    APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), {}, errorMessage));
+    auto fullCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int64_t fullSize = store.GetFileSize();
+
+    const int kRounds = 10;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (size_t i = round; i < cpts.size(); i += 100) {
+            cpts[i]->mOffset += 4096;
+        }
+        APSARA_TEST_TRUE(store.Dump(ToPointers(cpts), {}, errorMessage));
+        APSARA_TEST_EQUAL(store.GetLastAppendCount(), kCount / 100);
+    }
+    auto incCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / kRounds;
+
+    start = std::chrono::steady_clock::now();
+    CheckPointStore reloaded(mStoreFile);
+    std::vector<CheckPointPtr> loaded;
+    std::vector<DirCheckPointPtr> loadedDirs;
+    APSARA_TEST_TRUE(reloaded.Load(loaded, loadedDirs, errorMessage));
+    auto loadCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    APSARA_TEST_EQUAL(loaded.size(), kCount);
+    LOG_INFO(sLogger,
+             ("benchmark", "checkpoint store")("checkpoints", kCount)("full dump ms", fullCost * 1e3)(
+                 "full size", fullSize)("incremental dump ms", incCost * 1e3)(
+                 "incremental bytes", (store.GetFileSize() - fullSize) / kRounds)("load ms", loadCost * 1e3));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
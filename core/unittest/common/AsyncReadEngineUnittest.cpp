@@ -0,0 +1,233 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <sys/resource.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/AsyncReadEngine.h"
+#include "common/Flags.h"
+#include "common/FileSystemUtil.h"
+#include "common/LogFileOperator.h"
+#include "common/RuntimeUtil.h"
+#include "common/StringTools.h"
+
+DECLARE_FLAG_STRING(file_read_backend);
+DECLARE_FLAG_INT32(io_uring_submit_batch);
+
+namespace logtail {
+
+class AsyncReadEngineUnittest : public ::testing::Test {
+public:
+    void TestDisabled();
+    void TestRead();
+    void TestSubmitFailure();
+    void BenchmarkTailFiles();
+
+protected:
+    void SetUp() override {
+        mRootDir = bfs::exists("/dev/shm") ? "/dev/shm" : GetProcessExecutionDir();
+        mRootDir += PATH_SEPARATOR + "AsyncReadEngineUnittest";
+        bfs::remove_all(mRootDir);
+        bfs::create_directories(mRootDir);
+    }
+    void TearDown() override { bfs::remove_all(mRootDir); }
+
+    static std::shared_ptr<AsyncReadEngine> MakeEngine(const std::string& backend) {
+        const std::string backup = STRING_FLAG(file_read_backend);
+        STRING_FLAG(file_read_backend) = backend;
+        std::shared_ptr<AsyncReadEngine> engine(new AsyncReadEngine, [](AsyncReadEngine* e) { delete e; });
+        STRING_FLAG(file_read_backend) = backup;
+        return engine;
+    }
+
+    std::string mRootDir;
+};
+
+UNIT_TEST_CASE(AsyncReadEngineUnittest, TestDisabled);
+UNIT_TEST_CASE(AsyncReadEngineUnittest, TestRead);
+UNIT_TEST_CASE(AsyncReadEngineUnittest, TestSubmitFailure);
+UNIT_BENCHMARK_CASE(AsyncReadEngineUnittest, BenchmarkTailFiles);
+
+void AsyncReadEngineUnittest::TestDisabled() {
+    auto engine = MakeEngine("pread");
+    APSARA_TEST_FALSE(engine->IsEnabled());
+    APSARA_TEST_TRUE(engine->Submit(0, ReadBufferPool::GetInstance()->Acquire(16), 16, 0) == nullptr);
+}
+
+void AsyncReadEngineUnittest::TestRead() {
+    auto engine = MakeEngine("io_uring");
+    if (!engine->IsEnabled()) {
+        LOG_WARNING(sLogger, ("io_uring is not supported", "skip test"));
+        return;
+    }
+    const int fileCount = 300;
+    std::vector<std::unique_ptr<LogFileOperator>> ops;
+    for (int i = 0; i < fileCount; ++i) {
+        const std::string path = mRootDir + PATH_SEPARATOR + ToString(i) + ".log";
+        FILE* file = fopen(path.c_str(), "w");
+        fprintf(file, "file %d\nsecond line\n", i);
+        fclose(file);
+        ops.emplace_back(new LogFileOperator);
+        APSARA_TEST_TRUE_FATAL(ops.back()->Open(path.c_str()) >= 0);
+    }
+
+    // More reads than queue entries, and not flushed on submit.
+    std::vector<AsyncReadRequestPtr> requests;
+    for (int i = 0; i < fileCount; ++i) {
+        requests.push_back(
+            engine->Submit(ops[i]->GetFd(), ReadBufferPool::GetInstance()->Acquire(4096), 4096, 5, false));
+    }
+    for (int i = 0; i < fileCount; ++i) {
+        const std::string expected = ToString(i) + "\nsecond line\n";
+        int64_t nbytes = engine->Wait(requests[i]);
+        APSARA_TEST_EQUAL_FATAL(nbytes, int64_t(expected.size()));
+        APSARA_TEST_EQUAL_FATAL(std::string(requests[i]->buffer.get(), nbytes), expected);
+    }
+    APSARA_TEST_EQUAL(engine->GetCompleteCount(), uint64_t(fileCount));
+    APSARA_TEST_TRUE(engine->GetEnterCount() < uint64_t(fileCount));
+
+    // Error is returned by completion.
+    auto request = engine->Submit(-1, ReadBufferPool::GetInstance()->Acquire(16), 16, 0);
+    APSARA_TEST_TRUE(engine->Wait(request) < 0);
+}
+
+void AsyncReadEngineUnittest::TestSubmitFailure() {
+    auto engine = MakeEngine("io_uring");
+    if (!engine->IsEnabled()) {
+        LOG_WARNING(sLogger, ("io_uring is not supported", "skip test"));
+        return;
+    }
+    const std::string path = mRootDir + PATH_SEPARATOR + "submit.log";
+    FILE* file = fopen(path.c_str(), "w");
+    fprintf(file, "content\n");
+    fclose(file);
+    LogFileOperator op;
+    APSARA_TEST_TRUE_FATAL(op.Open(path.c_str()) >= 0);
+
+    // Reads are queued, then io_uring_enter fails as the ring fd is invalid.
+    const int32_t batchBackup = INT32_FLAG(io_uring_submit_batch);
+    INT32_FLAG(io_uring_submit_batch) = 16;
+    auto first = engine->Submit(op.GetFd(), ReadBufferPool::GetInstance()->Acquire(16), 16, 0, false);
+    auto second = engine->Submit(op.GetFd(), ReadBufferPool::GetInstance()->Acquire(16), 16, 0, false);
+    INT32_FLAG(io_uring_submit_batch) = batchBackup;
+    APSARA_TEST_EQUAL(engine->mPendingCount, 2U);
+    const int ringFd = engine->mRingFd;
+    engine->mRingFd = -1;
+    // Wait returns instead of waiting for completions of unsubmitted reads.
+    APSARA_TEST_EQUAL(engine->Wait(first), int64_t(-EBADF));
+    engine->mRingFd = ringFd;
+    APSARA_TEST_TRUE(second->done);
+    APSARA_TEST_EQUAL(second->result, int64_t(-EBADF));
+    APSARA_TEST_EQUAL(engine->mPendingCount, 0U);
+    APSARA_TEST_TRUE(engine->mInflightRequests.empty());
+
+    // Entries of failed reads are taken back, following reads work.
+    auto request = engine->Submit(op.GetFd(), ReadBufferPool::GetInstance()->Acquire(16), 16, 0);
+    APSARA_TEST_EQUAL(engine->Wait(request), int64_t(8));
+    APSARA_TEST_EQUAL(std::string(request->buffer.get(), 8), "content\n");
+}
+
+// Tail 10k files on tmpfs: append to every file, then read the new content of all files,
+//  compare syscall count and throughput between pread and io_uring backends.
+void AsyncReadEngineUnittest::BenchmarkTailFiles() {
+    auto engine = MakeEngine("io_uring");
+    if (!engine->IsEnabled()) {
+        LOG_WARNING(sLogger, ("io_uring is not supported", "skip benchmark"));
+        return;
+    }
+    int fileCount = 10000;
+    // Keep some descriptors for others if open files limit is low.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < RLIM_INFINITY
+        && limit.rlim_cur < rlim_t(fileCount + 256)) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < rlim_t(fileCount + 256)) {
+            fileCount = limit.rlim_cur > 512 ? int(limit.rlim_cur) - 256 : 256;
+        }
+    }
+    const int rounds = 5;
+    const size_t chunkSize = 4096;
+    std::string chunk;
+    while (chunk.size() < chunkSize) {
+        chunk.append("2022-08-01 12:00:00,123 INFO [main] com.example.Service - request done\n");
+    }
+    chunk.resize(chunkSize);
+
+    std::vector<std::string> paths;
+    std::vector<std::unique_ptr<LogFileOperator>> ops;
+    for (int i = 0; i < fileCount; ++i) {
+        paths.push_back(mRootDir + PATH_SEPARATOR + ToString(i) + ".log");
+        fclose(fopen(paths.back().c_str(), "w"));
+        ops.emplace_back(new LogFileOperator);
+        APSARA_TEST_TRUE_FATAL(ops.back()->Open(paths.back().c_str()) >= 0);
+    }
+
+    std::vector<ReadBufferPtr> buffers;
+    for (int i = 0; i < fileCount; ++i) {
+        buffers.push_back(ReadBufferPtr(new char[chunkSize + 1], std::default_delete<char[]>()));
+    }
+    std::chrono::steady_clock::duration preadCost(0), uringCost(0);
+    uint64_t preadBytes = 0, uringBytes = 0, preadCalls = 0;
+    const uint64_t enterBegin = engine->GetEnterCount();
+    for (int round = 0; round < rounds * 2; ++round) {
+        for (int i = 0; i < fileCount; ++i) {
+            FILE* file = fopen(paths[i].c_str(), "a");
+            fwrite(chunk.data(), 1, chunk.size(), file);
+            fclose(file);
+        }
+        const int64_t offset = int64_t(round) * chunkSize;
+        auto start = std::chrono::steady_clock::now();
+        if (round % 2 == 0) {
+            for (int i = 0; i < fileCount; ++i) {
+                preadBytes += ops[i]->Pread(buffers[i].get(), 1, chunkSize, offset);
+                ++preadCalls;
+            }
+            preadCost += std::chrono::steady_clock::now() - start;
+        } else {
+            std::vector<AsyncReadRequestPtr> requests;
+            requests.reserve(fileCount);
+            for (int i = 0; i < fileCount; ++i) {
+                requests.push_back(engine->Submit(ops[i]->GetFd(), buffers[i], chunkSize, offset, false));
+            }
+            for (auto& request : requests) {
+                int64_t nbytes = engine->Wait(request);
+                uringBytes += nbytes > 0 ? nbytes : 0;
+            }
+            uringCost += std::chrono::steady_clock::now() - start;
+        }
+    }
+    const uint64_t enterCount = engine->GetEnterCount() - enterBegin;
+    APSARA_TEST_EQUAL(preadBytes, uint64_t(fileCount) * chunkSize * rounds);
+    APSARA_TEST_EQUAL(uringBytes, preadBytes);
+
+    auto preadMs = std::chrono::duration_cast<std::chrono::milliseconds>(preadCost).count();
+    auto uringMs = std::chrono::duration_cast<std::chrono::milliseconds>(uringCost).count();
+    double mb = preadBytes / 1024.0 / 1024.0;
+    LOG_INFO(sLogger,
+             ("benchmark", "tail files on tmpfs")("files", fileCount)("rounds", rounds)("data MB", mb)(
+                 "pread syscalls", preadCalls)("pread ms", preadMs)("pread MB/s", preadMs > 0 ? mb * 1000 / preadMs : 0)(
+                 "io_uring syscalls", enterCount)("io_uring ms", uringMs)(
+                 "io_uring MB/s", uringMs > 0 ? mb * 1000 / uringMs : 0));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
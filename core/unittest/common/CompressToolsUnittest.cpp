@@ -0,0 +1,290 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "common/CompressTools.h"
+#include "common/Flags.h"
+#include "common/FileSystemUtil.h"
+#include "common/RuntimeUtil.h"
+#include "common/StringTools.h"
+#include "log_pb/sls_logs.pb.h"
+#include "logger/Logger.h"
+#include "sender/ZstdDictionaryManager.h"
+
+DECLARE_FLAG_INT32(zstd_dict_sample_bytes);
+
+namespace logtail {
+
+class CompressToolsUnittest : public ::testing::Test {
+public:
+    void TestCompressType();
+    void TestCompressData();
+    void TestZstdDictionary();
+    void TestDictionaryManager();
+    void BenchmarkCodecs();
+
+protected:
+    void SetUp() override {
+        mRootDir = GetProcessExecutionDir() + "CompressToolsUnittest" + PATH_SEPARATOR;
+        bfs::remove_all(mRootDir);
+        bfs::create_directories(mRootDir);
+    }
+    void TearDown() override { bfs::remove_all(mRootDir); }
+
+private:
+    // Access logs with a few hundred distinct values, like what a logstore usually gets.
+    static std::vector<std::string> MakeLogGroups(size_t count, size_t logsPerGroup, uint32_t seed);
+    // Captured log groups are read from file $LOGTAIL_CODEC_BENCHMARK_DATA if it is set,
+    //  the file is a sequence of serialized sls_logs.LogGroup, each with a 4 bytes length prefix.
+    static bool LoadCapturedLogGroups(std::vector<std::string>& logGroups);
+
+    std::string mRootDir;
+};
+
+UNIT_TEST_CASE(CompressToolsUnittest, TestCompressType);
+UNIT_TEST_CASE(CompressToolsUnittest, TestCompressData);
+UNIT_TEST_CASE(CompressToolsUnittest, TestZstdDictionary);
+UNIT_TEST_CASE(CompressToolsUnittest, TestDictionaryManager);
+UNIT_BENCHMARK_CASE(CompressToolsUnittest, BenchmarkCodecs);
+
+std::vector<std::string> CompressToolsUnittest::MakeLogGroups(size_t count, size_t logsPerGroup, uint32_t seed) {
+    static const char* kMethods[] = {"GET", "POST", "PUT", "DELETE"};
+    static const char* kPaths[] = {"/api/v1/users", "/api/v1/orders", "/api/v2/items", "/static/app.js", "/health"};
+    static const char* kAgents[] = {"Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 Chrome/103.0",
+                                    "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) Safari/605.1.15",
+                                    "curl/7.79.1",
+                                    "Go-http-client/1.1"};
+    srand(seed);
+    std::vector<std::string> logGroups;
+    for (size_t i = 0; i < count; ++i) {
+        sls_logs::LogGroup logGroup;
+        logGroup.set_category("access-log");
+        logGroup.set_topic("nginx");
+        logGroup.set_source("192.168.0.1");
+        auto tag = logGroup.add_logtags();
+        tag->set_key("__path__");
+        tag->set_value("/var/log/nginx/access.log");
+        for (size_t j = 0; j < logsPerGroup; ++j) {
+            auto log = logGroup.add_logs();
+            log->set_time(1660000000 + i);
+            auto addContent = [log](const std::string& key, const std::string& value) {
+                auto content = log->add_contents();
+                content->set_key(key);
+                content->set_value(value);
+            };
+            addContent("remote_addr", "10.0." + ToString(rand() % 16) + "." + ToString(rand() % 256));
+            addContent("method", kMethods[rand() % 4]);
+            addContent("request_uri", std::string(kPaths[rand() % 5]) + "?id=" + ToString(rand() % 100000));
+            addContent("status", rand() % 10 == 0 ? "500" : "200");
+            addContent("body_bytes_sent", ToString(rand() % 20000));
+            addContent("request_time", "0." + ToString(rand() % 1000));
+            addContent("http_user_agent", kAgents[rand() % 4]);
+            addContent("request_id", ToString(rand()) + ToString(rand()));
+        }
+        logGroups.emplace_back(logGroup.SerializeAsString());
+    }
+    return logGroups;
+}
+
+bool CompressToolsUnittest::LoadCapturedLogGroups(std::vector<std::string>& logGroups) {
+    const char* path = getenv("LOGTAIL_CODEC_BENCHMARK_DATA");
+    if (path == NULL) {
+        return false;
+    }
+    std::ifstream in(path, std::ios::binary);
+    uint32_t size = 0;
+    while (in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+        std::string data(size, '\0');
+        if (!in.read(&data[0], size)) {
+            break;
+        }
+        logGroups.emplace_back(std::move(data));
+    }
+    return !logGroups.empty();
+}
+
+void CompressToolsUnittest::TestCompressType() {
+    CompressType type = COMPRESS_LZ4;
+    APSARA_TEST_TRUE(StringToCompressType("zstd", type));
+    APSARA_TEST_EQUAL(type, COMPRESS_ZSTD);
+    APSARA_TEST_EQUAL(std::string(CompressTypeToString(type)), "zstd");
+    APSARA_TEST_TRUE(StringToCompressType("lz4", type));
+    APSARA_TEST_EQUAL(type, COMPRESS_LZ4);
+    APSARA_TEST_EQUAL(std::string(CompressTypeToString(type)), "lz4");
+    APSARA_TEST_FALSE(StringToCompressType("snappy", type));
+    APSARA_TEST_EQUAL(type, COMPRESS_LZ4);
+}
+
+void CompressToolsUnittest::TestCompressData() {
+    const std::string data = MakeLogGroups(1, 100, 0)[0];
+    for (auto type : {COMPRESS_LZ4, COMPRESS_ZSTD}) {
+        std::string compressed, uncompressed;
+        APSARA_TEST_TRUE(CompressData(type, data, compressed, 3));
+        APSARA_TEST_TRUE(compressed.size() < data.size());
+        APSARA_TEST_TRUE(UncompressData(type, compressed, data.size(), uncompressed));
+        APSARA_TEST_TRUE(uncompressed == data);
+        // Wrong raw size is an error.
+        APSARA_TEST_FALSE(UncompressData(type, compressed, data.size() - 1, uncompressed));
+    }
+    // Empty data.
+    std::string compressed, uncompressed;
+    APSARA_TEST_TRUE(CompressZstd("", 0, compressed, 1));
+    APSARA_TEST_TRUE(UncompressZstd(compressed.data(), compressed.size(), 0, uncompressed));
+    APSARA_TEST_TRUE(uncompressed.empty());
+}
+
+void CompressToolsUnittest::TestZstdDictionary() {
+    // Not enough samples.
+    APSARA_TEST_TRUE(ZstdDictionary::Train({"a", "b"}, 16 * 1024, 3) == NULL);
+
+    auto dict = ZstdDictionary::Train(MakeLogGroups(100, 20, 1), 16 * 1024, 3);
+    APSARA_TEST_TRUE_FATAL(dict != NULL);
+    APSARA_TEST_TRUE(dict->GetId() != 0);
+    APSARA_TEST_TRUE(dict->GetContent().size() <= 16 * 1024UL);
+
+    const std::string data = MakeLogGroups(1, 20, 2)[0];
+    std::string plain, withDict, uncompressed;
+    APSARA_TEST_TRUE(CompressZstd(data.data(), data.size(), plain, 3));
+    APSARA_TEST_TRUE(CompressZstd(data.data(), data.size(), withDict, 3, dict.get()));
+    APSARA_TEST_TRUE(withDict.size() < plain.size());
+
+    // Data can be decompressed with the dictionary loaded from content, but not without it.
+    auto loaded = ZstdDictionary::Load(dict->GetContent(), 3);
+    APSARA_TEST_TRUE_FATAL(loaded != NULL);
+    APSARA_TEST_EQUAL(loaded->GetId(), dict->GetId());
+    APSARA_TEST_TRUE(UncompressZstd(withDict.data(), withDict.size(), data.size(), uncompressed, loaded.get()));
+    APSARA_TEST_TRUE(uncompressed == data);
+    APSARA_TEST_FALSE(UncompressZstd(withDict.data(), withDict.size(), data.size(), uncompressed));
+
+    APSARA_TEST_TRUE(ZstdDictionary::Load("not a dictionary", 3) == NULL);
+}
+
+void CompressToolsUnittest::TestDictionaryManager() {
+    const int32_t backup = INT32_FLAG(zstd_dict_sample_bytes);
+    INT32_FLAG(zstd_dict_sample_bytes) = 64 * 1024;
+    const LogstoreFeedBackKey key = 1;
+    std::unique_ptr<ZstdDictionaryManager> manager(new ZstdDictionaryManager);
+    std::shared_ptr<ZstdDictionary> dict;
+    for (const auto& logGroup : MakeLogGroups(100, 20, 5)) {
+        dict = manager->GetDictionary(key, logGroup, mRootDir);
+        if (dict) {
+            break;
+        }
+    }
+    INT32_FLAG(zstd_dict_sample_bytes) = backup;
+    APSARA_TEST_TRUE_FATAL(dict != NULL);
+    APSARA_TEST_TRUE(manager->GetDictionary(key, "", mRootDir) == dict);
+    const std::string fileName = mRootDir + ZstdDictionaryManager::GetDictionaryFileName(dict->GetId());
+    APSARA_TEST_TRUE(bfs::exists(fileName));
+
+    // A new run loads the dictionary from disk.
+    std::unique_ptr<ZstdDictionaryManager> restarted(new ZstdDictionaryManager);
+    auto loaded = restarted->FindDictionary(dict->GetId(), mRootDir);
+    APSARA_TEST_TRUE_FATAL(loaded != NULL);
+    APSARA_TEST_TRUE(loaded->GetContent() == dict->GetContent());
+    APSARA_TEST_TRUE(restarted->FindDictionary(dict->GetId() + 1, mRootDir) == NULL);
+
+    // Dictionaries in use are kept, others are removed.
+    APSARA_TEST_TRUE(OverwriteFile(mRootDir + ZstdDictionaryManager::GetDictionaryFileName(12345), "stale"));
+    manager->RemoveUnusedDictionaries(mRootDir);
+    APSARA_TEST_TRUE(bfs::exists(fileName));
+    APSARA_TEST_FALSE(bfs::exists(mRootDir + ZstdDictionaryManager::GetDictionaryFileName(12345)));
+    restarted->RemoveUnusedDictionaries(mRootDir);
+    APSARA_TEST_FALSE(bfs::exists(fileName));
+    APSARA_TEST_TRUE(restarted->mDictionaries.empty());
+}
+
+// Compression ratio and speed of each codec, on small log groups (sent by logstores with
+//  low traffic or short batch interval) and large ones (merged by busy logstores).
+void CompressToolsUnittest::BenchmarkCodecs() {
+    struct Codec {
+        std::string mName;
+        CompressType mType;
+        int32_t mLevel;
+        bool mWithDictionary;
+    };
+    const std::vector<Codec> codecs = {{"lz4", COMPRESS_LZ4, 0, false},
+                                       {"zstd-1", COMPRESS_ZSTD, 1, false},
+                                       {"zstd-3", COMPRESS_ZSTD, 3, false},
+                                       {"zstd-9", COMPRESS_ZSTD, 9, false},
+                                       {"zstd-3-dict", COMPRESS_ZSTD, 3, true}};
+    std::vector<std::pair<std::string, std::vector<std::string>>> dataSets;
+    std::vector<std::string> captured;
+    if (LoadCapturedLogGroups(captured)) {
+        dataSets.emplace_back("captured", captured);
+    } else {
+        dataSets.emplace_back("10 logs per group", MakeLogGroups(2000, 10, 3));
+        dataSets.emplace_back("1000 logs per group", MakeLogGroups(20, 1000, 4));
+    }
+
+    for (const auto& dataSet : dataSets) {
+        const std::vector<std::string>& logGroups = dataSet.second;
+        // Train with the first 10% (at least 8) of log groups truncated to 64KB like ZstdDictionaryManager
+        //  does, and measure on all of them.
+        std::vector<std::string> samples;
+        for (size_t i = 0; i < logGroups.size() && (i < 8 || i < logGroups.size() / 10); ++i) {
+            samples.emplace_back(logGroups[i].substr(0, 64 * 1024));
+        }
+        size_t rawBytes = 0;
+        for (const auto& logGroup : logGroups) {
+            rawBytes += logGroup.size();
+        }
+        for (const auto& codec : codecs) {
+            std::shared_ptr<ZstdDictionary> dict;
+            if (codec.mWithDictionary) {
+                dict = ZstdDictionary::Train(samples, 64 * 1024, codec.mLevel);
+                APSARA_TEST_TRUE_FATAL(dict != NULL);
+            }
+            std::vector<std::string> compressed(logGroups.size());
+            size_t compressedBytes = 0;
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < logGroups.size(); ++i) {
+                if (dict) {
+                    CompressZstd(logGroups[i].data(), logGroups[i].size(), compressed[i], 0, dict.get());
+                } else {
+                    CompressData(codec.mType, logGroups[i], compressed[i], codec.mLevel);
+                }
+                compressedBytes += compressed[i].size();
+            }
+            auto compressCost = std::chrono::steady_clock::now() - begin;
+            std::string uncompressed;
+            begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < logGroups.size(); ++i) {
+                bool ok = dict ? UncompressZstd(
+                              compressed[i].data(), compressed[i].size(), logGroups[i].size(), uncompressed, dict.get())
+                               : UncompressData(codec.mType, compressed[i], logGroups[i].size(), uncompressed);
+                APSARA_TEST_TRUE(ok);
+            }
+            auto uncompressCost = std::chrono::steady_clock::now() - begin;
+            auto mbps = [rawBytes](std::chrono::steady_clock::duration cost) {
+                double seconds = std::chrono::duration<double>(cost).count();
+                return seconds > 0 ? rawBytes / seconds / 1024 / 1024 : 0;
+            };
+            LOG_INFO(sLogger,
+                     ("benchmark", "codec")("data", dataSet.first)("codec", codec.mName)("raw bytes", rawBytes)(
+                         "ratio", 1.0 * rawBytes / compressedBytes)("compress MB/s", mbps(compressCost))(
+                         "uncompress MB/s", mbps(uncompressCost)));
+        }
+    }
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,214 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <chrono>
+#include <cstdlib>
+#include "common/EncodingConverter.h"
+
+namespace logtail {
+
+class EncodingConverterUnittest : public ::testing::Test {
+public:
+    void TestConvertLines();
+    void TestInvalidLines();
+    void TestCapacity();
+    void TestSameAsIconv();
+    void BenchmarkConvert();
+
+private:
+    // MakeGbkLines returns lines of ASCII mixed with GBK characters, about @asciiPercent of bytes are ASCII.
+    static std::string MakeGbkLines(size_t lineCount, int asciiPercent, bool withInvalid);
+    static std::string Convert(const std::string& gbk, size_t* srcLength, std::vector<size_t>& lineFeedPos);
+};
+
+UNIT_TEST_CASE(EncodingConverterUnittest, TestConvertLines);
+UNIT_TEST_CASE(EncodingConverterUnittest, TestInvalidLines);
+UNIT_TEST_CASE(EncodingConverterUnittest, TestCapacity);
+UNIT_TEST_CASE(EncodingConverterUnittest, TestSameAsIconv);
+UNIT_BENCHMARK_CASE(EncodingConverterUnittest, BenchmarkConvert);
+
+std::string EncodingConverterUnittest::MakeGbkLines(size_t lineCount, int asciiPercent, bool withInvalid) {
+    srand(0);
+    std::string lines;
+    for (size_t i = 0; i < lineCount; ++i) {
+        size_t lineSize = rand() % 200;
+        for (size_t j = 0; j < lineSize; ++j) {
+            if (rand() % 100 < asciiPercent) {
+                lines.push_back(static_cast<char>(' ' + rand() % 95));
+            } else {
+                // Level 1 and 2 Chinese characters of GB2312, 0xD7FA - 0xD7FE are not assigned.
+                lines.push_back(static_cast<char>(0xB0 + rand() % 0x27));
+                lines.push_back(static_cast<char>(0xA1 + rand() % 0x5E));
+            }
+        }
+        if (withInvalid && i % 10 == 5) {
+            // A lead byte without trail byte.
+            lines.push_back('\x81');
+        }
+        lines.push_back('\n');
+    }
+    return lines;
+}
+
+std::string
+EncodingConverterUnittest::Convert(const std::string& gbk, size_t* srcLength, std::vector<size_t>& lineFeedPos) {
+    std::string des(*srcLength * 3, '\0');
+    size_t desLength = EncodingConverter::GetInstance()->ConvertGbk2Utf8Lines(
+        gbk.data(), srcLength, &des[0], des.size(), lineFeedPos);
+    des.resize(desLength);
+    return des;
+}
+
+void EncodingConverterUnittest::TestConvertLines() {
+    // "中文" and euro sign in GBK.
+    std::string gbk = "abc\xD6\xD0\xCE\xC4\n\x80\nlast";
+    size_t srcLength = gbk.size();
+    std::vector<size_t> lineFeedPos;
+    std::string des = Convert(gbk, &srcLength, lineFeedPos);
+    APSARA_TEST_EQUAL(des, "abc\xE4\xB8\xAD\xE6\x96\x87\n\xE2\x82\xAC\nlast");
+    APSARA_TEST_EQUAL(srcLength, gbk.size());
+    APSARA_TEST_EQUAL(lineFeedPos.size(), 2UL);
+    APSARA_TEST_EQUAL(lineFeedPos[0], 7UL);
+    APSARA_TEST_EQUAL(lineFeedPos[1], 9UL);
+
+    // Line feeds at every position of SIMD blocks.
+    for (size_t len = 1; len < 48; ++len) {
+        std::string ascii(len, 'x');
+        ascii[len - 1] = '\n';
+        ascii += "\xD6\xD0" + ascii;
+        srcLength = ascii.size();
+        lineFeedPos.clear();
+        des = Convert(ascii, &srcLength, lineFeedPos);
+        APSARA_TEST_EQUAL(des.size(), ascii.size() + 1);
+        APSARA_TEST_EQUAL(lineFeedPos.size(), 2UL);
+        APSARA_TEST_EQUAL(lineFeedPos[0], len - 1);
+        APSARA_TEST_EQUAL(lineFeedPos[1], ascii.size() - 1);
+    }
+}
+
+void EncodingConverterUnittest::TestInvalidLines() {
+    // 0xFF is invalid, and so is a lead byte followed by '\n' or at the end.
+    std::string gbk = "ok\xD6\xD0\nbad\xFF\xD6\xD0\nbad\x81\nok\nbad\x81";
+    size_t srcLength = gbk.size();
+    std::vector<size_t> lineFeedPos;
+    std::string des = Convert(gbk, &srcLength, lineFeedPos);
+    APSARA_TEST_EQUAL(des, "ok\xE4\xB8\xAD\nbad\xFF\xD6\xD0\nbad\x81\nok\nbad\x81");
+    APSARA_TEST_EQUAL(srcLength, gbk.size());
+    APSARA_TEST_EQUAL(lineFeedPos.size(), 4UL);
+    APSARA_TEST_EQUAL(lineFeedPos[1], 11UL);
+    APSARA_TEST_EQUAL(lineFeedPos[2], 16UL);
+}
+
+void EncodingConverterUnittest::TestCapacity() {
+    std::string gbk = "0123456789\n\xD6\xD0\xD6\xD0\n0123456789012345678901234567890123456789\n";
+    std::vector<size_t> lineFeedPos;
+    for (size_t capacity = 0; capacity < 80; ++capacity) {
+        std::string des(capacity, '\0');
+        size_t srcLength = gbk.size();
+        lineFeedPos.clear();
+        size_t desLength = EncodingConverter::GetInstance()->ConvertGbk2Utf8Lines(
+            gbk.data(), &srcLength, &des[0], capacity, lineFeedPos);
+        // Only whole lines are converted.
+        if (capacity < 11) {
+            APSARA_TEST_EQUAL(srcLength, 0UL);
+            APSARA_TEST_EQUAL(desLength, 0UL);
+        } else if (capacity < 18) {
+            APSARA_TEST_EQUAL(srcLength, 11UL);
+            APSARA_TEST_EQUAL(desLength, 11UL);
+        } else if (capacity < 59) {
+            APSARA_TEST_EQUAL(srcLength, 16UL);
+            APSARA_TEST_EQUAL(desLength, 18UL);
+        } else {
+            APSARA_TEST_EQUAL(srcLength, gbk.size());
+            APSARA_TEST_EQUAL(desLength, 59UL);
+        }
+        size_t lineCount = 0;
+        for (size_t i = 0; i < srcLength; ++i) {
+            lineCount += gbk[i] == '\n';
+        }
+        APSARA_TEST_EQUAL(lineFeedPos.size(), lineCount);
+    }
+}
+
+void EncodingConverterUnittest::TestSameAsIconv() {
+#if defined(__linux__)
+    for (int asciiPercent = 0; asciiPercent <= 100; asciiPercent += 25) {
+        std::string gbk = MakeGbkLines(1000, asciiPercent, true);
+        std::vector<size_t> lineFeedPos;
+        size_t srcLength = gbk.size();
+        std::string des = Convert(gbk, &srcLength, lineFeedPos);
+        APSARA_TEST_EQUAL(srcLength, gbk.size());
+        APSARA_TEST_EQUAL(lineFeedPos.size(), 1000UL);
+
+        srcLength = gbk.size();
+        char* iconvDes = NULL;
+        size_t iconvDesLength = 0;
+        APSARA_TEST_TRUE(EncodingConverter::GetInstance()->ConvertGbk2Utf8(
+            &gbk[0], &srcLength, iconvDes, &iconvDesLength, lineFeedPos));
+        APSARA_TEST_EQUAL(des, std::string(iconvDes, iconvDesLength));
+        delete[] iconvDes;
+    }
+#endif
+}
+
+void EncodingConverterUnittest::BenchmarkConvert() {
+#if defined(__linux__)
+    std::string gbk = MakeGbkLines(50000, 95, false);
+    const int rounds = 10;
+
+    // The same work as LogFileReader::ReadGBK before: find line feeds, then iconv line by line.
+    size_t iconvBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        std::vector<size_t> lineFeedPos;
+        for (size_t idx = 0; idx < gbk.size() - 1; ++idx) {
+            if (gbk[idx] == '\n') {
+                lineFeedPos.push_back(idx);
+            }
+        }
+        lineFeedPos.push_back(gbk.size() - 1);
+        size_t srcLength = gbk.size();
+        char* des = NULL;
+        size_t desLength = 0;
+        EncodingConverter::GetInstance()->ConvertGbk2Utf8(&gbk[0], &srcLength, des, &desLength, lineFeedPos);
+        iconvBytes += desLength;
+        delete[] des;
+    }
+    auto iconvCost = std::chrono::steady_clock::now() - start;
+
+    std::string des(gbk.size() * 3, '\0');
+    size_t bytes = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        std::vector<size_t> lineFeedPos;
+        size_t srcLength = gbk.size();
+        bytes += EncodingConverter::GetInstance()->ConvertGbk2Utf8Lines(
+            gbk.data(), &srcLength, &des[0], des.size(), lineFeedPos);
+    }
+    auto cost = std::chrono::steady_clock::now() - start;
+
+    APSARA_TEST_EQUAL(bytes, iconvBytes);
+    auto iconvMs = std::chrono::duration_cast<std::chrono::milliseconds>(iconvCost).count();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(cost).count();
+    double mb = gbk.size() * rounds / 1024.0 / 1024.0;
+    LOG_INFO(sLogger,
+             ("benchmark", "gbk to utf8")("data MB", mb)("iconv ms", iconvMs)("table ms", ms)(
+                 "iconv MB/s", iconvMs > 0 ? mb * 1000 / iconvMs : 0)("table MB/s", ms > 0 ? mb * 1000 / ms : 0));
+#endif
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,249 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <chrono>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include "common/JsonObjectScanner.h"
+#include "common/StringTools.h"
+
+namespace logtail {
+
+class JsonObjectScannerUnittest : public ::testing::Test {
+public:
+    void TestScanMembers();
+    void TestEscape();
+    void TestInvalid();
+    void TestSameAsRapidjson();
+    void BenchmarkScan();
+
+private:
+    static std::string MakeJsonLog(int seq);
+};
+
+UNIT_TEST_CASE(JsonObjectScannerUnittest, TestScanMembers);
+UNIT_TEST_CASE(JsonObjectScannerUnittest, TestEscape);
+UNIT_TEST_CASE(JsonObjectScannerUnittest, TestInvalid);
+UNIT_TEST_CASE(JsonObjectScannerUnittest, TestSameAsRapidjson);
+UNIT_BENCHMARK_CASE(JsonObjectScannerUnittest, BenchmarkScan);
+
+std::string JsonObjectScannerUnittest::MakeJsonLog(int seq) {
+    return "{\"time\": \"2022-08-01 12:00:0" + ToString(seq % 10) + "\", \"level\": \"INFO\", \"seq\": " + ToString(seq)
+        + ", \"latency\": 0." + ToString(seq % 1000) + ", \"success\": " + (seq % 2 ? "true" : "false")
+        + ", \"trace\": null, \"msg\": \"request /api/v1/users/" + ToString(seq)
+        + " done\\tstatus=200\", \"tags\": [\"a\", \"b\"], \"ctx\": {\"user\": \"u" + ToString(seq)
+        + "\", \"region\": \"cn-hangzhou\", \"attrs\": {\"k\": [1, 2, {\"x\": \"}]\"}]}}}";
+}
+
+void JsonObjectScannerUnittest::TestScanMembers() {
+    JsonObjectScanner scanner;
+    const char* log = " {\"s\":\"str\", \"i\" : -12, \"d\":1.50e+3,\"t\":true,\"f\":false,\"n\":null,"
+                      "\"o\":{ \"a\" : [1, \"]\"] },\"a\":[ ],\"e\":\"\",\"s\":\"dup\"}\n";
+    APSARA_TEST_TRUE(scanner.Scan(log));
+    auto& members = scanner.Members();
+    APSARA_TEST_EQUAL(members.size(), 10UL);
+    const char* keys[] = {"s", "i", "d", "t", "f", "n", "o", "a", "e", "s"};
+    const char* values[] = {"str", "-12", "1.50e+3", "true", "false", "", "{ \"a\" : [1, \"]\"] }", "[ ]", "", "dup"};
+    JsonValueType types[] = {JSON_VALUE_STRING,
+                             JSON_VALUE_NUMBER,
+                             JSON_VALUE_NUMBER,
+                             JSON_VALUE_TRUE,
+                             JSON_VALUE_FALSE,
+                             JSON_VALUE_NULL,
+                             JSON_VALUE_OBJECT,
+                             JSON_VALUE_ARRAY,
+                             JSON_VALUE_STRING,
+                             JSON_VALUE_STRING};
+    for (size_t i = 0; i < members.size(); ++i) {
+        APSARA_TEST_EQUAL(members[i].key.as_string(), keys[i]);
+        APSARA_TEST_EQUAL(members[i].value.as_string(), values[i]);
+        APSARA_TEST_EQUAL(members[i].type, types[i]);
+    }
+    // Values are slices of the input.
+    APSARA_TEST_TRUE(members[0].value.data() > log && members[0].value.data() < log + strlen(log));
+
+    APSARA_TEST_EQUAL(scanner.FindMember("s")->value.as_string(), "str");
+    APSARA_TEST_TRUE(scanner.FindMember("x") == NULL);
+    APSARA_TEST_TRUE(JsonObjectScanner::IsInteger(members[1]));
+    APSARA_TEST_TRUE(!JsonObjectScanner::IsInteger(members[2]));
+    APSARA_TEST_TRUE(!JsonObjectScanner::IsInteger(members[0]));
+
+    APSARA_TEST_TRUE(scanner.Scan("{}"));
+    APSARA_TEST_EQUAL(scanner.Members().size(), 0UL);
+}
+
+void JsonObjectScannerUnittest::TestEscape() {
+    JsonObjectScanner scanner;
+    APSARA_TEST_TRUE(scanner.Scan("{\"k\\\"1\":\"a\\\\b\\/c\\b\\f\\n\\r\\t\",\"k2\":\"\\u0041\\u00e9\\u4e2d\\ud83d\\ude00\","
+                                  "\"k3\":\"plain\"}"));
+    auto& members = scanner.Members();
+    APSARA_TEST_EQUAL(members.size(), 3UL);
+    APSARA_TEST_EQUAL(members[0].key.as_string(), "k\"1");
+    APSARA_TEST_EQUAL(members[0].value.as_string(), "a\\b/c\b\f\n\r\t");
+    APSARA_TEST_EQUAL(members[1].value.as_string(), "A\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80");
+    APSARA_TEST_EQUAL(members[2].value.as_string(), "plain");
+    APSARA_TEST_TRUE(members[0].keyOffset >= 0);
+    APSARA_TEST_TRUE(members[2].valueOffset < 0);
+
+    // Strings ending at every position of SIMD blocks.
+    for (size_t len = 0; len < 48; ++len) {
+        for (size_t shift = 0; shift < 16; ++shift) {
+            std::string value(len, 'x');
+            if (len > 0) {
+                value[len / 2] = '\\';
+                value.insert(len / 2 + 1, "n");
+            }
+            std::string log = std::string(shift, ' ') + "{\"k\":\"" + value + "\"}";
+            APSARA_TEST_TRUE(scanner.Scan(log.c_str()));
+            std::string expected(len, 'x');
+            if (len > 0) {
+                expected[len / 2] = '\n';
+            }
+            APSARA_TEST_EQUAL(scanner.Members()[0].value.as_string(), expected);
+        }
+    }
+}
+
+void JsonObjectScannerUnittest::TestInvalid() {
+    const char* logs[] = {"",
+                          "  ",
+                          "[1]",
+                          "\"str\"",
+                          "{",
+                          "{\"k\"}",
+                          "{\"k\":}",
+                          "{\"k\":1,}",
+                          "{\"k\":1 \"k2\":2}",
+                          "{k:1}",
+                          "{\"k\":01}",
+                          "{\"k\":1.}",
+                          "{\"k\":1e}",
+                          "{\"k\":-}",
+                          "{\"k\":tru}",
+                          "{\"k\":nul}",
+                          "{\"k\":\"abc}",
+                          "{\"k\":\"a\tb\"}",
+                          "{\"k\":\"\\x\"}",
+                          "{\"k\":\"\\u12\"}",
+                          "{\"k\":\"\\ud83d\"}",
+                          "{\"k\":[1, 2}",
+                          "{\"k\":{\"a\":[}]}",
+                          "{\"k\":[\"]]\"}",
+                          "{\"k\":1} {}",
+                          "{\"k\":1}}"};
+    JsonObjectScanner scanner;
+    for (const char* log : logs) {
+        APSARA_TEST_TRUE_DESC(!scanner.Scan(log), log);
+        APSARA_TEST_TRUE_DESC(scanner.Error() != NULL, log);
+        APSARA_TEST_TRUE_DESC(scanner.ErrorOffset() <= strlen(log), log);
+
+        rapidjson::Document doc;
+        doc.Parse(log);
+        APSARA_TEST_TRUE_DESC(doc.HasParseError() || !doc.IsObject(), log);
+    }
+    APSARA_TEST_TRUE(!scanner.Scan("{\"k\":1,}"));
+    APSARA_TEST_EQUAL(scanner.ErrorOffset(), 7UL);
+}
+
+void JsonObjectScannerUnittest::TestSameAsRapidjson() {
+    JsonObjectScanner scanner;
+    for (int seq = 0; seq < 1000; ++seq) {
+        std::string log = MakeJsonLog(seq);
+        APSARA_TEST_TRUE(scanner.Scan(log.c_str()));
+        rapidjson::Document doc;
+        doc.Parse(log.c_str());
+        APSARA_TEST_TRUE(!doc.HasParseError() && doc.IsObject());
+        APSARA_TEST_EQUAL(scanner.Members().size(), doc.MemberCount());
+
+        size_t idx = 0;
+        for (auto itr = doc.MemberBegin(); itr != doc.MemberEnd(); ++itr, ++idx) {
+            const JsonMember& member = scanner.Members()[idx];
+            APSARA_TEST_EQUAL(member.key.as_string(), itr->name.GetString());
+            if (itr->value.IsString()) {
+                APSARA_TEST_EQUAL(member.value.as_string(), itr->value.GetString());
+            } else if (itr->value.IsInt64()) {
+                APSARA_TEST_EQUAL(member.value.as_string(), ToString(itr->value.GetInt64()));
+            } else if (itr->value.IsObject() || itr->value.IsArray()) {
+                // Raw text has the same value as rapidjson.
+                rapidjson::Document nested;
+                nested.Parse(member.value.as_string().c_str());
+                APSARA_TEST_TRUE(!nested.HasParseError() && nested == itr->value);
+            }
+        }
+    }
+}
+
+void JsonObjectScannerUnittest::BenchmarkScan() {
+    std::vector<std::string> logs;
+    size_t bytes = 0;
+    for (int seq = 0; seq < 10000; ++seq) {
+        logs.push_back(MakeJsonLog(seq));
+        bytes += logs.back().size();
+    }
+    const int rounds = 10;
+
+    // The same work as JsonLogFileReader in rapidjson mode: DOM, strlen and stringify values.
+    size_t rapidjsonBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        for (auto& log : logs) {
+            if (strlen(log.c_str()) == 0) {
+                continue;
+            }
+            rapidjson::Document doc;
+            doc.Parse(log.c_str());
+            for (auto itr = doc.MemberBegin(); itr != doc.MemberEnd(); ++itr) {
+                std::string value;
+                if (itr->value.IsString()) {
+                    value = itr->value.GetString();
+                } else {
+                    rapidjson::StringBuffer buffer;
+                    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+                    itr->value.Accept(writer);
+                    value = buffer.GetString();
+                }
+                rapidjsonBytes += std::string(itr->name.GetString()).size() + value.size();
+            }
+        }
+    }
+    auto rapidjsonCost = std::chrono::steady_clock::now() - start;
+
+    JsonObjectScanner scanner;
+    size_t scannerBytes = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        for (auto& log : logs) {
+            scanner.Scan(log.c_str());
+            for (auto& member : scanner.Members()) {
+                scannerBytes += member.key.size() + member.value.size();
+            }
+        }
+    }
+    auto cost = std::chrono::steady_clock::now() - start;
+
+    APSARA_TEST_TRUE(scannerBytes > 0 && rapidjsonBytes > 0);
+    auto rapidjsonMs = std::chrono::duration_cast<std::chrono::milliseconds>(rapidjsonCost).count();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(cost).count();
+    double mb = bytes * rounds / 1024.0 / 1024.0;
+    LOG_INFO(sLogger,
+             ("benchmark", "json object scan")("data MB", mb)("rapidjson ms", rapidjsonMs)("scanner ms", ms)(
+                 "rapidjson MB/s", rapidjsonMs > 0 ? mb * 1000 / rapidjsonMs : 0)("scanner MB/s",
+                                                                                  ms > 0 ? mb * 1000 / ms : 0));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,286 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "common/LogstoreFeedbackQueue.h"
+#include "logger/Logger.h"
+
+namespace logtail {
+
+class TestFeedbackQueueParam : public LogstoreFeedbackQueueParam {
+public:
+    static TestFeedbackQueueParam* GetInstance() {
+        static auto sQueueParam = new TestFeedbackQueueParam;
+        return sQueueParam;
+    }
+};
+
+class MockFeedBack : public LogstoreFeedBackInterface {
+public:
+    void FeedBack(const LogstoreFeedBackKey& key) override { ++mFeedBackCount; }
+
+    // Takes a lock like the sender queue does.
+    bool IsValidToPush(const LogstoreFeedBackKey& key) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mInvalidKeys.find(key) == mInvalidKeys.end();
+    }
+
+    std::mutex mMutex;
+    std::atomic_int mFeedBackCount{0};
+    std::set<LogstoreFeedBackKey> mInvalidKeys;
+};
+
+typedef LogstoreFeedbackQueue<int64_t, TestFeedbackQueueParam> TestFeedbackQueue;
+
+class LogstoreFeedbackQueueUnittest : public ::testing::Test {
+public:
+    void SetUp() override {
+        mQueue.reset(new TestFeedbackQueue);
+        mQueue->SetParam(2, 4, 6);
+        mQueue->SetFeedBackObject(&mFeedBack);
+        mFeedBack.mFeedBackCount = 0;
+        mFeedBack.mInvalidKeys.clear();
+    }
+
+    void TestWatermark() {
+        const LogstoreFeedBackKey key = 1;
+        for (int64_t i = 0; i < 4; ++i) {
+            APSARA_TEST_TRUE(mQueue->IsValidToPush(key));
+            APSARA_TEST_TRUE(mQueue->PushItem(key, i));
+        }
+        // Invalid after reaching high size, but still accepts items until full.
+        APSARA_TEST_FALSE(mQueue->IsValidToPush(key));
+        APSARA_TEST_TRUE(mQueue->PushItem(key, 4));
+        APSARA_TEST_TRUE(mQueue->PushItem(key, 5));
+        APSARA_TEST_FALSE(mQueue->PushItem(key, 6));
+
+        LogstoreFeedBackKey startKey = 0;
+        int64_t item = -1;
+        for (int64_t i = 0; i < 4; ++i) {
+            APSARA_TEST_EQUAL(mFeedBack.mFeedBackCount.load(), 0);
+            APSARA_TEST_TRUE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 1));
+            APSARA_TEST_EQUAL(item, i);
+        }
+        // Valid again and fed back when it drops to low size.
+        APSARA_TEST_EQUAL(mFeedBack.mFeedBackCount.load(), 1);
+        APSARA_TEST_TRUE(mQueue->IsValidToPush(key));
+        APSARA_TEST_TRUE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 1));
+        APSARA_TEST_TRUE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 1));
+        APSARA_TEST_EQUAL(item, 5);
+        APSARA_TEST_FALSE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 1));
+        APSARA_TEST_TRUE(mQueue->IsEmpty());
+        APSARA_TEST_EQUAL(mFeedBack.mFeedBackCount.load(), 1);
+    }
+
+    void TestPriorityAndFairness() {
+        for (LogstoreFeedBackKey key = 1; key <= 3; ++key) {
+            APSARA_TEST_TRUE(mQueue->PushItem(key, key * 10));
+            APSARA_TEST_TRUE(mQueue->PushItem(key, key * 10 + 1));
+        }
+        mQueue->SetPriority(3, 1);
+
+        LogstoreFeedBackKey startKey = 0;
+        int64_t item = -1;
+        std::vector<int64_t> items;
+        while (mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 1)) {
+            items.push_back(item);
+        }
+        // Queue with priority goes first, others are popped round robin.
+        std::vector<int64_t> expected = {30, 31, 10, 20, 11, 21};
+        APSARA_TEST_TRUE(items == expected);
+    }
+
+    void TestCheckAndExactlyOnce() {
+        APSARA_TEST_TRUE(mQueue->PushItem(1, 1));
+        APSARA_TEST_TRUE(mQueue->PushItem(2, 2));
+        APSARA_TEST_TRUE(mQueue->PushItem(3, 3));
+        mFeedBack.mInvalidKeys.insert(1);
+        mQueue->ConvertToExactlyOnceQueue(3);
+
+        LogstoreFeedBackKey startKey = 0;
+        int64_t item = -1;
+        // Thread 0 of 2 can not pop exactly once queue 3, key 1 is blocked by checker.
+        APSARA_TEST_TRUE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 2));
+        APSARA_TEST_EQUAL(item, 2);
+        APSARA_TEST_FALSE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 2));
+        APSARA_TEST_TRUE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 1, 2));
+        APSARA_TEST_EQUAL(item, 3);
+        mFeedBack.mInvalidKeys.clear();
+        APSARA_TEST_TRUE(mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 2));
+        APSARA_TEST_EQUAL(item, 1);
+    }
+
+    void TestDeleteAndReuseSlot() {
+        for (LogstoreFeedBackKey key = 1; key <= 40; ++key) {
+            APSARA_TEST_TRUE(mQueue->PushItem(key, key));
+        }
+        mQueue->Delete(5);
+        APSARA_TEST_TRUE(mQueue->IsEmpty(5));
+        // The slot of queue 5 is reused by queue 41.
+        APSARA_TEST_TRUE(mQueue->PushItem(41, 41));
+        APSARA_TEST_EQUAL(mQueue->mSlots.size(), 40UL);
+
+        LogstoreFeedBackKey startKey = 0;
+        int64_t item = -1;
+        std::set<int64_t> items;
+        while (mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, 0, 1)) {
+            items.insert(item);
+        }
+        APSARA_TEST_EQUAL(items.size(), 40UL);
+        APSARA_TEST_TRUE(items.find(5) == items.end());
+        APSARA_TEST_TRUE(items.find(41) != items.end());
+        APSARA_TEST_TRUE(mQueue->IsEmpty());
+    }
+
+    void TestConcurrentPushPop() {
+        mQueue->SetParam(10, 15, 100);
+        int64_t elapsedMs = 0;
+        APSARA_TEST_TRUE(runContention(4, 4, 64, 50000, elapsedMs));
+    }
+
+    // Producers push only when the queue is valid, as readers do, while consumers pop it between
+    //  low and high size. The queue must never be left invalid at or below low size, or producers
+    //  stop and it stalls.
+    void TestWatermarkContention() {
+        mQueue->SetParam(1, 2, 4);
+        const LogstoreFeedBackKey key = 1;
+        const int kProducers = 4;
+        const int kConsumers = 4;
+        const int kItemsPerProducer = 20000;
+        const int64_t total = (int64_t)kProducers * kItemsPerProducer;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        std::atomic<int64_t> popped(0);
+        std::atomic_bool stalled(false);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < kProducers; ++p) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < kItemsPerProducer && !stalled; ++i) {
+                    while (!mQueue->IsValidToPush(key) || !mQueue->PushItem(key, i)) {
+                        if (std::chrono::steady_clock::now() > deadline) {
+                            stalled = true;
+                            return;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < kConsumers; ++c) {
+            threads.emplace_back([&, c]() {
+                LogstoreFeedBackKey startKey = 0;
+                int64_t item = 0;
+                while (popped.load() < total && !stalled) {
+                    if (mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, c, kConsumers)) {
+                        ++popped;
+                    } else if (std::chrono::steady_clock::now() > deadline) {
+                        stalled = true;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        APSARA_TEST_FALSE(stalled.load());
+        APSARA_TEST_EQUAL(popped.load(), total);
+        APSARA_TEST_TRUE(mQueue->IsEmpty());
+        APSARA_TEST_TRUE(mQueue->IsValidToPush(key));
+    }
+
+    // Throughput with N producers and M consumers. Most logstores of a host are idle, so queues
+    //  of idle logstores are created before the run.
+    void BenchmarkContention() {
+        mQueue->SetParam(10, 15, 100);
+        const int kItemsPerProducer = 100000;
+        const int kActiveKeyCount = 32;
+        const int kIdleKeyCount = 2000;
+        const std::vector<std::pair<int, int>> cases = {{1, 1}, {4, 4}, {8, 8}, {2, 8}, {8, 2}};
+        for (auto& c : cases) {
+            mQueue.reset(new TestFeedbackQueue);
+            mQueue->SetFeedBackObject(&mFeedBack);
+            for (int i = 0; i < kIdleKeyCount; ++i) {
+                mQueue->IsValidToPush(kActiveKeyCount + 1 + i);
+            }
+            int64_t elapsedMs = 0;
+            APSARA_TEST_TRUE(runContention(c.first, c.second, kActiveKeyCount, kItemsPerProducer, elapsedMs));
+            const double total = 1.0 * c.first * kItemsPerProducer;
+            LOG_INFO(sLogger,
+                     ("benchmark", "logstore feedback queue")("producers", c.first)("consumers", c.second)(
+                         "idle logstores", kIdleKeyCount)("items", total)("ms", elapsedMs)(
+                         "items/s", elapsedMs > 0 ? total * 1000 / elapsedMs : 0));
+        }
+    }
+
+private:
+    bool runContention(int producers, int consumers, int keyCount, int itemsPerProducer, int64_t& elapsedMs) {
+        const int64_t total = (int64_t)producers * itemsPerProducer;
+        std::atomic<int64_t> popped(0), poppedSum(0);
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([this, p, producers, keyCount, itemsPerProducer]() {
+                for (int i = 0; i < itemsPerProducer; ++i) {
+                    LogstoreFeedBackKey key = (p + (int64_t)i * producers) % keyCount + 1;
+                    while (!mQueue->PushItem(key, i)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([this, c, consumers, total, &popped, &poppedSum]() {
+                LogstoreFeedBackKey startKey = 0;
+                int64_t item = 0;
+                while (popped.load() < total) {
+                    if (!mQueue->CheckAndPopNextItem(startKey, item, &mFeedBack, c, consumers)) {
+                        mQueue->Wait(1);
+                        continue;
+                    }
+                    poppedSum += item;
+                    ++popped;
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        elapsedMs
+            = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+        const int64_t expectedSum = (int64_t)producers * itemsPerProducer * (itemsPerProducer - 1) / 2;
+        return popped.load() == total && poppedSum.load() == expectedSum && mQueue->IsEmpty();
+    }
+
+    std::unique_ptr<TestFeedbackQueue> mQueue;
+    MockFeedBack mFeedBack;
+};
+
+UNIT_TEST_CASE(LogstoreFeedbackQueueUnittest, TestWatermark);
+UNIT_TEST_CASE(LogstoreFeedbackQueueUnittest, TestPriorityAndFairness);
+UNIT_TEST_CASE(LogstoreFeedbackQueueUnittest, TestCheckAndExactlyOnce);
+UNIT_TEST_CASE(LogstoreFeedbackQueueUnittest, TestDeleteAndReuseSlot);
+UNIT_TEST_CASE(LogstoreFeedbackQueueUnittest, TestConcurrentPushPop);
+UNIT_TEST_CASE(LogstoreFeedbackQueueUnittest, TestWatermarkContention);
+UNIT_BENCHMARK_CASE(LogstoreFeedbackQueueUnittest, BenchmarkContention);
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
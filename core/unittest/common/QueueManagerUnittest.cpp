@@ -41,7 +41,7 @@ public:
 
     void SetUp() {
         sQueueM->clear();
-        sProcessQueueMap->clear();
+        LogProcess::GetInstance()->GetQueue().RemoveAll();
         sSenderQueueMap->clear();
     }
 
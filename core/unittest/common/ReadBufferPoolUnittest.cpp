@@ -0,0 +1,105 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <thread>
+#include "common/Flags.h"
+#include "common/ReadBufferPool.h"
+
+DECLARE_FLAG_INT32(read_buffer_pool_max_free_count);
+
+namespace logtail {
+
+class ReadBufferPoolUnittest : public ::testing::Test {
+public:
+    void SetUp() override {
+        sPool = ReadBufferPool::GetInstance();
+        // Reset to an empty pool.
+        sPool->SetBlockSize(1);
+        sPool->SetBlockSize(kBlockSize);
+    }
+
+    void TestReuse() {
+        char* first = NULL;
+        {
+            ReadBufferPtr buffer = sPool->Acquire(kBlockSize);
+            first = buffer.get();
+            APSARA_TEST_EQUAL(reinterpret_cast<uintptr_t>(first) % 64, 0UL);
+            // Handle is shared, block is held until the last copy is released.
+            ReadBufferPtr copy = buffer;
+            buffer.reset();
+            APSARA_TEST_EQUAL(sPool->GetFreeBlockCount(), 0UL);
+        }
+        APSARA_TEST_EQUAL(sPool->GetFreeBlockCount(), 1UL);
+        auto hit = sPool->GetHitCount();
+        ReadBufferPtr buffer = sPool->Acquire(100);
+        APSARA_TEST_EQUAL(buffer.get(), first);
+        APSARA_TEST_EQUAL(sPool->GetHitCount(), hit + 1);
+    }
+
+    void TestOversizeAndResize() {
+        {
+            // Larger than block size, not pooled.
+            ReadBufferPtr buffer = sPool->Acquire(kBlockSize * 2);
+            buffer.get()[kBlockSize * 2 - 1] = '\0';
+        }
+        APSARA_TEST_EQUAL(sPool->GetFreeBlockCount(), 0UL);
+
+        ReadBufferPtr buffer = sPool->Acquire(kBlockSize);
+        sPool->SetBlockSize(kBlockSize * 4);
+        buffer.reset();
+        // Block with old size is freed.
+        APSARA_TEST_EQUAL(sPool->GetFreeBlockCount(), 0UL);
+    }
+
+    void TestMaxFreeCount() {
+        std::vector<ReadBufferPtr> buffers;
+        for (int i = 0; i < INT32_FLAG(read_buffer_pool_max_free_count) + 10; ++i) {
+            buffers.push_back(sPool->Acquire(kBlockSize));
+        }
+        buffers.clear();
+        APSARA_TEST_EQUAL(sPool->GetFreeBlockCount(), size_t(INT32_FLAG(read_buffer_pool_max_free_count)));
+    }
+
+    // Buffers are acquired by reader thread and released by processor threads.
+    void TestCrossThreadRelease() {
+        std::vector<ReadBufferPtr> buffers;
+        for (int i = 0; i < 8; ++i) {
+            buffers.push_back(sPool->Acquire(kBlockSize));
+        }
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            ReadBufferPtr buffer = buffers[i];
+            threads.emplace_back([buffer]() mutable { buffer.reset(); });
+        }
+        buffers.clear();
+        for (auto& t : threads) {
+            t.join();
+        }
+        APSARA_TEST_EQUAL(sPool->GetFreeBlockCount(), 8UL);
+    }
+
+private:
+    static const size_t kBlockSize = 64 * 1024 + 1;
+    ReadBufferPool* sPool = NULL;
+};
+
+UNIT_TEST_CASE(ReadBufferPoolUnittest, TestReuse);
+UNIT_TEST_CASE(ReadBufferPoolUnittest, TestOversizeAndResize);
+UNIT_TEST_CASE(ReadBufferPoolUnittest, TestMaxFreeCount);
+UNIT_TEST_CASE(ReadBufferPoolUnittest, TestCrossThreadRelease);
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,127 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <boost/regex.hpp>
+#include "common/RegexPrefilter.h"
+#include "common/LineFeedScanner.h"
+
+namespace logtail {
+
+class RegexPrefilterUnittest : public ::testing::Test {
+public:
+    void TestShape();
+    void TestNoFalseNegative();
+    void TestFindLineFeeds();
+};
+
+UNIT_TEST_CASE(RegexPrefilterUnittest, TestShape);
+UNIT_TEST_CASE(RegexPrefilterUnittest, TestNoFalseNegative);
+UNIT_TEST_CASE(RegexPrefilterUnittest, TestFindLineFeeds);
+
+void RegexPrefilterUnittest::TestShape() {
+    {
+        RegexPrefilter filter("\\[\\d+-\\d+\\].*");
+        APSARA_TEST_TRUE(filter.IsEnabled());
+        APSARA_TEST_EQUAL(filter.GetLiteralPrefix(), std::string("["));
+        APSARA_TEST_EQUAL(filter.GetShapeLength(), 2UL);
+    }
+    {
+        RegexPrefilter filter("\\d{4}-\\d{2}-\\d{2}\\s\\d{2}:\\d{2}:\\d{2}.*");
+        APSARA_TEST_TRUE(filter.IsEnabled());
+        APSARA_TEST_EQUAL(filter.GetShapeLength(), 19UL);
+        const std::string line = "2022-08-01 12:00:00,123 INFO";
+        APSARA_TEST_TRUE(filter.MayMatch(line.data(), line.size()));
+        const std::string trace = "\tat com.example.Main.main(Main.java:10)";
+        APSARA_TEST_FALSE(filter.MayMatch(trace.data(), trace.size()));
+        const std::string shortLine = "2022-08-01";
+        APSARA_TEST_FALSE(filter.MayMatch(shortLine.data(), shortLine.size()));
+    }
+    {
+        RegexPrefilter filter("^\\[[0-9]{2}\\] .*");
+        APSARA_TEST_EQUAL(filter.GetShapeLength(), 5UL);
+    }
+    {
+        RegexPrefilter filter("x\\.y\\ .*");
+        APSARA_TEST_EQUAL(filter.GetLiteralPrefix(), std::string("x.y "));
+    }
+    {
+        // Optional elements end the shape.
+        RegexPrefilter filter("ab?c.*");
+        APSARA_TEST_EQUAL(filter.GetLiteralPrefix(), std::string("a"));
+        APSARA_TEST_EQUAL(filter.GetShapeLength(), 1UL);
+    }
+    // Disabled cases.
+    APSARA_TEST_FALSE(RegexPrefilter("abc|def.*").IsEnabled());
+    APSARA_TEST_FALSE(RegexPrefilter("(a|b).*").IsEnabled());
+    APSARA_TEST_FALSE(RegexPrefilter(".*x").IsEnabled());
+    APSARA_TEST_FALSE(RegexPrefilter("(?i)abc.*").IsEnabled());
+    APSARA_TEST_FALSE(RegexPrefilter("\\Qa|b\\E.*").IsEnabled());
+}
+
+// The prefilter must never reject a line matched by the regex.
+void RegexPrefilterUnittest::TestNoFalseNegative() {
+    const char* regs[] = {"\\[\\d+-\\d+\\].*",
+                          "\\d{4}-\\d{2}-\\d{2}\\s\\d{2}:\\d{2}:\\d{2}.*",
+                          "^\\[[0-9]{2}\\] .*",
+                          "ab?c.*",
+                          "\\d{2,3}x.*",
+                          "x\\.y\\ .*",
+                          "\\t\\w\\w+.*",
+                          "a{2}?b.*",
+                          "[ab]{2}.*"};
+    const char alphabet[] = "0123456789[]- :.abcdefxy\t_";
+    srand(0);
+    for (size_t r = 0; r < sizeof(regs) / sizeof(regs[0]); ++r) {
+        RegexPrefilter filter(regs[r]);
+        boost::regex reg(regs[r]);
+        int falseNegatives = 0;
+        for (int t = 0; t < 20000; ++t) {
+            std::string line;
+            if (t % 7 == 0) {
+                line = "2022-01-02 12:34:56";
+            } else if (t % 11 == 0) {
+                line = "[12-3] ";
+            } else if (t % 13 == 0) {
+                line = "aab";
+            }
+            int len = rand() % 25;
+            for (int i = 0; i < len; ++i) {
+                line.push_back(alphabet[rand() % (sizeof(alphabet) - 1)]);
+            }
+            if (boost::regex_match(line.c_str(), reg) && !filter.MayMatch(line.data(), line.size())) {
+                ++falseNegatives;
+            }
+        }
+        APSARA_TEST_EQUAL_DESC(falseNegatives, 0, regs[r]);
+    }
+}
+
+void RegexPrefilterUnittest::TestFindLineFeeds() {
+    srand(0);
+    for (size_t size = 0; size < 300; ++size) {
+        std::string buffer;
+        for (size_t i = 0; i < size; ++i) {
+            buffer.push_back(rand() % 8 == 0 ? '\n' : 'a' + rand() % 26);
+        }
+        std::vector<int32_t> expected, actual;
+        FindLineFeedsScalar(buffer.data(), buffer.size(), expected);
+        FindLineFeeds(buffer.data(), buffer.size(), actual);
+        APSARA_TEST_TRUE_DESC(expected == actual, size);
+    }
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,177 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "common/TimeFormatParser.h"
+#include "common/TimeUtil.h"
+#include "logger/Logger.h"
+
+namespace logtail {
+
+class TimeFormatParserUnittest : public ::testing::Test {
+public:
+    void TestCompile();
+    void TestParse();
+    void TestSameAsStrptime();
+    void BenchmarkParse();
+
+private:
+    // Parses @str with Strptime + mktime like LogParser::ParseLogTime does.
+    static const char* StrptimeParse(const char* str, const char* format, time_t& logTime) {
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        const char* end = Strptime(str, format, &tm, -1);
+        if (end != NULL) {
+            tm.tm_isdst = -1;
+            logTime = mktime(&tm);
+        }
+        return end;
+    }
+};
+
+UNIT_TEST_CASE(TimeFormatParserUnittest, TestCompile);
+UNIT_TEST_CASE(TimeFormatParserUnittest, TestParse);
+UNIT_TEST_CASE(TimeFormatParserUnittest, TestSameAsStrptime);
+UNIT_BENCHMARK_CASE(TimeFormatParserUnittest, BenchmarkParse);
+
+void TimeFormatParserUnittest::TestCompile() {
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("%Y-%m-%d %H:%M:%S") != NULL);
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("%d/%b/%Y:%H:%M:%S %z") != NULL);
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("%F %T") != NULL);
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("[%y%m%d %R]") != NULL);
+    // Unsupported directives, and formats without year which need year deduction.
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("%s") == NULL);
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("%Y-%m-%d %I:%M:%S %p") == NULL);
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("%b %d %H:%M:%S") == NULL);
+    APSARA_TEST_TRUE(TimeFormatParser::Compile("%Y-%m-%d %") == NULL);
+}
+
+void TimeFormatParserUnittest::TestParse() {
+    auto parser = TimeFormatParser::Compile("%d/%b/%Y:%H:%M:%S %z");
+    APSARA_TEST_TRUE_FATAL(parser != NULL);
+    const char* str = "18/Jul/2022:10:59:21 +0800 \"GET / HTTP/1.1\"";
+    time_t logTime = 0, expectedTime = 0;
+    bool fixedWidth = false;
+    const char* end = parser->Parse(str, logTime, fixedWidth);
+    APSARA_TEST_TRUE_FATAL(end != NULL);
+    APSARA_TEST_EQUAL(std::string(str, end), "18/Jul/2022:10:59:21 +0800");
+    APSARA_TEST_TRUE(fixedWidth);
+    APSARA_TEST_TRUE(StrptimeParse(str, "%d/%b/%Y:%H:%M:%S %z", expectedTime) == end);
+    APSARA_TEST_EQUAL(logTime, expectedTime);
+
+    // Fractional seconds are left for precise timestamp.
+    parser = TimeFormatParser::Compile("%Y-%m-%d %H:%M:%S");
+    APSARA_TEST_TRUE_FATAL(parser != NULL);
+    str = "2022-07-18 10:59:21.123456";
+    end = parser->Parse(str, logTime, fixedWidth);
+    APSARA_TEST_TRUE_FATAL(end != NULL);
+    APSARA_TEST_EQUAL(std::string(end), ".123456");
+
+    // Numbers shorter than field width.
+    end = parser->Parse("2022-7-8 1:2:3", logTime, fixedWidth);
+    APSARA_TEST_TRUE(end != NULL);
+    APSARA_TEST_FALSE(fixedWidth);
+
+    APSARA_TEST_TRUE(parser->Parse("2022-13-01 00:00:00", logTime, fixedWidth) == NULL);
+    APSARA_TEST_TRUE(parser->Parse("2022/07/18 10:59:21", logTime, fixedWidth) == NULL);
+    APSARA_TEST_TRUE(parser->Parse("", logTime, fixedWidth) == NULL);
+}
+
+void TimeFormatParserUnittest::TestSameAsStrptime() {
+    const std::vector<std::string> formats = {"%Y-%m-%d %H:%M:%S",
+                                              "%d/%b/%Y:%H:%M:%S %z",
+                                              "%Y%m%d%H%M%S",
+                                              "%y-%m-%d %T",
+                                              "%F  %R",
+                                              "%d %B %Y %H:%M:%S%%"};
+    const std::vector<std::string> strings = {"2022-07-18 10:59:21",
+                                              "2022-7-8 1:2:3.456",
+                                              "  2022-07-18   10:59:60",
+                                              "18/Jul/2022:10:59:21 +0800",
+                                              "18/jul/2022:10:59:21 -08:00",
+                                              "18/July/2022:10:59:21 Z",
+                                              "18/Jul/2022:10:59:21 +08",
+                                              "18/Jul/2022:10:59:21 +0860",
+                                              "18/Jul/2022:10:59:21 0800",
+                                              "20220718105921",
+                                              "2022071810592",
+                                              "22-07-18 10:59:21",
+                                              "68-02-29 23:59:59",
+                                              "2022-02-31  23:59",
+                                              "2022-07-18 10:59",
+                                              "18 September 2022 10:59:21%",
+                                              "18 Sep 2022 10:59:21",
+                                              "31 Dec 1969 23:59:59%",
+                                              "2022-00-18 10:59:21",
+                                              "abc"};
+    for (const auto& format : formats) {
+        auto parser = TimeFormatParser::Compile(format);
+        APSARA_TEST_TRUE_FATAL(parser != NULL);
+        // Twice, the second one hits minute cache.
+        for (int round = 0; round < 2; ++round) {
+            for (const auto& str : strings) {
+                time_t logTime = 0, expectedTime = 0;
+                bool fixedWidth = false;
+                const char* end = parser->Parse(str.c_str(), logTime, fixedWidth);
+                const char* expectedEnd = StrptimeParse(str.c_str(), format.c_str(), expectedTime);
+                APSARA_TEST_TRUE(end == expectedEnd);
+                if (end != NULL && expectedEnd != NULL) {
+                    APSARA_TEST_EQUAL(logTime, expectedTime);
+                }
+            }
+        }
+    }
+}
+
+// Throughput of parsing nginx access log time, which changes every second.
+void TimeFormatParserUnittest::BenchmarkParse() {
+    const char* format = "%d/%b/%Y:%H:%M:%S %z";
+    const int kCount = 1000000;
+    std::vector<std::string> strings;
+    const time_t begin = 1658113161;
+    for (int i = 0; i < 3600; ++i) {
+        strings.push_back(GetTimeStamp(begin + i, "%d/%b/%Y:%H:%M:%S") + " +0000");
+    }
+    auto parser = TimeFormatParser::Compile(format);
+    APSARA_TEST_TRUE_FATAL(parser != NULL);
+
+    time_t sum = 0, expectedSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kCount; ++i) {
+        time_t logTime = 0;
+        StrptimeParse(strings[i % strings.size()].c_str(), format, logTime);
+        expectedSum += logTime;
+    }
+    auto strptimeCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kCount; ++i) {
+        time_t logTime = 0;
+        bool fixedWidth = false;
+        parser->Parse(strings[i % strings.size()].c_str(), logTime, fixedWidth);
+        sum += logTime;
+    }
+    auto compiledCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    APSARA_TEST_EQUAL(sum, expectedSum);
+    LOG_INFO(sLogger,
+             ("benchmark", "time format parser")("format", format)("count", kCount)(
+                 "strptime+mktime ns/op", strptimeCost * 1e9 / kCount)("compiled ns/op", compiledCost * 1e9 / kCount));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
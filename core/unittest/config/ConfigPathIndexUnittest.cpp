@@ -0,0 +1,279 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#if defined(__linux__)
+#include <fnmatch.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/StringTools.h"
+#include "config/Config.h"
+#include "config/ConfigPathIndex.h"
+#include "logger/Logger.h"
+
+namespace logtail {
+
+class ConfigPathIndexUnittest : public ::testing::Test {
+public:
+    void TestFilePatternMatcher();
+    void TestFindCandidates();
+    void TestSameAsIsMatch();
+    void BenchmarkFindCandidates();
+
+private:
+    Config* NewConfig(const std::string& basePath, const std::string& filePattern, int maxDepth = -1) {
+        mConfigs.emplace_back(new Config(basePath,
+                                         filePattern,
+                                         REGEX_LOG,
+                                         "config_" + std::to_string(mConfigs.size()),
+                                         "",
+                                         "project",
+                                         true,
+                                         0,
+                                         maxDepth,
+                                         "logstore"));
+        return mConfigs.back().get();
+    }
+
+    // Configs matched by brute force, like FindAllMatch did before the index.
+    std::vector<Config*> MatchAll(const std::string& path, const std::string& name) {
+        std::vector<Config*> result;
+        for (auto& config : mConfigs) {
+            if (config->IsMatch(path, name)) {
+                result.push_back(config.get());
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<Config*> MatchByIndex(const ConfigPathIndex& index, const std::string& path, const std::string& name) {
+        std::vector<Config*> candidates, result;
+        index.FindCandidates(path, name, candidates);
+        for (auto config : candidates) {
+            if (config->IsMatch(path, name)) {
+                result.push_back(config);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<std::unique_ptr<Config>> mConfigs;
+};
+
+UNIT_TEST_CASE(ConfigPathIndexUnittest, TestFilePatternMatcher);
+UNIT_TEST_CASE(ConfigPathIndexUnittest, TestFindCandidates);
+UNIT_TEST_CASE(ConfigPathIndexUnittest, TestSameAsIsMatch);
+UNIT_BENCHMARK_CASE(ConfigPathIndexUnittest, BenchmarkFindCandidates);
+
+void ConfigPathIndexUnittest::TestFilePatternMatcher() {
+    const std::vector<std::string> patterns
+        = {"*", "**", "access.log", "*.log", "app_*", "app_*.log", "*.lo?", "[ab].log", "\\*.log", ""};
+    const std::vector<std::string> names = {"access.log",
+                                            "access.log.1",
+                                            ".log",
+                                            "a.log",
+                                            "b.log",
+                                            "app_",
+                                            "app_1.log",
+                                            "app.log",
+                                            "*.log",
+                                            "x.lot",
+                                            "log"};
+    for (const auto& pattern : patterns) {
+        FilePatternMatcher matcher(pattern);
+        for (const auto& name : names) {
+            APSARA_TEST_EQUAL_DESC(matcher.Match(name),
+                                   fnmatch(pattern.c_str(), name.c_str(), 0) == 0,
+                                   "pattern: " + pattern + ", name: " + name);
+        }
+    }
+}
+
+void ConfigPathIndexUnittest::TestFindCandidates() {
+    ConfigPathIndex index;
+    Config* logs = NewConfig("/home/admin/logs", "*.log");
+    Config* app = NewConfig("/home/admin/logs/app", "app.log");
+    Config* wildcard = NewConfig("/home/*/logs", "*.log");
+    Config* root = NewConfig("/", "*");
+    Config* other = NewConfig("/var/log", "*");
+    for (auto& config : mConfigs) {
+        index.Add(config.get());
+    }
+    APSARA_TEST_EQUAL(index.Size(), 5UL);
+
+    std::vector<Config*> candidates;
+    index.FindCandidates("/home/admin/logs/app", "app.log", candidates);
+    std::sort(candidates.begin(), candidates.end());
+    std::vector<Config*> expected = {logs, app, wildcard, root};
+    std::sort(expected.begin(), expected.end());
+    APSARA_TEST_TRUE(candidates == expected);
+
+    // File pattern is checked by the index, other candidates are filtered by Config::IsMatch.
+    candidates.clear();
+    index.FindCandidates("/home/admin/logs/app", "app.txt", candidates);
+    APSARA_TEST_TRUE(candidates == std::vector<Config*>{root});
+
+    // Directories are matched with all file patterns.
+    candidates.clear();
+    index.FindCandidates("/var/log/nginx", "", candidates);
+    std::sort(candidates.begin(), candidates.end());
+    expected = {root, other};
+    std::sort(expected.begin(), expected.end());
+    APSARA_TEST_TRUE(candidates == expected);
+
+    candidates.clear();
+    index.FindCandidates("/home/admin/logs", "a.log", candidates);
+    APSARA_TEST_EQUAL(candidates.size(), 3UL);
+    APSARA_TEST_TRUE(std::find(candidates.begin(), candidates.end(), app) == candidates.end());
+
+    index.Remove(logs);
+    index.Remove(app);
+    index.Remove(app);
+    APSARA_TEST_EQUAL(index.Size(), 3UL);
+    candidates.clear();
+    index.FindCandidates("/home/admin/logs/app", "app.log", candidates);
+    std::sort(candidates.begin(), candidates.end());
+    expected = {wildcard, root};
+    std::sort(expected.begin(), expected.end());
+    APSARA_TEST_TRUE(candidates == expected);
+
+    // Docker file configs are always candidates since they match container paths.
+    Config* docker = NewConfig("/home/admin/logs", "*.log");
+    APSARA_TEST_TRUE(docker->SetDockerFileFlag(false));
+    index.Add(docker);
+    candidates.clear();
+    index.FindCandidates("/logtail_host/docker/abc/home/admin/logs", "a.log", candidates);
+    std::sort(candidates.begin(), candidates.end());
+    expected = {root, docker};
+    std::sort(expected.begin(), expected.end());
+    APSARA_TEST_TRUE(candidates == expected);
+
+    index.Clear();
+    APSARA_TEST_EQUAL(index.Size(), 0UL);
+    candidates.clear();
+    index.FindCandidates("/home/admin/logs", "a.log", candidates);
+    APSARA_TEST_TRUE(candidates.empty());
+}
+
+void ConfigPathIndexUnittest::TestSameAsIsMatch() {
+    NewConfig("/home/admin/logs", "*.log");
+    NewConfig("/home/admin/logs", "access.log", 0);
+    NewConfig("/home/admin/logs/", "*");
+    NewConfig("/home/admin/log", "*");
+    NewConfig("/home/admin/logs/app", "app_*", 1);
+    NewConfig("/home/*/logs", "*.log");
+    NewConfig("/home/ad?in/logs/*", "*.log", 0);
+    NewConfig("/home/admin/l*s/app", "app_*");
+    NewConfig("/home/[ab]*/logs", "*");
+    NewConfig("/*/admin", "*.log", 2);
+    NewConfig("/", "*");
+    NewConfig("/var/log", "*.[0-9]");
+    ConfigPathIndex index;
+    for (auto& config : mConfigs) {
+        index.Add(config.get());
+    }
+    const std::vector<std::string> paths = {"/",
+                                            "/home",
+                                            "/home/admin",
+                                            "/home/admin/logs",
+                                            "/home/admin/logs/",
+                                            "/home/admin/logs/app",
+                                            "/home/admin/logs/app/1/2",
+                                            "/home/admin/logs1",
+                                            "/home/admin/log",
+                                            "/home/admin/lags/app",
+                                            "/home/bob/logs",
+                                            "/home/adxin/logs/app",
+                                            "/var/log",
+                                            "/var/log/nginx",
+                                            "/tmp/admin/logs"};
+    const std::vector<std::string> names = {"", "access.log", "app_1.log", "app.txt", "messages.1"};
+    for (int round = 0; round < 2; ++round) {
+        for (const auto& path : paths) {
+            for (const auto& name : names) {
+                APSARA_TEST_TRUE_DESC(MatchByIndex(index, path, name) == MatchAll(path, name), path + "/" + name);
+            }
+        }
+        // Incremental updates.
+        index.Remove(mConfigs[0].get());
+        index.Remove(mConfigs[5].get());
+        mConfigs.erase(mConfigs.begin() + 5);
+        mConfigs.erase(mConfigs.begin());
+        index.Add(NewConfig("/home/admin/logs/app/1", "*.log"));
+        index.Add(NewConfig("/home/*", "*"));
+    }
+}
+
+// Cold matching of files with 2000 configs, like the first match after configs are updated.
+void ConfigPathIndexUnittest::BenchmarkFindCandidates() {
+    const int kConfigCount = 2000;
+    const int kFileCount = 20000;
+    for (int i = 0; i < kConfigCount; ++i) {
+        if (i % 10 == 0) {
+            NewConfig("/home/app" + std::to_string(i) + "/*/logs", "*.log");
+        } else {
+            NewConfig("/home/app" + std::to_string(i) + "/logs", i % 2 == 0 ? "*.log" : "app.log");
+        }
+    }
+    ConfigPathIndex index;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& config : mConfigs) {
+        index.Add(config.get());
+    }
+    auto buildCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> paths;
+    for (int i = 0; i < kFileCount; ++i) {
+        int app = i % kConfigCount;
+        paths.push_back("/home/app" + std::to_string(app) + (app % 10 == 0 ? "/pod/logs" : "/logs"));
+    }
+    size_t matchCount = 0, expectedCount = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& path : paths) {
+        for (auto& config : mConfigs) {
+            if (config->IsMatch(path, "app.log")) {
+                ++expectedCount;
+            }
+        }
+    }
+    auto scanCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    std::vector<Config*> candidates;
+    for (const auto& path : paths) {
+        candidates.clear();
+        index.FindCandidates(path, "app.log", candidates);
+        for (auto config : candidates) {
+            if (config->IsMatch(path, "app.log")) {
+                ++matchCount;
+            }
+        }
+    }
+    auto indexCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    APSARA_TEST_EQUAL(matchCount, expectedCount);
+    APSARA_TEST_EQUAL(matchCount, (size_t)kFileCount);
+    LOG_INFO(sLogger,
+             ("benchmark", "config path index")("configs", kConfigCount)("files", kFileCount)(
+                 "build index ms", buildCost * 1e3)("scan ns/op", scanCost * 1e9 / kFileCount)(
+                 "index ns/op", indexCost * 1e9 / kFileCount));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
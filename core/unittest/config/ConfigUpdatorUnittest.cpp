@@ -3345,6 +3345,7 @@ void ConfigUpdatorUnittest::TestCheckUlogfsEnv() {
 
         BOOL_FLAG(default_global_fuse_mode) = false;
         ConfigManager::GetInstance()->mNameConfigMap.clear();
+        ConfigManager::GetInstance()->mConfigPathIndex.Clear();
     }
 
     // env ULOGFS_ENABLED not set
@@ -3376,6 +3377,7 @@ void ConfigUpdatorUnittest::TestCheckUlogfsEnv() {
 
         BOOL_FLAG(default_global_fuse_mode) = false;
         ConfigManager::GetInstance()->mNameConfigMap.clear();
+        ConfigManager::GetInstance()->mConfigPathIndex.Clear();
     }
 
     // env ULOGFS_ENABLED set "true"
@@ -3402,6 +3404,7 @@ void ConfigUpdatorUnittest::TestCheckUlogfsEnv() {
 
         BOOL_FLAG(default_global_fuse_mode) = false;
         ConfigManager::GetInstance()->mNameConfigMap.clear();
+        ConfigManager::GetInstance()->mConfigPathIndex.Clear();
     }
 
     // env ULOGFS_ENABLED not set
@@ -3436,6 +3439,7 @@ void ConfigUpdatorUnittest::TestCheckUlogfsEnv() {
 
         BOOL_FLAG(default_global_fuse_mode) = false;
         ConfigManager::GetInstance()->mNameConfigMap.clear();
+        ConfigManager::GetInstance()->mConfigPathIndex.Clear();
     }
 
     RemoveConfigFile();
@@ -0,0 +1,69 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <vector>
+#include "event_handler/LogReaderThreadPool.h"
+
+namespace logtail {
+
+class LogReaderThreadPoolUnittest : public ::testing::Test {
+public:
+    void TestShardIndex();
+    void TestReadingFlags();
+};
+
+UNIT_TEST_CASE(LogReaderThreadPoolUnittest, TestShardIndex);
+UNIT_TEST_CASE(LogReaderThreadPoolUnittest, TestReadingFlags);
+
+void LogReaderThreadPoolUnittest::TestShardIndex() {
+    LogReaderThreadPool pool;
+    for (int i = 0; i < 4; ++i) {
+        pool.mShards.emplace_back(new LogReaderThreadPool::Shard);
+    }
+    APSARA_TEST_EQUAL(pool.GetShardCount(), 4UL);
+
+    // Sequential inodes should be spread over all shards, and the same file always goes to the same shard.
+    std::vector<int> counts(pool.GetShardCount(), 0);
+    for (uint64_t inode = 1000; inode < 5000; ++inode) {
+        size_t index = pool.GetShardIndex(DevInode(2049, inode));
+        APSARA_TEST_TRUE(index < pool.GetShardCount());
+        APSARA_TEST_EQUAL(index, pool.GetShardIndex(DevInode(2049, inode)));
+        ++counts[index];
+    }
+    for (auto count : counts) {
+        APSARA_TEST_TRUE_DESC(count > 500, count);
+    }
+}
+
+void LogReaderThreadPoolUnittest::TestReadingFlags() {
+    LogFileReaderPtr reader(new CommonRegLogFileReader("project", "logstore", "/tmp", "a.log", 1024, "", "none"));
+    APSARA_TEST_FALSE(reader->DelayIfReading());
+    APSARA_TEST_TRUE(reader->TryStartReading());
+    APSARA_TEST_TRUE(reader->IsReading());
+    APSARA_TEST_FALSE(reader->TryStartReading());
+    // No read is requested during reading.
+    APSARA_TEST_FALSE(reader->FinishReading());
+
+    APSARA_TEST_TRUE(reader->TryStartReading());
+    APSARA_TEST_TRUE(reader->DelayIfReading());
+    APSARA_TEST_TRUE(reader->DelayIfReading());
+    APSARA_TEST_TRUE(reader->FinishReading());
+    APSARA_TEST_FALSE(reader->IsReading());
+    APSARA_TEST_FALSE(reader->DelayIfReading());
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
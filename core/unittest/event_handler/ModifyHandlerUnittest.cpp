@@ -108,6 +108,24 @@ public:
         APSARA_TEST_TRUE_FATAL(mReaderPtr->IsReadToEnd());
         APSARA_TEST_TRUE_FATAL(!mReaderPtr->mLogFileOp.IsOpen());
     }
+
+    void TestHandleModifyEventWhenReaderIsReading() {
+        LOG_INFO(sLogger, ("TestHandleModifyEventWhenReaderIsReading() begin", time(NULL)));
+        // reader is being read by a reader thread
+        APSARA_TEST_TRUE_FATAL(mReaderPtr->TryStartReading());
+        APSARA_TEST_TRUE_FATAL(!mReaderPtr->TryStartReading());
+
+        Event event(gRootDir, gLogName, EVENT_MODIFY, 0, 0, mReaderPtr->mDevInode.dev, mReaderPtr->mDevInode.inode);
+        mHandlerPtr->Handle(event);
+        // nothing is read by handler, the read is delayed until current reading finishes
+        APSARA_TEST_TRUE_FATAL(!mReaderPtr->IsReadToEnd());
+        APSARA_TEST_TRUE_FATAL(mReaderPtr->FinishReading());
+        APSARA_TEST_TRUE_FATAL(!mReaderPtr->IsReading());
+
+        mHandlerPtr->Handle(event);
+        APSARA_TEST_TRUE_FATAL(mReaderPtr->IsReadToEnd());
+        APSARA_TEST_TRUE_FATAL(!mReaderPtr->FinishReading());
+    }
 };
 
 std::string ModifyHandlerUnittest::gRootDir;
@@ -116,6 +134,7 @@ std::string ModifyHandlerUnittest::gLogName;
 APSARA_UNIT_TEST_CASE(ModifyHandlerUnittest, TestHandleContainerStoppedEventWhenReadToEnd, 0);
 APSARA_UNIT_TEST_CASE(ModifyHandlerUnittest, TestHandleContainerStoppedEventWhenNotReadToEnd, 0);
 APSARA_UNIT_TEST_CASE(ModifyHandlerUnittest, TestHandleModifyEventWhenContainerStopped, 0);
+APSARA_UNIT_TEST_CASE(ModifyHandlerUnittest, TestHandleModifyEventWhenReaderIsReading, 0);
 } // end of namespace logtail
 
 int main(int argc, char** argv) {
@@ -0,0 +1,239 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <vector>
+#include "event/Event.h"
+#include "event_handler/ReadScheduler.h"
+
+DECLARE_FLAG_INT64(read_scheduler_max_lag_bytes);
+DECLARE_FLAG_INT32(read_scheduler_max_defer_ms);
+
+namespace logtail {
+
+class ReadSchedulerUnittest : public ::testing::Test {
+public:
+    void TestWeight();
+    void TestFairShare();
+    void TestIdleLogstore();
+    void TestBusyLogstore();
+    void TestReadBudget();
+    void TestDeferEvents();
+    void TestReadDelay();
+
+    void SetUp() override {
+        INT64_FLAG(read_scheduler_max_lag_bytes) = 1024 * 1024;
+        INT32_FLAG(read_scheduler_max_defer_ms) = 1000;
+    }
+
+private:
+    static const uint64_t kMB = 1024 * 1024;
+};
+
+UNIT_TEST_CASE(ReadSchedulerUnittest, TestWeight);
+UNIT_TEST_CASE(ReadSchedulerUnittest, TestFairShare);
+UNIT_TEST_CASE(ReadSchedulerUnittest, TestIdleLogstore);
+UNIT_TEST_CASE(ReadSchedulerUnittest, TestBusyLogstore);
+UNIT_TEST_CASE(ReadSchedulerUnittest, TestReadBudget);
+UNIT_TEST_CASE(ReadSchedulerUnittest, TestDeferEvents);
+UNIT_TEST_CASE(ReadSchedulerUnittest, TestReadDelay);
+
+void ReadSchedulerUnittest::TestWeight() {
+    APSARA_TEST_EQUAL(ReadScheduler::GetWeight(0), 1U);
+    APSARA_TEST_EQUAL(ReadScheduler::GetWeight(1), 8U);
+    APSARA_TEST_EQUAL(ReadScheduler::GetWeight(3), 2U);
+    APSARA_TEST_EQUAL(ReadScheduler::GetWeight(4), 1U);
+}
+
+void ReadSchedulerUnittest::TestFairShare() {
+    ReadScheduler scheduler;
+    uint64_t now = 1000000;
+    scheduler.SetQuota(1, 1, -1);
+    scheduler.SetQuota(2, 2, -1);
+
+    // A logstore reading alone is never deferred.
+    for (int i = 0; i < 100; ++i) {
+        scheduler.Charge(1, kMB, true, now);
+        APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    }
+
+    // Logstore 2 becomes backlogged, logstore 1 waits until 2 catches up.
+    scheduler.Charge(2, kMB, true, now);
+    now += 20;
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    scheduler.Charge(1, 2 * kMB, true, now);
+    now += 20;
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now));
+    APSARA_TEST_TRUE(scheduler.IsReadable(2, now));
+    // Logstore 2 has double weight, 4MB of it is 2MB of logstore 1.
+    scheduler.Charge(2, 4 * kMB, true, now);
+    now += 20;
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+
+    // Logstore 1 goes on when logstore 2 is blocked or not backlogged any more.
+    scheduler.Charge(1, 4 * kMB, true, now);
+    now += 20;
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now));
+    scheduler.SetBlocked(2);
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    scheduler.Charge(1, 4 * kMB, true, now);
+    now += 2000;
+    scheduler.Charge(1, 4 * kMB, true, now);
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    // Logstore 2 is unblocked, and it starts from the virtual time of logstore 1.
+    scheduler.Charge(2, kMB, true, now);
+    now += 20;
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    APSARA_TEST_TRUE(scheduler.IsReadable(2, now));
+}
+
+void ReadSchedulerUnittest::TestIdleLogstore() {
+    ReadScheduler scheduler;
+    uint64_t now = 1000000;
+    scheduler.Charge(1, 100 * kMB, true, now);
+    // Logstore 2 read little before, it does not keep the credit when it becomes backlogged.
+    scheduler.Charge(2, kMB, false, now);
+    now += 20;
+    scheduler.Charge(2, kMB, true, now);
+    now += 20;
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    APSARA_TEST_TRUE(scheduler.IsReadable(2, now));
+    APSARA_TEST_TRUE(scheduler.mLogstoreStates[2].mVirtualTime >= 100.0 * kMB);
+}
+
+void ReadSchedulerUnittest::TestBusyLogstore() {
+    ReadScheduler scheduler;
+    uint64_t now = 1000000;
+    // Logstore 1 reads much more than backlogged logstore 2, but always reads to end.
+    for (int i = 0; i < 100; ++i) {
+        scheduler.Charge(1, kMB, false, now);
+        scheduler.Charge(2, 10 * 1024, true, now);
+        now += 20;
+    }
+    APSARA_TEST_TRUE(scheduler.IsReadable(2, now));
+
+    // Logstore 1 becomes backlogged, it is not starved for reads before.
+    scheduler.Charge(1, kMB, true, now);
+    now += 20;
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    APSARA_TEST_TRUE(scheduler.IsReadable(2, now));
+    APSARA_TEST_TRUE(scheduler.mLogstoreStates[1].mVirtualTime < 2.0 * kMB + scheduler.mLogstoreStates[2].mVirtualTime);
+
+    // Then both are scheduled fairly.
+    scheduler.Charge(1, 2 * kMB, true, now);
+    now += 20;
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now));
+    APSARA_TEST_TRUE(scheduler.IsReadable(2, now));
+}
+
+void ReadSchedulerUnittest::TestReadBudget() {
+    ReadScheduler scheduler;
+    uint64_t now = 1000000;
+    scheduler.SetQuota(1, 1, kMB);
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now));
+    scheduler.Charge(1, 2 * kMB, true, now);
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now + 500));
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now + 1000));
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now + 1100));
+
+    // A throttled logstore does not hold back others.
+    scheduler.Charge(2, 10 * kMB, true, now + 1100);
+    scheduler.Charge(1, 2 * kMB, true, now + 1100);
+    APSARA_TEST_TRUE(scheduler.IsReadable(2, now + 1200));
+
+    // Budget is removed, logstore 1 is scheduled by virtual time only.
+    scheduler.SetQuota(1, 1, -1);
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now + 1300));
+    scheduler.Charge(2, 2 * kMB, true, now + 1300);
+    APSARA_TEST_TRUE(scheduler.IsReadable(1, now + 1300));
+}
+
+void ReadSchedulerUnittest::TestDeferEvents() {
+    ReadScheduler scheduler;
+    uint64_t now = 1000000;
+    scheduler.Charge(1, 0, true, now);
+    scheduler.Charge(2, 0, true, now);
+    scheduler.Charge(3, 0, true, now);
+    scheduler.Charge(1, 10 * kMB, true, now);
+    scheduler.Charge(2, 5 * kMB, true, now);
+    now += 20;
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now));
+    APSARA_TEST_FALSE(scheduler.IsReadable(2, now));
+
+    Event event1("/var/log", "a.log", EVENT_MODIFY, 0);
+    Event event2("/var/log", "b.log", EVENT_MODIFY, 0);
+    scheduler.Defer(1, "config1", event1, DevInode(1, 1), now);
+    scheduler.Defer(1, "config1", event1, DevInode(1, 1), now + 10);
+    scheduler.Defer(2, "config2", event2, DevInode(1, 2), now);
+    APSARA_TEST_EQUAL(scheduler.GetDeferredEventCount(), 2UL);
+
+    std::vector<Event*> events;
+    scheduler.GetReadyEvents(events, now + 20);
+    APSARA_TEST_EQUAL(events.size(), 0UL);
+
+    // Logstore 3 catches up with logstore 2, and both are released in virtual time order by timeout.
+    scheduler.Charge(3, 5 * kMB, true, now + 20);
+    scheduler.GetReadyEvents(events, now + 40);
+    APSARA_TEST_EQUAL(events.size(), 1UL);
+    APSARA_TEST_EQUAL(events[0]->GetObject(), "b.log");
+    APSARA_TEST_EQUAL(events[0]->GetConfigName(), "config2");
+    APSARA_TEST_EQUAL(events[0]->GetInode(), 2UL);
+    // Event of logstore 2 is released as logstore 2 is readable, it is checked again when handled.
+    APSARA_TEST_FALSE(scheduler.TakeReleased("config2", *events[0], DevInode(1, 2)));
+    scheduler.GetReadyEvents(events, now + 1000);
+    APSARA_TEST_EQUAL(events.size(), 2UL);
+    APSARA_TEST_EQUAL(events[1]->GetObject(), "a.log");
+    APSARA_TEST_EQUAL(scheduler.GetDeferredEventCount(), 0UL);
+
+    // Event of logstore 1 is released by timeout, it is read once though logstore 1 is still not readable.
+    APSARA_TEST_FALSE(scheduler.IsReadable(1, now + 1000));
+    APSARA_TEST_FALSE(scheduler.TakeReleased("config2", *events[1], DevInode(1, 1)));
+    APSARA_TEST_TRUE(scheduler.TakeReleased("config1", *events[1], DevInode(1, 1)));
+    APSARA_TEST_FALSE(scheduler.TakeReleased("config1", *events[1], DevInode(1, 1)));
+
+    // Deferred again after the read while logstore 3 is still backlogged, and released by timeout again.
+    scheduler.Charge(3, 0, true, now + 1000);
+    scheduler.Defer(1, "config1", *events[1], DevInode(1, 1), now + 1000);
+    scheduler.Charge(3, 0, true, now + 1500);
+    scheduler.GetReadyEvents(events, now + 1500);
+    APSARA_TEST_EQUAL(events.size(), 2UL);
+    scheduler.GetReadyEvents(events, now + 2000);
+    APSARA_TEST_EQUAL(events.size(), 3UL);
+    // The mark is dropped if the event is not handled in time.
+    scheduler.GetReadyEvents(events, now + 3000);
+    APSARA_TEST_FALSE(scheduler.TakeReleased("config1", *events[2], DevInode(1, 1)));
+    for (auto event : events) {
+        delete event;
+    }
+}
+
+void ReadSchedulerUnittest::TestReadDelay() {
+    ReadScheduler scheduler;
+    scheduler.RecordReadDelay(0, "/a.log");
+    scheduler.RecordReadDelay(10, "/a.log");
+    scheduler.RecordReadDelay(200, "/b.log");
+    scheduler.RecordReadDelay(60000, "/c.log");
+    APSARA_TEST_EQUAL(scheduler.mDelayBuckets[0], 2UL);
+    APSARA_TEST_EQUAL(scheduler.mDelayBuckets[2], 1UL);
+    APSARA_TEST_EQUAL(scheduler.mDelayBuckets[6], 1UL);
+    APSARA_TEST_EQUAL(scheduler.mMaxDelayMs, 60000UL);
+    APSARA_TEST_EQUAL(scheduler.mMaxDelayPath, "/c.log");
+    scheduler.UpdateMetrics();
+    APSARA_TEST_EQUAL(scheduler.mDelayBuckets[0], 0UL);
+    APSARA_TEST_EQUAL(scheduler.mMaxDelayMs, 0UL);
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
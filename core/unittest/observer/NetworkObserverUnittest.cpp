@@ -25,6 +25,10 @@
 #include "network/protocols/ProtocolEventAggregators.h"
 #include "metas/ContainerProcessGroup.h"
 #include "observer/network/protocols/infer.h"
+#include "observer/network/NetworkObserverWorker.h"
+#include "common/FileSystemUtil.h"
+
+DECLARE_FLAG_STRING(sls_observer_network_save_filename);
 
 namespace logtail {
 
@@ -236,7 +240,147 @@ public:
         inferMySQL();
     }
 
+    // writeReplayEvents writes http requests and responses of @connCount connections of @pidCount processes to
+    // @fileName in the format of replay file, each connection has @requestCount requests.
+    void writeReplayEvents(const std::string& fileName, uint32_t pidCount, uint32_t connCount, uint32_t requestCount) {
+        std::vector<std::string> requests, responses;
+        RawNetPacketReader(kLocalAddress, false, ProtocolType_HTTP, {kHTTPRequestHex}).GetAllNetPackets(requests);
+        RawNetPacketReader(kLocalAddress, false, ProtocolType_HTTP, {kHTTPResponseHex}).GetAllNetPackets(responses);
+        APSARA_TEST_EQUAL_FATAL(requests.size(), size_t(1));
+        APSARA_TEST_EQUAL_FATAL(responses.size(), size_t(1));
+        FILE* file = fopen(fileName.c_str(), "wb");
+        APSARA_TEST_TRUE_FATAL(file != NULL);
+        uint64_t timeNano = GetCurrentTimeInNanoSeconds();
+        std::string buffer;
+        for (uint32_t i = 0; i < requestCount; ++i) {
+            for (uint32_t conn = 0; conn < connCount; ++conn) {
+                for (std::string* packet : {&requests[0], &responses[0]}) {
+                    PacketEventHeader* header = (PacketEventHeader*)&packet->at(0);
+                    header->PID = 1000 + conn % pidCount;
+                    header->SockHash = conn;
+                    header->TimeNano = ++timeNano;
+                    PacketEventToBuffer(&packet->at(0), packet->size(), buffer);
+                    fwrite(buffer.data(), 1, buffer.size(), file);
+                }
+            }
+        }
+        fclose(file);
+    }
+
+    // readReplayEvents reads events from replay file like NetworkObserver::EventLoop.
+    void readReplayEvents(const std::string& fileName, std::vector<std::string>& events) {
+        FILE* file = fopen(fileName.c_str(), "rb");
+        APSARA_TEST_TRUE_FATAL(file != NULL);
+        uint32_t dataSize = 0;
+        while (fread(&dataSize, 1, 4, file) == 4 && dataSize != 0 && dataSize < 1024 * 1024) {
+            std::string event(dataSize, '\0');
+            if (fread(&event.at(0), 1, dataSize, file) != dataSize) {
+                break;
+            }
+            events.push_back(std::move(event));
+        }
+        fclose(file);
+        for (auto& event : events) {
+            void* ptr = NULL;
+            int32_t len = 0;
+            BufferToPacketEvent(&event.at(0), event.size(), ptr, len);
+        }
+    }
+
+    // replayEvents processes @events with @workerCount workers and flushes metrics to @allData.
+    // @return events processed per second.
+    double replayEvents(std::vector<std::string>& events, size_t workerCount, std::vector<sls_logs::Log>& allData) {
+        mObserver->StartWorkers(workerCount);
+        uint64_t beginTime = GetCurrentTimeInMicroSeconds();
+        for (size_t i = 0; i < events.size(); ++i) {
+            mObserver->OnPacketEvent(&events[i].at(0), events[i].size());
+            if (i % 100 == 99) {
+                mObserver->SubmitToWorkers();
+            }
+        }
+        mObserver->SubmitToWorkers();
+        mObserver->WaitWorkersIdle();
+        uint64_t costTime = GetCurrentTimeInMicroSeconds() - beginTime;
+        mObserver->FlushOutMetrics(allData);
+        mObserver->StopWorkers();
+        return events.size() * 1000000.0 / (costTime + 1);
+    }
+
+    static int64_t sumTotalCount(const std::vector<sls_logs::Log>& allData) {
+        int64_t totalCount = 0;
+        for (const auto& log : allData) {
+            for (const auto& content : log.contents()) {
+                if (content.key() == "total_count") {
+                    totalCount += std::stoll(content.value());
+                }
+            }
+        }
+        return totalCount;
+    }
+
+    void TestWorkersMergeAggregators() {
+        const std::string fileName = "network_observer_workers.dump";
+        writeReplayEvents(fileName, 8, 64, 10);
+        std::vector<std::string> events;
+        readReplayEvents(fileName, events);
+        remove(fileName.c_str());
+        APSARA_TEST_EQUAL_FATAL(events.size(), size_t(64 * 10 * 2));
+
+        std::vector<sls_logs::Log> inlineData;
+        replayEvents(events, 1, inlineData);
+        APSARA_TEST_TRUE(mObserver->mWorkers.empty());
+        APSARA_TEST_EQUAL(inlineData.size(), size_t(8));
+        APSARA_TEST_EQUAL(sumTotalCount(inlineData), 64 * 10);
+
+        mObserver->StartWorkers(4);
+        APSARA_TEST_EQUAL(mObserver->mWorkers.size(), size_t(4));
+        // events of a connection are processed by one worker, and a process is observed by several workers.
+        std::vector<sls_logs::Log> workerData;
+        replayEvents(events, 4, workerData);
+        APSARA_TEST_TRUE(mObserver->mWorkers.empty());
+        APSARA_TEST_EQUAL(workerData.size(), inlineData.size());
+        APSARA_TEST_EQUAL(sumTotalCount(workerData), sumTotalCount(inlineData));
+    }
+
+    // BenchmarkReplayThroughput replays the local replay file, which is written when observer saves packets to disk,
+    // with different worker counts. A file of synthetic http packets is used if the replay file doesn't exist.
+    void BenchmarkReplayThroughput() {
+        std::string fileName = STRING_FLAG(sls_observer_network_save_filename);
+        bool generated = false;
+        if (!CheckExistance(fileName)) {
+            fileName = "network_observer_benchmark.dump";
+            writeReplayEvents(fileName, 16, 1024, 50);
+            generated = true;
+        }
+        std::vector<std::string> events;
+        readReplayEvents(fileName, events);
+        if (generated) {
+            remove(fileName.c_str());
+        }
+        LOG_INFO(sLogger, ("replay file", fileName)("events", events.size()));
+        for (size_t workerCount : {1, 2, 4, 8}) {
+            std::vector<sls_logs::Log> allData;
+            double eventsPerSecond = replayEvents(events, workerCount, allData);
+            LOG_INFO(sLogger,
+                     ("workers", workerCount)("events/s", (uint64_t)eventsPerSecond)("total_count",
+                                                                                     sumTotalCount(allData)));
+        }
+    }
+
     NetworkObserver* mObserver = NetworkObserver::GetInstance();
+    const std::string kLocalAddress = "30.43.120.83";
+    const std::string kHTTPRequestHex
+        = "00749c945d39a07817a0852e080045000071000040004006a0581e2b7853dcb526fbcd4700506b7401eca591a5ce5018100037ad"
+          "0000474554202f20485454502f312e310d0a486f73743a2062616964752e636f6d0d0a557365722d4167656e743a206375726c2f"
+          "372e37372e300d0a4163636570743a202a2f2a0d0a0d0a";
+    const std::string kHTTPResponseHex
+        = "a07817a0852e00749c945d390800450001598c7240002a0628fedcb526fb1e2b78530050cd47a591a5ce6b74023550180304c265"
+          "0000485454502f312e3120323030204f4b0d0a446174653a205468752c203237204a616e20323032322030393a34363a31332047"
+          "4d540d0a5365727665723a204170616368650d0a4c6173742d4d6f6469666965643a205475652c203132204a616e203230313020"
+          "31333a34383a303020474d540d0a455461673a202235312d34376366376536656538343030220d0a4163636570742d52616e6765"
+          "733a2062797465730d0a436f6e74656e742d4c656e6774683a2038310d0a43616368652d436f6e74726f6c3a206d61782d616765"
+          "3d38363430300d0a457870697265733a204672692c203238204a616e20323032322030393a34363a313320474d540d0a436f6e6e"
+          "656374696f6e3a204b6565702d416c6976650d0a436f6e74656e742d547970653a20746578742f68746d6c0d0a0d0a";
 };
 
 
@@ -246,6 +390,8 @@ APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestToPB, 0);
 APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestRawPacketUDPReader, 0);
 APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestRawPacketTCPReader, 0);
 APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestInferProtocol, 0);
+APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestWorkersMergeAggregators, 0);
+UNIT_BENCHMARK_CASE(NetworkObserverUnittest, BenchmarkReplayThroughput);
 } // namespace logtail
 
 
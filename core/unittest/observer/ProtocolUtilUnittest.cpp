@@ -14,6 +14,9 @@
 
 #include "unittest/Unittest.h"
 #include "unittest/UnittestHelper.h"
+#include <json/json.h>
+#include <algorithm>
+#include <cmath>
 #include "observer/interface/helper.h"
 #include "observer/network/protocols/utils.h"
 #include "network/protocols/mysql/parser.h"
@@ -327,6 +330,100 @@ public:
         APSARA_TEST_EQUAL(cache.GetResponsesSize(), 0);
         APSARA_TEST_EQUAL(count, 1);
     }
+
+    void TestCommonAggKey() {
+        PacketEventHeader header;
+        memset(&header, 0, sizeof(header));
+        header.PID = 100;
+        header.RoleType = PacketRoleType::Client;
+        header.DstAddr = SockAddressFromString("10.0.0.1");
+        header.DstPort = 3306;
+        CommonAggKey key(&header);
+        APSARA_TEST_EQUAL(key.HashVal, key.ComputeHash());
+        APSARA_TEST_EQUAL(key.HashVal, CommonAggKey(&header).HashVal);
+
+        header.DstPort = 3307;
+        APSARA_TEST_TRUE(CommonAggKey(&header).HashVal != key.HashVal);
+        header.DstAddr = SockAddressFromString("10.0.0.2");
+        header.DstPort = 3306;
+        APSARA_TEST_TRUE(CommonAggKey(&header).HashVal != key.HashVal);
+        header.DstAddr = SockAddressFromString("fe80::1");
+        APSARA_TEST_TRUE(CommonAggKey(&header).HashVal != key.HashVal);
+
+        // Remote port of server is ignored.
+        header.RoleType = PacketRoleType::Server;
+        CommonAggKey serverKey(&header);
+        header.DstPort = 40000;
+        APSARA_TEST_EQUAL(CommonAggKey(&header).HashVal, serverKey.HashVal);
+        APSARA_TEST_TRUE(serverKey.HashVal != CommonAggKey().ComputeHash());
+
+        sls_logs::Log log;
+        serverKey.ToPB(&log, ProtocolType_MySQL);
+        APSARA_TEST_EQUAL(log.contents_size(), 2);
+        APSARA_TEST_EQUAL(log.contents(0).value(), "server");
+        Json::Value root;
+        APSARA_TEST_TRUE(Json::Reader().parse(log.contents(1).value(), root));
+        APSARA_TEST_EQUAL(root["remote_ip"].asString(), "fe80::1");
+        APSARA_TEST_EQUAL(root["remote_port"].asString(), "0");
+    }
+
+    void TestLatencyHistogram() {
+        // buckets are contiguous and ordered.
+        for (int32_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+            int64_t lower = LatencyHistogram::BucketLowerBound(i);
+            int64_t upper = lower + LatencyHistogram::BucketWidth(i) - 1;
+            APSARA_TEST_EQUAL(LatencyHistogram::BucketIndex(lower), i);
+            if (i < LatencyHistogram::kBucketCount - 1) {
+                APSARA_TEST_EQUAL(LatencyHistogram::BucketIndex(upper), i);
+                APSARA_TEST_EQUAL(LatencyHistogram::BucketLowerBound(i + 1), upper + 1);
+            }
+        }
+        APSARA_TEST_EQUAL(LatencyHistogram::BucketIndex(-1), 0);
+        APSARA_TEST_EQUAL(LatencyHistogram::BucketIndex(INT64_MAX), LatencyHistogram::kBucketCount - 1);
+
+        LatencyHistogram histogram;
+        APSARA_TEST_EQUAL(histogram.Percentile(50), 0);
+        std::vector<int64_t> latencies;
+        srand(1);
+        for (int i = 0; i < 10000; ++i) {
+            // 10us ~ 10s
+            int64_t latency = (int64_t)(10000 * pow(10, (rand() % 6000) / 1000.0));
+            latencies.push_back(latency);
+            histogram.Add(latency);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        for (double percent : {50.0, 90.0, 99.0}) {
+            double expect = latencies[(size_t)(percent / 100 * latencies.size()) - 1];
+            double error = fabs(histogram.Percentile(percent) - expect) / expect;
+            APSARA_TEST_TRUE_DESC(error <= 0.125, percent);
+        }
+
+        // merged histograms are the same as one histogram of all latencies.
+        LatencyHistogram left, right;
+        for (size_t i = 0; i < latencies.size(); ++i) {
+            (i % 3 == 0 ? left : right).Add(latencies[i]);
+        }
+        left.Merge(right);
+        APSARA_TEST_EQUAL(memcmp(left.Buckets, histogram.Buckets, sizeof(histogram.Buckets)), 0);
+
+        CommonProtocolAggResult aggResult;
+        CommonProtocolEventInfo info;
+        for (int64_t latency : {1000000, 2000000, 3000000, 100000000}) {
+            info.LatencyNs = latency;
+            aggResult.AddEventInfo(info);
+        }
+        CommonProtocolAggResult otherResult;
+        otherResult.AddEventInfo(info);
+        aggResult.Merge(otherResult);
+        sls_logs::Log log;
+        aggResult.ToPB(&log);
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "total_count", "5"));
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "latency_p50_ns", "2883584"));
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "latency_p99_ns", "92274688"));
+        aggResult.Clear();
+        APSARA_TEST_TRUE(aggResult.IsEmpty());
+        APSARA_TEST_EQUAL(aggResult.Latency.Percentile(99), 0);
+    }
 };
 
 
@@ -339,6 +436,8 @@ APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheContinueOneByOneAndRe
 APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheInsertOldResp, 0);
 APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheInsertNewReq, 0);
 APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheTryMatchingReq, 0);
+APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonAggKey, 0);
+APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestLatencyHistogram, 0);
 } // namespace logtail
 
 
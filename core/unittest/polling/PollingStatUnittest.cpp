@@ -0,0 +1,129 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "common/FileSystemUtil.h"
+#include "common/RuntimeUtil.h"
+#include "logger/Logger.h"
+#include "polling/PollingStat.h"
+
+namespace logtail {
+
+class PollingStatUnittest : public ::testing::Test {
+public:
+    void TestStat();
+    void TestLatencyHistogram();
+    void BenchmarkStat();
+
+protected:
+    void SetUp() override {
+        mRootDir = GetProcessExecutionDir() + "PollingStatUnittest" + PATH_SEPARATOR;
+        bfs::remove_all(mRootDir);
+        bfs::create_directories(mRootDir);
+    }
+    void TearDown() override { bfs::remove_all(mRootDir); }
+
+    std::vector<std::string> CreateFiles(size_t count) {
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < count; ++i) {
+            paths.push_back(mRootDir + "file_" + std::to_string(i) + ".log");
+            std::ofstream(paths.back()) << std::string(i % 100, 'a');
+        }
+        return paths;
+    }
+
+    std::string mRootDir;
+};
+
+UNIT_TEST_CASE(PollingStatUnittest, TestStat);
+UNIT_TEST_CASE(PollingStatUnittest, TestLatencyHistogram);
+UNIT_BENCHMARK_CASE(PollingStatUnittest, BenchmarkStat);
+
+void PollingStatUnittest::TestStat() {
+    std::vector<std::string> paths = CreateFiles(100);
+    paths.insert(paths.begin() + 50, mRootDir + "not_exist.log");
+    paths.push_back(mRootDir);
+    for (size_t threadCount : {0, 1, 3}) {
+        // Always stat in parallel.
+        PollingStatPool pool(threadCount, 0);
+        std::vector<PollingStatResult> results;
+        // Pool is reusable, and batches smaller than a chunk are stated by the caller.
+        for (size_t batchSize : {paths.size(), (size_t)3, (size_t)0}) {
+            std::vector<std::string> batch(paths.begin(), paths.begin() + batchSize);
+            pool.Stat(batch, results);
+            APSARA_TEST_EQUAL_FATAL(results.size(), batch.size());
+            for (size_t i = 0; i < batch.size(); ++i) {
+                fsutil::PathStat expected;
+                bool success = fsutil::PathStat::stat(batch[i], expected);
+                APSARA_TEST_EQUAL_DESC(results[i].mSuccess, success, batch[i]);
+                if (!success) {
+                    APSARA_TEST_EQUAL(results[i].mErrno, ENOENT);
+                    continue;
+                }
+                APSARA_TEST_EQUAL(results[i].mStat.GetFileSize(), expected.GetFileSize());
+                APSARA_TEST_TRUE(results[i].mStat.GetDevInode() == expected.GetDevInode());
+                APSARA_TEST_EQUAL(results[i].mStat.IsDir(), expected.IsDir());
+            }
+        }
+    }
+}
+
+void PollingStatUnittest::TestLatencyHistogram() {
+    PollingLatencyHistogram histogram;
+    APSARA_TEST_EQUAL(histogram.ToString(), "");
+    for (int64_t latency : {0, 1, 2, 10, 150, 999, 1000, 1001, 100000}) {
+        histogram.Add(latency);
+    }
+    APSARA_TEST_EQUAL(histogram.GetCount(), 9UL);
+    APSARA_TEST_EQUAL(histogram.GetBucket(0), 2UL);
+    APSARA_TEST_EQUAL(histogram.GetBucket(histogram.GetBucketCount() - 1), 1UL);
+    APSARA_TEST_EQUAL(histogram.ToString(), "<=1ms:2,<=10ms:2,<=200ms:1,<=1000ms:2,<=2000ms:1,>60000ms:1");
+}
+
+// One polling round of PollingModify over 20000 files, stated in batches of 100 files.
+void PollingStatUnittest::BenchmarkStat() {
+    const size_t kFileCount = 20000;
+    const size_t kBatchSize = 100;
+    std::vector<std::string> paths = CreateFiles(kFileCount);
+    const std::vector<std::pair<size_t, int64_t>> poolOptions = {{0, 0}, {3, 0}, {3, 10000}};
+    for (const auto& option : poolOptions) {
+        PollingStatPool pool(option.first, option.second);
+        std::vector<std::string> batch;
+        std::vector<PollingStatResult> results;
+        size_t successCount = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < paths.size(); i += kBatchSize) {
+            batch.assign(paths.begin() + i, paths.begin() + std::min(i + kBatchSize, paths.size()));
+            pool.Stat(batch, results);
+            for (const auto& result : results) {
+                successCount += result.mSuccess ? 1 : 0;
+            }
+        }
+        auto cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        APSARA_TEST_EQUAL(successCount, kFileCount);
+        LOG_INFO(sLogger,
+                 ("benchmark", "polling stat pool")("files", kFileCount)("threads", option.first)(
+                     "parallel latency ns", option.second)(
+                     "round ms", cost * 1e3)("ns/file", cost * 1e9 / kFileCount));
+    }
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
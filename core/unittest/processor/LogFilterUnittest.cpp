@@ -21,11 +21,13 @@
 #include "common/util.h"
 #include "common/Flags.h"
 #include "common/StringTools.h"
+#include "common/Constants.h"
 #include "logger/Logger.h"
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
 #include <functional>
+#include <chrono>
 #include "config_manager/ConfigManager.h"
 #include "controller/EventDispatcher.h"
 #include <sys/stat.h>
@@ -1327,6 +1329,203 @@ public:
             APSARA_TEST_TRUE(root->GetNodeType() == OPERATOR_NODE);
         }
     }
+
+    // GetPiiMaskingRules returns sensitive_keys config of @key with common PII masking rules.
+    static Json::Value GetPiiMaskingRules(const std::string& key) {
+        static const char* kRules[][3] = {
+            {"(?:phone|mobile|tel)[=:]\\s*", "1[3-9]\\d{9}", "const"},
+            {"(?:id_?card|idno)[=:]\\s*", "\\d{17}[\\dXx]", "md5"},
+            {"email[=:]\\s*", "[\\w.+-]+@[\\w-]+\\.[\\w.]+", "const"},
+            {"(?:password|passwd|pwd)[=:]\\s*", "[^,&\\s]+", "const"},
+            {"(?:access_?token|token)[=:]\\s*", "[\\w.-]+", "const"},
+            {"(?:card_?no|bank_?card)[=:]\\s*", "\\d{16,19}", "md5"},
+            {"(?:secret|access_?key_?secret)[=:]\\s*", "\\w+", "const"},
+            {"(?:access_?key_?id|ak)[=:]\\s*", "LTAI\\w+", "const"},
+            {"(?:client_ip|remote_addr)[=:]\\s*", "\\d{1,3}(?:\\.\\d{1,3}){3}", "md5"},
+            {"(?:real_?name|username)[=:]\\s*", "[^,&\\s]+", "md5"},
+            {"address[=:]\\s*", "[^,&]+", "const"},
+            {"(?:birthday|dob)[=:]\\s*", "\\d{4}-\\d{2}-\\d{2}", "const"},
+            {"passport[=:]\\s*", "[A-Z]\\d{8}", "const"},
+            {"plate[=:]\\s*", "\\S+", "const"},
+            {"(?:cookie|session_?id)[=:]\\s*", "[^;\\s]+", "const"},
+            {"Authorization:\\s*Bearer\\s+", "[\\w.-]+", "const"},
+            {"jwt[=:]\\s*", "eyJ[\\w.-]+", "const"},
+            {"cvv[=:]\\s*", "\\d{3,4}", "const"},
+            {"ssn[=:]\\s*", "\\d{3}-\\d{2}-\\d{4}", "const"},
+            {"(?:wechat|wx)[=:]\\s*", "[\\w-]+", "md5"},
+            {"qq[=:]\\s*", "\\d{5,11}", "md5"},
+            {"landline[=:]\\s*", "0\\d{2,3}-\\d{7,8}", "const"},
+            {"mac[=:]\\s*", "(?:[0-9a-fA-F]{2}:){5}[0-9a-fA-F]{2}", "const"},
+            {"imei[=:]\\s*", "\\d{15}", "md5"},
+        };
+        Json::Value rules;
+        for (size_t i = 0; i < sizeof(kRules) / sizeof(kRules[0]); ++i) {
+            Json::Value rule;
+            rule["key"] = Json::Value(key);
+            rule["type"] = Json::Value(kRules[i][2]);
+            rule["regex_begin"] = Json::Value(kRules[i][0]);
+            rule["regex_content"] = Json::Value(kRules[i][1]);
+            rule["const"] = Json::Value("********");
+            rule["all"] = Json::Value(true);
+            rules.append(rule);
+        }
+        return rules;
+    }
+
+    // CastWithoutSet casts @value with each option of @pConfig one by one.
+    static std::string CastWithoutSet(Config* pConfig, const std::string& key, const std::string& value) {
+        std::unordered_map<std::string, std::shared_ptr<re2::RE2::Set>> sets;
+        sets.swap(pConfig->mSensitiveWordCastSets);
+        Log_Content content;
+        content.set_key(key);
+        content.set_value(value);
+        LogFilter::CastOneSensitiveWord(&content, pConfig);
+        sets.swap(pConfig->mSensitiveWordCastSets);
+        return content.value();
+    }
+
+    void TestCastSensWordRuleSet() {
+        Config* pConfig = new Config;
+        Json::Value rules = GetPiiMaskingRules("content");
+        // The second password rule only matches values masked by the first one.
+        Json::Value chained;
+        chained["key"] = Json::Value("content");
+        chained["type"] = Json::Value("const");
+        chained["regex_begin"] = Json::Value("pwd=");
+        chained["regex_content"] = Json::Value("\\*+");
+        chained["const"] = Json::Value("<masked>");
+        chained["all"] = Json::Value(true);
+        rules.append(chained);
+        Json::Value single;
+        single["key"] = Json::Value("single");
+        single["type"] = Json::Value("const");
+        single["regex_begin"] = Json::Value("pwd=");
+        single["regex_content"] = Json::Value("[^,]+");
+        single["const"] = Json::Value("********");
+        single["all"] = Json::Value(false);
+        rules.append(single);
+        ConfigManager::GetInstance()->GetSensitiveKeys(rules, pConfig);
+        APSARA_TEST_EQUAL(pConfig->mSensitiveWordCastOptions["content"].size(), rules.size() - 1);
+        APSARA_TEST_TRUE(pConfig->mSensitiveWordCastSets["content"].get() != NULL);
+        // No set for single option.
+        APSARA_TEST_TRUE(pConfig->mSensitiveWordCastSets.find("single") == pConfig->mSensitiveWordCastSets.end());
+
+        const char* values[] = {"",
+                                "request done, uri=/api/v1/order, cost=12ms",
+                                "phone=13812345678, email=someone@example.com, pwd=abc123",
+                                "idcard=11010119900307663X&card_no=6222020200112233445&qq=12345678",
+                                "Authorization: Bearer abc.def-ghi client_ip=10.1.2.3 mac=00:1A:2b:3C:4d:5E",
+                                "pwd=***, pwd=x, tel:13900001111 tel:13900001111"};
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+            Log_Content content;
+            content.set_key("content");
+            content.set_value(values[i]);
+            LogFilter::CastOneSensitiveWord(&content, pConfig);
+            APSARA_TEST_EQUAL(content.value(), CastWithoutSet(pConfig, "content", values[i]));
+        }
+
+        Log_Content content;
+        content.set_key("content");
+        content.set_value("user login, pwd=abc123, phone=13812345678");
+        LogFilter::CastOneSensitiveWord(&content, pConfig);
+        APSARA_TEST_EQUAL(content.value(), "user login, pwd=<masked>, phone=********");
+        delete pConfig;
+    }
+
+    // Masks application logs with 24 PII rules, 10% of them contain phone and email.
+    void BenchmarkCastSensWordRuleSet() {
+        Config* pConfig = new Config;
+        ConfigManager::GetInstance()->GetSensitiveKeys(GetPiiMaskingRules("content"), pConfig);
+        APSARA_TEST_TRUE_FATAL(pConfig->mSensitiveWordCastSets["content"].get() != NULL);
+        std::vector<std::string> values;
+        for (int i = 0; i < 1000; ++i) {
+            std::string value = "2022-07-18 10:59:21.123 INFO [order-service] [trace-" + ToString(i * 7919)
+                + "] request done, uri=/api/v1/order/create, cost=" + ToString(i % 97)
+                + "ms, user_id=" + ToString(889123 + i) + ", status=200";
+            if (i % 10 == 0) {
+                value += ", phone=13812345678, email=someone@example.com";
+            }
+            values.push_back(value);
+        }
+
+        const int kRounds = 100;
+        double costs[2] = {0, 0};
+        for (int withSet = 0; withSet < 2; ++withSet) {
+            std::unordered_map<std::string, std::shared_ptr<re2::RE2::Set>> sets;
+            if (!withSet) {
+                sets.swap(pConfig->mSensitiveWordCastSets);
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (int round = 0; round < kRounds; ++round) {
+                for (size_t i = 0; i < values.size(); ++i) {
+                    Log_Content content;
+                    content.set_key("content");
+                    content.set_value(values[i]);
+                    LogFilter::CastOneSensitiveWord(&content, pConfig);
+                }
+            }
+            costs[withSet] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!withSet) {
+                sets.swap(pConfig->mSensitiveWordCastSets);
+            }
+        }
+        LOG_INFO(sLogger,
+                 ("benchmark", "cast sensitive words")("rules", pConfig->mSensitiveWordCastOptions["content"].size())(
+                     "each regex ns/value", costs[0] * 1e9 / (kRounds * values.size()))(
+                     "regex set ns/value", costs[1] * 1e9 / (kRounds * values.size())));
+        delete pConfig;
+    }
+
+    void TestIsRawLineSearchable() {
+        APSARA_TEST_TRUE(LogFilter::IsRawLineSearchable("content", ".*ERROR.*"));
+        APSARA_TEST_TRUE(LogFilter::IsRawLineSearchable("level", "WARN|ERROR"));
+        APSARA_TEST_TRUE(LogFilter::IsRawLineSearchable("ip", "10\\.\\d+\\.[^ ]+"));
+        APSARA_TEST_TRUE(LogFilter::IsRawLineSearchable("a", "[$^]\\$(?i)abc"));
+        // Anchors, word boundaries and lookarounds depend on text around the value.
+        APSARA_TEST_FALSE(LogFilter::IsRawLineSearchable("content", "^ERROR.*"));
+        APSARA_TEST_FALSE(LogFilter::IsRawLineSearchable("content", ".*ERROR$"));
+        APSARA_TEST_FALSE(LogFilter::IsRawLineSearchable("content", "\\bERROR\\b"));
+        APSARA_TEST_FALSE(LogFilter::IsRawLineSearchable("content", "(?!DEBUG).*"));
+        APSARA_TEST_FALSE(LogFilter::IsRawLineSearchable("content", "abc\\"));
+        // Values not from the raw line.
+        APSARA_TEST_FALSE(LogFilter::IsRawLineSearchable(LOG_RESERVED_KEY_FILE_OFFSET, "\\d+"));
+    }
+
+    void TestMayMatchRawLine() {
+        static LogFilter* filterPtr = LogFilter::Instance();
+        Config config;
+        config.mProjectName = "pushdown_proj";
+        config.mCategory = "pushdown_logstore";
+        // No filter, all lines are kept.
+        APSARA_TEST_TRUE(filterPtr->MayMatchRawLine(&config, "2022-07-18 DEBUG hello"));
+
+        Json::Value keys, regs;
+        keys.append("level");
+        regs.append("ERROR|WARN");
+        keys.append("content");
+        regs.append("^order.*");
+        config.mFilterRule.reset(ConfigManager::GetInstance()->GetFilterFule(keys, regs));
+        APSARA_TEST_FALSE(filterPtr->MayMatchRawLine(&config, "2022-07-18 DEBUG order created"));
+        APSARA_TEST_TRUE(filterPtr->MayMatchRawLine(&config, "2022-07-18 ERROR order failed"));
+        // The anchored regex is not searched on the raw line.
+        APSARA_TEST_TRUE(filterPtr->MayMatchRawLine(&config, "2022-07-18 WARN user login"));
+
+        // (a and not b) or c, only c is searched when a fails.
+        const char* jsonStr = "{\"operator\": \"or\", \"operands\": ["
+                              "{\"operator\": \"and\", \"operands\": ["
+                              "{\"type\": \"regex\", \"key\": \"a\", \"exp\": \"ERROR\"},"
+                              "{\"operator\": \"not\", \"operands\": ["
+                              "{\"type\": \"regex\", \"key\": \"b\", \"exp\": \"timeout\"}]}]},"
+                              "{\"type\": \"regex\", \"key\": \"c\", \"exp\": \"\\\\d{3}ms\"}]}";
+        Json::Reader reader;
+        Json::Value rootNode;
+        APSARA_TEST_TRUE_FATAL(reader.parse(jsonStr, rootNode));
+        config.mAdvancedConfig.mFilterExpressionRoot = UserLogConfigParser::ParseExpressionFromJSON(rootNode);
+        APSARA_TEST_TRUE_FATAL(config.mAdvancedConfig.mFilterExpressionRoot.get() != NULL);
+        APSARA_TEST_TRUE(filterPtr->MayMatchRawLine(&config, "ERROR timeout"));
+        APSARA_TEST_TRUE(filterPtr->MayMatchRawLine(&config, "INFO cost 120ms"));
+        APSARA_TEST_FALSE(filterPtr->MayMatchRawLine(&config, "INFO cost 12ms"));
+    }
 };
 
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestFilterNoneUtf8, 0);
@@ -1337,11 +1536,15 @@ APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestCastSensWordFail, 0);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestCastSensWordLoggroup, 0);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestCastSensWordMulti, 0);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestCastWholeKey, 0);
+APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestCastSensWordRuleSet, 0);
+UNIT_BENCHMARK_CASE(LogFilterUnittest, BenchmarkCastSensWordRuleSet);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestInitFilter, 0);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestInitFilterFail, 0);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestInitFilterMissFieldFail, 0);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestFilter, 0);
 APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestFilterNode, 0);
+APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestIsRawLineSearchable, 0);
+APSARA_UNIT_TEST_CASE(LogFilterUnittest, TestMayMatchRawLine, 0);
 
 } // namespace logtail
 
@@ -0,0 +1,173 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <thread>
+#include <vector>
+#include "profiler/LogFileProfiler.h"
+
+namespace logtail {
+
+class LogFileProfilerUnittest : public ::testing::Test {
+public:
+    void TestHandle();
+    void TestConcurrentAdd();
+    void TestReadInfo();
+    void TestLazyShard();
+
+    void SetUp() override { LogFileProfiler::GetInstance()->CleanEnviroments(); }
+
+private:
+    static size_t GetShardCount(const ProfilingCounter& counter) {
+        size_t count = 0;
+        for (size_t i = 0; i < ProfilingCounter::kShardCount; ++i) {
+            count += counter.mShards[i].load() != NULL ? 1 : 0;
+        }
+        return count;
+    }
+
+    // GetStatistic returns the statistic with counters drained, NULL if not found.
+    LogFileProfiler::LogStoreStatistic* GetStatistic(const std::string& filename) {
+        LogFileProfiler* profiler = LogFileProfiler::GetInstance();
+        auto regionIter = profiler->mAllStatisticsMap.find("region");
+        if (regionIter == profiler->mAllStatisticsMap.end()) {
+            return NULL;
+        }
+        auto iter = regionIter->second->find("project_logstore_" + filename);
+        if (iter == regionIter->second->end()) {
+            return NULL;
+        }
+        profiler->DrainCounter(iter->second);
+        return iter->second;
+    }
+};
+
+UNIT_TEST_CASE(LogFileProfilerUnittest, TestHandle);
+UNIT_TEST_CASE(LogFileProfilerUnittest, TestConcurrentAdd);
+UNIT_TEST_CASE(LogFileProfilerUnittest, TestReadInfo);
+UNIT_TEST_CASE(LogFileProfilerUnittest, TestLazyShard);
+
+void LogFileProfilerUnittest::TestHandle() {
+    LogFileProfiler* profiler = LogFileProfiler::GetInstance();
+    ProfilingHandle handle = profiler->GetProfilingHandle("config", "region", "project", "logstore", "/a.log");
+    ProfilingHandle handle2 = profiler->GetProfilingHandle("config", "region", "project", "logstore", "/b.log");
+    APSARA_TEST_TRUE(handle.mLogstoreCounter == handle2.mLogstoreCounter);
+    APSARA_TEST_TRUE(handle.mFileCounter != handle2.mFileCounter);
+
+    profiler->AddProfilingData(handle, 100, 10, 20, 3, 1, 1, 1, 2, "bad line");
+    profiler->AddProfilingData(handle, 100, 0, 20, 1, 1, 0, 0, 0, "another bad line");
+    profiler->AddProfilingData(handle2, 50, 0, 5, 0, 0, 0, 0, 0, "");
+    profiler->AddProfilingFilterDrops(handle, 4, 2);
+    // Data added by keys goes to the same statistics.
+    profiler->AddProfilingData("config", "region", "project", "logstore", "/a.log", 10, 0, 1, 0, 0, 0, 0, 0, "");
+
+    LogFileProfiler::LogStoreStatistic* file = GetStatistic("/a.log");
+    APSARA_TEST_TRUE(file != NULL);
+    APSARA_TEST_EQUAL(file->mReadBytes, 210UL);
+    APSARA_TEST_EQUAL(file->mSkipBytes, 10UL);
+    APSARA_TEST_EQUAL(file->mSplitLines, 41UL);
+    APSARA_TEST_EQUAL(file->mParseFailures, 4UL);
+    APSARA_TEST_EQUAL(file->mRegexMatchFailures, 2UL);
+    APSARA_TEST_EQUAL(file->mParseTimeFailures, 1UL);
+    APSARA_TEST_EQUAL(file->mHistoryFailures, 1UL);
+    APSARA_TEST_EQUAL(file->mSendFailures, 2UL);
+    APSARA_TEST_EQUAL(file->mFilterEarlyDrops, 4UL);
+    APSARA_TEST_EQUAL(file->mFilterLateDrops, 2UL);
+    APSARA_TEST_EQUAL(file->mErrorLine, "bad line");
+
+    LogFileProfiler::LogStoreStatistic* logstore = GetStatistic("");
+    APSARA_TEST_TRUE(logstore != NULL);
+    APSARA_TEST_EQUAL(logstore->mReadBytes, 260UL);
+    APSARA_TEST_EQUAL(logstore->mSplitLines, 46UL);
+    APSARA_TEST_TRUE(logstore->mErrorLine.empty());
+
+    // Counters are reset after drained.
+    file->Reset();
+    profiler->AddProfilingData(handle, 1, 0, 1, 1, 0, 0, 0, 0, "new bad line");
+    file = GetStatistic("/a.log");
+    APSARA_TEST_EQUAL(file->mReadBytes, 1UL);
+    APSARA_TEST_EQUAL(file->mErrorLine, "new bad line");
+}
+
+void LogFileProfilerUnittest::TestConcurrentAdd() {
+    LogFileProfiler* profiler = LogFileProfiler::GetInstance();
+    const int threadCount = 16;
+    const int addCount = 10000;
+    std::vector<ProfilingHandle> handles;
+    for (int i = 0; i < 4; ++i) {
+        handles.push_back(
+            profiler->GetProfilingHandle("config", "region", "project", "logstore", "/" + std::to_string(i) + ".log"));
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < addCount; ++j) {
+                profiler->AddProfilingData(handles[i % handles.size()], 10, 0, 1, 0, 0, 0, 0, 0, "");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < handles.size(); ++i) {
+        APSARA_TEST_EQUAL(GetStatistic("/" + std::to_string(i) + ".log")->mSplitLines,
+                          (uint64_t)threadCount / handles.size() * addCount);
+    }
+    APSARA_TEST_EQUAL(GetStatistic("")->mSplitLines, (uint64_t)threadCount * addCount);
+    APSARA_TEST_EQUAL(GetStatistic("")->mReadBytes, (uint64_t)threadCount * addCount * 10);
+}
+
+void LogFileProfilerUnittest::TestReadInfo() {
+    LogFileProfiler* profiler = LogFileProfiler::GetInstance();
+    ProfilingHandle handle = profiler->GetProfilingHandle("config", "region", "project", "logstore", "/a.log");
+    profiler->AddProfilingReadBytes(handle, 1, 2, 1000, 400, 100);
+    profiler->AddProfilingReadBytes(handle, 1, 2, 1000, 800, 101);
+    LogFileProfiler::LogStoreStatistic* file = GetStatistic("/a.log");
+    APSARA_TEST_EQUAL(file->mFileDev, 1UL);
+    APSARA_TEST_EQUAL(file->mFileInode, 2UL);
+    APSARA_TEST_EQUAL(file->mReadOffset, 800UL);
+    APSARA_TEST_EQUAL(file->mLastReadTime, 101);
+    APSARA_TEST_EQUAL(file->mReadCount, 2U);
+    APSARA_TEST_EQUAL(file->mReadDelaySum, 800UL);
+    APSARA_TEST_EQUAL(GetStatistic("")->mReadCount, 2U);
+
+    // Read info is not overwritten if there is no read since last drain.
+    file->Reset();
+    file = GetStatistic("/a.log");
+    APSARA_TEST_EQUAL(file->mReadCount, 0U);
+    APSARA_TEST_EQUAL(file->mReadOffset, 0UL);
+}
+
+void LogFileProfilerUnittest::TestLazyShard() {
+    LogFileProfiler* profiler = LogFileProfiler::GetInstance();
+    ProfilingHandle handle = profiler->GetProfilingHandle("config", "region", "project", "logstore", "/a.log");
+    APSARA_TEST_EQUAL(GetShardCount(*handle.mFileCounter), 0U);
+
+    // Only the shard of current thread is allocated.
+    profiler->AddProfilingData(handle, 100, 0, 10, 0, 0, 0, 0, 0, "");
+    profiler->AddProfilingReadBytes(handle, 1, 2, 1000, 400, 100);
+    APSARA_TEST_EQUAL(GetShardCount(*handle.mFileCounter), 1U);
+    APSARA_TEST_EQUAL(GetShardCount(*handle.mLogstoreCounter), 1U);
+    std::thread([&]() { profiler->AddProfilingData(handle, 100, 0, 10, 0, 0, 0, 0, 0, ""); }).join();
+    APSARA_TEST_TRUE(GetShardCount(*handle.mFileCounter) <= 2U);
+
+    LogFileProfiler::LogStoreStatistic* file = GetStatistic("/a.log");
+    APSARA_TEST_EQUAL(file->mReadBytes, 200UL);
+    APSARA_TEST_EQUAL(file->mSplitLines, 20UL);
+    APSARA_TEST_EQUAL(file->mReadCount, 1U);
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
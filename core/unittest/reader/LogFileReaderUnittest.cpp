@@ -0,0 +1,517 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "checkpoint/RangeCheckpoint.h"
+#include "common/AsyncReadEngine.h"
+#include "common/FileSystemUtil.h"
+#include "common/Flags.h"
+#include "common/StringTools.h"
+#include "common/TimeUtil.h"
+#include "config/Config.h"
+#include "config/UserLogConfigParser.h"
+#include "parser/LogParser.h"
+#include "reader/JsonLogFileReader.h"
+#include "reader/LogFileReader.h"
+
+DECLARE_FLAG_STRING(file_read_backend);
+
+namespace logtail {
+
+class LogFileReaderUnittest : public ::testing::Test {
+public:
+    void TestCarryOverUTF8();
+    void TestCarryOverGBK();
+    void TestCarryOverAcrossBuffers();
+    void TestCarryOverInvalidation();
+    void TestReadAheadHeadReservation();
+    void TestExactlyOnceRanges();
+    void TestJsonFastParse();
+    void TestJsonFastParseUnmatch();
+    void TestJsonFastParseValues();
+    void TestJsonFastParseConfig();
+
+protected:
+    static void SetUpTestCase() {
+        sBufferSizeBackup = LogFileReader::BUFFER_SIZE;
+        LogFileReader::SetReadBufferSize(10 * 1024);
+        // Read ahead is used if io_uring is supported, the engine is created on first read.
+        sReadBackendBackup = STRING_FLAG(file_read_backend);
+        STRING_FLAG(file_read_backend) = "io_uring";
+    }
+
+    static void TearDownTestCase() {
+        LogFileReader::SetReadBufferSize(sBufferSizeBackup);
+        STRING_FLAG(file_read_backend) = sReadBackendBackup;
+    }
+
+    void SetUp() override {
+        mRootDir = GetProcessExecutionDir();
+        if (PATH_SEPARATOR[0] == mRootDir.at(mRootDir.size() - 1))
+            mRootDir.resize(mRootDir.size() - 1);
+        mRootDir += PATH_SEPARATOR + "LogFileReaderUnittest";
+        bfs::remove_all(mRootDir);
+        bfs::create_directories(mRootDir);
+        mLogPath = mRootDir + PATH_SEPARATOR + kLogName;
+    }
+
+    void TearDown() override { bfs::remove_all(mRootDir); }
+
+    void WriteLog(const std::string& content, bool append = true) {
+        std::ofstream writer(mLogPath.c_str(), std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+        writer << content;
+    }
+
+    LogFileReaderPtr MakeReader(FileEncoding encoding = ENCODING_UTF8) {
+        LogFileReaderPtr reader(new CommonRegLogFileReader(
+            "project", "logstore", mRootDir, kLogName, INT32_FLAG(default_tail_limit_kb), "", "", "", encoding));
+        reader->UpdateReaderManual();
+        int64_t fileSize = 0;
+        reader->CheckFileSignatureAndOffset(fileSize);
+        reader->mFirstWatched = false;
+        return reader;
+    }
+
+    // Lines of different lengths, so that reads of BUFFER_SIZE end in the middle of a line.
+    static std::string MakeLines(size_t bytes) {
+        std::string lines;
+        for (int seq = 0; lines.size() < bytes; ++seq) {
+            lines.append("line-" + ToString(seq) + " " + std::string(seq % 97, 'x') + "\n");
+        }
+        return lines;
+    }
+
+    // Reads once by ReadUTF8 or ReadGBK, returns the lines read with the last line feed restored.
+    static std::string ReadOnce(LogFileReader& reader, int64_t end, bool& moreData) {
+        ReadBufferPtr buffer;
+        size_t size = 0;
+        TruncateInfo* truncateInfo = NULL;
+        moreData = false;
+        if (reader.mFileEncoding == ENCODING_GBK)
+            reader.ReadGBK(buffer, &size, end, moreData, truncateInfo);
+        else
+            reader.ReadUTF8(buffer, &size, end, moreData, truncateInfo);
+        TruncateInfoPtr truncateInfoPtr(truncateInfo);
+        return ToLines(buffer.get(), size);
+    }
+
+    static std::string ToLines(const char* buffer, size_t size) {
+        std::string lines;
+        if (size > 0) {
+            lines.assign(buffer, size);
+            lines[size - 1] = '\n';
+        }
+        return lines;
+    }
+
+    // Reads until the end of file, checks carry-over and positions after each read.
+    std::string ReadAll(LogFileReader& reader, int64_t end) {
+        std::string lines;
+        bool moreData = false;
+        for (int i = 0; i < 1000 && reader.mLastFilePos < end; ++i) {
+            lines.append(ReadOnce(reader, end, moreData));
+            APSARA_TEST_EQUAL(reader.mLastFilePos, static_cast<int64_t>(lines.size()));
+            if (!reader.mCarryOver.empty()) {
+                APSARA_TEST_EQUAL(reader.mCarryOverOffset, reader.mLastFilePos);
+                APSARA_TEST_EQUAL(reader.mLastReadPos,
+                                  reader.mLastFilePos + static_cast<int64_t>(reader.mCarryOver.size()));
+            }
+        }
+        return lines;
+    }
+
+    static std::unique_ptr<JsonLogFileReader>
+    MakeJsonReader(const std::string& timeKey, const std::string& timeFormat, bool discardUnmatch = true) {
+        std::unique_ptr<JsonLogFileReader> reader(new JsonLogFileReader("project",
+                                                                        "logstore",
+                                                                        "/var/log",
+                                                                        "json.log",
+                                                                        INT32_FLAG(default_tail_limit_kb),
+                                                                        timeFormat,
+                                                                        "",
+                                                                        "",
+                                                                        ENCODING_UTF8,
+                                                                        discardUnmatch));
+        reader->SetTimeKey(timeKey);
+        // Set by config for readers created by it.
+        reader->SetSpecifiedYear(-1);
+        reader->SetTzOffsetSecond();
+        return reader;
+    }
+
+    static bool
+    ParseJsonLine(JsonLogFileReader& reader, const std::string& line, bool fast, sls_logs::LogGroup& logGroup) {
+        reader.SetFastParse(fast);
+        ParseLogError error;
+        time_t lastLogLineTime = 0;
+        std::string lastLogTimeStr;
+        uint32_t logGroupSize = 0;
+        return reader.ParseLogLine(line.c_str(), logGroup, error, lastLogLineTime, lastLogTimeStr, logGroupSize);
+    }
+
+    // ParseJson parses @line by both rapidjson and the fast path, checks they return @expected and make the
+    //  same logs, and returns logs of the fast path.
+    static sls_logs::LogGroup ParseJson(JsonLogFileReader& reader, const std::string& line, bool expected = true) {
+        sls_logs::LogGroup rapidjsonGroup;
+        sls_logs::LogGroup fastGroup;
+        APSARA_TEST_EQUAL(ParseJsonLine(reader, line, false, rapidjsonGroup), expected);
+        APSARA_TEST_EQUAL(ParseJsonLine(reader, line, true, fastGroup), expected);
+        APSARA_TEST_EQUAL(fastGroup.logs_size(), rapidjsonGroup.logs_size());
+        for (int i = 0; i < fastGroup.logs_size() && i < rapidjsonGroup.logs_size(); ++i) {
+            const sls_logs::Log& rapidjsonLog = rapidjsonGroup.logs(i);
+            const sls_logs::Log& fastLog = fastGroup.logs(i);
+            // Logs without time key use system time, which may step between two parses.
+            APSARA_TEST_TRUE(fastLog.time() >= rapidjsonLog.time() && fastLog.time() <= rapidjsonLog.time() + 1);
+            APSARA_TEST_EQUAL(fastLog.contents_size(), rapidjsonLog.contents_size());
+            for (int j = 0; j < fastLog.contents_size() && j < rapidjsonLog.contents_size(); ++j) {
+                APSARA_TEST_EQUAL(fastLog.contents(j).key(), rapidjsonLog.contents(j).key());
+                APSARA_TEST_EQUAL(fastLog.contents(j).value(), rapidjsonLog.contents(j).value());
+            }
+        }
+        return fastGroup;
+    }
+
+    static const std::string kLogName;
+    static size_t sBufferSizeBackup;
+    static std::string sReadBackendBackup;
+    std::string mRootDir;
+    std::string mLogPath;
+};
+
+const std::string LogFileReaderUnittest::kLogName = "reader.log";
+size_t LogFileReaderUnittest::sBufferSizeBackup = 0;
+std::string LogFileReaderUnittest::sReadBackendBackup;
+
+UNIT_TEST_CASE(LogFileReaderUnittest, TestCarryOverUTF8);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestCarryOverGBK);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestCarryOverAcrossBuffers);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestCarryOverInvalidation);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestReadAheadHeadReservation);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestExactlyOnceRanges);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestJsonFastParse);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestJsonFastParseUnmatch);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestJsonFastParseValues);
+UNIT_TEST_CASE(LogFileReaderUnittest, TestJsonFastParseConfig);
+
+void LogFileReaderUnittest::TestCarryOverUTF8() {
+    WriteLog("line-1\nline-2\nline-", false);
+    auto reader = MakeReader();
+    bool moreData = false;
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 19, moreData), "line-1\nline-2\n");
+    APSARA_TEST_FALSE(moreData);
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 14);
+    APSARA_TEST_EQUAL(reader->mLastReadPos, 19);
+    APSARA_TEST_EQUAL(reader->mCarryOver, "line-");
+    APSARA_TEST_EQUAL(reader->mCarryOverOffset, 14);
+
+    // The incomplete line is not complete yet, only the new bytes are read.
+    WriteLog("3");
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 20, moreData), "");
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 14);
+    APSARA_TEST_EQUAL(reader->mLastReadPos, 20);
+    APSARA_TEST_EQUAL(reader->mCarryOver, "line-3");
+    APSARA_TEST_EQUAL(reader->mCarryOverOffset, 14);
+
+    WriteLog("\nline-4\n");
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 28, moreData), "line-3\nline-4\n");
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 28);
+    APSARA_TEST_EQUAL(reader->mLastReadPos, 28);
+    APSARA_TEST_TRUE(reader->mCarryOver.empty());
+    APSARA_TEST_EQUAL(reader->mCarryOverOffset, -1);
+}
+
+void LogFileReaderUnittest::TestCarryOverGBK() {
+    // "\xc4\xe3\xba\xc3" is GBK of "\xe4\xbd\xa0\xe5\xa5\xbd" in UTF8.
+    WriteLog("line-1\n\xc4\xe3\xba\xc3", false);
+    auto reader = MakeReader(ENCODING_GBK);
+    bool moreData = false;
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 11, moreData), "line-1\n");
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 7);
+    APSARA_TEST_EQUAL(reader->mLastReadPos, 11);
+    APSARA_TEST_EQUAL(reader->mCarryOver, "\xc4\xe3\xba\xc3");
+    APSARA_TEST_EQUAL(reader->mCarryOverOffset, 7);
+
+    WriteLog("\nline-3\n");
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 19, moreData), "\xe4\xbd\xa0\xe5\xa5\xbd\nline-3\n");
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 19);
+    APSARA_TEST_EQUAL(reader->mLastReadPos, 19);
+    APSARA_TEST_TRUE(reader->mCarryOver.empty());
+}
+
+void LogFileReaderUnittest::TestCarryOverAcrossBuffers() {
+    const std::string content = MakeLines(LogFileReader::BUFFER_SIZE * 5 / 2);
+    WriteLog(content, false);
+    auto reader = MakeReader();
+    bool moreData = false;
+    std::string lines = ReadOnce(*reader, content.size(), moreData);
+    APSARA_TEST_TRUE(moreData);
+    APSARA_TEST_FALSE(reader->mCarryOver.empty());
+    APSARA_TEST_EQUAL(reader->mLastReadPos, static_cast<int64_t>(LogFileReader::BUFFER_SIZE));
+    lines.append(ReadAll(*reader, content.size()));
+    APSARA_TEST_TRUE(lines == content);
+    APSARA_TEST_EQUAL(reader->mLastReadPos, static_cast<int64_t>(content.size()));
+}
+
+void LogFileReaderUnittest::TestCarryOverInvalidation() {
+    // Truncated with the same signature, position moves back to file size.
+    const std::string head = MakeLines(1500);
+    WriteLog(head + "tail-part", false);
+    auto reader = MakeReader();
+    bool moreData = false;
+    APSARA_TEST_TRUE(ReadOnce(*reader, head.size() + 9, moreData) == head);
+    APSARA_TEST_EQUAL(reader->mCarryOver, "tail-part");
+    bfs::resize_file(mLogPath, 1200);
+    WriteLog("after-truncate\n");
+    int64_t fileSize = 0;
+    APSARA_TEST_TRUE(reader->CheckFileSignatureAndOffset(fileSize));
+    APSARA_TEST_EQUAL(fileSize, 1215);
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 1215);
+    WriteLog("line-new\n");
+    APSARA_TEST_TRUE(reader->CheckFileSignatureAndOffset(fileSize));
+    APSARA_TEST_EQUAL(ReadOnce(*reader, fileSize, moreData), "line-new\n");
+    APSARA_TEST_TRUE(reader->mCarryOver.empty());
+
+    // Rewritten with another signature, read from the beginning.
+    WriteLog("line-1\nline-", false);
+    reader = MakeReader();
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 12, moreData), "line-1\n");
+    APSARA_TEST_EQUAL(reader->mCarryOver, "line-");
+    WriteLog("other-1\nother-2\n", false);
+    APSARA_TEST_FALSE(reader->CheckFileSignatureAndOffset(fileSize));
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 0);
+    APSARA_TEST_EQUAL(ReadOnce(*reader, fileSize, moreData), "other-1\nother-2\n");
+
+    // Closed and reopened, the tail is read from file again.
+    WriteLog("line-1\nline-", false);
+    reader = MakeReader();
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 12, moreData), "line-1\n");
+    APSARA_TEST_EQUAL(reader->mCarryOver, "line-");
+    reader->CloseFilePtr();
+    APSARA_TEST_TRUE(reader->mCarryOver.empty());
+    APSARA_TEST_EQUAL(reader->mCarryOverOffset, -1);
+    WriteLog("2\n");
+    reader->UpdateReaderManual();
+    APSARA_TEST_EQUAL(ReadOnce(*reader, 14, moreData), "line-2\n");
+    APSARA_TEST_EQUAL(reader->mLastFilePos, 14);
+}
+
+void LogFileReaderUnittest::TestReadAheadHeadReservation() {
+    if (!AsyncReadEngine::GetInstance()->IsEnabled()) {
+        LOG_WARNING(sLogger, ("io_uring is not supported", "skip test"));
+        return;
+    }
+    const std::string content = MakeLines(LogFileReader::BUFFER_SIZE * 7 / 2);
+    WriteLog(content, false);
+    auto reader = MakeReader();
+    const int64_t readAheadBytes = LogFileReader::sReadAheadBytes.load();
+    bool moreData = false;
+    std::string lines = ReadOnce(*reader, content.size(), moreData);
+    APSARA_TEST_TRUE(moreData);
+
+    // The chunk is read after the carried tail, which is copied before it when taken.
+    const size_t headSize = reader->mCarryOver.size();
+    auto request = reader->mReadAhead;
+    APSARA_TEST_TRUE_FATAL(request != nullptr);
+    APSARA_TEST_TRUE(headSize > 0);
+    APSARA_TEST_EQUAL(reader->mReadAheadHeadSize, headSize);
+    APSARA_TEST_EQUAL(request->offset, reader->mLastFilePos + static_cast<int64_t>(headSize));
+    APSARA_TEST_EQUAL(request->size, LogFileReader::BUFFER_SIZE - headSize);
+    APSARA_TEST_EQUAL(LogFileReader::sReadAheadBytes.load() - readAheadBytes,
+                      static_cast<int64_t>(LogFileReader::BUFFER_SIZE + 1));
+
+    ReadBufferPtr buffer;
+    size_t size = 0;
+    TruncateInfo* truncateInfo = NULL;
+    reader->ReadUTF8(buffer, &size, content.size(), moreData, truncateInfo);
+    TruncateInfoPtr truncateInfoPtr(truncateInfo);
+    APSARA_TEST_TRUE(buffer.get() + headSize == request->buffer.get());
+    lines.append(ToLines(buffer.get(), size));
+    APSARA_TEST_TRUE(lines == content.substr(0, lines.size()));
+
+    lines.append(ReadAll(*reader, content.size()));
+    APSARA_TEST_TRUE(lines == content);
+    reader->CloseFilePtr();
+    APSARA_TEST_TRUE(reader->mReadAhead == nullptr);
+    APSARA_TEST_EQUAL(LogFileReader::sReadAheadBytes.load(), readAheadBytes);
+}
+
+void LogFileReaderUnittest::TestExactlyOnceRanges() {
+    const std::string content = MakeLines(LogFileReader::BUFFER_SIZE * 7 / 2);
+    WriteLog(content, false);
+    auto reader = MakeReader();
+    reader->mEOOption.reset(new LogFileReader::ExactlyOnceOption);
+    reader->mEOOption->primaryCheckpoint.set_sig_size(reader->mLastFileSignatureSize);
+
+    // Ranges of new checkpoints are continuous, tails carried over are not counted twice.
+    std::vector<RangeCheckpointPtr> checkpoints;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    std::string lines;
+    bool carried = false;
+    for (int i = 0; i < 100 && reader->mLastFilePos < static_cast<int64_t>(content.size()); ++i) {
+        LogBuffer* logBuffer = NULL;
+        reader->ReadLog(logBuffer);
+        APSARA_TEST_TRUE_FATAL(logBuffer != NULL);
+        std::unique_ptr<LogBuffer> logBufferPtr(logBuffer);
+        auto& cpt = logBuffer->exactlyOnceCheckpoint->data;
+        APSARA_TEST_EQUAL(cpt.read_offset(), lines.size());
+        APSARA_TEST_EQUAL(cpt.read_length(), static_cast<uint64_t>(logBuffer->bufferSize));
+        APSARA_TEST_EQUAL(logBuffer->beginOffset, cpt.read_offset());
+        lines.append(ToLines(logBuffer->buffer, logBuffer->bufferSize));
+        checkpoints.push_back(logBuffer->exactlyOnceCheckpoint);
+        ranges.push_back(std::make_pair(cpt.read_offset(), cpt.read_length()));
+        carried = carried || !reader->mCarryOver.empty();
+    }
+    APSARA_TEST_TRUE(carried);
+    APSARA_TEST_TRUE(checkpoints.size() > 1);
+    APSARA_TEST_TRUE(lines == content);
+
+    // Replay all as uncommitted checkpoints, a stale carry-over must not be used.
+    reader->mLastFilePos = reader->mLastReadPos = 0;
+    reader->mCarryOver = "stale";
+    reader->mCarryOverOffset = 0;
+    for (auto& cpt : checkpoints) {
+        cpt->data.set_hash_key("hash");
+        reader->mEOOption->toReplayCheckpoints.push_back(cpt);
+    }
+    lines.clear();
+    for (size_t idx = 0; idx < checkpoints.size(); ++idx) {
+        LogBuffer* logBuffer = NULL;
+        reader->ReadLog(logBuffer);
+        APSARA_TEST_TRUE_FATAL(logBuffer != NULL);
+        std::unique_ptr<LogBuffer> logBufferPtr(logBuffer);
+        APSARA_TEST_TRUE(logBuffer->exactlyOnceCheckpoint == checkpoints[idx]);
+        auto& cpt = logBuffer->exactlyOnceCheckpoint->data;
+        APSARA_TEST_EQUAL(cpt.read_offset(), ranges[idx].first);
+        APSARA_TEST_EQUAL(cpt.read_length(), ranges[idx].second);
+        APSARA_TEST_EQUAL(static_cast<uint64_t>(logBuffer->bufferSize), ranges[idx].second);
+        APSARA_TEST_TRUE(reader->mCarryOver.empty());
+        lines.append(ToLines(logBuffer->buffer, logBuffer->bufferSize));
+    }
+    APSARA_TEST_TRUE(lines == content);
+    APSARA_TEST_EQUAL(reader->mLastFilePos, static_cast<int64_t>(content.size()));
+    APSARA_TEST_TRUE(reader->mEOOption->toReplayCheckpoints.empty());
+    reader->mEOOption.reset();
+}
+
+void LogFileReaderUnittest::TestJsonFastParse() {
+    time_t now = time(NULL);
+    const std::string timeStr = GetTimeStamp(now, "%Y-%m-%d %H:%M:%S");
+    auto reader = MakeJsonReader("time", "%Y-%m-%d %H:%M:%S");
+    ParseJson(*reader, "", true);
+
+    auto logGroup = ParseJson(*reader, "{\"level\":\"INFO\",\"time\":\"" + timeStr + "\",\"seq\":12,\"ok\":true}");
+    APSARA_TEST_EQUAL_FATAL(logGroup.logs_size(), 1);
+    const sls_logs::Log& log = logGroup.logs(0);
+    APSARA_TEST_EQUAL(log.time(), static_cast<uint32_t>(now));
+    APSARA_TEST_EQUAL(log.contents_size(), 4);
+    APSARA_TEST_EQUAL(log.contents(1).key(), "time");
+    APSARA_TEST_EQUAL(log.contents(1).value(), timeStr);
+    APSARA_TEST_EQUAL(log.contents(2).value(), "12");
+    APSARA_TEST_EQUAL(log.contents(3).value(), "true");
+
+    // Integer time value.
+    reader = MakeJsonReader("ts", "%s");
+    logGroup = ParseJson(*reader, "{\"ts\": " + ToString(now) + ", \"msg\": \"hello\"}");
+    APSARA_TEST_EQUAL_FATAL(logGroup.logs_size(), 1);
+    APSARA_TEST_EQUAL(logGroup.logs(0).time(), static_cast<uint32_t>(now));
+
+    // Precise timestamp from the fraction of time value.
+    reader = MakeJsonReader("time", "%Y-%m-%d %H:%M:%S");
+    reader->SetPreciseTimestampConfig(true, "precise_timestamp", TimeStampUnit::MILLISECOND);
+    logGroup = ParseJson(*reader, "{\"time\":\"" + timeStr + ".123\",\"msg\":\"hello\"}");
+    APSARA_TEST_EQUAL_FATAL(logGroup.logs_size(), 1);
+    APSARA_TEST_EQUAL_FATAL(logGroup.logs(0).contents_size(), 3);
+    APSARA_TEST_EQUAL(logGroup.logs(0).time(), static_cast<uint32_t>(now));
+    APSARA_TEST_EQUAL(logGroup.logs(0).contents(2).key(), "precise_timestamp");
+    APSARA_TEST_EQUAL(logGroup.logs(0).contents(2).value(), ToString(static_cast<uint64_t>(now) * 1000 + 123));
+}
+
+void LogFileReaderUnittest::TestJsonFastParseUnmatch() {
+    const std::string timeStr = GetTimeStamp(time(NULL), "%Y-%m-%d %H:%M:%S");
+    // Missing time key, time value which is not string or integer, and invalid json.
+    const std::vector<std::string> lines = {"{\"level\":\"INFO\",\"msg\":\"hello\"}",
+                                            "{\"time\":1.5,\"msg\":\"hello\"}",
+                                            "{\"time\":\"" + timeStr + "\",\"msg\":",
+                                            "[\"" + timeStr + "\"]"};
+    auto reader = MakeJsonReader("time", "%Y-%m-%d %H:%M:%S", true);
+    for (auto& line : lines) {
+        auto logGroup = ParseJson(*reader, line, false);
+        APSARA_TEST_EQUAL(logGroup.logs_size(), 0);
+    }
+
+    reader = MakeJsonReader("time", "%Y-%m-%d %H:%M:%S", false);
+    for (auto& line : lines) {
+        auto logGroup = ParseJson(*reader, line, true);
+        APSARA_TEST_EQUAL_FATAL(logGroup.logs_size(), 1);
+        APSARA_TEST_EQUAL_FATAL(logGroup.logs(0).contents_size(), 1);
+        APSARA_TEST_EQUAL(logGroup.logs(0).contents(0).key(), LogParser::UNMATCH_LOG_KEY);
+        APSARA_TEST_EQUAL(logGroup.logs(0).contents(0).value(), line);
+    }
+}
+
+void LogFileReaderUnittest::TestJsonFastParseValues() {
+    auto reader = MakeJsonReader("", "");
+    auto logGroup = ParseJson(*reader,
+                              "{\"msg\":\"a\\\"b\\\\c\\nd\\u00e9\\t\",\"k\\\"ey\":\"v\",\"n\":null,"
+                              "\"o\":{\"a\":[1,\"x\"],\"b\":{\"c\":\"}\"}},\"e\":[]}");
+    APSARA_TEST_EQUAL_FATAL(logGroup.logs_size(), 1);
+    const sls_logs::Log& log = logGroup.logs(0);
+    APSARA_TEST_EQUAL_FATAL(log.contents_size(), 5);
+    APSARA_TEST_EQUAL(log.contents(0).value(), "a\"b\\c\nd\xc3\xa9\t");
+    APSARA_TEST_EQUAL(log.contents(1).key(), "k\"ey");
+    APSARA_TEST_EQUAL(log.contents(2).key(), "n");
+    APSARA_TEST_EQUAL(log.contents(2).value(), "");
+    APSARA_TEST_EQUAL(log.contents(3).value(), "{\"a\":[1,\"x\"],\"b\":{\"c\":\"}\"}}");
+    APSARA_TEST_EQUAL(log.contents(4).value(), "[]");
+
+    // Unlike rapidjson, nested values are kept as they are written.
+    sls_logs::LogGroup fastGroup;
+    APSARA_TEST_TRUE(ParseJsonLine(*reader, "{\"o\": { \"a\" : [1, 2] }}", true, fastGroup));
+    APSARA_TEST_EQUAL_FATAL(fastGroup.logs_size(), 1);
+    APSARA_TEST_EQUAL(fastGroup.logs(0).contents(0).value(), "{ \"a\" : [1, 2] }");
+}
+
+void LogFileReaderUnittest::TestJsonFastParseConfig() {
+    WriteLog("{\"msg\":\"hello\"}\n", false);
+    for (bool fastParse : {false, true}) {
+        Config config(mRootDir, "*.log", JSON_LOG, "log", "", "project", false, 0, 0, "logstore");
+        Json::Value configJson;
+        configJson["advanced"]["json_fast_parse"] = fastParse;
+        UserLogConfigParser::ParseAdvancedConfig(configJson, config);
+        APSARA_TEST_EQUAL(config.mAdvancedConfig.mJsonFastParse, fastParse);
+
+        std::unique_ptr<LogFileReader> reader(
+            config.CreateLogFileReader(mRootDir, kLogName, GetFileDevInode(mLogPath), true));
+        APSARA_TEST_TRUE_FATAL(reader != nullptr);
+        JsonLogFileReader* jsonReader = dynamic_cast<JsonLogFileReader*>(reader.get());
+        APSARA_TEST_TRUE_FATAL(jsonReader != NULL);
+        APSARA_TEST_EQUAL(jsonReader->mFastParse, fastParse);
+    }
+
+    // Only for JSON_LOG.
+    Config config(mRootDir, "*.log", REGEX_LOG, "log", "", "project", false, 0, 0, "logstore");
+    Json::Value configJson;
+    configJson["advanced"]["json_fast_parse"] = true;
+    UserLogConfigParser::ParseAdvancedConfig(configJson, config);
+    APSARA_TEST_FALSE(config.mAdvancedConfig.mJsonFastParse);
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,218 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <chrono>
+#include <memory>
+#include <boost/regex.hpp>
+#include "common/StringTools.h"
+#include "reader/LogFileReader.h"
+
+namespace logtail {
+
+static const char* kJavaLogBeginRegex = "\\d{4}-\\d{2}-\\d{2}\\s\\d{2}:\\d{2}:\\d{2}.*";
+
+class LogSplitUnittest : public ::testing::Test {
+public:
+    void TestSingleLine();
+    void TestMultiLine();
+    void TestLastMatchedLine();
+    void TestLastMatchedLineWithCheckedSize();
+    void BenchmarkJavaMultiLine();
+
+private:
+    static std::string MakeJavaLogs(size_t bytes);
+
+    // The splitter before vectorized line feed scanning and regex prefilter, kept as baseline.
+    static std::vector<int32_t> LegacyLogSplit(const boost::regex* reg, char* buffer, int32_t size, int32_t& lineFeed);
+
+    static LogFileReaderPtr MakeReader(const std::string& logBeginReg) {
+        LogFileReaderPtr reader(
+            new CommonRegLogFileReader("project", "logstore", "/tmp", "split.log", 1024, "", "none"));
+        reader->SetLogBeginRegex(logBeginReg);
+        return reader;
+    }
+
+    static void CheckSameSplit(const std::string& logBeginReg, const std::string& logs) {
+        std::unique_ptr<boost::regex> reg(logBeginReg.empty() ? NULL : new boost::regex(logBeginReg));
+        std::string expectedBuf = logs;
+        int32_t expectedLineFeed = 0;
+        auto expected = LegacyLogSplit(reg.get(), &expectedBuf[0], logs.size(), expectedLineFeed);
+
+        std::string actualBuf = logs;
+        int32_t actualLineFeed = 0;
+        auto actual = MakeReader(logBeginReg)->LogSplit(&actualBuf[0], logs.size(), actualLineFeed);
+
+        APSARA_TEST_TRUE(expected == actual);
+        APSARA_TEST_EQUAL(expectedLineFeed, actualLineFeed);
+        APSARA_TEST_TRUE(expectedBuf == actualBuf);
+    }
+};
+
+UNIT_TEST_CASE(LogSplitUnittest, TestSingleLine);
+UNIT_TEST_CASE(LogSplitUnittest, TestMultiLine);
+UNIT_TEST_CASE(LogSplitUnittest, TestLastMatchedLine);
+UNIT_TEST_CASE(LogSplitUnittest, TestLastMatchedLineWithCheckedSize);
+UNIT_BENCHMARK_CASE(LogSplitUnittest, BenchmarkJavaMultiLine);
+
+std::string LogSplitUnittest::MakeJavaLogs(size_t bytes) {
+    std::string logs;
+    int seq = 0;
+    while (logs.size() < bytes) {
+        logs.append("2022-08-01 12:00:0" + ToString(seq % 10) + ",123 INFO [main] com.example.Service - request "
+                    + ToString(seq) + " done\n");
+        if (seq % 3 == 0) {
+            logs.append("2022-08-01 12:00:01,456 ERROR [worker-" + ToString(seq % 16)
+                        + "] com.example.Service - unexpected failure\n");
+            logs.append("java.lang.IllegalStateException: connection reset\n");
+            for (int i = 0; i < 20; ++i) {
+                logs.append("\tat com.example.dao.Repository.query" + ToString(i) + "(Repository.java:"
+                            + ToString(100 + i) + ")\n");
+            }
+            logs.append("Caused by: java.net.SocketException: reset by peer\n\t... 20 more\n");
+        }
+        ++seq;
+    }
+    // Buffer passed to LogSplit ends with '\0' instead of the last '\n'.
+    logs[logs.size() - 1] = '\0';
+    return logs;
+}
+
+std::vector<int32_t>
+LogSplitUnittest::LegacyLogSplit(const boost::regex* reg, char* buffer, int32_t size, int32_t& lineFeed) {
+    std::vector<int32_t> index;
+    int begIndex = 0;
+    int endIndex = 0;
+    lineFeed = 0;
+    std::string exception;
+    while (endIndex < size) {
+        if (buffer[endIndex] == '\n') {
+            lineFeed++;
+            buffer[endIndex] = '\0';
+            if (reg == NULL || BoostRegexMatch(buffer + begIndex, *reg, exception)) {
+                index.push_back(begIndex);
+                if (begIndex > 0) {
+                    buffer[begIndex - 1] = '\0';
+                }
+            }
+            buffer[endIndex] = '\n';
+            begIndex = endIndex + 1;
+        }
+        endIndex++;
+    }
+    lineFeed++;
+    if (reg == NULL || BoostRegexMatch(buffer + begIndex, *reg, exception)) {
+        if (begIndex > 0) {
+            buffer[begIndex - 1] = '\0';
+        }
+        index.push_back(begIndex);
+    }
+    return index;
+}
+
+void LogSplitUnittest::TestSingleLine() {
+    CheckSameSplit("", std::string("line1\nline2\n\nline4\0", 19));
+    CheckSameSplit("", std::string("\0", 1));
+    CheckSameSplit("", MakeJavaLogs(64 * 1024));
+}
+
+void LogSplitUnittest::TestMultiLine() {
+    CheckSameSplit(kJavaLogBeginRegex, MakeJavaLogs(64 * 1024));
+    // Regex without extractable shape.
+    CheckSameSplit("(\\d+|x).*", MakeJavaLogs(16 * 1024));
+    CheckSameSplit("\\[\\d+\\].*", std::string("[1] a\n\tb\n[2] c\nd\n[x\n[3]\0", 24));
+}
+
+void LogSplitUnittest::TestLastMatchedLine() {
+    std::string logs = MakeJavaLogs(16 * 1024);
+    logs[logs.size() - 1] = '\n';
+    logs.append("2022-08-01 12:00:02,000 ERROR unfinished\n\tat a.b.C(C.java:1)\n");
+    std::string expected = logs;
+    size_t lastBegin = expected.rfind("2022-08-01 12:00:02,000 ERROR unfinished");
+
+    auto reader = MakeReader(kJavaLogBeginRegex);
+    int32_t rollbackLineFeedCount = 0;
+    int32_t size = reader->LastMatchedLine(&logs[0], logs.size(), rollbackLineFeedCount);
+    APSARA_TEST_EQUAL(size, int32_t(lastBegin));
+    APSARA_TEST_EQUAL(rollbackLineFeedCount, 2);
+    // Buffer is not modified, the unfinished log can be carried over to next read.
+    APSARA_TEST_TRUE(logs == expected);
+}
+
+void LogSplitUnittest::TestLastMatchedLineWithCheckedSize() {
+    auto reader = MakeReader(kJavaLogBeginRegex);
+    std::string carryOver = "2022-08-01 12:00:02,000 ERROR unfinished\n";
+    for (int i = 0; i < 50; ++i) {
+        carryOver.append("\tat com.example.dao.Repository.query" + ToString(i) + "(Repository.java:1)\n");
+    }
+    int32_t checkedSize = carryOver.size();
+
+    // The log is still unfinished after more lines are read.
+    std::string logs = carryOver + "\tat a.b.C(C.java:1)\n";
+    int32_t rollbackLineFeedCount = 0;
+    int32_t expected = reader->LastMatchedLine(&logs[0], logs.size(), rollbackLineFeedCount);
+    APSARA_TEST_EQUAL(expected, 0);
+    APSARA_TEST_EQUAL(reader->lastMatchedLine(&logs[0], logs.size(), checkedSize, rollbackLineFeedCount), expected);
+    APSARA_TEST_EQUAL(rollbackLineFeedCount, 1);
+
+    // The next log begins in new lines.
+    logs = carryOver + "\tat a.b.C(C.java:1)\n2022-08-01 12:00:03,000 INFO next\n\tat a.b.D(D.java:1)\n";
+    expected = reader->LastMatchedLine(&logs[0], logs.size(), rollbackLineFeedCount);
+    APSARA_TEST_EQUAL(expected, int32_t(logs.find("2022-08-01 12:00:03,000")));
+    APSARA_TEST_EQUAL(reader->lastMatchedLine(&logs[0], logs.size(), checkedSize, rollbackLineFeedCount), expected);
+    APSARA_TEST_EQUAL(rollbackLineFeedCount, 2);
+
+    // Lines before checkedSize are trusted and not matched again.
+    logs = "2022-08-01 12:00:02,000 a\n2022-08-01 12:00:03,000 b\nc\n";
+    checkedSize = logs.find("c\n");
+    APSARA_TEST_EQUAL(reader->lastMatchedLine(&logs[0], logs.size(), checkedSize, rollbackLineFeedCount), 0);
+    APSARA_TEST_EQUAL(reader->lastMatchedLine(&logs[0], logs.size(), 0, rollbackLineFeedCount),
+                      int32_t(logs.find("2022-08-01 12:00:03,000")));
+}
+
+void LogSplitUnittest::BenchmarkJavaMultiLine() {
+    const std::string logs = MakeJavaLogs(512 * 1024);
+    const int rounds = 20;
+    boost::regex reg(kJavaLogBeginRegex);
+    auto reader = MakeReader(kJavaLogBeginRegex);
+
+    size_t legacyLogs = 0, currentLogs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        std::string buffer = logs;
+        int32_t lineFeed = 0;
+        legacyLogs += LegacyLogSplit(&reg, &buffer[0], buffer.size(), lineFeed).size();
+    }
+    auto legacyCost = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        std::string buffer = logs;
+        int32_t lineFeed = 0;
+        currentLogs += reader->LogSplit(&buffer[0], buffer.size(), lineFeed).size();
+    }
+    auto cost = std::chrono::steady_clock::now() - start;
+
+    APSARA_TEST_EQUAL(legacyLogs, currentLogs);
+    auto legacyMs = std::chrono::duration_cast<std::chrono::milliseconds>(legacyCost).count();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(cost).count();
+    double mb = logs.size() * rounds / 1024.0 / 1024.0;
+    LOG_INFO(sLogger,
+             ("benchmark", "java multiline LogSplit")("data MB", mb)("legacy ms", legacyMs)("current ms", ms)(
+                 "legacy MB/s", legacyMs > 0 ? mb * 1000 / legacyMs : 0)("current MB/s", ms > 0 ? mb * 1000 / ms : 0));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
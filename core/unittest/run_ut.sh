@@ -86,12 +86,15 @@ if [ ! -d testDataSet ]; then
 	cp -r $CURRENT_DIR/reader/testDataSet ./
 fi
 ./reader_unittest >> $output 2>&1
+./reader_log_split_unittest >> $output 2>&1
+./reader_log_file_reader_unittest >> $output 2>&1
 cd ..
 echo "====================================" >> $output
 
 echo "============== sender ==============" >> $output
 cd sender
 ./sender_unittest >> $output 2>&1
+./sender_aggregator_unittest >> $output 2>&1
 cd ..
 
 echo "============== profiler ==============" >> $output
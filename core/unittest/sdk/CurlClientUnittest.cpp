@@ -0,0 +1,203 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sdk/Closure.h"
+#include "sdk/Common.h"
+#include "sdk/CurlHandlePool.h"
+#include "sdk/CurlImp.h"
+
+namespace logtail {
+
+// A keep-alive HTTP server on loopback which answers every request like SLS does,
+//  it counts accepted connections to tell whether connections are reused.
+class LoopbackServer {
+public:
+    bool Start() {
+        mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (mListenFd < 0 || bind(mListenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(mListenFd, 1024) != 0
+            || getsockname(mListenFd, (sockaddr*)&addr, &len) != 0) {
+            return false;
+        }
+        mPort = ntohs(addr.sin_port);
+        mAcceptThread = std::thread([this]() {
+            while (true) {
+                int fd = accept(mListenFd, NULL, NULL);
+                if (fd < 0) {
+                    break;
+                }
+                ++mAcceptCount;
+                std::thread(&LoopbackServer::Serve, fd).detach();
+            }
+        });
+        return true;
+    }
+
+    void Stop() {
+        shutdown(mListenFd, SHUT_RDWR);
+        close(mListenFd);
+        mAcceptThread.join();
+    }
+
+    int32_t mPort = 0;
+    std::atomic_int mAcceptCount{0};
+
+private:
+    static void Serve(int fd) {
+        std::string buffer;
+        char data[4096];
+        while (true) {
+            size_t headerEnd = buffer.find("\r\n\r\n");
+            if (headerEnd == std::string::npos) {
+                ssize_t n = read(fd, data, sizeof(data));
+                if (n <= 0) {
+                    break;
+                }
+                buffer.append(data, n);
+                continue;
+            }
+            size_t bodySize = 0;
+            size_t pos = buffer.find("Content-Length:");
+            if (pos != std::string::npos && pos < headerEnd) {
+                bodySize = strtoul(buffer.c_str() + pos + strlen("Content-Length:"), NULL, 10);
+            }
+            if (buffer.size() < headerEnd + 4 + bodySize) {
+                ssize_t n = read(fd, data, sizeof(data));
+                if (n <= 0) {
+                    break;
+                }
+                buffer.append(data, n);
+                continue;
+            }
+            buffer.erase(0, headerEnd + 4 + bodySize);
+            static const std::string kResponse
+                = "HTTP/1.1 200 OK\r\nx-log-requestid: 0123456789\r\nContent-Length: 0\r\n\r\n";
+            if (write(fd, kResponse.data(), kResponse.size()) != (ssize_t)kResponse.size()) {
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    int mListenFd = -1;
+    std::thread mAcceptThread;
+};
+
+class CountClosure : public sdk::LogsClosure {
+public:
+    CountClosure(std::atomic_int& successCount, std::atomic_int& failCount)
+        : mSuccessCount(successCount), mFailCount(failCount) {}
+    void Done() override {}
+    void OnSuccess(sdk::Response* response) override { ++mSuccessCount; }
+    void OnFail(sdk::Response* response, const std::string& errorCode, const std::string& errorMessage) override {
+        ++mFailCount;
+    }
+
+private:
+    std::atomic_int& mSuccessCount;
+    std::atomic_int& mFailCount;
+};
+
+class CurlClientUnittest : public ::testing::Test {
+public:
+    void TestSendReuseConnection();
+    void TestAsynSendReuseConnection();
+
+protected:
+    void SetUp() override { APSARA_TEST_TRUE_FATAL(mServer.Start()); }
+    void TearDown() override { mServer.Stop(); }
+
+    // Sends @count requests asynchronously and waits until all of them are done.
+    bool AsynSend(int count) {
+        std::atomic_int successCount(0), failCount(0);
+        std::vector<std::unique_ptr<CountClosure>> closures;
+        for (int i = 0; i < count; ++i) {
+            closures.emplace_back(new CountClosure(successCount, failCount));
+            mClient.AsynSend(new sdk::AsynRequest(sdk::HTTP_POST,
+                                                  kHost,
+                                                  mServer.mPort,
+                                                  "/logstores/test/shards/lb",
+                                                  "",
+                                                  {},
+                                                  std::string(1024, 'a'),
+                                                  5,
+                                                  "",
+                                                  false,
+                                                  closures.back().get(),
+                                                  new sdk::PostLogStoreLogsResponse));
+        }
+        for (int i = 0; i < 1000 && successCount + failCount < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return successCount == count;
+    }
+
+    static const std::string kHost;
+    LoopbackServer mServer;
+    sdk::CurlClient mClient;
+};
+
+const std::string CurlClientUnittest::kHost = "127.0.0.1";
+
+UNIT_TEST_CASE(CurlClientUnittest, TestSendReuseConnection);
+UNIT_TEST_CASE(CurlClientUnittest, TestAsynSendReuseConnection);
+
+void CurlClientUnittest::TestSendReuseConnection() {
+    for (int i = 0; i < 20; ++i) {
+        sdk::HttpMessage httpMessage;
+        mClient.Send(sdk::HTTP_POST,
+                     kHost,
+                     mServer.mPort,
+                     "/logstores/test/shards/lb",
+                     "",
+                     {},
+                     "body",
+                     5,
+                     httpMessage,
+                     "",
+                     false);
+        APSARA_TEST_EQUAL(httpMessage.statusCode, 200);
+    }
+    // The pooled handle keeps its connection.
+    APSARA_TEST_EQUAL(mServer.mAcceptCount.load(), 1);
+    APSARA_TEST_TRUE(sdk::CurlHandlePool::GetInstance()->GetIdleCount(kHost) >= 1UL);
+}
+
+void CurlClientUnittest::TestAsynSendReuseConnection() {
+    for (int i = 0; i < 20; ++i) {
+        APSARA_TEST_TRUE(AsynSend(1));
+    }
+    APSARA_TEST_EQUAL(mServer.mAcceptCount.load(), 1);
+    // Concurrent requests need more connections, all of them are done.
+    APSARA_TEST_TRUE(AsynSend(500));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,176 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "aggregator/Aggregator.h"
+#include "common/Constants.h"
+#include "common/LogGroupContext.h"
+#include "config/Config.h"
+#include "config_manager/ConfigManager.h"
+
+namespace logtail {
+
+class AggregatorUnittest : public ::testing::Test {
+public:
+    void TestCachedKey();
+    void TestConfigReload();
+    void TestTopicAndSourceChange();
+    void TestDynamicShardHashKey();
+
+protected:
+    struct Keys {
+        int64_t mLogGroupKey;
+        int64_t mLogstoreKey;
+        std::string mShardHashKey;
+    };
+
+    static std::unique_ptr<Config> MakeConfig(const std::string& basePath, const std::vector<std::string>& shardKeys) {
+        std::unique_ptr<Config> config(
+            new Config(basePath, "*.log", REGEX_LOG, "log", "", "project", false, 0, 0, "logstore"));
+        config->mShardHashKey = shardKeys;
+        return config;
+    }
+
+    // GetKeys returns keys of a log group as Aggregator::Add uses them, cached in @cache if it is set.
+    static Keys GetKeys(const Config* config,
+                        const std::string& topic,
+                        const std::string& source,
+                        const RoutingKeyCachePtr& cache) {
+        LogGroupContext context;
+        context.mRoutingKeyCache = cache;
+        LogGroupRoutingKeyPtr cachedKey;
+        LogGroupRoutingKey localKey;
+        Aggregator* aggregator = Aggregator::GetInstance();
+        const LogGroupRoutingKey* routingKey = aggregator->GetRoutingKey(
+            "project", "source-id", "logstore", topic, source, config, context, true, cachedKey, localKey);
+        Keys keys;
+        keys.mLogGroupKey = routingKey->mLogGroupKey;
+        keys.mLogstoreKey = routingKey->mLogstoreKey;
+        keys.mShardHashKey = routingKey->mShardHashKeyCached
+            ? routingKey->mShardHashKey
+            : aggregator->CalPostRequestShardHashKey(source, topic, config);
+        return keys;
+    }
+
+    // CheckKeys checks keys from @cache are the same as keys computed without cache, and returns them.
+    static Keys CheckKeys(const Config* config,
+                          const std::string& topic,
+                          const std::string& source,
+                          const RoutingKeyCachePtr& cache) {
+        Keys cached = GetKeys(config, topic, source, cache);
+        Keys uncached = GetKeys(config, topic, source, RoutingKeyCachePtr());
+        APSARA_TEST_EQUAL(cached.mLogGroupKey, uncached.mLogGroupKey);
+        APSARA_TEST_EQUAL(cached.mLogstoreKey, uncached.mLogstoreKey);
+        APSARA_TEST_EQUAL(cached.mShardHashKey, uncached.mShardHashKey);
+        return cached;
+    }
+};
+
+UNIT_TEST_CASE(AggregatorUnittest, TestCachedKey);
+UNIT_TEST_CASE(AggregatorUnittest, TestConfigReload);
+UNIT_TEST_CASE(AggregatorUnittest, TestTopicAndSourceChange);
+UNIT_TEST_CASE(AggregatorUnittest, TestDynamicShardHashKey);
+
+void AggregatorUnittest::TestCachedKey() {
+    auto config = MakeConfig("/var/log", {LOG_RESERVED_KEY_SOURCE, LOG_RESERVED_KEY_TOPIC});
+    RoutingKeyCachePtr cache = std::make_shared<RoutingKeyCache>();
+    CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+    LogGroupRoutingKeyPtr key = cache->Get();
+    APSARA_TEST_TRUE_FATAL(key != nullptr);
+    APSARA_TEST_TRUE(key->mShardHashKeyCached);
+    APSARA_TEST_FALSE(key->mShardHashKey.empty());
+
+    // The same inputs reuse the cached key.
+    CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+    APSARA_TEST_TRUE(cache->Get() == key);
+}
+
+void AggregatorUnittest::TestConfigReload() {
+    auto config = MakeConfig("/var/log", {LOG_RESERVED_KEY_SOURCE});
+    RoutingKeyCachePtr cache = std::make_shared<RoutingKeyCache>();
+    Keys oldKeys = CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+
+    // A reloaded config is a new instance, even with the same name.
+    auto reloaded = MakeConfig("/var/log/app", {LOG_RESERVED_KEY_SOURCE});
+    APSARA_TEST_TRUE(reloaded->mInstanceId != config->mInstanceId);
+    Keys newKeys = CheckKeys(reloaded.get(), "topic", "1.1.1.1", cache);
+    APSARA_TEST_TRUE(newKeys.mLogGroupKey != oldKeys.mLogGroupKey);
+    APSARA_TEST_EQUAL(cache->Get()->mConfigInstanceId, reloaded->mInstanceId);
+
+    // A config object reused for another config is checked by its instance id too.
+    config->mBasePath = "/var/log/other";
+    config->mInstanceId = Config::NewInstanceId();
+    newKeys = CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+    APSARA_TEST_TRUE(newKeys.mLogGroupKey != oldKeys.mLogGroupKey);
+    APSARA_TEST_EQUAL(cache->Get()->mConfigInstanceId, config->mInstanceId);
+}
+
+void AggregatorUnittest::TestTopicAndSourceChange() {
+    auto config = MakeConfig("/var/log", {LOG_RESERVED_KEY_SOURCE, LOG_RESERVED_KEY_TOPIC});
+    RoutingKeyCachePtr cache = std::make_shared<RoutingKeyCache>();
+    Keys keys = CheckKeys(config.get(), "topic-1", "1.1.1.1", cache);
+
+    Keys topicKeys = CheckKeys(config.get(), "topic-2", "1.1.1.1", cache);
+    APSARA_TEST_TRUE(topicKeys.mLogGroupKey != keys.mLogGroupKey);
+    APSARA_TEST_TRUE(topicKeys.mShardHashKey != keys.mShardHashKey);
+    APSARA_TEST_EQUAL(topicKeys.mLogstoreKey, keys.mLogstoreKey);
+    APSARA_TEST_EQUAL(cache->Get()->mTopic, "topic-2");
+
+    Keys sourceKeys = CheckKeys(config.get(), "topic-2", "2.2.2.2", cache);
+    APSARA_TEST_TRUE(sourceKeys.mLogGroupKey != topicKeys.mLogGroupKey);
+    APSARA_TEST_TRUE(sourceKeys.mShardHashKey != topicKeys.mShardHashKey);
+    APSARA_TEST_EQUAL(cache->Get()->mSource, "2.2.2.2");
+
+    // Back to the first topic and source.
+    Keys backKeys = CheckKeys(config.get(), "topic-1", "1.1.1.1", cache);
+    APSARA_TEST_EQUAL(backKeys.mLogGroupKey, keys.mLogGroupKey);
+    APSARA_TEST_EQUAL(backKeys.mShardHashKey, keys.mShardHashKey);
+}
+
+void AggregatorUnittest::TestDynamicShardHashKey() {
+    ConfigManager* configManager = ConfigManager::GetInstance();
+    const std::set<std::string> userDefinedIds = configManager->mUserDefinedIdSet;
+    const std::string uuid = configManager->GetUUID();
+    RoutingKeyCachePtr cache = std::make_shared<RoutingKeyCache>();
+
+    // User defined ids are read for every log group.
+    auto config = MakeConfig("/var/log", {LOG_RESERVED_KEY_SOURCE, LOG_RESERVED_KEY_USER_DEFINED_ID});
+    configManager->SetUserDefinedIdSet({"id-1"});
+    Keys keys = CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+    APSARA_TEST_FALSE(cache->Get()->mShardHashKeyCached);
+    configManager->SetUserDefinedIdSet({"id-2"});
+    Keys newKeys = CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+    APSARA_TEST_TRUE(newKeys.mShardHashKey != keys.mShardHashKey);
+    APSARA_TEST_EQUAL(newKeys.mLogGroupKey, keys.mLogGroupKey);
+
+    // So is machine uuid.
+    config = MakeConfig("/var/log", {LOG_RESERVED_KEY_MACHINE_UUID});
+    configManager->SetUUID("uuid-1");
+    keys = CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+    APSARA_TEST_FALSE(cache->Get()->mShardHashKeyCached);
+    configManager->SetUUID("uuid-2");
+    newKeys = CheckKeys(config.get(), "topic", "1.1.1.1", cache);
+    APSARA_TEST_TRUE(newKeys.mShardHashKey != keys.mShardHashKey);
+
+    configManager->SetUserDefinedIdSet(std::vector<std::string>(userDefinedIds.begin(), userDefinedIds.end()));
+    configManager->SetUUID(uuid);
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
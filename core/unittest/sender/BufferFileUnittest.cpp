@@ -0,0 +1,396 @@
+// Copyright 2022 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "unittest/Unittest.h"
+#if defined(__linux__)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "common/FileSystemUtil.h"
+#include "common/RuntimeUtil.h"
+#include "logger/Logger.h"
+#include "sender/BufferFile.h"
+
+namespace logtail {
+
+class BufferFileUnittest : public ::testing::Test {
+public:
+    void TestWriteAndRead();
+    void TestBrokenRecord();
+    void TestPartialCommit();
+    void BenchmarkOutageAndDrain();
+
+protected:
+    void SetUp() override {
+        mRootDir = GetProcessExecutionDir() + "BufferFileUnittest" + PATH_SEPARATOR;
+        bfs::remove_all(mRootDir);
+        bfs::create_directories(mRootDir);
+    }
+    void TearDown() override { bfs::remove_all(mRootDir); }
+
+    static EncryptionStateMeta MakeMeta(const std::string& encodedInfo, const std::string& data) {
+        EncryptionStateMeta meta;
+        meta.mLogDataSize = data.size();
+        meta.mEncryptionSize = data.size();
+        meta.mEncodedInfoSize = encodedInfo.size() + BUFFER_META_BASE_SIZE;
+        meta.mTimeStamp = 1658113161;
+        meta.mHandled = 0;
+        meta.mRetryTime = 0;
+        return meta;
+    }
+
+    static std::string MakeData(int32_t index, size_t size) {
+        std::string data(size, 'a' + index % 26);
+        memcpy(&data[0], &index, sizeof(index));
+        return data;
+    }
+
+    // Reads all records, returns count of unhandled ones and marks them handled if @handle.
+    static int32_t Drain(const std::string& fileName, int32_t headerSize, bool handle) {
+        BufferFileReader reader;
+        if (!reader.Open(fileName, headerSize)) {
+            return -1;
+        }
+        EncryptionStateMeta meta;
+        int32_t encodedInfoSize = 0, count = 0;
+        std::string encodedInfo, encryption, errorMessage;
+        while (reader.ReadMeta(meta, encodedInfoSize, errorMessage)) {
+            if (meta.mHandled == 1) {
+                continue;
+            }
+            if (!reader.ReadBody(encodedInfoSize, meta.mEncryptionSize, encodedInfo, encryption, errorMessage)) {
+                return -1;
+            }
+            ++count;
+            if (handle) {
+                meta.mHandled = 1;
+                reader.WriteBackMeta(meta, errorMessage);
+            }
+        }
+        return errorMessage.empty() ? count : -1;
+    }
+
+    // Write and drain a buffer file like Sender did before BufferFileWriter and BufferFileReader:
+    //  the file is opened for every record, and every handled meta.
+    static bool LegacyWrite(const std::string& fileName,
+                            const std::string& header,
+                            const EncryptionStateMeta& meta,
+                            const std::string& encodedInfo,
+                            const std::string& data);
+    static int32_t LegacyDrain(const std::string& fileName, int32_t headerSize);
+
+    std::string mRootDir;
+};
+
+UNIT_TEST_CASE(BufferFileUnittest, TestWriteAndRead);
+UNIT_TEST_CASE(BufferFileUnittest, TestBrokenRecord);
+UNIT_TEST_CASE(BufferFileUnittest, TestPartialCommit);
+UNIT_BENCHMARK_CASE(BufferFileUnittest, BenchmarkOutageAndDrain);
+
+void BufferFileUnittest::TestWriteAndRead() {
+    const std::string fileName = mRootDir + "logtail_buffer_file_1";
+    const std::string header(1024, 'h');
+    const std::string encodedInfo = "project-logstore";
+    {
+        BufferFileWriter writer;
+        APSARA_TEST_TRUE_FATAL(writer.Open(fileName, header));
+        for (int32_t i = 0; i < 10; ++i) {
+            std::string data = MakeData(i, 100 + i);
+            writer.Append(MakeMeta(encodedInfo, data), encodedInfo, data.data(), data.size());
+        }
+        APSARA_TEST_EQUAL(writer.GetPendingCount(), 10UL);
+        // Nothing is written before commit.
+        APSARA_TEST_EQUAL(bfs::file_size(fileName), 0UL);
+        std::string errorMessage;
+        APSARA_TEST_TRUE(writer.Commit(false, errorMessage));
+        APSARA_TEST_EQUAL(writer.GetPendingCount(), 0UL);
+        APSARA_TEST_EQUAL((int64_t)bfs::file_size(fileName), writer.GetFileSize());
+    }
+    {
+        // Header is not written again for existing file, pending records are committed by Close.
+        BufferFileWriter writer;
+        APSARA_TEST_TRUE_FATAL(writer.Open(fileName, header));
+        for (int32_t i = 10; i < 20; ++i) {
+            std::string data = MakeData(i, 100 + i);
+            writer.Append(MakeMeta(encodedInfo, data), encodedInfo, data.data(), data.size());
+        }
+        writer.Close();
+        APSARA_TEST_FALSE(writer.IsOpen());
+    }
+
+    BufferFileReader reader;
+    APSARA_TEST_TRUE_FATAL(reader.Open(fileName, header.size()));
+    EncryptionStateMeta meta;
+    int32_t encodedInfoSize = 0;
+    std::string readInfo, encryption, errorMessage;
+    for (int32_t i = 0; i < 20; ++i) {
+        APSARA_TEST_TRUE_FATAL(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+        APSARA_TEST_EQUAL(encodedInfoSize, (int32_t)encodedInfo.size());
+        APSARA_TEST_EQUAL(meta.mEncryptionSize, 100 + i);
+        // Bodies of odd records are skipped.
+        if (i % 2 == 1) {
+            continue;
+        }
+        APSARA_TEST_TRUE_FATAL(reader.ReadBody(encodedInfoSize, meta.mEncryptionSize, readInfo, encryption, errorMessage));
+        APSARA_TEST_EQUAL(readInfo, encodedInfo);
+        APSARA_TEST_EQUAL(encryption, MakeData(i, 100 + i));
+        meta.mHandled = 1;
+        APSARA_TEST_TRUE(reader.WriteBackMeta(meta, errorMessage));
+    }
+    APSARA_TEST_FALSE(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+    APSARA_TEST_TRUE(errorMessage.empty());
+    reader.Close();
+
+    // Handled records are skipped in next round.
+    APSARA_TEST_EQUAL(Drain(fileName, header.size(), true), 10);
+    APSARA_TEST_EQUAL(Drain(fileName, header.size(), true), 0);
+}
+
+void BufferFileUnittest::TestBrokenRecord() {
+    const std::string fileName = mRootDir + "logtail_buffer_file_2";
+    const std::string encodedInfo = "project-logstore";
+    {
+        BufferFileWriter writer;
+        APSARA_TEST_TRUE_FATAL(writer.Open(fileName, ""));
+        for (int32_t i = 0; i < 2; ++i) {
+            std::string data = MakeData(i, 100);
+            writer.Append(MakeMeta(encodedInfo, data), encodedInfo, data.data(), data.size());
+        }
+    }
+    // The last record is truncated.
+    bfs::resize_file(fileName, bfs::file_size(fileName) - 10);
+    BufferFileReader reader;
+    APSARA_TEST_TRUE_FATAL(reader.Open(fileName, 0));
+    EncryptionStateMeta meta;
+    int32_t encodedInfoSize = 0;
+    std::string readInfo, encryption, errorMessage;
+    APSARA_TEST_TRUE(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+    APSARA_TEST_TRUE(reader.ReadBody(encodedInfoSize, meta.mEncryptionSize, readInfo, encryption, errorMessage));
+    APSARA_TEST_TRUE(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+    APSARA_TEST_FALSE(reader.ReadBody(encodedInfoSize, meta.mEncryptionSize, readInfo, encryption, errorMessage));
+    APSARA_TEST_FALSE(errorMessage.empty());
+    errorMessage.clear();
+    APSARA_TEST_FALSE(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+    APSARA_TEST_TRUE(errorMessage.empty());
+
+    // Broken meta.
+    bfs::resize_file(fileName, sizeof(EncryptionStateMeta) / 2);
+    APSARA_TEST_TRUE_FATAL(reader.Open(fileName, 0));
+    APSARA_TEST_FALSE(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+    APSARA_TEST_FALSE(errorMessage.empty());
+}
+
+void BufferFileUnittest::TestPartialCommit() {
+#if defined(__linux__)
+    const std::string fileName = mRootDir + "logtail_buffer_file_3";
+    const std::string encodedInfo = "project-logstore";
+    BufferFileWriter writer;
+    APSARA_TEST_TRUE_FATAL(writer.Open(fileName, ""));
+    std::string data = MakeData(0, 100);
+    writer.Append(MakeMeta(encodedInfo, data), encodedInfo, data.data(), data.size());
+    std::string errorMessage;
+    APSARA_TEST_TRUE_FATAL(writer.Commit(false, errorMessage));
+    const int64_t committedSize = writer.GetFileSize();
+    for (int32_t i = 1; i < 5; ++i) {
+        data = MakeData(i, 100);
+        writer.Append(MakeMeta(encodedInfo, data), encodedInfo, data.data(), data.size());
+    }
+
+    // File size limit stops the write in the middle of the batch.
+    struct rlimit backup, limit;
+    getrlimit(RLIMIT_FSIZE, &backup);
+    limit = backup;
+    limit.rlim_cur = committedSize + 150;
+    sighandler_t handler = signal(SIGXFSZ, SIG_IGN);
+    APSARA_TEST_EQUAL_FATAL(setrlimit(RLIMIT_FSIZE, &limit), 0);
+    const bool committed = writer.Commit(false, errorMessage);
+    setrlimit(RLIMIT_FSIZE, &backup);
+    signal(SIGXFSZ, handler);
+    APSARA_TEST_FALSE(committed);
+    APSARA_TEST_FALSE(errorMessage.empty());
+    // The partial batch is dropped from file and kept in memory.
+    APSARA_TEST_EQUAL((int64_t)bfs::file_size(fileName), committedSize);
+    APSARA_TEST_EQUAL(writer.GetPendingCount(), 4UL);
+
+    // Retried by next commit.
+    data = MakeData(5, 100);
+    writer.Append(MakeMeta(encodedInfo, data), encodedInfo, data.data(), data.size());
+    APSARA_TEST_TRUE(writer.Commit(false, errorMessage));
+    writer.Close();
+    BufferFileReader reader;
+    APSARA_TEST_TRUE_FATAL(reader.Open(fileName, 0));
+    EncryptionStateMeta meta;
+    int32_t encodedInfoSize = 0;
+    std::string readInfo, encryption;
+    errorMessage.clear();
+    for (int32_t i = 0; i < 6; ++i) {
+        APSARA_TEST_TRUE_FATAL(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+        APSARA_TEST_TRUE_FATAL(
+            reader.ReadBody(encodedInfoSize, meta.mEncryptionSize, readInfo, encryption, errorMessage));
+        APSARA_TEST_EQUAL(encryption, MakeData(i, 100));
+    }
+    APSARA_TEST_FALSE(reader.ReadMeta(meta, encodedInfoSize, errorMessage));
+    APSARA_TEST_TRUE(errorMessage.empty());
+#endif
+}
+
+bool BufferFileUnittest::LegacyWrite(const std::string& fileName,
+                                     const std::string& header,
+                                     const EncryptionStateMeta& meta,
+                                     const std::string& encodedInfo,
+                                     const std::string& data) {
+    FILE* fout = FileAppendOpen(fileName.c_str(), "ab");
+    if (!fout) {
+        return false;
+    }
+    if (ftell(fout) == 0) {
+        fwrite(header.c_str(), 1, header.size(), fout);
+    }
+    const size_t size = sizeof(meta) + encodedInfo.size() + data.size();
+    char* buffer = new char[size];
+    memcpy(buffer, (char*)&meta, sizeof(meta));
+    memcpy(buffer + sizeof(meta), encodedInfo.c_str(), encodedInfo.size());
+    memcpy(buffer + sizeof(meta) + encodedInfo.size(), data.c_str(), data.size());
+    bool result = fwrite(buffer, 1, size, fout) == size;
+    delete[] buffer;
+    fclose(fout);
+    return result;
+}
+
+int32_t BufferFileUnittest::LegacyDrain(const std::string& fileName, int32_t headerSize) {
+    int32_t pos = headerSize, count = 0;
+    while (true) {
+        FILE* fin = FileReadOnlyOpen(fileName.c_str(), "rb");
+        if (!fin) {
+            return -1;
+        }
+        fseek(fin, 0, SEEK_END);
+        if (ftell(fin) == pos) {
+            fclose(fin);
+            break;
+        }
+        fseek(fin, pos, SEEK_SET);
+        EncryptionStateMeta meta;
+        if (fread(&meta, 1, sizeof(meta), fin) != sizeof(meta)) {
+            fclose(fin);
+            return -1;
+        }
+        const int32_t metaPos = pos;
+        const int32_t encodedInfoSize = meta.mEncodedInfoSize - BUFFER_META_BASE_SIZE;
+        pos += sizeof(meta) + encodedInfoSize + meta.mEncryptionSize;
+        char* buffer = new char[encodedInfoSize + 1];
+        size_t nbytes = fread(buffer, 1, encodedInfoSize, fin);
+        std::string encodedInfo(buffer, encodedInfoSize);
+        delete[] buffer;
+        buffer = new char[meta.mEncryptionSize + 1];
+        nbytes += fread(buffer, 1, meta.mEncryptionSize, fin);
+        std::string encryption(buffer, meta.mEncryptionSize);
+        delete[] buffer;
+        fclose(fin);
+        if (nbytes != (size_t)(encodedInfoSize + meta.mEncryptionSize)) {
+            return -1;
+        }
+        ++count;
+        meta.mHandled = 1;
+#if defined(__linux__)
+        int fd = open(fileName.c_str(), O_WRONLY);
+        lseek(fd, metaPos, SEEK_SET);
+        if (write(fd, &meta, sizeof(meta)) < 0) {
+            close(fd);
+            return -1;
+        }
+        close(fd);
+#endif
+    }
+    return count;
+}
+
+// One hour of outage with 5 log groups (4KB each) per second dumped in rounds of 20 log groups,
+//  then the buffer files are drained. Files are rotated at 20MB.
+void BufferFileUnittest::BenchmarkOutageAndDrain() {
+    const int32_t kLogGroupCount = 3600 * 5;
+    const int32_t kBatchSize = 20;
+    const int64_t kFileSize = 20 * 1024 * 1024;
+    const std::string header(1024, 'h');
+    const std::string encodedInfo(64, 'm');
+    std::vector<std::string> dataList;
+    for (int32_t i = 0; i < 64; ++i) {
+        dataList.push_back(MakeData(i, 4096));
+    }
+
+    std::vector<std::string> legacyFiles, files;
+    int64_t fileSize = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < kLogGroupCount; ++i) {
+        if (legacyFiles.empty() || fileSize > kFileSize) {
+            legacyFiles.push_back(mRootDir + "legacy_" + std::to_string(legacyFiles.size()));
+            fileSize = header.size();
+        }
+        const std::string& data = dataList[i % dataList.size()];
+        APSARA_TEST_TRUE_FATAL(LegacyWrite(legacyFiles.back(), header, MakeMeta(encodedInfo, data), encodedInfo, data));
+        fileSize += sizeof(EncryptionStateMeta) + encodedInfo.size() + data.size();
+    }
+    auto legacyWriteCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    {
+        BufferFileWriter writer;
+        std::string errorMessage;
+        for (int32_t i = 0; i < kLogGroupCount; ++i) {
+            if (!writer.IsOpen() || writer.GetFileSize() > kFileSize) {
+                APSARA_TEST_TRUE_FATAL(writer.Commit(false, errorMessage));
+                files.push_back(mRootDir + "segment_" + std::to_string(files.size()));
+                APSARA_TEST_TRUE_FATAL(writer.Open(files.back(), header));
+            }
+            const std::string& data = dataList[i % dataList.size()];
+            writer.Append(MakeMeta(encodedInfo, data), encodedInfo, data.data(), data.size());
+            if ((i + 1) % kBatchSize == 0) {
+                APSARA_TEST_TRUE_FATAL(writer.Commit(false, errorMessage));
+            }
+        }
+    }
+    auto writeCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    APSARA_TEST_EQUAL(files.size(), legacyFiles.size());
+
+    int32_t legacyCount = 0, count = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& fileName : legacyFiles) {
+        legacyCount += LegacyDrain(fileName, header.size());
+    }
+    auto legacyDrainCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (const auto& fileName : files) {
+        count += Drain(fileName, header.size(), true);
+    }
+    auto drainCost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    APSARA_TEST_EQUAL(legacyCount, kLogGroupCount);
+    APSARA_TEST_EQUAL(count, kLogGroupCount);
+
+    const double totalMB = kLogGroupCount * (4096.0 + encodedInfo.size() + sizeof(EncryptionStateMeta)) / 1024 / 1024;
+    LOG_INFO(sLogger,
+             ("benchmark", "buffer file outage and drain")("log groups", kLogGroupCount)("files", files.size())(
+                 "legacy write MB/s", totalMB / legacyWriteCost)("write MB/s", totalMB / writeCost)(
+                 "legacy drain MB/s", totalMB / legacyDrainCost)("drain MB/s", totalMB / drainCost));
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -462,7 +462,7 @@ class SenderUnittest : public ::testing::Test {
     void clearGlobalResource() {
         sCptM->rebuild();
         sQueueM->clear();
-        sProcessQueueMap->clear();
+        LogProcess::GetInstance()->GetQueue().RemoveAll();
         sSenderQueueMap->clear();
     }
 
@@ -2844,6 +2844,53 @@ public:
         LOG_INFO(sLogger, ("TestMergeTruncateInfo() end", time(NULL)));
     }
 
+    void TestMergeItemSerializeLogGroup() {
+        LOG_INFO(sLogger, ("TestMergeItemSerializeLogGroup() begin", time(NULL)));
+        MergeItem mergeItem(std::string("test_project"),
+                            std::string("test_config_name"),
+                            std::string("test_filename"),
+                            true,
+                            std::string("test_aliuid"),
+                            std::string("test_region"),
+                            123456,
+                            MERGE_BY_TOPIC,
+                            std::string("test_shardhashkey"),
+                            123456);
+        sls_logs::Log lastLog;
+        APSARA_TEST_FALSE(mergeItem.GetLastLog(lastLog));
+
+        sls_logs::LogGroup expected;
+        expected.set_category("test_logstore");
+        expected.set_topic("test_topic");
+        expected.set_source("127.0.0.1");
+        sls_logs::LogTag* logTag = expected.add_logtags();
+        logTag->set_key("tag_key");
+        logTag->set_value("tag_value");
+        mergeItem.mLogGroup.CopyFrom(expected);
+        for (int i = 0; i < 200; ++i) {
+            sls_logs::Log* log = expected.add_logs();
+            log->set_time(1600000000 + i);
+            sls_logs::Log_Content* content = log->add_contents();
+            content->set_key("content");
+            // Make logs larger than 127 bytes, whose size needs a multi-byte varint.
+            content->set_value(std::string(i, 'a'));
+
+            log->ByteSize();
+            mergeItem.AppendLog(*log);
+            ++mergeItem.mLines;
+        }
+
+        std::string expectedData;
+        expected.SerializeToString(&expectedData);
+        APSARA_TEST_TRUE(mergeItem.SerializeLogGroup() == expectedData);
+        // Serialized once, and the last log is still available for integrity check.
+        APSARA_TEST_TRUE(mergeItem.SerializeLogGroup() == expectedData);
+        APSARA_TEST_TRUE(mergeItem.GetLastLog(lastLog));
+        APSARA_TEST_EQUAL(lastLog.time(), 1600000199U);
+        APSARA_TEST_EQUAL(lastLog.contents(0).value(), std::string(199, 'a'));
+        LOG_INFO(sLogger, ("TestMergeItemSerializeLogGroup() end", time(NULL)));
+    }
+
     void TestGlobalMarkOffset() {
         LOG_INFO(sLogger, ("TestGlobalMarkOffset() begin", time(NULL)));
         // prepare
@@ -3064,6 +3111,7 @@ APSARA_UNIT_TEST_CASE(SenderUnittest, TestLogstoreFlowControlPause, gCaseID);
 APSARA_UNIT_TEST_CASE(SenderUnittest, TestLogstoreFlowControlExpire, gCaseID);
 APSARA_UNIT_TEST_CASE(SenderUnittest, TestTooOldFilesIntegrity, gCaseID);
 APSARA_UNIT_TEST_CASE(SenderUnittest, TestMergeTruncateInfo, gCaseID);
+APSARA_UNIT_TEST_CASE(SenderUnittest, TestMergeItemSerializeLogGroup, gCaseID);
 APSARA_UNIT_TEST_CASE(SenderUnittest, TestGlobalMarkOffset, gCaseID);
 APSARA_UNIT_TEST_CASE(SenderUnittest, TestRealIpSend, gCaseID);
 APSARA_UNIT_TEST_CASE(SenderUnittest, TestEmptyRealIp, gCaseID);